@@ -1,11 +1,20 @@
 // --- Includes Padrão ---
-#include <stdlib.h>     // Para funções de alocação de memória (malloc, free)
+#include <stdlib.h>     // Utilitários padrão (a memória vem do pool estático, ver hal_pool.h)
 #include <string.h>     // Para funções de manipulação de strings (strcmp, memset)
 #include <fcntl.h>      // Para flags de controle de arquivo (comum em HALs, mas não usado diretamente aqui)
 #include <android/log.h> // Para a função __android_log_print, usada para logs no Logcat Android
 #include <errno.h>      // Para códigos de erro padrão (ex: -ENODEV, -EINVAL, -ENOMEM)
-#include <unistd.h>     // Para usleep (usado em passos futuros para simulação de otimização)
+#include <unistd.h>     // Para funções POSIX auxiliares
+#include <pthread.h>    // Para o mutex das operações de controle
 #include <stdio.h>      // Para printf, usado como log de fallback/verificação em C padrão
+#include <limits.h>     // Para INT_MIN (prioridade de ducking sem streams ativos)
+#include <time.h>       // Para nanosleep (espera ao fechar um stream)
+#include <atomic>       // Para os parâmetros do equalizador publicados entre threads
+#include <new>          // Placement new do cabeçalho de filas compartilhadas
+#include <stddef.h>     // Para offsetof
+#include <math.h>       // Para powf (curva de volume do veículo em dB)
+
+#include "hal_log.h"    // Nível de log em tempo de compilação e log com limite de taxa
 
 
 // --- Definições Manuais de Constantes de Prioridade de Log ---
@@ -30,109 +39,238 @@
 // Elas são definidas manualmente aqui para garantir sua disponibilidade,
 // dado que o cabeçalho <log/log.h> (que as define nativamente) não foi encontrado
 // de forma consistente no ambiente de build.
+// Todas passam por HAL_LOG (hal_log.h), que remove em tempo de compilação as
+// prioridades abaixo de HAL_LOG_LEVEL (ALOGD some nas builds de release).
 #ifndef ALOGD
-#define ALOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "AudioHAL", __VA_ARGS__)
+#define ALOGD(...) HAL_LOG(ANDROID_LOG_DEBUG, "AudioHAL", __VA_ARGS__)
 #endif
 
 #ifndef ALOGE
-#define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR, "AudioHAL", __VA_ARGS__)
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "AudioHAL", __VA_ARGS__)
 #endif
 
 #ifndef ALOGI
-#define ALOGI(...) __android_log_print(ANDROID_LOG_INFO, "AudioHAL", __VA_ARGS__)
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "AudioHAL", __VA_ARGS__)
 #endif
+
+// Versões com limite de taxa, para eventos do caminho de áudio que podem se
+// repetir a cada período: no máximo uma mensagem por segundo por ponto de chamada.
+#define HAL_LOG_INTERVAL_MS 1000
+#define ALOGE_RATELIMITED(...) HAL_LOG_RATELIMITED(ANDROID_LOG_ERROR, "AudioHAL", HAL_LOG_INTERVAL_MS, __VA_ARGS__)
+#define ALOGI_RATELIMITED(...) HAL_LOG_RATELIMITED(ANDROID_LOG_INFO, "AudioHAL", HAL_LOG_INTERVAL_MS, __VA_ARGS__)
 // --- Fim das Definições Manuais das Macros ALOG ---
 
 
-// --- Definições Mínimas Injetadas para Simulação da HAL ---
-// Este bloco de código contém as definições mínimas de estruturas e macros
-// que normalmente seriam fornecidas pelos cabeçalhos padrão do NDK,
-// especificamente <hardware/hardware.h> e <hardware/audio.h>.
-// Elas foram injetadas diretamente neste arquivo (e em native-lib.cpp)
-// como uma solução de contorno para problemas de ambiente que impediram
-// o compilador de encontrar esses cabeçalhos.
-// A ordem de declaração das estruturas é crucial em C/C++ para evitar erros de tipo.
-
-// Forward declarations para estruturas que se referenciam mutuamente.
-// Isso informa ao compilador sobre a existência dessas estruturas antes de suas definições completas.
-struct hw_module_t;
-struct hw_device_t;
-struct audio_hw_device; // Forward declaration para a estrutura base de audio_hw_device_t
-
-// Estrutura comum para todos os módulos de hardware (base para HALs).
-// Define a interface básica que um módulo HAL deve ter.
-struct hw_module_t {
-    uint32_t tag;               // Identificador único da estrutura (ex: HARDWARE_MODULE_TAG)
-    uint32_t version_major;     // Versão principal da interface do módulo
-    uint32_t version_minor;     // Versão secundária da interface do módulo
-    const char *id;             // Identificador textual do módulo (ex: "audio")
-    const char *name;           // Nome amigável do módulo
-    const char *author;         // Autor ou organização responsável pelo módulo
-    struct hw_module_methods_t *methods; // Ponteiro para os métodos de acesso do módulo
-    void* dso;                  // Ponteiro interno para o objeto de biblioteca compartilhada (não usado na simulação)
-    uint32_t reserved[32-7];    // Campos reservados para uso futuro, garantindo tamanho fixo
-};
+// --- Definições da Interface da HAL ---
+// As estruturas e macros de <hardware/hardware.h> e <hardware/audio.h> injetadas
+// para a simulação ficam em audio_hal.h, compartilhado com native-lib.cpp.
+#include "audio_hal.h"
+#include "eq_dsp.h"     // Motor DSP do equalizador de N bandas
+#include "spsc_ring_buffer.h" // Fila lock-free entre quem escreve e quem drena os períodos
+#include "render_thread.h" // Thread de renderização acordada por prazo absoluto
+#include "eq_params.h"  // Snapshots de parâmetros do equalizador (buffer triplo)
+#include "hal_metrics.h" // Contadores e histogramas de latência lock-free
+#include "audio_mixer.h" // Kernels SIMD de mistura e volume com saturação
+#include "pcm_format.h" // Conversão especializada por formato e canais dos streams
+#include "resampler.h"  // Conversor de taxa polifásico dos streams fora de HAL_SAMPLE_RATE
+#include "hal_pool.h"   // Pool estático dos dispositivos (sem malloc/free)
+#include "hal_alloc_guard.h" // Aborta em builds Debug se o caminho de áudio alocar
+#include "worker_pool.h" // Workers fixos das cadeias DSP das zonas
+#include "dynamics.h"   // Compensação por velocidade e limitador com look-ahead
+#include "hal_trace.h"  // Marcadores de trace por etapa (com HAL_TRACE)
 
-// Métodos comuns para todos os módulos de hardware.
-// Contém o método 'open', que é o ponto de entrada principal para obter uma instância de um dispositivo HAL.
-struct hw_module_methods_t {
-    // Função para abrir um dispositivo de hardware específico dentro do módulo.
-    // Parâmetros: ponteiro para o módulo, ID do dispositivo (ex: "primary"), e ponteiro para preencher com o dispositivo aberto.
-    int (*open)(const struct hw_module_t* module, const char* id, struct hw_device_t** device);
-};
 
-// Estrutura comum para todos os dispositivos de hardware.
-// Define a interface básica que um dispositivo HAL deve ter.
-struct hw_device_t {
-    uint32_t tag;               // Identificador único da estrutura (ex: HARDWARE_DEVICE_TAG)
-    uint32_t version;           // Versão da interface do dispositivo
-    struct hw_module_t* module; // Ponteiro de volta para o módulo ao qual este dispositivo pertence
-    int (*close)(struct hw_device_t* device); // Função para fechar e liberar o dispositivo
-    void* reserved[32-4];       // Campos reservados para uso futuro
-};
+// --- Estrutura Personalizada do Dispositivo de Áudio ---
+// Esta estrutura estende a 'audio_hw_device_t' com campos adicionais
+// para controle de estado da simulação.
+// Ela DEVE VIR DEPOIS da definição de 'audio_hw_device_t' para que o tipo seja reconhecido.
 
-// Estrutura específica do dispositivo de áudio.
-// Estende a estrutura genérica 'hw_device_t' com operações específicas de áudio.
-// 'audio_hw_device_t' é um alias (typedef) para 'struct audio_hw_device'.
-typedef struct audio_hw_device {
-    struct hw_device_t common; // Membro comum, herdando as propriedades e métodos de 'hw_device_t'
+// Capacidade da fila de cada stream: 16 KiB = 4096 frames estéreo (~85 ms a 48 kHz).
+// Precisa ser potência de dois (ver spsc_ring_buffer.h).
+#define HAL_RING_BYTES 16384
+// Índice do stream primário, aberto pelo próprio dispositivo e usado por 'write'.
+#define HAL_PRIMARY_STREAM 0
+// Dispositivos abertos ao mesmo tempo (blocos do pool estático do módulo). O
+// renderizador offline abre um por thread, mais o que carrega o estado.
+#define HAL_MAX_DEVICES 8
+// Janela do conversor de taxa de cada stream: blocos de EQ_BLOCK_FRAMES frames
+// de saída com entrada de até RESAMPLER_MAX_RATE.
+#define HAL_RESAMPLE_WINDOW_FRAMES RESAMPLER_WINDOW_FRAMES(EQ_BLOCK_FRAMES, RESAMPLER_MAX_RATE / HAL_SAMPLE_RATE)
+// Tempo máximo que 'close_output_stream' espera a thread de renderização
+// terminar o período em andamento (bem acima do maior período, 20 ms).
+#define HAL_STREAM_CLOSE_TIMEOUT_NS 200000000LL
+// Workers das cadeias DSP das zonas, além da própria thread de renderização:
+// com AUDIO_MAX_ZONES zonas, cada uma das quatro threads processa duas.
+#define HAL_ZONE_WORKERS 3
+// Volume do veículo (AUDIO_VEHICLE_PARAM_MASTER_VOLUME): 0..100 em uma curva em dB,
+// como os controles de volume do Android, para que cada passo soe como um
+// incremento parecido: 100 = 0 dB, 1 = -59,4 dB, 0 = mudo.
+#define HAL_VEHICLE_VOLUME_MAX 100.0f
+#define HAL_VEHICLE_VOLUME_RANGE_DB 60.0f
+// Velocidade aceita por AUDIO_VEHICLE_PARAM_SPEED_KMH.
+#define HAL_VEHICLE_SPEED_MAX_KMH 500.0f
 
-    // Operações específicas de áudio.
-    // Para esta simulação, apenas a função 'write' (simulando a saída de áudio) é implementada.
-    int (*write)(struct audio_hw_device* dev, const void* buffer, size_t bytes);
+// Dinâmica padrão (desligada): +4 dB, +6 dB de graves e +3 dB de agudos a 120 km/h;
+// teto de -1 dBFS com recuperação de 200 ms.
+static const audio_dynamics_config_t kDefaultDynamics = { false, 120.0f, 4.0f, 6.0f, 3.0f, -1.0f, 200.0f };
 
-    void* reserved[32 - 1]; // Campos reservados para outras funções de áudio não simuladas
-} audio_hw_device_t;
+struct custom_audio_device;
 
-// Estrutura para o módulo de áudio.
-// Usada para definir o símbolo HAL_MODULE_INFO_SYM que o Android procura em bibliotecas compartilhadas.
-// 'audio_module_t' é um alias (typedef) para 'struct audio_module'.
-typedef struct audio_module {
-    struct hw_module_t common; // Membro comum, herdando as propriedades de 'hw_module_t'
-} audio_module_t;
+// --- Stream de Saída ---
+// Cada stream tem sua própria fila SPSC (produtor: o cliente do stream,
+// consumidor: a thread de renderização) e seu próprio ganho. Os slots são
+// pré-alocados no dispositivo, então abrir e fechar streams não aloca memória.
+typedef struct {
+    audio_stream_out_t stream;          // Interface pública (primeiro membro: permite o cast)
+    struct custom_audio_device* dev;    // Dispositivo dono do stream
+    int index;                          // Posição em 'streams' (bit em 'stream_mask')
+    audio_usage_t usage;
+    int priority;                       // Prioridade de ducking
+    std::atomic<float> gain;            // Ganho pedido pelo cliente (escrito por qualquer thread)
+    // Estado da thread de renderização:
+    float applied_gain;                 // Ganho efetivo ao fim do último período (inclui ducking)
+    bool playing;                       // Entregou um período completo no período anterior
+    // Formato do PCM do cliente: kernels escolhidos na abertura e tamanho do frame.
+    const pcm_kernels_t* kernels;
+    size_t frame_bytes;
+    // Um frame partido pelo fim físico da fila (só com frames de tamanho que não
+    // divide a capacidade, ex: 24 bits) é copiado para cá antes da conversão.
+    alignas(16) uint8_t straddle[AUDIO_MAX_STREAM_CHANNELS * sizeof(float)];
+    // Conversão de taxa (stream fora de HAL_SAMPLE_RATE). As tabelas vêm do cache
+    // do módulo; o estado e a janela pertencem à thread de renderização.
+    bool resampling;
+    resampler_t resampler;
+    alignas(HAL_CACHE_LINE_SIZE) float resample_window[HAL_RESAMPLE_WINDOW_FRAMES * HAL_CHANNELS];
+    // Fila do stream. Com uma região compartilhada, só as posições ficam no
+    // cabeçalho dela; os dados são o restante da região em vez de 'ring_storage'.
+    spsc_ring_t ring;
+    // Armazenamento da fila interna (alinhado à linha de cache).
+    alignas(HAL_CACHE_LINE_SIZE) uint8_t ring_storage[HAL_RING_BYTES];
+} hal_stream_t;
 
-// Macros e Constantes cruciais para a identificação e versão das HALs.
-#define HARDWARE_MODULE_TAG        0x4D4F4455 // "MODU" - Tag para módulos de hardware (ASCII para MODU)
-#define HARDWARE_DEVICE_TAG        0x44455649 // "DEVI" - Tag para dispositivos de hardware (ASCII para DEVI)
+// O cabeçalho da região compartilhada guarda só as posições da fila; ponteiro,
+// capacidade e máscara ficam no spsc_ring_t do stream, fora do alcance do
+// cliente (ver AUDIO_SHARED_PCM_* em audio_hal.h).
+static_assert(sizeof(spsc_ring_positions_t) <= AUDIO_SHARED_PCM_HEADER_BYTES, "cabeçalho compartilhado");
+static_assert(offsetof(spsc_ring_positions_t, write_pos) == AUDIO_SHARED_PCM_WRITE_POS_OFFSET, "posição de escrita");
+static_assert(offsetof(spsc_ring_positions_t, read_pos) == AUDIO_SHARED_PCM_READ_POS_OFFSET, "posição de leitura");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "posições compartilhadas precisam ser uint32 lock-free");
 
-#define AUDIO_DEVICE_API_VERSION_2_0 0x02000000 // Versão da API do dispositivo de áudio (Major 2, Minor 0)
+// --- Zona de Saída ---
+// Cadeia DSP de uma zona: equalizador, volume e conversão para 16 bits sobre a
+// mistura compartilhada do período. O estado pertence a quem processa a zona no
+// período (a thread de renderização ou um worker); a barreira do fim de cada
+// período ordena os acessos de um período para o outro. Cada zona ocupa suas
+// próprias linhas de cache, então zonas vizinhas não disputam linhas.
+typedef struct {
+    // --- Equalizador ---
+    // As threads de UI/Binder calculam os coeficientes e publicam um snapshot
+    // completo em 'eq_params'; a zona o adota na fronteira do período seguinte,
+    // com uma rampa de coeficientes de um período para não gerar cliques.
+    eq_state_t eq;
+    eq_param_store_t eq_params;
+    bool eq_active;           // Cascata sendo aplicada (inclui o crossfade de desligamento)
+    float eq_mix;             // Ganho de mistura atual: 0 = só original, 1 = só processado
+    float eq_mix_step;        // Incremento de 'eq_mix' por frame durante um crossfade
+    size_t eq_mix_remaining;  // Frames restantes do crossfade (0 = nenhum)
+    const eq_params_t* eq_next_layout; // Snapshot com outro número de bandas, adotado ao fim do fade-out (ou NULL)
 
-#define AUDIO_HARDWARE_MODULE_ID   "audio"    // ID padrão para o módulo HAL de áudio (usado por hw_get_module)
-#define AUDIO_HARDWARE_INTERFACE   "primary"  // Nome da interface primária de áudio (comum para áudio)
+    std::atomic<float> volume;  // Volume da zona pedido (qualquer thread)
+    float applied_gain;         // Volume da zona x volume mestre (x ganho por velocidade) ao fim do último período
 
-// --- Fim das Definições Injetadas ---
+    // --- Dinâmica (com 'dynamics.enabled' do dispositivo) ---
+    eq_state_t loudness;        // Equalizador de loudness (coeficientes da tabela do dispositivo)
+    int loudness_step;          // Degrau da tabela em uso
+    dyn_limiter_t limiter;
+    audio_sink_fn sink;         // Destino dos períodos da zona (NULL = descartar)
+    void* sink_cookie;
 
+    alignas(HAL_CACHE_LINE_SIZE) float work_buffer[EQ_BLOCK_FRAMES * HAL_CHANNELS];
+    alignas(HAL_CACHE_LINE_SIZE) float dry_buffer[EQ_BLOCK_FRAMES * HAL_CHANNELS]; // Sinal original durante crossfades
+    alignas(HAL_CACHE_LINE_SIZE) int16_t period_buffer[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+} hal_zone_t;
 
-// --- Estrutura Personalizada do Dispositivo de Áudio ---
-// Esta estrutura estende a 'audio_hw_device_t' com campos adicionais
-// para controle de estado da simulação.
-// Ela DEVE VIR DEPOIS da definição de 'audio_hw_device_t' para que o tipo seja reconhecido.
-typedef struct {
+typedef struct custom_audio_device {
     audio_hw_device_t device; // Estrutura padrão do Android HAL, a ser preenchida e usada
     bool is_initialized;      // Flag para indicar se o dispositivo foi inicializado
-    int error_count;          // Contador para simular erros (usado em passos futuros da atividade)
+
+    // --- Streams de Saída (produtores: clientes, consumidor: thread de renderização) ---
+    // 'write' de cada stream apenas enfileira e retorna, sem bloquear a thread JNI/Binder.
+    // Quando uma fila está cheia ou vazia, o evento é contado em vez de esperar.
+    // 'stream_mask' publica para a thread de renderização quais slots estão abertos;
+    // 'allocated_mask' (protegido por 'control_lock') também inclui os slots que
+    // estão sendo fechados e ainda não podem ser reutilizados.
+    hal_stream_t streams[AUDIO_MAX_OUTPUT_STREAMS];
+    std::atomic<uint32_t> stream_mask;
+    uint32_t allocated_mask;
+    // Incrementado ao fim de cada período; 'close_output_stream' espera uma
+    // mudança para saber que a thread não lê mais o stream removido da máscara.
+    std::atomic<uint64_t> render_epoch;
+
+    // --- Volume Mestre (controlado pela mensagem CAN 0x123) ---
+    std::atomic<float> master_volume;   // Volume pedido (qualquer thread)
+
+    // --- Parâmetros do Veículo (ver 'set_vehicle_params') ---
+    // Último valor publicado de cada sinal, em unidades físicas.
+    std::atomic<float> vehicle_params[AUDIO_VEHICLE_PARAM_COUNT];
+
+    // --- Métricas ---
+    // Substituem o log por chamada no caminho de áudio: bytes/frames, underruns,
+    // overruns e histogramas de latência de 'write' e do processamento por período.
+    hal_metrics_t metrics;
+
+    // --- Thread de Renderização ---
+    // As operações de controle (start/stop, período, sink) são serializadas por
+    // 'control_lock' e só alteram 'period_frames', os sinks e as zonas com a thread parada.
+    pthread_mutex_t control_lock;
+    render_thread_t render_thread;
+    size_t period_frames;       // Frames drenados por período
+
+    // --- Standby (ver 'set_standby_delay') ---
+    std::atomic<uint32_t> standby_delay_ms;  // 0 = sem standby
+    uint64_t idle_frames;       // Frames renderizados sem dados (thread de renderização)
+    // Leitura anterior de 'get_render_stats', para os despertares por segundo.
+    uint64_t stats_wakeups;
+    uint64_t stats_time_ns;
+
+    // --- Zonas ---
+    // A mistura dos streams é feita uma vez por período em 'mix_buffer'; as
+    // cadeias das zonas a leem em paralelo no pool fixo 'zone_workers' (criado
+    // por 'set_zone_count', nunca por período) e a barreira do pool fecha o período.
+    hal_zone_t zones[AUDIO_MAX_ZONES];
+    int zone_count;             // Zonas renderizadas (só muda com a thread parada)
+    worker_pool_t zone_workers;
+    // Período em andamento, lido pelas zonas (publicado pela barreira):
+    size_t render_frames;
+    int16_t* render_out;        // Saída da zona 0
+    float master_target;        // Volume mestre ao fim do período
+    float speed_gain;           // Ganho por velocidade do período (1 com a dinâmica desligada)
+    int loudness_step;          // Degrau de loudness do período
+
+    // --- Dinâmica (ver 'set_dynamics_config'; só muda com a thread parada) ---
+    audio_dynamics_config_t dynamics;
+    dyn_loudness_table_t loudness_table;
+
+    // --- Layout do Equalizador (ver 'set_eq_layout') ---
+    // Cache de coeficientes de todos os níveis de cada banda e os níveis de cada
+    // preset no layout. Só são lidos com o lock de escritores de alguma zona e
+    // só são trocados com os de todas as zonas: quem publica nunca vê um layout
+    // pela metade, e a thread de áudio nunca os lê.
+    eq_coeff_table_t eq_table;
+    int eq_preset_levels[AUDIO_EQ_PRESET_COUNT][AUDIO_EQ_MAX_BANDS];
+
+    // Buffers de trabalho embutidos no dispositivo (que vem do pool estático),
+    // alinhados à linha de cache: a renderização não aloca memória.
+    alignas(HAL_CACHE_LINE_SIZE) float mix_buffer[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+    alignas(HAL_CACHE_LINE_SIZE) float resample_buffer[EQ_BLOCK_FRAMES * HAL_CHANNELS]; // Saída do conversor de taxa
+    const pcm_kernels_t* mix_kernels; // Soma de float estéreo (saída do conversor) na mistura
 } custom_audio_device_t;
 
+// Todos os dispositivos, com seus slots de stream, filas e buffers de período,
+// vêm deste pool, reservado quando a biblioteca é carregada.
+HAL_POOL_DEFINE(g_device_pool, custom_audio_device_t, HAL_MAX_DEVICES);
+
 
 // --- Funções da HAL de Áudio Simulada ---
 // Estas funções implementam o comportamento da sua HAL.
@@ -149,27 +287,136 @@ typedef struct {
 static int audio_close(hw_device_t* device) {
     custom_audio_device_t* dev = (custom_audio_device_t*)device;
     if (dev) {
-        free(dev); // Libera a memória alocada para a estrutura custom_audio_device_t
+        // A thread de renderização referencia o dispositivo: precisa parar antes de devolvê-lo ao pool.
+        pthread_mutex_lock(&dev->control_lock);
+        render_thread_stop(&dev->render_thread);
+        worker_pool_stop(&dev->zone_workers);
+        pthread_mutex_unlock(&dev->control_lock);
+        pthread_mutex_destroy(&dev->control_lock);
+        for (int zone = 0; zone < AUDIO_MAX_ZONES; zone++) {
+            eq_params_destroy(&dev->zones[zone].eq_params);
+        }
+        hal_pool_free(&g_device_pool, dev); // Devolve o bloco do dispositivo ao pool do módulo
         ALOGD("AudioHAL: HAL de áudio liberada com sucesso."); // Log de depuração para o Logcat
     }
     return 0;
 }
 
 /**
- * Função para simular a escrita de dados de áudio na HAL.
- * Em uma HAL real, esta função processaria os dados de áudio recebidos (buffer e bytes).
- * Para esta simulação, ela apenas registra o "processamento" e pode simular falhas ou otimizações.
- * @param dev Um ponteiro para a estrutura do dispositivo de áudio que está processando a escrita.
- * @param buffer Um ponteiro para o buffer de dados de áudio a ser "processado".
- * @param bytes O número de bytes no buffer.
- * @return O número de bytes "processados" (simulando sucesso), ou um código de erro.
+ * Adota o snapshot de parâmetros mais recente publicado por outras threads.
+ * Executada por quem processa a zona na fronteira de cada período; não calcula
+ * trigonometria nem toma locks, apenas inicia as transições do período seguinte:
+ * - mudança de nível: rampa, por frame, dos coeficientes atuais para os novos;
+ * - desligar: crossfade do sinal processado para o original e só então bypass;
+ * - religar: estado zerado, coeficientes novos e crossfade do original para o processado;
+ * - novo layout (outro número de bandas): crossfade da cascata antiga para o
+ *   original e, no período seguinte ao fim dele, troca de cascata e crossfade do
+ *   original para a nova (não há rampa entre cascatas de tamanhos diferentes).
+ * As transições de liga/desliga são feitas pelo ganho de mistura e não por rampa
+ * de coeficientes porque o estado dos filtros de graves (polos perto de z = 1)
+ * leva centenas de frames para convergir, e o bypass abrupto depois disso clicaria.
+ * @param zone A zona cujo equalizador será atualizado.
+ * @param period_frames Duração das rampas, em frames.
  */
-static int audio_write(audio_hw_device_t* dev, const void* buffer, size_t bytes) {
-    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+static void apply_pending_eq_params(hal_zone_t* zone, size_t period_frames) {
+    // O snapshot consumido continua válido até o próximo consumo (slot do leitor).
+    const eq_params_t* params = eq_params_consume(&zone->eq_params);
+    if (!params) {
+        if (!zone->eq_next_layout || zone->eq_active) {
+            return; // Nada mudou desde o último período, ou o fade-out da cascata antiga continua
+        }
+        params = zone->eq_next_layout;
+    }
+    zone->eq_next_layout = NULL;
+    const float fade_step = 1.0f / (float)period_frames;
+
+    if (params->bands != zone->eq.bands) {
+        const size_t fade_out = zone->eq_active ? (size_t)(zone->eq_mix / fade_step + 0.5f) : 0;
+        if (fade_out > 0) {
+            // Primeiro a cascata antiga sai (coeficientes mantidos); a troca fica para depois.
+            zone->eq_next_layout = params;
+            zone->eq_mix_step = -fade_step;
+            zone->eq_mix_remaining = fade_out;
+            return;
+        }
+        eq_set_bands(&zone->eq, params->coeffs, params->bands);
+        zone->eq_active = false;
+        zone->eq_mix = 0.0f;
+        zone->eq_mix_remaining = 0;
+    }
+    if (params->enabled) {
+        if (!zone->eq_active) {
+            eq_reset(&zone->eq);
+            eq_ramp_to(&zone->eq, params->coeffs, 0);
+            zone->eq_active = true;
+            zone->eq_mix = 0.0f;
+        } else {
+            eq_ramp_to(&zone->eq, params->coeffs, period_frames);
+        }
+        if (zone->eq_mix < 1.0f) {
+            zone->eq_mix_step = fade_step;
+            zone->eq_mix_remaining = (size_t)((1.0f - zone->eq_mix) / fade_step + 0.5f);
+        }
+    } else if (zone->eq_active) {
+        eq_ramp_to(&zone->eq, params->coeffs, period_frames);
+        zone->eq_mix_step = -fade_step;
+        zone->eq_mix_remaining = (size_t)(zone->eq_mix / fade_step + 0.5f);
+    }
+}
+
+/**
+ * Processa um bloco já convertido para float pela cascata do equalizador,
+ * aplicando o crossfade de liga/desliga quando houver um em andamento.
+ * @param zone A zona (dona do estado do equalizador).
+ * @param work Bloco intercalado em float, processado no lugar.
+ * @param frames Frames no bloco (no máximo EQ_BLOCK_FRAMES).
+ */
+static void process_eq_block(hal_zone_t* zone, float* work, size_t frames) {
+    if (zone->eq_mix_remaining == 0) {
+        eq_process(&zone->eq, work, frames);
+        return;
+    }
+    const size_t samples = frames * HAL_CHANNELS;
+    memcpy(zone->dry_buffer, work, samples * sizeof(float));
+    eq_process(&zone->eq, work, frames);
+
+    const size_t n = frames < zone->eq_mix_remaining ? frames : zone->eq_mix_remaining;
+    eq_crossfade(work, zone->dry_buffer, n, HAL_CHANNELS, zone->eq_mix + zone->eq_mix_step, zone->eq_mix_step);
+    zone->eq_mix += zone->eq_mix_step * (float)n;
+    zone->eq_mix_remaining -= n;
+    if (zone->eq_mix_remaining == 0) {
+        // Fim do crossfade: fixa o valor exato e, se foi um desligamento, volta ao bypass.
+        zone->eq_mix = zone->eq_mix_step > 0.0f ? 1.0f : 0.0f;
+        if (zone->eq_mix == 0.0f) {
+            zone->eq_active = false;
+        }
+    }
+    // Após um desligamento concluído no meio do bloco, o resto é o sinal original.
+    if (n < frames && !zone->eq_active) {
+        memcpy(work + n * HAL_CHANNELS, zone->dry_buffer + n * HAL_CHANNELS,
+               (frames - n) * HAL_CHANNELS * sizeof(float));
+    }
+}
+
+/**
+ * Função de escrita de dados de áudio em um stream (lado produtor).
+ * Enfileira PCM intercalado (no formato do stream) na fila lock-free do stream e retorna
+ * imediatamente; a mistura e o processamento acontecem em 'render', um período por vez.
+ * Nunca bloqueia nem aloca: se a fila estiver cheia, aceita o que couber e conta um overrun.
+ * @param stream O stream de saída que recebe os dados.
+ * @param buffer Um ponteiro para o buffer de dados de áudio a ser enfileirado.
+ * @param bytes O número de bytes no buffer (frames incompletos no final são descartados).
+ * @return O número de bytes aceitos (pode ser menor que 'bytes'), ou um código de erro.
+ */
+static int stream_write(audio_stream_out_t* stream, const void* buffer, size_t bytes) {
+    HAL_NO_ALLOC_SCOPE();
+    hal_stream_t* hal_stream = (hal_stream_t*)stream;
+    HAL_TRACE_SCOPE_ARG("write", hal_stream->index);
+    custom_audio_device_t* custom_dev = hal_stream->dev;
 
     // Verifica se a HAL está inicializada antes de "processar" dados.
     if (!custom_dev->is_initialized) {
-        ALOGE("AudioHAL: Erro: HAL não inicializada!");
+        ALOGE_RATELIMITED("AudioHAL: Erro: HAL não inicializada!");
         return -ENODEV; // Retorna erro de dispositivo não encontrado (No Device)
     }
 
@@ -186,15 +433,1357 @@ static int audio_write(audio_hw_device_t* dev, const void* buffer, size_t bytes)
     }
     */
 
-    // --- Otimização de Energia (para o Passo 8 da atividade) ---
-    // Descomente esta linha quando for implementar o Passo 8.
-    // Ela simula um pequeno atraso para reduzir a frequência de polling da CPU
-    // e permitir que ela entre em estados de baixa energia mais frequentemente.
-    // usleep(1000); // Pausa por 1 milissegundo (1000 microssegundos)
+    // --- Otimização de Energia ---
+    // Em vez de um usleep() de polling aqui, o consumo é feito pela thread de
+    // renderização, que só acorda uma vez por período em um prazo absoluto
+    // (ver render_thread.h). A escrita em si nunca dorme nem bloqueia.
+
+    // Sem log por chamada: o "processamento" é contabilizado nas métricas.
+    const uint64_t start_ns = hal_metrics_now_ns();
+
+    // Enfileira apenas frames completos. Se o frame não for potência de dois, o
+    // espaço livre pode não ser múltiplo dele: a escrita é limitada antes do push.
+    const size_t stream_frame = hal_stream->frame_bytes;
+    size_t frame_bytes = (bytes / stream_frame) * stream_frame;
+    size_t limit = frame_bytes;
+    if (stream_frame & (stream_frame - 1)) {
+        const size_t free_frames = spsc_ring_writable(&hal_stream->ring) / stream_frame;
+        if (free_frames * stream_frame < limit) limit = free_frames * stream_frame;
+    }
+    const size_t queued = spsc_ring_push(&hal_stream->ring, buffer, limit);
+
+    // Os contadores de escrita são compartilhados pelos produtores de todos os streams.
+    hal_metrics_t* metrics = &custom_dev->metrics;
+    hal_counter_add_shared(&metrics->bytes_written, queued);
+    hal_counter_add_shared(&metrics->frames_written, queued / stream_frame);
+    if (queued < frame_bytes) {
+        hal_counter_add_shared(&metrics->overruns, 1);
+        ALOGI_RATELIMITED("AudioHAL: Overrun no stream %d: fila cheia, %zu de %zu bytes aceitos.",
+                          hal_stream->index, queued, frame_bytes);
+    }
+    hal_latency_record_shared(&metrics->write_latency, hal_metrics_now_ns() - start_ns);
+    // Em standby, a thread só volta por aqui (nenhum despertar periódico).
+    if (queued > 0) render_thread_wake(&custom_dev->render_thread);
+    return (int)queued; // Retorna o número de bytes aceitos pela fila
+}
+
+/**
+ * Publica frames que o produtor escreveu diretamente nos dados da fila (sem cópia).
+ * Usada com filas em memória compartilhada: o cliente escreve a partir da posição
+ * de escrita e só então chama 'commit', que publica os bytes com ordem de release.
+ * Publicar mais do que o espaço livre significa que o cliente sobrescreveu dados
+ * ainda não lidos: o excesso é descartado (em frames completos) e conta como overrun.
+ * @param bytes Bytes escritos; precisa ser múltiplo do tamanho de frame do stream.
+ * @return Espaço livre restante em bytes, ou -EINVAL / -ENODEV.
+ */
+static int stream_commit(audio_stream_out_t* stream, size_t bytes) {
+    HAL_NO_ALLOC_SCOPE();
+    hal_stream_t* hal_stream = (hal_stream_t*)stream;
+    HAL_TRACE_SCOPE_ARG("commit", hal_stream->index);
+    custom_audio_device_t* custom_dev = hal_stream->dev;
+    if (!custom_dev->is_initialized) {
+        ALOGE_RATELIMITED("AudioHAL: Erro: HAL não inicializada!");
+        return -ENODEV;
+    }
+    const size_t stream_frame = hal_stream->frame_bytes;
+    if (bytes % stream_frame != 0 || bytes > hal_stream->ring.capacity) {
+        return -EINVAL;
+    }
+    spsc_ring_t* ring = &hal_stream->ring;
+    const size_t free_frames = spsc_ring_writable(ring) / stream_frame;
+    const size_t queued = bytes < free_frames * stream_frame ? bytes : free_frames * stream_frame;
+    const size_t free_bytes = spsc_ring_commit(ring, queued);
+
+    hal_metrics_t* metrics = &custom_dev->metrics;
+    hal_counter_add_shared(&metrics->bytes_written, queued);
+    hal_counter_add_shared(&metrics->frames_written, queued / stream_frame);
+    if (queued < bytes) {
+        hal_counter_add_shared(&metrics->overruns, 1);
+        ALOGI_RATELIMITED("AudioHAL: Overrun no stream %d: commit de %zu bytes com %zu livres.",
+                          hal_stream->index, bytes, queued);
+    }
+    if (queued > 0) render_thread_wake(&custom_dev->render_thread);
+    return (int)free_bytes;
+}
+
+/**
+ * Função de escrita de dados de áudio na HAL: escreve no stream primário.
+ * Mantida para os clientes que não abrem streams próprios (ex: a camada JNI).
+ */
+static int audio_write(audio_hw_device_t* dev, const void* buffer, size_t bytes) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    return stream_write(&custom_dev->streams[HAL_PRIMARY_STREAM].stream, buffer, bytes);
+}
+
+/**
+ * Ajusta o ganho de um stream. A thread de renderização leva o ganho efetivo
+ * até o novo valor em uma rampa de um período.
+ * @param gain Ganho linear, limitado a 0..1.
+ * @return 0 em caso de sucesso, ou -EINVAL para um valor não numérico.
+ */
+static int stream_set_volume(audio_stream_out_t* stream, float gain) {
+    if (gain != gain) {
+        return -EINVAL; // NaN
+    }
+    hal_stream_t* hal_stream = (hal_stream_t*)stream;
+    hal_stream->gain.store(gain < 0.0f ? 0.0f : (gain > 1.0f ? 1.0f : gain), std::memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * Valida uma região compartilhada e monta a fila do stream sobre ela: o
+ * cabeçalho recebe as posições e os dados são a maior potência de dois que cabe
+ * depois dele. As posições começam em zero.
+ * @return 0 em caso de sucesso, ou -EINVAL para uma região desalinhada ou pequena demais.
+ */
+static int init_shared_ring(hal_stream_t* hal_stream, void* memory, size_t bytes) {
+    if ((uintptr_t)memory % AUDIO_SHARED_PCM_ALIGNMENT != 0 ||
+        bytes < AUDIO_SHARED_PCM_HEADER_BYTES + AUDIO_SHARED_PCM_MIN_BYTES) {
+        return -EINVAL;
+    }
+    size_t data_bytes = bytes - AUDIO_SHARED_PCM_HEADER_BYTES;
+    // Limitada a 1 GiB para que o espaço livre caiba no retorno 'int' de 'commit'.
+    if (data_bytes > (1u << 30)) data_bytes = 1u << 30;
+    uint32_t capacity = 1u << (31 - __builtin_clz((uint32_t)data_bytes));
+    spsc_ring_positions_t* positions = new (memory) spsc_ring_positions_t;
+    spsc_ring_init(&hal_stream->ring, positions, (uint8_t*)memory + AUDIO_SHARED_PCM_HEADER_BYTES, capacity);
+    return 0;
+}
+
+/**
+ * Prepara um slot de stream para uso. Chamado com o slot invisível para a
+ * thread de renderização (fora de 'stream_mask'). O formato já foi validado.
+ * @return 0 em caso de sucesso, -EINVAL para uma região compartilhada inválida,
+ *         ou o erro de resampler_init para uma taxa não suportada.
+ */
+static int init_stream(custom_audio_device_t* dev, int index, const audio_stream_config_t* config) {
+    hal_stream_t* hal_stream = &dev->streams[index];
+    if (config->shared_memory) {
+        int ret = init_shared_ring(hal_stream, config->shared_memory, config->shared_bytes);
+        if (ret != 0) {
+            ALOGE("AudioHAL: Erro: Região compartilhada inválida para o stream (%zu bytes).", config->shared_bytes);
+            return ret;
+        }
+    } else {
+        spsc_ring_init(&hal_stream->ring, NULL, hal_stream->ring_storage, HAL_RING_BYTES);
+    }
+    // Por último: é o único passo que pode falhar depois da fila (cache de tabelas cheio).
+    const uint32_t rate = config->sample_rate ? config->sample_rate : HAL_SAMPLE_RATE;
+    hal_stream->resampling = false;
+    if (rate != HAL_SAMPLE_RATE) {
+        int ret = resampler_init(&hal_stream->resampler, rate, HAL_SAMPLE_RATE, config->resampler_quality,
+                                 EQ_BLOCK_FRAMES, hal_stream->resample_window, HAL_RESAMPLE_WINDOW_FRAMES);
+        if (ret != 0) {
+            ALOGE("AudioHAL: Erro: Conversão de %u Hz com qualidade %d não suportada (%d).",
+                  rate, (int)config->resampler_quality, ret);
+            return ret;
+        }
+        hal_stream->resampling = true;
+        ALOGI("AudioHAL: Stream %d convertido de %u Hz (%s, %d taps, %zu frames de latência).", index, rate,
+              resampler_quality_name(hal_stream->resampler.quality), hal_stream->resampler.taps,
+              resampler_latency_frames(&hal_stream->resampler));
+    }
+    hal_stream->kernels = pcm_kernels_select(config->format, config->channels ? config->channels : HAL_CHANNELS);
+    hal_stream->frame_bytes = hal_stream->kernels->frame_bytes;
+    hal_stream->stream.write = stream_write;
+    hal_stream->stream.set_volume = stream_set_volume;
+    hal_stream->stream.commit = stream_commit;
+    hal_stream->dev = dev;
+    hal_stream->index = index;
+    hal_stream->usage = config->usage;
+    hal_stream->priority = config->priority;
+    hal_stream->gain.store(0.0f, std::memory_order_relaxed);
+    stream_set_volume(&hal_stream->stream, config->gain);
+    // Começa em silêncio: a primeira rampa leva o stream até o ganho pedido, sem clique.
+    hal_stream->applied_gain = 0.0f;
+    hal_stream->playing = false;
+    return 0;
+}
+
+/**
+ * Lê até 'frames' frames do stream (lado consumidor) e os soma em 'dst'
+ * (float estéreo), convertidos pelos kernels do formato, com o ganho
+ * g = gain + i * gain_step no frame i. Lê o PCM no lugar, direto da fila.
+ * @return Frames lidos (menos que 'frames' se a fila esvaziar).
+ */
+static size_t read_stream_frames(hal_stream_t* hal_stream, float* dst, size_t frames, float gain, float gain_step) {
+    HAL_TRACE_SCOPE_ARG("convert", hal_stream->index);
+    // No máximo dois trechos contíguos: antes e depois do wrap-around da fila
+    // (mais um frame partido entre eles, quando o frame não divide a capacidade).
+    const size_t stream_frame = hal_stream->frame_bytes;
+    size_t got = 0;
+    while (got < frames) {
+        const void* pcm;
+        const size_t avail = spsc_ring_peek(&hal_stream->ring, &pcm, (frames - got) * stream_frame);
+        const float g = gain + gain_step * (float)got;
+        size_t n = avail / stream_frame;
+        if (n == 0) {
+            // Stream sem dados não custa nada além do peek. O produtor só publica
+            // frames completos, então um resto não vazio é um frame partido.
+            if (avail == 0) break;
+            spsc_ring_pop(&hal_stream->ring, hal_stream->straddle, stream_frame);
+            hal_stream->kernels->accumulate(dst + got * HAL_CHANNELS, hal_stream->straddle, 1, g, gain_step);
+            got++;
+            continue;
+        }
+        hal_stream->kernels->accumulate(dst + got * HAL_CHANNELS, pcm, n, g, gain_step);
+        spsc_ring_consume(&hal_stream->ring, n * stream_frame);
+        got += n;
+    }
+    return got;
+}
+
+/**
+ * Como read_stream_frames, para um stream em outra taxa: completa a janela do
+ * conversor com os frames de entrada que faltam para 'frames' frames de saída,
+ * converte a taxa e soma a saída em 'dst' com o ganho do stream.
+ * @return Frames de saída produzidos (menos que 'frames' se a fila esvaziar).
+ */
+static size_t mix_resampled_stream(custom_audio_device_t* custom_dev, hal_stream_t* hal_stream, float* dst,
+                                   size_t frames, float gain, float gain_step) {
+    resampler_t* rs = &hal_stream->resampler;
+    const size_t needed = resampler_input_needed(rs, frames);
+    if (needed > 0) {
+        float* in = resampler_input_buffer(rs, needed);
+        resampler_commit_input(rs, read_stream_frames(hal_stream, in, needed, 1.0f, 0.0f));
+    }
+    float* out = custom_dev->resample_buffer;
+    size_t got;
+    {
+        HAL_TRACE_SCOPE_ARG("resample", hal_stream->index);
+        got = resampler_process(rs, out, frames);
+    }
+    custom_dev->mix_kernels->accumulate(dst, out, got, gain, gain_step);
+    return got;
+}
+
+/**
+ * Cadeia DSP de uma zona (tarefa do pool de workers): passa a mistura do
+ * período pelo equalizador da zona, aplica o volume da zona vezes o volume
+ * mestre e converte para 16 bits, em blocos de até EQ_BLOCK_FRAMES frames.
+ * Só lê 'mix_buffer'; o bloco é copiado para o buffer da zona apenas quando o
+ * equalizador está ativo. Não aloca memória nem bloqueia.
+ * @param cookie O dispositivo de áudio.
+ * @param index Índice da zona.
+ */
+static void render_zone(void* cookie, int index) {
+    HAL_NO_ALLOC_SCOPE();
+    HAL_TRACE_SCOPE_ARG("zone", index);
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)cookie;
+    hal_zone_t* zone = &custom_dev->zones[index];
+    const size_t frames = custom_dev->render_frames;
+    int16_t* out = index == 0 ? custom_dev->render_out : zone->period_buffer;
+    apply_pending_eq_params(zone, custom_dev->period_frames);
+
+    const bool dynamics = custom_dev->dynamics.enabled;
+    if (dynamics && zone->loudness_step != custom_dev->loudness_step) {
+        // Saindo do plano (onde o filtro não roda), o estado parado é descartado.
+        if (zone->loudness_step == 0 && !eq_is_ramping(&zone->loudness)) eq_reset(&zone->loudness);
+        zone->loudness_step = custom_dev->loudness_step;
+        eq_ramp_to(&zone->loudness, custom_dev->loudness_table.coeffs[zone->loudness_step],
+                   custom_dev->period_frames);
+    }
+    const bool loudness = dynamics && (zone->loudness_step > 0 || eq_is_ramping(&zone->loudness));
+
+    const float target = custom_dev->master_target * zone->volume.load(std::memory_order_relaxed) *
+                         custom_dev->speed_gain;
+    const float gain = zone->applied_gain;
+    const float gain_step = target == gain ? 0.0f : (target - gain) * (1.0f / (float)frames);
+    for (size_t done = 0; done < frames; ) {
+        size_t chunk = frames - done;
+        if (chunk > EQ_BLOCK_FRAMES) chunk = EQ_BLOCK_FRAMES;
+        const float* block = custom_dev->mix_buffer + done * HAL_CHANNELS;
+        const float block_gain = gain + gain_step * (float)done;
+        if (zone->eq_active || loudness) {
+            HAL_TRACE_SCOPE("eq");
+            memcpy(zone->work_buffer, block, chunk * HAL_CHANNELS * sizeof(float));
+            if (zone->eq_active) process_eq_block(zone, zone->work_buffer, chunk);
+            if (loudness) eq_process(&zone->loudness, zone->work_buffer, chunk);
+            block = zone->work_buffer;
+        }
+        if (dynamics) {
+            HAL_TRACE_SCOPE("limiter");
+            // O ganho entra antes do limitador, que garante o teto já na escala final.
+            dyn_limiter_process(&zone->limiter, block, zone->work_buffer, chunk, block_gain, gain_step);
+            mixer_apply_gain_to_s16(zone->work_buffer, out + done * HAL_CHANNELS, chunk, HAL_CHANNELS, 1.0f, 0.0f);
+        } else {
+            mixer_apply_gain_to_s16(block, out + done * HAL_CHANNELS, chunk, HAL_CHANNELS, block_gain, gain_step);
+        }
+        done += chunk;
+    }
+    zone->applied_gain = target;
+}
+
+/**
+ * Drena um período de todos os streams abertos (lado consumidor) e produz a saída
+ * de cada zona.
+ * 1. Em blocos de até EQ_BLOCK_FRAMES frames, mistura os streams com dados no
+ *    acumulador float do período, cada um com seu ganho (incluindo o ducking), em
+ *    uma passada SIMD por stream que lê o PCM no lugar, direto da fila (sem cópia
+ *    intermediária, também para filas compartilhadas); streams em outra taxa
+ *    passam antes pelo conversor polifásico.
+ * 2. Executa a cadeia de cada zona (equalizador, volume, 16 bits com saturação)
+ *    sobre a mesma mistura, em paralelo no pool de workers, e espera a barreira.
+ *    Com as zonas divididas entre as threads, o tempo do período cresce com
+ *    zonas / threads e não com o número de zonas.
+ * Mudanças de ganho, ducking e volume viram rampas lineares de um período.
+ * Um stream que tocava e ficou sem frames suficientes conta um underrun; a falta
+ * é preenchida com silêncio. Não aloca memória nem bloqueia.
+ * @param custom_dev O dispositivo de áudio.
+ * @param out Buffer de saída da zona 0 (PCM 16 bits estéreo intercalado); as
+ *        demais zonas escrevem em seus próprios buffers de período.
+ * @param frames Tamanho do período em frames (no máximo HAL_MAX_PERIOD_FRAMES).
+ * @return true se algum stream entregou frames no período.
+ */
+static bool render_period(custom_audio_device_t* custom_dev, int16_t* out, size_t frames) {
+    HAL_NO_ALLOC_SCOPE();
+    HAL_TRACE_SCOPE("period");
+    const uint64_t start_ns = hal_metrics_now_ns();
+    hal_metrics_t* metrics = &custom_dev->metrics;
+
+    const uint32_t mask = custom_dev->stream_mask.load(std::memory_order_seq_cst);
+    const float inv_frames = 1.0f / (float)frames;
+
+    // Ducking: a maior prioridade entre os streams que têm dados neste período.
+    int top_priority = INT_MIN;
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        const hal_stream_t* hal_stream = &custom_dev->streams[i];
+        if ((mask & (1u << i)) && spsc_ring_readable(&hal_stream->ring) > 0 &&
+            hal_stream->priority > top_priority) {
+            top_priority = hal_stream->priority;
+        }
+    }
+
+    // Ganho alvo de cada stream ao fim do período e o incremento por frame até ele.
+    float target_gain[AUDIO_MAX_OUTPUT_STREAMS];
+    float gain_step[AUDIO_MAX_OUTPUT_STREAMS];
+    size_t got_frames[AUDIO_MAX_OUTPUT_STREAMS];
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        if (!(mask & (1u << i))) continue;
+        const hal_stream_t* hal_stream = &custom_dev->streams[i];
+        float target = hal_stream->gain.load(std::memory_order_relaxed);
+        if (hal_stream->priority < top_priority) {
+            target *= AUDIO_DUCK_GAIN;
+        }
+        target_gain[i] = target;
+        gain_step[i] = target == hal_stream->applied_gain ? 0.0f : (target - hal_stream->applied_gain) * inv_frames;
+        got_frames[i] = 0;
+    }
+
+    // Mistura compartilhada por todas as zonas, em blocos que cabem no cache L1.
+    memset(custom_dev->mix_buffer, 0, frames * HAL_CHANNELS * sizeof(float));
+    {
+        HAL_TRACE_SCOPE("mix");
+        for (size_t done = 0; done < frames; ) {
+            size_t chunk = frames - done;
+            if (chunk > EQ_BLOCK_FRAMES) chunk = EQ_BLOCK_FRAMES;
+            float* mix = custom_dev->mix_buffer + done * HAL_CHANNELS;
+
+            for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+                if (!(mask & (1u << i))) continue;
+                hal_stream_t* hal_stream = &custom_dev->streams[i];
+                const float gain = hal_stream->applied_gain + gain_step[i] * (float)done;
+                const size_t got = hal_stream->resampling
+                        ? mix_resampled_stream(custom_dev, hal_stream, mix, chunk, gain, gain_step[i])
+                        : read_stream_frames(hal_stream, mix, chunk, gain, gain_step[i]);
+                got_frames[i] += got;
+            }
+            done += chunk;
+        }
+    }
+
+    // Cadeias das zonas: a thread atual também processa zonas e só segue depois
+    // que todas terminaram.
+    custom_dev->render_frames = frames;
+    custom_dev->render_out = out;
+    custom_dev->master_target = custom_dev->master_volume.load(std::memory_order_relaxed);
+    if (custom_dev->dynamics.enabled) {
+        // Compensação da velocidade publicada (ex: pela CAN), igual para todas as zonas.
+        const float fraction = dyn_speed_fraction(
+                &custom_dev->dynamics,
+                custom_dev->vehicle_params[AUDIO_VEHICLE_PARAM_SPEED_KMH].load(std::memory_order_relaxed));
+        custom_dev->speed_gain = powf(10.0f, fraction * custom_dev->dynamics.speed_gain_db / 20.0f);
+        custom_dev->loudness_step = (int)(fraction * DYN_LOUDNESS_STEPS + 0.5f);
+    }
+    {
+        HAL_TRACE_SCOPE("zones"); // Na thread atual, inclui a espera da barreira
+        worker_pool_run(&custom_dev->zone_workers, render_zone, custom_dev, custom_dev->zone_count);
+    }
+
+    // Fim das rampas e contagem de underruns por stream.
+    bool had_input = false;
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        if (!(mask & (1u << i))) continue;
+        hal_stream_t* hal_stream = &custom_dev->streams[i];
+        had_input |= got_frames[i] > 0;
+        hal_stream->applied_gain = target_gain[i];
+        if (hal_stream->playing && got_frames[i] < frames) {
+            hal_counter_add(&metrics->underruns, 1);
+        }
+        hal_stream->playing = got_frames[i] == frames;
+    }
+
+    hal_counter_add(&metrics->frames_rendered, frames);
+    hal_counter_add(&metrics->periods_rendered, 1);
+    hal_latency_record(&metrics->process_latency, hal_metrics_now_ns() - start_ns);
+    // Publica o fim do período (e de todas as leituras dos streams da máscara acima).
+    custom_dev->render_epoch.fetch_add(1, std::memory_order_seq_cst);
+    return had_input;
+}
+
+/**
+ * Entrega os períodos das zonas 1.. aos seus sinks (a zona 0 é entregue por
+ * quem renderizou, ou já está no buffer de 'render').
+ */
+static void deliver_zone_periods(custom_audio_device_t* custom_dev, size_t frames) {
+    for (int i = 1; i < custom_dev->zone_count; i++) {
+        const hal_zone_t* zone = &custom_dev->zones[i];
+        if (zone->sink) {
+            HAL_TRACE_SCOPE_ARG("sink", i);
+            zone->sink(zone->sink_cookie, zone->period_buffer, frames * HAL_FRAME_SIZE);
+        }
+    }
+}
+
+// --- Standby ---
+
+/**
+ * Indica se algum stream aberto tem frames na fila.
+ */
+static bool streams_have_data(const custom_audio_device_t* custom_dev) {
+    const uint32_t mask = custom_dev->stream_mask.load(std::memory_order_seq_cst);
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        if ((mask & (1u << i)) && spsc_ring_readable(&custom_dev->streams[i].ring) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Libera o estado de processamento antes do standby e deixa pronto o do
+ * primeiro período depois dele: filtros (equalizador, loudness, conversores de
+ * taxa) zerados, que é o estado exato de um filtro que só recebeu silêncio;
+ * limitador sem redução; streams em silêncio, para entrarem com a rampa de
+ * ganho de um período. Como a entrada dos filtros sobe a partir de zero junto
+ * com a rampa, a volta não tem clique. Coeficientes, tabelas e parâmetros
+ * pendentes ficam: a volta não calcula nada.
+ */
+static void release_render_state(custom_audio_device_t* custom_dev) {
+    HAL_TRACE_SCOPE("standby");
+    const uint32_t mask = custom_dev->stream_mask.load(std::memory_order_seq_cst);
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        if (!(mask & (1u << i))) continue;
+        hal_stream_t* hal_stream = &custom_dev->streams[i];
+        hal_stream->applied_gain = 0.0f;
+        hal_stream->playing = false;
+        if (hal_stream->resampling) resampler_reset(&hal_stream->resampler);
+    }
+    for (int z = 0; z < custom_dev->zone_count; z++) {
+        hal_zone_t* zone = &custom_dev->zones[z];
+        eq_reset(&zone->eq);
+        eq_reset(&zone->loudness);
+        if (custom_dev->dynamics.enabled) {
+            dyn_limiter_reset(&zone->limiter, &custom_dev->dynamics, (float)HAL_SAMPLE_RATE);
+        }
+    }
+}
+
+/**
+ * Conta o período sem dados e, passado o atraso configurado, pede o standby.
+ * Chamada pela thread de renderização ao fim de cada período.
+ */
+static void update_standby(custom_audio_device_t* custom_dev, bool had_input) {
+    if (had_input) {
+        custom_dev->idle_frames = 0;
+        return;
+    }
+    custom_dev->idle_frames += custom_dev->period_frames;
+    const uint32_t delay_ms = custom_dev->standby_delay_ms.load(std::memory_order_relaxed);
+    if (delay_ms == 0 || custom_dev->idle_frames < (uint64_t)delay_ms * HAL_SAMPLE_RATE / 1000) {
+        return;
+    }
+    render_thread_enter_standby(&custom_dev->render_thread);
+    // Um 'write' concluído antes do pedido não acorda a thread: desiste se há dados.
+    if (streams_have_data(custom_dev)) {
+        render_thread_cancel_standby(&custom_dev->render_thread);
+        return;
+    }
+    // 'idle_frames' continua acima do atraso: um despertar sem dados (ex: para
+    // fechar um stream) rende um período e volta direto ao standby.
+    release_render_state(custom_dev);
+}
+
+/**
+ * Callback da thread de renderização: um período por despertar.
+ * Drena e processa o período nos buffers pré-alocados das zonas e os entrega aos sinks.
+ * @param cookie O dispositivo de áudio dono da thread.
+ */
+static void render_thread_period(void* cookie) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)cookie;
+    hal_zone_t* main_zone = &custom_dev->zones[0];
+    const bool had_input = render_period(custom_dev, main_zone->period_buffer, custom_dev->period_frames);
+    if (main_zone->sink) {
+        HAL_TRACE_SCOPE_ARG("sink", 0);
+        main_zone->sink(main_zone->sink_cookie, main_zone->period_buffer,
+                        custom_dev->period_frames * HAL_FRAME_SIZE);
+    }
+    deliver_zone_periods(custom_dev, custom_dev->period_frames);
+    update_standby(custom_dev, had_input);
+}
+
+/**
+ * Inicia a thread de renderização com o período atual. Requer 'control_lock'.
+ */
+static int start_render_thread_locked(custom_audio_device_t* custom_dev) {
+    const uint32_t period_us = (uint32_t)(custom_dev->period_frames * 1000000 / HAL_SAMPLE_RATE);
+    int ret = render_thread_start(&custom_dev->render_thread, period_us, render_thread_period, custom_dev);
+    if (ret != 0 && ret != -EALREADY) {
+        ALOGE("AudioHAL: Erro ao iniciar a thread de renderização: %d", ret);
+        return ret;
+    }
+    return 0;
+}
+
+/**
+ * Drena um período manualmente (apenas com a thread de renderização parada).
+ * Útil para testes e para renderização offline, sem ritmo de tempo real.
+ * Pedidos maiores que HAL_MAX_PERIOD_FRAMES são renderizados em vários períodos;
+ * as zonas 1.. são entregues aos seus sinks a cada período.
+ * @param dev O dispositivo de áudio.
+ * @param out Buffer de saída da zona 0 (PCM 16 bits estéreo intercalado).
+ * @param bytes Tamanho do período em bytes (frames incompletos são ignorados).
+ * @return O número de bytes escritos em 'out', -EBUSY se a thread de renderização
+ *         estiver consumindo a fila, ou outro código de erro.
+ */
+static int audio_render(audio_hw_device_t* dev, void* out, size_t bytes) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (!custom_dev->is_initialized) {
+        return -ENODEV;
+    }
+    if (render_thread_is_running(&custom_dev->render_thread)) {
+        return -EBUSY; // A fila só pode ter um consumidor
+    }
+    const size_t frames = bytes / HAL_FRAME_SIZE;
+    int16_t* pcm = (int16_t*)out;
+    for (size_t done = 0; done < frames; ) {
+        size_t chunk = frames - done;
+        if (chunk > HAL_MAX_PERIOD_FRAMES) chunk = HAL_MAX_PERIOD_FRAMES;
+        render_period(custom_dev, pcm + done * HAL_CHANNELS, chunk);
+        deliver_zone_periods(custom_dev, chunk);
+        done += chunk;
+    }
+    return (int)(frames * HAL_FRAME_SIZE);
+}
+
+/**
+ * Inicia a thread de renderização (já iniciada por 'open'; útil após 'stop_render_thread').
+ * @return 0 em caso de sucesso, ou um código de erro.
+ */
+static int audio_start_render_thread(audio_hw_device_t* dev) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    pthread_mutex_lock(&custom_dev->control_lock);
+    int ret = start_render_thread_locked(custom_dev);
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    return ret;
+}
+
+/**
+ * Para a thread de renderização, aguardando o fim do período em andamento.
+ * Depois disso a fila pode ser drenada manualmente com 'render'.
+ * @return 0 em caso de sucesso.
+ */
+static int audio_stop_render_thread(audio_hw_device_t* dev) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    pthread_mutex_lock(&custom_dev->control_lock);
+    render_thread_stop(&custom_dev->render_thread);
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    return 0;
+}
+
+/**
+ * Altera o tamanho do período da thread de renderização.
+ * Períodos maiores reduzem despertares (CPU); menores reduzem latência.
+ * @param frames Novo período em frames (HAL_MIN_PERIOD_FRAMES..HAL_MAX_PERIOD_FRAMES).
+ * @return 0 em caso de sucesso, ou -EINVAL para tamanho fora da faixa.
+ */
+static int audio_set_period_size(audio_hw_device_t* dev, size_t frames) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (frames < HAL_MIN_PERIOD_FRAMES || frames > HAL_MAX_PERIOD_FRAMES) {
+        ALOGE("AudioHAL: Erro: Período de %zu frames fora da faixa.", frames);
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    const bool was_running = render_thread_is_running(&custom_dev->render_thread);
+    render_thread_stop(&custom_dev->render_thread);
+    custom_dev->period_frames = frames;
+    int ret = was_running ? start_render_thread_locked(custom_dev) : 0;
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    ALOGI("AudioHAL: Período ajustado para %zu frames.", frames);
+    return ret;
+}
+
+/**
+ * Ajusta o tempo sem dados antes do standby. Vale a partir do próximo período;
+ * não é preciso parar a thread.
+ * @param delay_ms Atraso em milissegundos (0 desliga o standby).
+ * @return 0.
+ */
+static int audio_set_standby_delay(audio_hw_device_t* dev, uint32_t delay_ms) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    custom_dev->standby_delay_ms.store(delay_ms, std::memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * Registra o destino dos períodos processados.
+ * A thread é parada durante a troca para que nunca veja um par sink/cookie misturado.
+ * @param sink Função chamada com cada período, ou NULL para descartar o áudio.
+ * @param cookie Argumento repassado ao sink.
+ * @return 0 em caso de sucesso.
+ */
+static int audio_set_output_sink(audio_hw_device_t* dev, audio_sink_fn sink, void* cookie) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    pthread_mutex_lock(&custom_dev->control_lock);
+    const bool was_running = render_thread_is_running(&custom_dev->render_thread);
+    render_thread_stop(&custom_dev->render_thread);
+    custom_dev->zones[0].sink = sink;
+    custom_dev->zones[0].sink_cookie = cookie;
+    int ret = was_running ? start_render_thread_locked(custom_dev) : 0;
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    return ret;
+}
+
+/**
+ * Lê as estatísticas de despertar (jitter) da thread de renderização e os underruns.
+ * Pode ser chamada de qualquer thread.
+ * @return 0 em caso de sucesso.
+ */
+static int audio_get_render_stats(audio_hw_device_t* dev, audio_render_stats_t* stats) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    render_thread_stats_t rt;
+    pthread_mutex_lock(&custom_dev->control_lock);
+    render_thread_get_stats(&custom_dev->render_thread, &rt);
+    // Taxa de despertares (por prazo e de standby) desde a leitura anterior; os
+    // contadores zeram quando a thread reinicia.
+    const uint64_t now_ns = hal_metrics_now_ns();
+    const uint64_t all_wakeups = rt.wakeups + rt.resumes;
+    const uint64_t since = all_wakeups >= custom_dev->stats_wakeups ? custom_dev->stats_wakeups : 0;
+    const uint64_t elapsed_ns = now_ns - custom_dev->stats_time_ns;
+    stats->wakeups_per_sec = custom_dev->stats_time_ns != 0 && elapsed_ns > 0
+            ? (float)((double)(all_wakeups - since) * 1e9 / (double)elapsed_ns) : 0.0f;
+    custom_dev->stats_wakeups = all_wakeups;
+    custom_dev->stats_time_ns = now_ns;
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    stats->standby = rt.standby;
+    stats->standby_entries = rt.standby_entries;
+    stats->resumes = rt.resumes;
+    stats->standby_latency_last_ns = rt.standby_latency_last_ns;
+    stats->standby_latency_max_ns = rt.standby_latency_max_ns;
+    stats->resume_latency_last_ns = rt.resume_latency_last_ns;
+    stats->resume_latency_max_ns = rt.resume_latency_max_ns;
+    stats->standby_ms = rt.standby_ns / 1000000;
+    stats->period_us = rt.period_us;
+    stats->wakeups = rt.wakeups;
+    stats->late_wakeups = rt.late_wakeups;
+    stats->jitter_last_ns = rt.jitter_last_ns;
+    stats->jitter_avg_ns = rt.jitter_avg_ns;
+    stats->jitter_max_ns = rt.jitter_max_ns;
+    stats->underruns = (int)custom_dev->metrics.underruns.load(std::memory_order_relaxed);
+    stats->latency_frames = custom_dev->dynamics.enabled ? DYN_LIMITER_LATENCY_FRAMES : 0;
+    return 0;
+}
+
+// --- Resumo do Estado de Renderização ---
+// FNV-1a de 64 bits sobre os bytes do estado (floats comparados bit a bit).
+#define HAL_DIGEST_OFFSET 0xcbf29ce484222325ull
+#define HAL_DIGEST_PRIME 0x100000001b3ull
+
+static uint64_t digest_bytes(uint64_t h, const void* data, size_t bytes) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        h = (h ^ p[i]) * HAL_DIGEST_PRIME;
+    }
+    return h;
+}
+
+// Só para escalares e vetores de escalares: bytes de preenchimento de uma struct
+// não são inicializados e mudariam o resumo sem mudar o estado.
+#define DIGEST_VALUE(h, v) digest_bytes((h), &(v), sizeof(v))
+
+static_assert(sizeof(biquad_coeffs_t) == 5 * sizeof(float), "coeficientes sem preenchimento");
+
+/**
+ * Configuração de dinâmica, campo a campo ('enabled' é seguido de preenchimento).
+ */
+static uint64_t digest_dynamics(uint64_t h, const audio_dynamics_config_t* config) {
+    h = DIGEST_VALUE(h, config->enabled);
+    h = DIGEST_VALUE(h, config->speed_ref_kmh);
+    h = DIGEST_VALUE(h, config->speed_gain_db);
+    h = DIGEST_VALUE(h, config->loudness_bass_db);
+    h = DIGEST_VALUE(h, config->loudness_treble_db);
+    h = DIGEST_VALUE(h, config->limiter_threshold_db);
+    h = DIGEST_VALUE(h, config->limiter_release_ms);
+    return h;
+}
+
+/**
+ * Estado de um equalizador que influencia a saída: coeficientes (e a rampa, se
+ * houver uma) e o estado dos filtros dos estágios e canais em uso.
+ */
+static uint64_t digest_eq(uint64_t h, const eq_state_t* eq) {
+    const size_t stage_bytes = (size_t)eq->bands * sizeof(biquad_coeffs_t);
+    h = DIGEST_VALUE(h, eq->bands);
+    h = digest_bytes(h, eq->coeffs, stage_bytes);
+    h = DIGEST_VALUE(h, eq->ramp_remaining);
+    if (eq->ramp_remaining > 0) {
+        h = digest_bytes(h, eq->target, stage_bytes);
+        h = digest_bytes(h, eq->delta, stage_bytes);
+    }
+    for (int s = 0; s < eq->bands; s++) {
+        h = digest_bytes(h, eq->z1[s], (size_t)eq->channels * sizeof(float));
+        h = digest_bytes(h, eq->z2[s], (size_t)eq->channels * sizeof(float));
+    }
+    return h;
+}
+
+/**
+ * Resumo (hash de 64 bits) de todo o estado que, junto com as entradas, decide
+ * a saída dos próximos períodos: rampas de ganho e ducking dos streams, nível
+ * das filas e estado dos conversores de taxa; por zona renderizada, equalizador
+ * (filtros, rampas e crossfade), volume, loudness e limitador. Contadores,
+ * métricas e posições absolutas ficam de fora. Dois dispositivos com o mesmo
+ * resumo que recebem as mesmas entradas produzem a mesma saída, bit a bit (ex:
+ * o renderizador offline, que divide um arquivo entre threads).
+ * @return 0 em caso de sucesso, ou -EBUSY com a thread de renderização ativa.
+ */
+static int audio_get_render_state_digest(audio_hw_device_t* dev, uint64_t* digest) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (!digest) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    if (render_thread_is_running(&custom_dev->render_thread)) {
+        pthread_mutex_unlock(&custom_dev->control_lock);
+        return -EBUSY;
+    }
+    uint64_t h = HAL_DIGEST_OFFSET;
+    const uint32_t mask = custom_dev->stream_mask.load(std::memory_order_seq_cst);
+    h = DIGEST_VALUE(h, mask);
+    h = DIGEST_VALUE(h, custom_dev->period_frames);
+    h = DIGEST_VALUE(h, custom_dev->zone_count);
+    h = digest_dynamics(h, &custom_dev->dynamics);
+    for (int i = 0; i < AUDIO_VEHICLE_PARAM_COUNT; i++) {
+        const float value = custom_dev->vehicle_params[i].load(std::memory_order_relaxed);
+        h = DIGEST_VALUE(h, value);
+    }
+    const float master = custom_dev->master_volume.load(std::memory_order_relaxed);
+    h = DIGEST_VALUE(h, master);
+
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        if (!(mask & (1u << i))) continue;
+        const hal_stream_t* hal_stream = &custom_dev->streams[i];
+        const float gain = hal_stream->gain.load(std::memory_order_relaxed);
+        const size_t queued = spsc_ring_readable(&hal_stream->ring);
+        h = DIGEST_VALUE(h, gain);
+        h = DIGEST_VALUE(h, hal_stream->applied_gain);
+        h = DIGEST_VALUE(h, hal_stream->playing);
+        h = DIGEST_VALUE(h, queued);
+        if (hal_stream->resampling) {
+            const resampler_t* rs = &hal_stream->resampler;
+            h = DIGEST_VALUE(h, rs->phase);
+            h = DIGEST_VALUE(h, rs->base);
+            h = digest_bytes(h, rs->frames, rs->count * RESAMPLER_CHANNELS * sizeof(float));
+        }
+    }
+
+    for (int z = 0; z < custom_dev->zone_count; z++) {
+        const hal_zone_t* zone = &custom_dev->zones[z];
+        const float volume = zone->volume.load(std::memory_order_relaxed);
+        const uint32_t pending = zone->eq_params.ready.load(std::memory_order_relaxed) & EQ_PARAMS_FRESH;
+        h = DIGEST_VALUE(h, pending);
+        h = digest_eq(h, &zone->eq);
+        h = DIGEST_VALUE(h, zone->eq_active);
+        h = DIGEST_VALUE(h, zone->eq_mix);
+        h = DIGEST_VALUE(h, zone->eq_mix_step);
+        h = DIGEST_VALUE(h, zone->eq_mix_remaining);
+        const bool next_layout = zone->eq_next_layout != NULL;
+        h = DIGEST_VALUE(h, next_layout);
+        h = DIGEST_VALUE(h, volume);
+        h = DIGEST_VALUE(h, zone->applied_gain);
+        if (custom_dev->dynamics.enabled) {
+            const dyn_limiter_t* lim = &zone->limiter;
+            // Da posição do limitador só importa a fase na fila (e nos blocos).
+            const uint64_t phase = lim->written % DYN_LIMITER_RING_FRAMES;
+            h = digest_eq(h, &zone->loudness);
+            h = DIGEST_VALUE(h, zone->loudness_step);
+            h = DIGEST_VALUE(h, phase);
+            h = DIGEST_VALUE(h, lim->threshold);
+            h = DIGEST_VALUE(h, lim->release_coeff);
+            h = DIGEST_VALUE(h, lim->block_peak);
+            h = DIGEST_VALUE(h, lim->next_target);
+            h = DIGEST_VALUE(h, lim->last_gain);
+            h = digest_bytes(h, lim->block_gain, sizeof(lim->block_gain));
+            h = digest_bytes(h, lim->ring, sizeof(lim->ring));
+        }
+    }
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    *digest = h;
+    return 0;
+}
+
+/**
+ * Extensão do fornecedor: lê os contadores de overrun e underrun da fila de entrada.
+ * Pode ser chamada de qualquer thread.
+ * @return 0 em caso de sucesso.
+ */
+static int audio_get_xrun_counts(audio_hw_device_t* dev, uint64_t* overruns, uint64_t* underruns) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (overruns) *overruns = custom_dev->metrics.overruns.load(std::memory_order_relaxed);
+    if (underruns) *underruns = custom_dev->metrics.underruns.load(std::memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * Extensão do fornecedor: copia um snapshot das métricas do caminho de áudio.
+ * Lock-free; pode ser chamada de qualquer thread, inclusive durante a renderização.
+ * @param metrics Destino do snapshot.
+ * @return 0 em caso de sucesso, ou -EINVAL se 'metrics' for NULL.
+ */
+static int audio_get_metrics(audio_hw_device_t* dev, audio_metrics_t* metrics) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (!metrics) {
+        return -EINVAL;
+    }
+    hal_metrics_snapshot(&custom_dev->metrics, metrics);
+    return 0;
+}
+
+/**
+ * Espera a thread de renderização concluir o período em andamento, para que um
+ * stream retirado de 'stream_mask' não esteja mais sendo lido. Requer 'control_lock'.
+ * Sem a thread rodando não há o que esperar (quem chama 'render' manualmente não
+ * deve fechar streams ao mesmo tempo).
+ * @return 0, ou -ETIMEDOUT se a thread não avançou dentro do prazo.
+ */
+static int wait_render_period_locked(custom_audio_device_t* custom_dev) {
+    if (!render_thread_is_running(&custom_dev->render_thread)) {
+        return 0;
+    }
+    const uint64_t epoch = custom_dev->render_epoch.load(std::memory_order_seq_cst);
+    // Em standby não há próximo período sem um despertar (a thread renderiza
+    // um período de silêncio e volta a dormir).
+    render_thread_wake(&custom_dev->render_thread);
+    const struct timespec poll = { 0, 500000 }; // 0,5 ms
+    for (int64_t waited = 0; waited < HAL_STREAM_CLOSE_TIMEOUT_NS; waited += poll.tv_nsec) {
+        if (custom_dev->render_epoch.load(std::memory_order_seq_cst) != epoch) {
+            return 0;
+        }
+        nanosleep(&poll, NULL);
+    }
+    return -ETIMEDOUT;
+}
+
+/**
+ * Abre um stream de saída adicional em um slot pré-alocado.
+ * O stream só fica visível para a thread de renderização depois de inicializado.
+ * @param config Uso, prioridade de ducking e ganho inicial.
+ * @param stream_out Recebe o stream aberto.
+ * @return 0 em caso de sucesso, -EINVAL para configuração inválida ou -ENOSPC
+ *         se todos os slots estiverem ocupados.
+ */
+static int audio_open_output_stream(audio_hw_device_t* dev, const audio_stream_config_t* config,
+                                    audio_stream_out_t** stream_out) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (!config || !stream_out || config->usage < AUDIO_USAGE_MEDIA || config->usage > AUDIO_USAGE_PHONE) {
+        return -EINVAL;
+    }
+    if (!pcm_kernels_select(config->format, config->channels ? config->channels : HAL_CHANNELS)) {
+        ALOGE("AudioHAL: Erro: Formato %d com %d canais não suportado.", (int)config->format, config->channels);
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    int index = -1;
+    for (int i = 0; i < AUDIO_MAX_OUTPUT_STREAMS; i++) {
+        if (!(custom_dev->allocated_mask & (1u << i))) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        pthread_mutex_unlock(&custom_dev->control_lock);
+        ALOGE("AudioHAL: Erro: Todos os %d streams de saída estão em uso.", AUDIO_MAX_OUTPUT_STREAMS);
+        return -ENOSPC;
+    }
+    int ret = init_stream(custom_dev, index, config);
+    if (ret != 0) {
+        pthread_mutex_unlock(&custom_dev->control_lock);
+        return ret;
+    }
+    custom_dev->allocated_mask |= 1u << index;
+    custom_dev->stream_mask.fetch_or(1u << index, std::memory_order_seq_cst);
+    pthread_mutex_unlock(&custom_dev->control_lock);
+
+    *stream_out = &custom_dev->streams[index].stream;
+    ALOGI("AudioHAL: Stream %d aberto (uso %d, prioridade %d).", index, config->usage, config->priority);
+    return 0;
+}
+
+/**
+ * Fecha um stream aberto por 'open_output_stream'. Os frames ainda na fila são descartados.
+ * Se a thread de renderização não confirmar a tempo, o stream fica "fechando":
+ * já fora da mistura, mas com o slot (e a região compartilhada) reservados até
+ * uma nova chamada concluir o fechamento.
+ * @return 0 em caso de sucesso, -EINVAL para um stream que não pertence ao
+ *         dispositivo (ou o primário, ou já fechado), ou -ETIMEDOUT se a thread
+ *         de renderização não liberou o stream (chame de novo para concluir).
+ */
+static int audio_close_output_stream(audio_hw_device_t* dev, audio_stream_out_t* stream) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    hal_stream_t* hal_stream = (hal_stream_t*)stream;
+    if (hal_stream < &custom_dev->streams[0] || hal_stream >= &custom_dev->streams[AUDIO_MAX_OUTPUT_STREAMS]) {
+        return -EINVAL;
+    }
+    const int index = hal_stream->index;
+    if (index == HAL_PRIMARY_STREAM) {
+        return -EINVAL; // Pertence ao dispositivo; é liberado em 'close'
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    if (!(custom_dev->allocated_mask & (1u << index))) {
+        pthread_mutex_unlock(&custom_dev->control_lock);
+        return -EINVAL; // Já fechado
+    }
+    // Em uma nova tentativa o bit já está limpo; só falta a confirmação da thread.
+    custom_dev->stream_mask.fetch_and(~(1u << index), std::memory_order_seq_cst);
+    int ret = wait_render_period_locked(custom_dev);
+    if (ret == 0) {
+        hal_stream->resampling = false;
+        custom_dev->allocated_mask &= ~(1u << index);
+    }
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    if (ret != 0) {
+        ALOGE("AudioHAL: Erro: Thread de renderização não liberou o stream %d; fechamento pendente.", index);
+        return ret;
+    }
+    ALOGI("AudioHAL: Stream %d fechado.", index);
+    return 0;
+}
+
+/**
+ * Ajusta o volume mestre, aplicado depois da mistura e do equalizador.
+ * Na simulação ele é controlado pela mensagem CAN 0x123 (via JNI).
+ * Pode ser chamada de qualquer thread; a mudança vira uma rampa de um período.
+ * @param volume Ganho linear, limitado a 0..1.
+ * @return 0 em caso de sucesso, ou -EINVAL para um valor não numérico.
+ */
+static int audio_set_master_volume(audio_hw_device_t* dev, float volume) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (volume != volume) {
+        return -EINVAL; // NaN
+    }
+    custom_dev->master_volume.store(volume < 0.0f ? 0.0f : (volume > 1.0f ? 1.0f : volume),
+                                    std::memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * Converte o volume do veículo (0..100) no ganho linear do volume mestre.
+ */
+static float vehicle_volume_to_gain(float volume) {
+    if (volume <= 0.0f) return 0.0f;
+    if (volume >= HAL_VEHICLE_VOLUME_MAX) return 1.0f;
+    const float db = (volume / HAL_VEHICLE_VOLUME_MAX - 1.0f) * HAL_VEHICLE_VOLUME_RANGE_DB;
+    return powf(10.0f, db / 20.0f);
+}
+
+/**
+ * Extensão do fornecedor: publica um lote de sinais do veículo (ex: decodificados
+ * da CAN). O lote inteiro é validado antes de qualquer escrita; cada parâmetro é
+ * um atômico, então a thread de renderização lê sempre um valor completo.
+ * O volume do veículo vira o volume mestre (com a rampa de um período de sempre).
+ * @param updates Atualizações do lote (com repetições, vale a última).
+ * @param count Número de atualizações.
+ * @return 0 em caso de sucesso, ou -EINVAL para parâmetro ou valor inválido.
+ */
+static int audio_set_vehicle_params(audio_hw_device_t* dev, const audio_vehicle_param_update_t* updates,
+                                    size_t count) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (!updates && count > 0) {
+        return -EINVAL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const float value = updates[i].value;
+        if (value != value) {
+            return -EINVAL; // NaN
+        }
+        switch (updates[i].param) {
+            case AUDIO_VEHICLE_PARAM_MASTER_VOLUME:
+                break; // Limitado a 0..100 na conversão
+            case AUDIO_VEHICLE_PARAM_SPEED_KMH:
+                if (value < 0.0f || value > HAL_VEHICLE_SPEED_MAX_KMH) return -EINVAL;
+                break;
+            default:
+                return -EINVAL;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        const float value = updates[i].value;
+        custom_dev->vehicle_params[updates[i].param].store(value, std::memory_order_relaxed);
+        if (updates[i].param == AUDIO_VEHICLE_PARAM_MASTER_VOLUME) {
+            custom_dev->master_volume.store(vehicle_volume_to_gain(value), std::memory_order_relaxed);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Extensão do fornecedor: lê o último valor publicado de um sinal do veículo.
+ * @return 0 em caso de sucesso, ou -EINVAL para parâmetro inválido.
+ */
+static int audio_get_vehicle_param(audio_hw_device_t* dev, audio_vehicle_param_t param, float* value) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (param < 0 || param >= AUDIO_VEHICLE_PARAM_COUNT || !value) {
+        return -EINVAL;
+    }
+    *value = custom_dev->vehicle_params[param].load(std::memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * Publica o liga/desliga do equalizador de uma zona (ver 'set_eq_enabled').
+ */
+static void set_zone_eq_enabled(hal_zone_t* zone, bool enabled) {
+    eq_params_t* params = eq_params_begin_write(&zone->eq_params);
+    params->enabled = enabled;
+    eq_params_end_write(&zone->eq_params);
+}
+
+/**
+ * Publica o nível de uma banda do equalizador de uma zona. Os coeficientes vêm
+ * do cache do layout: a troca custa uma cópia e, para a thread de áudio, uma
+ * troca atômica. Nível já validado.
+ * @return 0 em caso de sucesso, ou -EINVAL se a banda não existir no layout.
+ */
+static int set_zone_eq_band_level(custom_audio_device_t* custom_dev, hal_zone_t* zone, int band, int level) {
+    eq_params_t* params = eq_params_begin_write(&zone->eq_params);
+    if (band < 0 || band >= params->bands) {
+        eq_params_cancel_write(&zone->eq_params);
+        return -EINVAL;
+    }
+    params->levels[band] = level;
+    params->coeffs[band] = *eq_table_lookup(&custom_dev->eq_table, band, level);
+    eq_params_end_write(&zone->eq_params);
+    return 0;
+}
+
+/**
+ * Publica os níveis de todas as bandas de uma zona em um único snapshot: os
+ * níveis pedidos ('levels', já validados) ou, com 'levels' NULL, os do preset.
+ * @return 0 em caso de sucesso, ou -EINVAL se 'count' não for o número de bandas do layout.
+ */
+static int set_zone_eq_levels(custom_audio_device_t* custom_dev, hal_zone_t* zone, const int* levels, int count,
+                              int preset) {
+    eq_params_t* params = eq_params_begin_write(&zone->eq_params);
+    if (!levels) {
+        levels = custom_dev->eq_preset_levels[preset];
+        count = params->bands;
+    }
+    if (count != params->bands) {
+        eq_params_cancel_write(&zone->eq_params);
+        return -EINVAL;
+    }
+    for (int band = 0; band < count; band++) {
+        params->levels[band] = levels[band];
+        params->coeffs[band] = *eq_table_lookup(&custom_dev->eq_table, band, levels[band]);
+    }
+    eq_params_end_write(&zone->eq_params);
+    return 0;
+}
 
-    // Log de depuração que indica o "processamento" dos dados de áudio.
-    ALOGD("AudioHAL: Processando %zu bytes de áudio.", bytes);
-    return bytes; // Retorna o número de bytes "processados" (simulando sucesso)
+/**
+ * Extensão do fornecedor: liga ou desliga o equalizador da zona principal.
+ * Pode ser chamada de qualquer thread; a troca vale a partir do próximo período,
+ * com uma rampa de um período (sem clique) em vez de um degrau.
+ * @param dev O dispositivo de áudio.
+ * @param enabled true para processar o áudio pelo equalizador, false para bypass.
+ * @return 0 em caso de sucesso.
+ */
+static int audio_set_eq_enabled(audio_hw_device_t* dev, bool enabled) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    set_zone_eq_enabled(&custom_dev->zones[0], enabled);
+    ALOGI("AudioHAL: Equalizador %s.", enabled ? "ativado" : "desativado");
+    return 0;
+}
+
+/**
+ * Extensão do fornecedor: ajusta o nível de uma banda do equalizador da zona principal.
+ * @param dev O dispositivo de áudio.
+ * @param band Índice da banda no layout (no padrão, um dos valores AUDIO_EQ_BAND_*).
+ * @param level Nível de 0 a 100 (50 = plano).
+ * @return 0 em caso de sucesso, ou -EINVAL para banda ou nível inválidos.
+ */
+static int audio_set_eq_band_level(audio_hw_device_t* dev, int band, int level) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (level < EQ_LEVEL_MIN || level > EQ_LEVEL_MAX ||
+        set_zone_eq_band_level(custom_dev, &custom_dev->zones[0], band, level) != 0) {
+        ALOGE("AudioHAL: Erro: Banda %d / nível %d inválidos.", band, level);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * Prepara uma zona para começar a tocar: equalizador plano e ligado, volume
+ * unitário e ganho efetivo zero (a primeira rampa entra sem clique). Chamada
+ * só na abertura, antes de qualquer renderização.
+ */
+static void init_zone(hal_zone_t* zone) {
+    eq_init(&zone->eq, (float)HAL_SAMPLE_RATE, HAL_CHANNELS);
+    eq_params_t initial_params;
+    memset(&initial_params, 0, sizeof(initial_params));
+    initial_params.enabled = true;
+    initial_params.bands = zone->eq.bands;
+    for (int band = 0; band < zone->eq.bands; band++) {
+        initial_params.levels[band] = zone->eq.levels[band];
+        initial_params.coeffs[band] = zone->eq.coeffs[band];
+    }
+    eq_params_init(&zone->eq_params, &initial_params);
+    zone->eq_active = true;
+    zone->eq_mix = 1.0f;
+    zone->eq_next_layout = NULL;
+    zone->volume.store(1.0f, std::memory_order_relaxed);
+    zone->applied_gain = 0.0f;
+    eq_init(&zone->loudness, (float)HAL_SAMPLE_RATE, HAL_CHANNELS);
+}
+
+/**
+ * Zera a dinâmica de uma zona: limitador em silêncio e loudness plano.
+ * Só com a thread de renderização parada.
+ */
+static void reset_zone_dynamics(custom_audio_device_t* custom_dev, hal_zone_t* zone) {
+    dyn_limiter_reset(&zone->limiter, &custom_dev->dynamics, (float)HAL_SAMPLE_RATE);
+    eq_reset(&zone->loudness);
+    eq_ramp_to(&zone->loudness, custom_dev->loudness_table.coeffs[0], 0);
+    zone->loudness_step = 0;
+}
+
+/**
+ * Configura o estágio de dinâmica de todas as zonas (ver audio_dynamics_config_t).
+ * A tabela de loudness é calculada aqui, fora do caminho de áudio. A thread de
+ * renderização é parada durante a troca e o estado das zonas é zerado: a saída
+ * recomeça com o atraso do limitador (ou sem ele, ao desligar).
+ * @return 0 em caso de sucesso, ou -EINVAL para uma configuração inválida.
+ */
+static int audio_set_dynamics_config(audio_hw_device_t* dev, const audio_dynamics_config_t* config) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (dyn_validate_config(config) != 0) {
+        ALOGE("AudioHAL: Erro: Configuração de dinâmica inválida.");
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    const bool was_running = render_thread_is_running(&custom_dev->render_thread);
+    render_thread_stop(&custom_dev->render_thread);
+    custom_dev->dynamics = *config;
+    dyn_loudness_design(&custom_dev->loudness_table, config, (float)HAL_SAMPLE_RATE);
+    for (int zone = 0; zone < AUDIO_MAX_ZONES; zone++) {
+        reset_zone_dynamics(custom_dev, &custom_dev->zones[zone]);
+    }
+    custom_dev->speed_gain = 1.0f;
+    custom_dev->loudness_step = 0;
+    int ret = was_running ? start_render_thread_locked(custom_dev) : 0;
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    ALOGI("AudioHAL: Dinâmica %s (latência de %d frames).", config->enabled ? "ligada" : "desligada",
+          config->enabled ? DYN_LIMITER_LATENCY_FRAMES : 0);
+    return ret;
+}
+
+/**
+ * Altera o número de zonas renderizadas. A thread de renderização é parada
+ * durante a troca e o pool de workers é recriado com min(zonas - 1,
+ * HAL_ZONE_WORKERS, núcleos - 1) threads (nenhuma com uma zona só); uma zona que volta a
+ * ser renderizada entra com uma rampa a partir do silêncio e o equalizador zerado.
+ * @param zones 1..AUDIO_MAX_ZONES.
+ * @return 0 em caso de sucesso, -EINVAL para um número inválido, ou o erro de
+ *         criação dos workers (o dispositivo fica com uma zona).
+ */
+static int audio_set_zone_count(audio_hw_device_t* dev, int zones) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zones < 1 || zones > AUDIO_MAX_ZONES) {
+        ALOGE("AudioHAL: Erro: %d zonas fora da faixa.", zones);
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    const bool was_running = render_thread_is_running(&custom_dev->render_thread);
+    render_thread_stop(&custom_dev->render_thread);
+    for (int i = custom_dev->zone_count; i < zones; i++) {
+        hal_zone_t* zone = &custom_dev->zones[i];
+        eq_reset(&zone->eq);
+        zone->applied_gain = 0.0f;
+        reset_zone_dynamics(custom_dev, zone);
+    }
+    worker_pool_stop(&custom_dev->zone_workers);
+    // Um worker a mais que os núcleos livres só disputaria a CPU com a thread de
+    // renderização (e a barreira esperaria o escalonador): em um único núcleo, serial.
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = zones - 1 < HAL_ZONE_WORKERS ? zones - 1 : HAL_ZONE_WORKERS;
+    if (cpus > 0 && workers > cpus - 1) workers = (int)(cpus - 1);
+    int ret = worker_pool_start(&custom_dev->zone_workers, workers);
+    custom_dev->zone_count = ret == 0 ? zones : 1;
+    if (ret != 0) {
+        ALOGE("AudioHAL: Erro ao criar %d workers das zonas: %d", workers, ret);
+    }
+    const int start_ret = was_running ? start_render_thread_locked(custom_dev) : 0;
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    ALOGI("AudioHAL: %d zonas, %d workers.", custom_dev->zone_count, workers);
+    return ret != 0 ? ret : start_ret;
+}
+
+/**
+ * Registra o destino dos períodos de uma zona (zona 0: ver 'set_output_sink').
+ * @return 0 em caso de sucesso, ou -EINVAL para uma zona inválida.
+ */
+static int audio_set_zone_sink(audio_hw_device_t* dev, int zone, audio_sink_fn sink, void* cookie) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zone < 0 || zone >= AUDIO_MAX_ZONES) {
+        return -EINVAL;
+    }
+    if (zone == 0) {
+        return audio_set_output_sink(dev, sink, cookie);
+    }
+    pthread_mutex_lock(&custom_dev->control_lock);
+    const bool was_running = render_thread_is_running(&custom_dev->render_thread);
+    render_thread_stop(&custom_dev->render_thread);
+    custom_dev->zones[zone].sink = sink;
+    custom_dev->zones[zone].sink_cookie = cookie;
+    int ret = was_running ? start_render_thread_locked(custom_dev) : 0;
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    return ret;
+}
+
+/**
+ * Ajusta o volume de uma zona; o ganho aplicado é o volume da zona vezes o
+ * volume mestre, com rampa de um período. Pode ser chamada de qualquer thread.
+ * @param volume Ganho linear, limitado a 0..1.
+ * @return 0 em caso de sucesso, ou -EINVAL para zona inválida ou valor não numérico.
+ */
+static int audio_set_zone_volume(audio_hw_device_t* dev, int zone, float volume) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zone < 0 || zone >= AUDIO_MAX_ZONES || volume != volume) {
+        return -EINVAL;
+    }
+    custom_dev->zones[zone].volume.store(volume < 0.0f ? 0.0f : (volume > 1.0f ? 1.0f : volume),
+                                         std::memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * Liga ou desliga o equalizador de uma zona (ver 'set_eq_enabled').
+ * @return 0 em caso de sucesso, ou -EINVAL para uma zona inválida.
+ */
+static int audio_set_zone_eq_enabled(audio_hw_device_t* dev, int zone, bool enabled) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zone < 0 || zone >= AUDIO_MAX_ZONES) {
+        return -EINVAL;
+    }
+    set_zone_eq_enabled(&custom_dev->zones[zone], enabled);
+    ALOGI("AudioHAL: Equalizador da zona %d %s.", zone, enabled ? "ativado" : "desativado");
+    return 0;
+}
+
+/**
+ * Ajusta o nível de uma banda do equalizador de uma zona (ver 'set_eq_band_level').
+ * @return 0 em caso de sucesso, ou -EINVAL para zona, banda ou nível inválidos.
+ */
+static int audio_set_zone_eq_band_level(audio_hw_device_t* dev, int zone, int band, int level) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zone < 0 || zone >= AUDIO_MAX_ZONES || level < EQ_LEVEL_MIN || level > EQ_LEVEL_MAX ||
+        set_zone_eq_band_level(custom_dev, &custom_dev->zones[zone], band, level) != 0) {
+        ALOGE("AudioHAL: Erro: Zona %d / banda %d / nível %d inválidos.", zone, band, level);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * Troca o layout do equalizador de todas as zonas (ver 'set_eq_layout'). O cache
+ * de coeficientes e os níveis dos presets são recalculados aqui, com os locks
+ * de escritores de todas as zonas tomados; cada zona recebe o layout novo, plano
+ * e com o liga/desliga mantido, no próximo período. A thread de renderização
+ * continua rodando: a zona leva a cascata antiga ao original por um crossfade e
+ * só então entra com a nova, por outro crossfade a partir do original.
+ * @return 0 em caso de sucesso, ou -EINVAL para um layout inválido.
+ */
+static int audio_set_eq_layout(audio_hw_device_t* dev, const audio_eq_band_t* bands, int count) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (eq_validate_layout(bands, count, (float)HAL_SAMPLE_RATE) != 0) {
+        ALOGE("AudioHAL: Erro: Layout de equalizador inválido (%d bandas).", count);
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&custom_dev->control_lock); // Serializa as trocas de layout
+    eq_params_t* params[AUDIO_MAX_ZONES];
+    for (int zone = 0; zone < AUDIO_MAX_ZONES; zone++) {
+        params[zone] = eq_params_begin_write(&custom_dev->zones[zone].eq_params);
+    }
+    eq_table_build(&custom_dev->eq_table, bands, count, (float)HAL_SAMPLE_RATE);
+    for (int preset = 0; preset < AUDIO_EQ_PRESET_COUNT; preset++) {
+        eq_preset_levels(preset, bands, count, custom_dev->eq_preset_levels[preset]);
+    }
+    for (int zone = 0; zone < AUDIO_MAX_ZONES; zone++) {
+        params[zone]->bands = count;
+        for (int band = 0; band < count; band++) {
+            params[zone]->levels[band] = EQ_LEVEL_FLAT;
+            params[zone]->coeffs[band] = *eq_table_lookup(&custom_dev->eq_table, band, EQ_LEVEL_FLAT);
+        }
+        eq_params_end_write(&custom_dev->zones[zone].eq_params);
+    }
+    pthread_mutex_unlock(&custom_dev->control_lock);
+    ALOGI("AudioHAL: Layout do equalizador com %d bandas.", count);
+    return 0;
+}
+
+/**
+ * Ajusta todas as bandas do equalizador de uma zona com uma única publicação
+ * (ver 'set_eq_bands').
+ * @return 0 em caso de sucesso, ou -EINVAL para zona, número de bandas ou nível inválidos.
+ */
+static int audio_set_zone_eq_bands(audio_hw_device_t* dev, int zone, const int* levels, int count) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zone < 0 || zone >= AUDIO_MAX_ZONES || !levels || count < 1 || count > AUDIO_EQ_MAX_BANDS) {
+        return -EINVAL;
+    }
+    for (int band = 0; band < count; band++) {
+        if (levels[band] < EQ_LEVEL_MIN || levels[band] > EQ_LEVEL_MAX) {
+            ALOGE("AudioHAL: Erro: Banda %d / nível %d inválidos.", band, levels[band]);
+            return -EINVAL;
+        }
+    }
+    int ret = set_zone_eq_levels(custom_dev, &custom_dev->zones[zone], levels, count, 0);
+    if (ret != 0) {
+        ALOGE("AudioHAL: Erro: %d níveis para o layout da zona %d.", count, zone);
+    }
+    return ret;
+}
+
+static int audio_set_eq_bands(audio_hw_device_t* dev, const int* levels, int count) {
+    return audio_set_zone_eq_bands(dev, 0, levels, count);
+}
+
+/**
+ * Carrega um preset no equalizador de uma zona: níveis e coeficientes já estão
+ * calculados para o layout, então a troca é uma consulta e uma publicação.
+ * @return 0 em caso de sucesso, ou -EINVAL para zona ou preset inválidos.
+ */
+static int audio_load_zone_eq_preset(audio_hw_device_t* dev, int zone, int preset) {
+    custom_audio_device_t* custom_dev = (custom_audio_device_t*)dev;
+    if (zone < 0 || zone >= AUDIO_MAX_ZONES || preset < 0 || preset >= AUDIO_EQ_PRESET_COUNT) {
+        ALOGE("AudioHAL: Erro: Zona %d / preset %d inválidos.", zone, preset);
+        return -EINVAL;
+    }
+    return set_zone_eq_levels(custom_dev, &custom_dev->zones[zone], NULL, 0, preset);
+}
+
+static int audio_load_eq_preset(audio_hw_device_t* dev, int preset) {
+    return audio_load_zone_eq_preset(dev, 0, preset);
 }
 
 /**
@@ -213,14 +1802,16 @@ static int audio_open(const hw_module_t* module, const char* name, hw_device_t**
         return -EINVAL; // Retorna erro de argumento inválido
     }
 
-    // Aloca memória para a estrutura personalizada do dispositivo de áudio.
-    custom_audio_device_t* dev = (custom_audio_device_t*)malloc(sizeof(custom_audio_device_t));
+    // Reserva um bloco do pool estático do módulo (já alinhado à linha de cache,
+    // como exige o ring buffer); nenhum dispositivo passa pelo malloc.
+    custom_audio_device_t* dev = (custom_audio_device_t*)hal_pool_alloc(&g_device_pool);
     if (!dev) {
-        ALOGE("AudioHAL: Falha na alocação de memória.");
+        ALOGE("AudioHAL: Todos os %d dispositivos do pool estão em uso.", HAL_MAX_DEVICES);
         return -ENOMEM; // Retorna erro de falta de memória (No Memory)
     }
 
-    memset(dev, 0, sizeof(custom_audio_device_t)); // Inicializa toda a memória alocada com zeros
+    // Zera o bloco inteiro: também toca todas as páginas aqui, fora do caminho de áudio.
+    memset((void*)dev, 0, sizeof(custom_audio_device_t));
 
     // Configuração da estrutura padrão 'common' do dispositivo de hardware.
     dev->device.common.tag = HARDWARE_DEVICE_TAG; // Identifica a estrutura como um dispositivo de hardware
@@ -229,13 +1820,91 @@ static int audio_open(const hw_module_t* module, const char* name, hw_device_t**
     dev->device.common.close = audio_close; // Atribui a função de fechamento do dispositivo
 
     // Atribui as funções específicas da HAL de áudio.
-    // Para esta simulação, apenas a função 'write' é atribuída.
-    dev->device.write = audio_write; // Atribui a função de escrita de áudio (simulada)
+    // Além da escrita, são atribuídas as extensões do fornecedor.
+    dev->device.write = audio_write; // Atribui a função de escrita de áudio (produtor)
+    dev->device.render = audio_render; // Atribui a função que drena um período (consumidor)
+    dev->device.start_render_thread = audio_start_render_thread;
+    dev->device.stop_render_thread = audio_stop_render_thread;
+    dev->device.set_period_size = audio_set_period_size;
+    dev->device.set_output_sink = audio_set_output_sink;
+    dev->device.get_render_stats = audio_get_render_stats;
+    dev->device.get_xrun_counts = audio_get_xrun_counts;
+    dev->device.get_metrics = audio_get_metrics;
+    dev->device.set_eq_enabled = audio_set_eq_enabled; // Extensões do equalizador
+    dev->device.set_eq_band_level = audio_set_eq_band_level;
+
+    dev->device.open_output_stream = audio_open_output_stream;
+    dev->device.close_output_stream = audio_close_output_stream;
+    dev->device.set_master_volume = audio_set_master_volume;
+    dev->device.set_zone_count = audio_set_zone_count; // Zonas de saída
+    dev->device.set_zone_sink = audio_set_zone_sink;
+    dev->device.set_zone_volume = audio_set_zone_volume;
+    dev->device.set_zone_eq_enabled = audio_set_zone_eq_enabled;
+    dev->device.set_zone_eq_band_level = audio_set_zone_eq_band_level;
+    dev->device.set_vehicle_params = audio_set_vehicle_params; // Sinais do veículo (CAN)
+    dev->device.get_vehicle_param = audio_get_vehicle_param;
+    dev->device.set_dynamics_config = audio_set_dynamics_config;
+    dev->device.set_eq_layout = audio_set_eq_layout; // Layout, níveis em lote e presets do equalizador
+    dev->device.set_eq_bands = audio_set_eq_bands;
+    dev->device.set_zone_eq_bands = audio_set_zone_eq_bands;
+    dev->device.load_eq_preset = audio_load_eq_preset;
+    dev->device.load_zone_eq_preset = audio_load_zone_eq_preset;
+    dev->device.get_render_state_digest = audio_get_render_state_digest;
+    dev->device.set_standby_delay = audio_set_standby_delay;
+
+    dev->mix_kernels = pcm_kernels_select(AUDIO_FORMAT_PCM_FLOAT, HAL_CHANNELS);
+
+    // Abre o stream primário (mídia), usado por 'write', já com ganho unitário.
+    // Zerada = fila interna, PCM 16 bits, HAL_CHANNELS canais na taxa da HAL.
+    audio_stream_config_t primary_config = {};
+    primary_config.usage = AUDIO_USAGE_MEDIA;
+    primary_config.gain = 1.0f;
+    init_stream(dev, HAL_PRIMARY_STREAM, &primary_config);
+    dev->streams[HAL_PRIMARY_STREAM].applied_gain = 1.0f;
+    dev->allocated_mask = 1u << HAL_PRIMARY_STREAM;
+    dev->stream_mask.store(1u << HAL_PRIMARY_STREAM, std::memory_order_relaxed);
+    dev->master_volume.store(1.0f, std::memory_order_relaxed);
+    dev->vehicle_params[AUDIO_VEHICLE_PARAM_MASTER_VOLUME].store(HAL_VEHICLE_VOLUME_MAX, std::memory_order_relaxed);
+    dev->vehicle_params[AUDIO_VEHICLE_PARAM_SPEED_KMH].store(0.0f, std::memory_order_relaxed);
+
+    // Inicializa as zonas com os equalizadores planos e publica os snapshots
+    // iniciais. Só a zona principal é renderizada (sem workers) até 'set_zone_count';
+    // ela começa no volume cheio, como a saída única de antes.
+    // A dinâmica começa desligada (sem latência extra), já com a configuração padrão;
+    // o equalizador, no layout padrão de três bandas, com o cache já calculado.
+    dev->dynamics = kDefaultDynamics;
+    dyn_loudness_design(&dev->loudness_table, &dev->dynamics, (float)HAL_SAMPLE_RATE);
+    dev->speed_gain = 1.0f;
+    dev->loudness_step = 0;
+    eq_table_build(&dev->eq_table, eq_default_layout, AUDIO_EQ_NUM_BANDS, (float)HAL_SAMPLE_RATE);
+    for (int preset = 0; preset < AUDIO_EQ_PRESET_COUNT; preset++) {
+        eq_preset_levels(preset, eq_default_layout, AUDIO_EQ_NUM_BANDS, dev->eq_preset_levels[preset]);
+    }
+    for (int zone = 0; zone < AUDIO_MAX_ZONES; zone++) {
+        init_zone(&dev->zones[zone]);
+        reset_zone_dynamics(dev, &dev->zones[zone]);
+    }
+    dev->zones[0].applied_gain = 1.0f;
+    dev->zone_count = 1;
+
+    // Inicia a thread de renderização que consome a fila a cada período.
+    pthread_mutex_init(&dev->control_lock, NULL);
+    dev->period_frames = HAL_PERIOD_FRAMES;
+    dev->standby_delay_ms.store(AUDIO_STANDBY_DEFAULT_MS, std::memory_order_relaxed);
+    int ret = start_render_thread_locked(dev);
+    if (ret != 0) {
+        pthread_mutex_destroy(&dev->control_lock);
+        for (int zone = 0; zone < AUDIO_MAX_ZONES; zone++) {
+            eq_params_destroy(&dev->zones[zone].eq_params);
+        }
+        hal_pool_free(&g_device_pool, dev);
+        return ret;
+    }
 
     dev->is_initialized = true; // Marca a HAL como inicializada após a abertura bem-sucedida
     *device = (hw_device_t*)dev; // Retorna o ponteiro para a instância alocada e configurada do dispositivo
 
-    ALOGD("AudioHAL: Dispositivo de áudio inicializado com sucesso."); // Log de sucesso para o Logcat
+    ALOGD("AudioHAL: Dispositivo de áudio inicializado com sucesso (kernel EQ: %s).", eq_kernel_name()); // Log de sucesso para o Logcat
     return 0; // Retorna 0 para indicar sucesso
 }
 
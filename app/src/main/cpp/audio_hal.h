@@ -0,0 +1,420 @@
+// --- Cabeçalho Compartilhado da HAL de Áudio Simulada ---
+// Este cabeçalho reúne as definições mínimas de estruturas e macros que
+// normalmente seriam fornecidas pelos cabeçalhos padrão do NDK,
+// especificamente <hardware/hardware.h> e <hardware/audio.h>.
+// Antes elas eram injetadas (duplicadas) em audio_hal.cpp e em native-lib.cpp
+// como solução de contorno para os problemas de ambiente que impediram o
+// compilador de encontrar esses cabeçalhos. Mantê-las em um único arquivo local
+// evita que as duas cópias divirjam quando a interface da HAL cresce.
+// A ordem de declaração das estruturas é crucial em C/C++ para evitar erros de tipo.
+#ifndef MYAUDIOHALPROJECT_AUDIO_HAL_H
+#define MYAUDIOHALPROJECT_AUDIO_HAL_H
+
+#include <stdint.h>     // Para tipos inteiros de tamanho fixo (uint32_t)
+#include <stddef.h>     // Para size_t
+
+// Forward declarations para estruturas que se referenciam mutuamente.
+// Isso informa ao compilador sobre a existência dessas estruturas antes de suas definições completas.
+struct hw_module_t;
+struct hw_device_t;
+struct audio_hw_device; // Forward declaration para a estrutura base de audio_hw_device_t
+
+// Estrutura comum para todos os módulos de hardware (base para HALs).
+// Define a interface básica que um módulo HAL deve ter.
+struct hw_module_t {
+    uint32_t tag;               // Identificador único da estrutura (ex: HARDWARE_MODULE_TAG)
+    uint32_t version_major;     // Versão principal da interface do módulo
+    uint32_t version_minor;     // Versão secundária da interface do módulo
+    const char *id;             // Identificador textual do módulo (ex: "audio")
+    const char *name;           // Nome amigável do módulo
+    const char *author;         // Autor ou organização responsável pelo módulo
+    struct hw_module_methods_t *methods; // Ponteiro para os métodos de acesso do módulo
+    void* dso;                  // Ponteiro interno para o objeto de biblioteca compartilhada (não usado na simulação)
+    uint32_t reserved[32-7];    // Campos reservados para uso futuro, garantindo tamanho fixo
+};
+
+// Métodos comuns para todos os módulos de hardware.
+// Contém o método 'open', que é o ponto de entrada principal para obter uma instância de um dispositivo HAL.
+struct hw_module_methods_t {
+    // Função para abrir um dispositivo de hardware específico dentro do módulo.
+    // Parâmetros: ponteiro para o módulo, ID do dispositivo (ex: "primary"), e ponteiro para preencher com o dispositivo aberto.
+    int (*open)(const struct hw_module_t* module, const char* id, struct hw_device_t** device);
+};
+
+// Estrutura comum para todos os dispositivos de hardware.
+// Define a interface básica que um dispositivo HAL deve ter.
+struct hw_device_t {
+    uint32_t tag;               // Identificador único da estrutura (ex: HARDWARE_DEVICE_TAG)
+    uint32_t version;           // Versão da interface do dispositivo
+    struct hw_module_t* module; // Ponteiro de volta para o módulo ao qual este dispositivo pertence
+    int (*close)(struct hw_device_t* device); // Função para fechar e liberar o dispositivo
+    void* reserved[32-4];       // Campos reservados para uso futuro
+};
+
+// Formato do dispositivo (saída da mistura e stream primário): PCM 16 bits intercalado, estéreo, 48 kHz.
+#define HAL_SAMPLE_RATE 48000
+#define HAL_CHANNELS 2
+#define HAL_FRAME_SIZE (HAL_CHANNELS * sizeof(int16_t))
+// Período padrão da thread de renderização: 240 frames = 5 ms a 48 kHz.
+#define HAL_PERIOD_FRAMES 240
+// Faixa aceita por 'set_period_size': 1 ms a 20 ms a 48 kHz.
+#define HAL_MIN_PERIOD_FRAMES 48
+#define HAL_MAX_PERIOD_FRAMES 960
+
+// Standby: sem nenhum 'write'/'commit' por este tempo, a thread de renderização
+// libera o estado de processamento e dorme sem despertares periódicos, até o
+// próximo 'write' (ver 'set_standby_delay'). 3 s, como o AudioFlinger.
+#define AUDIO_STANDBY_DEFAULT_MS 3000
+
+// Destino final de cada período processado (ex: driver do amplificador).
+// Chamado na thread de renderização; não deve bloquear nem alocar memória.
+typedef void (*audio_sink_fn)(void* cookie, const void* pcm, size_t bytes);
+
+// Estatísticas da thread de renderização, usadas para calibrar o período contra a carga de CPU.
+typedef struct {
+    uint32_t period_us;       // Período configurado em microssegundos
+    uint64_t wakeups;         // Despertares por prazo desde que a thread foi iniciada (os de standby estão em 'resumes')
+    uint64_t late_wakeups;    // Despertares atrasados em mais de um período (prazos perdidos)
+    uint64_t jitter_last_ns;  // Atraso do último despertar em relação ao prazo
+    uint64_t jitter_avg_ns;   // Atraso médio
+    uint64_t jitter_max_ns;   // Maior atraso observado
+    int underruns;            // Períodos em que um stream que tocava ficou sem dados
+    uint32_t latency_frames;  // Atraso do processamento (ex: look-ahead do limitador), em frames
+    // Consumo ocioso: despertares por segundo desde a leitura anterior destas
+    // estatísticas (0 em standby) e o custo de entrar e sair do standby.
+    float wakeups_per_sec;
+    bool standby;                       // Em standby agora
+    uint64_t standby_entries;           // Vezes que a thread dormiu em standby
+    uint64_t resumes;                   // Vezes que um 'write' a acordou
+    uint64_t standby_latency_last_ns;   // Da decisão de standby até a thread dormir (liberação do estado)
+    uint64_t standby_latency_max_ns;
+    uint64_t resume_latency_last_ns;    // Do 'write' que acordou até o início do primeiro período
+    uint64_t resume_latency_max_ns;
+    uint64_t standby_ms;                // Tempo total em standby (ciclos concluídos)
+} audio_render_stats_t;
+
+// Histograma de latência com baldes fixos: o balde 0 conta durações abaixo de
+// 2^AUDIO_METRICS_LATENCY_BUCKET0_SHIFT ns (~1 us); o balde k (k >= 1) conta
+// [2^(k+9), 2^(k+10)) ns; o último também acumula tudo acima (>= ~16,8 ms).
+#define AUDIO_METRICS_LATENCY_BUCKETS 16
+#define AUDIO_METRICS_LATENCY_BUCKET0_SHIFT 10
+typedef struct {
+    uint64_t count;           // Amostras registradas
+    uint64_t sum_ns;          // Soma das durações (média = sum_ns / count)
+    uint64_t max_ns;          // Maior duração observada
+    uint64_t buckets[AUDIO_METRICS_LATENCY_BUCKETS];
+} audio_latency_histogram_t;
+
+// Snapshot das métricas do caminho de áudio (ver 'get_metrics').
+typedef struct {
+    uint64_t bytes_written;       // Bytes aceitos por 'write'
+    uint64_t frames_written;      // Frames aceitos por 'write'
+    uint64_t overruns;            // Escritas truncadas por falta de espaço na fila
+    uint64_t frames_rendered;     // Frames entregues pelo lado consumidor
+    uint64_t periods_rendered;    // Períodos processados
+    uint64_t underruns;           // Períodos em que um stream que tocava ficou sem dados
+    audio_latency_histogram_t write_latency;   // Duração de cada chamada a 'write' (todos os streams)
+    audio_latency_histogram_t process_latency; // Duração do processamento de cada período
+} audio_metrics_t;
+
+// --- Streams de Saída ---
+// Número máximo de streams abertos ao mesmo tempo, incluindo o stream primário
+// que o próprio dispositivo abre (usado por 'write').
+#define AUDIO_MAX_OUTPUT_STREAMS 8
+// Atenuação aplicada a um stream enquanto outro de prioridade maior toca (-12 dB).
+#define AUDIO_DUCK_GAIN 0.25f
+
+// Uso de um stream de saída no veículo.
+typedef enum {
+    AUDIO_USAGE_MEDIA = 0,        // Música, rádio
+    AUDIO_USAGE_NAVIGATION,       // Instruções do navegador
+    AUDIO_USAGE_CHIME,            // Alertas do veículo (cinto, porta aberta)
+    AUDIO_USAGE_PHONE,            // Chamada telefônica
+} audio_usage_t;
+
+// Formato das amostras de um stream. O dispositivo sempre mistura em float e
+// entrega PCM 16 bits estéreo; cada stream é convertido na leitura, por kernels
+// escolhidos na abertura (ver pcm_format.h).
+typedef enum {
+    AUDIO_FORMAT_DEFAULT = 0,       // Igual a AUDIO_FORMAT_PCM_16_BIT
+    AUDIO_FORMAT_PCM_16_BIT,        // int16
+    AUDIO_FORMAT_PCM_24_BIT_PACKED, // int24 empacotado em 3 bytes, little-endian
+    AUDIO_FORMAT_PCM_32_BIT,        // int32 (escala completa de 32 bits)
+    AUDIO_FORMAT_PCM_FLOAT,         // float32 em [-1, 1]
+} audio_format_t;
+// Canais aceitos por stream (até 7.1).
+#define AUDIO_MAX_STREAM_CHANNELS 8
+
+// Qualidade do conversor de taxa de um stream cuja taxa difere de HAL_SAMPLE_RATE
+// (ver resampler.h). Mais taps dão mais atenuação de imagens/aliasing e banda
+// passante mais larga, ao custo de CPU e de latência (metade dos taps, em frames
+// de entrada): LOW_LATENCY 8 taps/~40 dB, LOW 16/~60 dB, MEDIUM 32/~80 dB,
+// HIGH 64/~100 dB.
+typedef enum {
+    AUDIO_RESAMPLER_QUALITY_DEFAULT = 0,  // Igual a AUDIO_RESAMPLER_QUALITY_MEDIUM
+    AUDIO_RESAMPLER_QUALITY_LOW_LATENCY,
+    AUDIO_RESAMPLER_QUALITY_LOW,
+    AUDIO_RESAMPLER_QUALITY_MEDIUM,
+    AUDIO_RESAMPLER_QUALITY_HIGH,
+} audio_resampler_quality_t;
+
+// --- Memória Compartilhada de PCM (produtor sem cópia) ---
+// Um stream pode usar como fila uma região fornecida pelo cliente (ByteBuffer
+// direto do Kotlin, memfd/ashmem mapeado), que o produtor preenche no lugar e a
+// thread de renderização lê no lugar. Layout da região:
+//   [0, AUDIO_SHARED_PCM_HEADER_BYTES)  cabeçalho de controle da fila
+//   [AUDIO_SHARED_PCM_HEADER_BYTES, ...) dados: a maior potência de dois que couber
+// O cabeçalho é da HAL: ela guarda ali as posições de escrita e de leitura
+// (contadores livres de 32 bits em offsets fixos, cada um em sua linha de
+// cache), e o cliente não deve lê-lo nem escrevê-lo. O cliente acompanha a
+// própria posição de escrita, escreve os dados a partir de
+// 'pos & (capacidade - 1)' e os publica com 'commit', cujo retorno é o espaço
+// livre. Ponteiros e tamanhos da fila nunca ficam na região.
+// O início da região precisa estar alinhado a AUDIO_SHARED_PCM_ALIGNMENT bytes.
+#define AUDIO_SHARED_PCM_ALIGNMENT 64
+#define AUDIO_SHARED_PCM_HEADER_BYTES 192
+#define AUDIO_SHARED_PCM_WRITE_POS_OFFSET 0
+#define AUDIO_SHARED_PCM_READ_POS_OFFSET 64
+// Menor área de dados aceita: um período máximo no formato do dispositivo.
+#define AUDIO_SHARED_PCM_MIN_BYTES (HAL_MAX_PERIOD_FRAMES * HAL_FRAME_SIZE)
+
+// Configuração de abertura de um stream. Formato, canais e taxa são do stream
+// (zerados = PCM 16 bits com HAL_CHANNELS canais a HAL_SAMPLE_RATE); uma taxa
+// diferente passa por um conversor polifásico antes da mistura e do equalizador.
+typedef struct {
+    audio_usage_t usage;
+    // Ducking: enquanto houver um stream com prioridade MAIOR tocando, este é
+    // atenuado por AUDIO_DUCK_GAIN. Streams de mesma prioridade não se atenuam.
+    int priority;
+    float gain;                   // Ganho linear inicial (0..1)
+    audio_format_t format;        // Formato das amostras em 'write'/'commit'
+    int channels;                 // 1..AUDIO_MAX_STREAM_CHANNELS, intercalados (0 = HAL_CHANNELS)
+    // Opcional: região compartilhada usada como fila do stream (layout acima).
+    // NULL usa a fila interna do slot. A região precisa continuar válida até
+    // 'close_output_stream' retornar 0.
+    void* shared_memory;
+    size_t shared_bytes;
+    uint32_t sample_rate;         // Hz, 8000..192000 (0 = HAL_SAMPLE_RATE)
+    audio_resampler_quality_t resampler_quality; // Usada só quando a taxa difere
+} audio_stream_config_t;
+
+// Stream de saída (equivalente simplificado de 'audio_stream_out' do Android).
+// Cada stream tem sua própria fila lock-free; 'write' segue as mesmas regras
+// de 'audio_hw_device::write' (não bloqueia, aceita só frames completos que
+// couberem), com frames no formato e número de canais da configuração. 'write' e
+// 'commit' devem ser chamados por uma única thread produtora por stream.
+typedef struct audio_stream_out {
+    int (*write)(struct audio_stream_out* stream, const void* buffer, size_t bytes);
+    // Ganho linear do stream (0..1), aplicado com rampa de um período.
+    int (*set_volume)(struct audio_stream_out* stream, float gain);
+    // Produtor sem cópia: publica 'bytes' (frames completos, no formato do stream)
+    // que o produtor já escreveu nos dados da fila a partir da posição de escrita.
+    // Retorna o espaço livre restante em bytes, ou um código de erro negativo.
+    int (*commit)(struct audio_stream_out* stream, size_t bytes);
+} audio_stream_out_t;
+
+// Bandas do layout padrão do equalizador (3 bandas), usado até 'set_eq_layout'.
+// Os índices são usados por 'set_eq_band_level' e pelas funções JNI correspondentes.
+enum {
+    AUDIO_EQ_BAND_BASS = 0,     // Graves (low shelf)
+    AUDIO_EQ_BAND_MID = 1,      // Médios (peaking)
+    AUDIO_EQ_BAND_TREBLE = 2,   // Agudos (high shelf)
+    AUDIO_EQ_NUM_BANDS = 3,
+};
+
+// --- Layout do Equalizador ---
+// Com 'set_eq_layout' o equalizador passa a ter até AUDIO_EQ_MAX_BANDS bandas
+// configuráveis, com os níveis (0..100, 50 = plano) indexados na ordem do layout.
+#define AUDIO_EQ_MAX_BANDS 10
+typedef enum {
+    AUDIO_EQ_SHAPE_LOW_SHELF = 0,
+    AUDIO_EQ_SHAPE_PEAKING,
+    AUDIO_EQ_SHAPE_HIGH_SHELF,
+} audio_eq_shape_t;
+
+typedef struct {
+    audio_eq_shape_t shape;
+    float freq_hz;              // Frequência central (peaking) ou de corte (shelves)
+    float q;                    // Fator de qualidade
+} audio_eq_band_t;
+
+// Presets do equalizador ('load_eq_preset'), válidos para qualquer layout.
+typedef enum {
+    AUDIO_EQ_PRESET_FLAT = 0,
+    AUDIO_EQ_PRESET_ROCK,
+    AUDIO_EQ_PRESET_POP,
+    AUDIO_EQ_PRESET_JAZZ,
+    AUDIO_EQ_PRESET_CLASSICAL,
+    AUDIO_EQ_PRESET_VOCAL,
+    AUDIO_EQ_PRESET_BASS_BOOST,
+    AUDIO_EQ_PRESET_COUNT,
+} audio_eq_preset_t;
+
+// --- Zonas de Saída ---
+// O dispositivo renderiza a mesma mistura de streams para até AUDIO_MAX_ZONES
+// zonas do veículo, cada uma com seu equalizador, seu volume e seu sink. A zona
+// 0 é a saída principal: 'set_eq_*' e 'set_output_sink' se referem a ela, e
+// 'render' escreve nela. O volume mestre vale para todas as zonas.
+#define AUDIO_MAX_ZONES 8
+enum {
+    AUDIO_ZONE_FRONT = 0,       // Saída principal (zona 0)
+    AUDIO_ZONE_REAR = 1,        // Bancos traseiros
+    AUDIO_ZONE_HEADREST = 2,    // Alto-falantes dos encostos de cabeça
+};
+
+// --- Parâmetros do Veículo ---
+// Sinais do veículo que a HAL consome (normalmente decodificados da CAN, ver
+// can_decoder.h), em unidades físicas. São publicados em lote por
+// 'set_vehicle_params': um lote com vários sinais é uma única chamada.
+typedef enum {
+    AUDIO_VEHICLE_PARAM_MASTER_VOLUME = 0, // Volume do veículo 0..100, convertido em ganho por uma curva em dB
+    AUDIO_VEHICLE_PARAM_SPEED_KMH,         // Velocidade do veículo em km/h
+    AUDIO_VEHICLE_PARAM_COUNT,
+} audio_vehicle_param_t;
+
+typedef struct {
+    audio_vehicle_param_t param;
+    float value;
+} audio_vehicle_param_update_t;
+
+// --- Dinâmica (ver dynamics.h) ---
+// Compensação do ruído de rodagem pela velocidade do veículo e limitador de
+// pico na saída de cada zona. A compensação cresce linearmente com a velocidade
+// até 'speed_ref_kmh'. Ligada, a dinâmica atrasa a saída (ver
+// 'audio_render_stats_t::latency_frames').
+typedef struct {
+    bool enabled;
+    float speed_ref_kmh;          // Velocidade com a compensação completa (> 0)
+    float speed_gain_db;          // Ganho a 'speed_ref_kmh' (0..12 dB)
+    float loudness_bass_db;       // Reforço de graves a 'speed_ref_kmh' (0..12 dB)
+    float loudness_treble_db;     // Reforço de agudos a 'speed_ref_kmh' (0..12 dB)
+    float limiter_threshold_db;   // Teto do limitador (-24..0 dBFS)
+    float limiter_release_ms;     // Tempo de recuperação do ganho (1..5000 ms)
+} audio_dynamics_config_t;
+
+// Estrutura específica do dispositivo de áudio.
+// Estende a estrutura genérica 'hw_device_t' com operações específicas de áudio.
+// 'audio_hw_device_t' é um alias (typedef) para 'struct audio_hw_device'.
+typedef struct audio_hw_device {
+    struct hw_device_t common; // Membro comum, herdando as propriedades e métodos de 'hw_device_t'
+
+    // Operações específicas de áudio.
+    // A função 'write' (produtor) enfileira PCM 16 bits intercalado sem bloquear,
+    // no stream primário (mídia, prioridade 0) aberto pelo próprio dispositivo.
+    int (*write)(struct audio_hw_device* dev, const void* buffer, size_t bytes);
+
+    // Abre um stream adicional (navegação, alertas, telefone), misturado aos
+    // demais a cada período. Retorna -ENOSPC se não houver slot livre.
+    int (*open_output_stream)(struct audio_hw_device* dev, const audio_stream_config_t* config,
+                              audio_stream_out_t** stream_out);
+    // Fecha um stream aberto por 'open_output_stream', aguardando a thread de
+    // renderização deixar de lê-lo. O stream primário não pode ser fechado.
+    // Com -ETIMEDOUT o stream já saiu da mistura, mas o slot segue reservado:
+    // chamar de novo com o mesmo stream conclui o fechamento.
+    int (*close_output_stream)(struct audio_hw_device* dev, audio_stream_out_t* stream);
+    // Volume mestre linear (0..1), aplicado após a mistura e o equalizador, com rampa.
+    int (*set_master_volume)(struct audio_hw_device* dev, float volume);
+
+    // Lado consumidor: drena um período de cada stream, mistura, aplica o processamento
+    // e escreve o PCM resultante em 'out'. Faltando dados, completa com silêncio.
+    // Normalmente é a thread de renderização do próprio dispositivo que consome a fila;
+    // chamadas manuais só são aceitas com ela parada (senão retorna -EBUSY).
+    int (*render)(struct audio_hw_device* dev, void* out, size_t bytes);
+
+    // Controle da thread de renderização (iniciada por 'open'), que a cada período
+    // chama 'render' e entrega o resultado ao sink. Não são chamadas de tempo real.
+    int (*start_render_thread)(struct audio_hw_device* dev);
+    int (*stop_render_thread)(struct audio_hw_device* dev);
+    // Troca o tamanho do período (HAL_MIN_PERIOD_FRAMES..HAL_MAX_PERIOD_FRAMES), reiniciando a thread.
+    int (*set_period_size)(struct audio_hw_device* dev, size_t frames);
+    // Registra o destino dos períodos processados (NULL descarta o áudio).
+    int (*set_output_sink)(struct audio_hw_device* dev, audio_sink_fn sink, void* cookie);
+    int (*get_render_stats)(struct audio_hw_device* dev, audio_render_stats_t* stats);
+
+    // Contadores de overrun (escritas truncadas) e underrun (períodos incompletos).
+    int (*get_xrun_counts)(struct audio_hw_device* dev, uint64_t* overruns, uint64_t* underruns);
+    // Snapshot das métricas (contadores e histogramas de latência). Lock-free; qualquer thread.
+    int (*get_metrics)(struct audio_hw_device* dev, audio_metrics_t* metrics);
+
+    // Extensões do fornecedor (vendor extensions) para o equalizador.
+    // Podem ser chamadas de qualquer thread (UI, Binder); o lado consumidor
+    // aplica a mudança no início do próximo período.
+    int (*set_eq_enabled)(struct audio_hw_device* dev, bool enabled);
+    // 'band' é um dos valores AUDIO_EQ_BAND_*; 'level' vai de 0 a 100 (50 = plano).
+    int (*set_eq_band_level)(struct audio_hw_device* dev, int band, int level);
+
+    // Zonas (ver AUDIO_MAX_ZONES). Operações de controle, não de tempo real.
+    // Número de zonas renderizadas por período (1..AUDIO_MAX_ZONES). As cadeias
+    // DSP das zonas rodam em paralelo em um pool fixo de workers, criado aqui.
+    int (*set_zone_count)(struct audio_hw_device* dev, int zones);
+    // Destino dos períodos de uma zona (zona 0: o mesmo que 'set_output_sink').
+    // As zonas 1.. são entregues também quando 'render' é chamado manualmente.
+    int (*set_zone_sink)(struct audio_hw_device* dev, int zone, audio_sink_fn sink, void* cookie);
+    // Volume linear da zona (0..1), multiplicado pelo volume mestre, com rampa.
+    int (*set_zone_volume)(struct audio_hw_device* dev, int zone, float volume);
+    // Equalizador da zona, com as mesmas regras de 'set_eq_enabled' / 'set_eq_band_level'.
+    int (*set_zone_eq_enabled)(struct audio_hw_device* dev, int zone, bool enabled);
+    int (*set_zone_eq_band_level)(struct audio_hw_device* dev, int zone, int band, int level);
+
+    // Publica sinais do veículo (lock-free, qualquer thread, sem alocação). Com
+    // mais de uma atualização do mesmo parâmetro no lote, vale a última.
+    // Retorna -EINVAL (sem aplicar nada) se algum parâmetro ou valor for inválido.
+    int (*set_vehicle_params)(struct audio_hw_device* dev, const audio_vehicle_param_update_t* updates,
+                              size_t count);
+    // Último valor publicado de um parâmetro (para diagnóstico e testes).
+    int (*get_vehicle_param)(struct audio_hw_device* dev, audio_vehicle_param_t param, float* value);
+
+    // Configura o estágio de dinâmica de todas as zonas (desligado por padrão).
+    // Operação de controle: reinicia a thread de renderização e zera o estado
+    // do limitador. Retorna -EINVAL para valores fora das faixas.
+    int (*set_dynamics_config)(struct audio_hw_device* dev, const audio_dynamics_config_t* config);
+
+    // Troca o layout do equalizador de todas as zonas (1..AUDIO_EQ_MAX_BANDS
+    // bandas; ver audio_eq_band_t). Operação de controle: os coeficientes de
+    // todos os níveis de cada banda são calculados aqui, e todas as bandas
+    // voltam ao plano. Retorna -EINVAL para um layout inválido.
+    int (*set_eq_layout)(struct audio_hw_device* dev, const audio_eq_band_t* bands, int count);
+    // Ajusta todas as bandas de uma vez ('count' = bandas do layout): os
+    // coeficientes vêm do cache do layout e são publicados com uma única troca
+    // atômica. Mesmas regras de thread de 'set_eq_band_level'.
+    int (*set_eq_bands)(struct audio_hw_device* dev, const int* levels, int count);
+    int (*set_zone_eq_bands)(struct audio_hw_device* dev, int zone, const int* levels, int count);
+    // Carrega um preset (AUDIO_EQ_PRESET_*), também por consulta ao cache.
+    int (*load_eq_preset)(struct audio_hw_device* dev, int preset);
+    int (*load_zone_eq_preset)(struct audio_hw_device* dev, int zone, int preset);
+
+    // Resumo (hash) do estado de processamento que decide a saída dos próximos
+    // períodos: dois dispositivos com o mesmo resumo e as mesmas entradas
+    // renderizam a mesma saída, bit a bit. Só com a thread de renderização
+    // parada (senão -EBUSY). Usado pelo renderizador offline (offline_render.h).
+    int (*get_render_state_digest)(struct audio_hw_device* dev, uint64_t* digest);
+
+    // Tempo sem dados depois do qual a thread de renderização entra em standby
+    // (padrão AUDIO_STANDBY_DEFAULT_MS; 0 desliga). Em standby nenhum período é
+    // entregue aos sinks; o próximo 'write' acorda a thread, que renderiza na
+    // hora, com os streams entrando em rampa a partir do silêncio.
+    int (*set_standby_delay)(struct audio_hw_device* dev, uint32_t delay_ms);
+
+    void* reserved[32 - 29]; // Campos reservados para outras funções de áudio não simuladas
+} audio_hw_device_t;
+
+// Estrutura para o módulo de áudio.
+// Usada para definir o símbolo HAL_MODULE_INFO_SYM que o Android procura em bibliotecas compartilhadas.
+// 'audio_module_t' é um alias (typedef) para 'struct audio_module'.
+typedef struct audio_module {
+    struct hw_module_t common; // Membro comum, herdando as propriedades de 'hw_module_t'
+} audio_module_t;
+
+// Macros e Constantes cruciais para a identificação e versão das HALs.
+#define HARDWARE_MODULE_TAG        0x4D4F4455 // "MODU" - Tag para módulos de hardware (ASCII para MODU)
+#define HARDWARE_DEVICE_TAG        0x44455649 // "DEVI" - Tag para dispositivos de hardware (ASCII para DEVI)
+
+#define AUDIO_DEVICE_API_VERSION_2_0 0x02000000 // Versão da API do dispositivo de áudio (Major 2, Minor 0)
+
+#define AUDIO_HARDWARE_MODULE_ID   "audio"    // ID padrão para o módulo HAL de áudio (usado por hw_get_module)
+#define AUDIO_HARDWARE_INTERFACE   "primary"  // Nome da interface primária de áudio (comum para áudio)
+
+// Símbolo de Informação do Módulo HAL, definido em audio_hal.cpp.
+extern struct audio_module HAL_MODULE_INFO_SYM;
+
+#endif // MYAUDIOHALPROJECT_AUDIO_HAL_H
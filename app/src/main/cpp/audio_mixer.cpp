@@ -0,0 +1,88 @@
+// --- Includes Padrão ---
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>       // Para lrintf
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // Intrínsecos SSE/SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>   // Intrínsecos NEON
+#endif
+
+#include "audio_mixer.h"
+#include "eq_dsp.h"     // Para eq_active_kernel (mesma escolha de kernel do equalizador)
+
+
+// --- Kernel Escalar (fallback e rampas de ganho) ---
+
+static void gain_to_s16_scalar(const float* in, int16_t* out, size_t frames, int channels,
+                               float gain, float gain_step) {
+    for (size_t i = 0; i < frames; i++) {
+        const float g = (gain + (float)i * gain_step) * 32768.0f;
+        for (int c = 0; c < channels; c++) {
+            const size_t k = i * channels + c;
+            float v = in[k] * g;
+            v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+            out[k] = (int16_t)lrintf(v); // Empate para o par, como os kernels SIMD
+        }
+    }
+}
+
+
+// --- Kernel SSE (ganho constante) ---
+#if defined(__SSE2__)
+
+static void gain_to_s16_sse(const float* in, int16_t* out, size_t samples, float gain) {
+    const __m128 g = _mm_set1_ps(gain * 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        // cvtps arredonda como lrintf (empate para o par); packs satura em [-32768, 32767].
+        const __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), g));
+        const __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), g));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+    }
+    gain_to_s16_scalar(in + i, out + i, samples - i, 1, gain, 0.0f);
+}
+
+#endif // __SSE2__
+
+
+// --- Kernel NEON (ganho constante) ---
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+static void gain_to_s16_neon(const float* in, int16_t* out, size_t samples, float gain) {
+    const float32x4_t g = vdupq_n_f32(gain * 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        // vcvt satura em 32 bits e vqmovn satura para 16 bits.
+        const int32x4_t lo = neon_round_s32(vmulq_f32(vld1q_f32(in + i), g));
+        const int32x4_t hi = neon_round_s32(vmulq_f32(vld1q_f32(in + i + 4), g));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    gain_to_s16_scalar(in + i, out + i, samples - i, 1, gain, 0.0f);
+}
+
+#endif // __ARM_NEON
+
+
+// --- API Pública ---
+// Com ganho constante o frame deixa de importar: as amostras intercaladas são
+// tratadas como um vetor contínuo de frames * channels elementos.
+
+void mixer_apply_gain_to_s16(const float* in, int16_t* out, size_t frames, int channels,
+                             float gain, float gain_step) {
+    if (gain_step == 0.0f) {
+        const size_t samples = frames * channels;
+        switch (eq_active_kernel()) {
+#if defined(__SSE2__)
+            case EQ_KERNEL_SSE: gain_to_s16_sse(in, out, samples, gain); return;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+            case EQ_KERNEL_NEON: gain_to_s16_neon(in, out, samples, gain); return;
+#endif
+            default: break;
+        }
+    }
+    gain_to_s16_scalar(in, out, frames, channels, gain, gain_step);
+}
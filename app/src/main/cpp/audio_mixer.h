@@ -0,0 +1,29 @@
+// --- Mixer de Streams de Saída ---
+// A soma dos streams no acumulador float é feita pelos kernels de conversão de
+// cada formato (pcm_format.h), em uma passada de multiplicação-acumulação por
+// stream ativo. Aqui fica o último passo: converter a mistura de volta para
+// 16 bits com saturação. Nenhuma função aloca memória.
+// Com ganho constante (o caso comum) o kernel é vetorizado ao longo das
+// amostras (SSE2/NEON); durante uma rampa de ganho (troca de volume mestre)
+// o ganho muda a cada frame e o laço escalar é usado. O kernel SIMD segue o
+// kernel escolhido pelo equalizador (ver eq_active_kernel).
+#ifndef MYAUDIOHALPROJECT_AUDIO_MIXER_H
+#define MYAUDIOHALPROJECT_AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Aplica o ganho final (volume mestre) e converte para 16 bits com saturação:
+ * out[k] = sat16(round(in[k] * g(frame) * 32768)).
+ * @param in Mistura float intercalada (frames * channels amostras).
+ * @param out PCM 16 bits intercalado.
+ * @param frames Frames a converter.
+ * @param channels Canais intercalados.
+ * @param gain Ganho linear no primeiro frame; g = gain + i * gain_step no frame i.
+ * @param gain_step Incremento do ganho por frame (0 = ganho constante).
+ */
+void mixer_apply_gain_to_s16(const float* in, int16_t* out, size_t frames, int channels,
+                             float gain, float gain_step);
+
+#endif // MYAUDIOHALPROJECT_AUDIO_MIXER_H
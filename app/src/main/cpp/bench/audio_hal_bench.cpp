@@ -0,0 +1,1292 @@
+// --- Benchmark da HAL de Áudio (build de host) ---
+// Executável de linha de comando para detectar regressões de desempenho do
+// núcleo da HAL em máquinas Linux de CI, sem emulador.
+//
+// O dispositivo é aberto exatamente como o Android faria, por
+// HAL_MODULE_INFO_SYM.common.methods->open. A thread de renderização é parada
+// e o benchmark faz o papel de consumidor, drenando a fila com 'render', para
+// que o tempo medido seja o do processamento e não o do relógio de tempo real.
+//
+// Seções:
+// 1. write: entrega de buffers de 64 B a 64 KiB pela HAL (write + render dos
+//    períodos completados), com vazão e percentis de latência por chamada.
+//    O stream primário é PCM 16 bits estéreo; os demais formatos e números de
+//    canais são medidos nas seções 2 e 5.
+// 2. dsp: cascata do equalizador para 1..8 canais, com entrada int16 (incluindo
+//    as conversões) e float32, em frames por segundo; e a conferência de que a
+//    conversão para 16 bits do kernel SIMD é idêntica à do escalar.
+// 3. mix: custo de um período com 1..AUDIO_MAX_OUTPUT_STREAMS streams ativos
+//    (mistura + equalizador + volume mestre), que deve crescer linearmente.
+// 4. feed: alimentação de um stream por cópia ('write' a partir de um buffer do
+//    produtor) contra a fila em memória compartilhada (o produtor escreve no
+//    lugar e só chama 'commit'), por período produzido e renderizado.
+// 5. convert: kernels de conversão dos streams (pcm_format.h) por formato e
+//    número de canais: soma no acumulador da mistura e separação em planos,
+//    contra uma conversão genérica que decide o formato a cada amostra.
+// 6. resample: conversor de taxa polifásico (resampler.h) para cada preset de
+//    qualidade, de 44,1 kHz e 96 kHz para 48 kHz: latência, frames de saída por
+//    segundo e SNR de senoides de 1 kHz e 10 kHz contra a senoide ideal
+//    (conferida contra um mínimo por preset).
+// 7. zones: período completo com 1..AUDIO_MAX_ZONES zonas (mistura compartilhada
+//    + equalizador e volume por zona, no pool de workers), em períodos de 5 ms e
+//    20 ms: percentis por período, vazão em frames de zona por segundo e ganho
+//    sobre o custo serial estimado (zonas x custo de uma zona).
+// 8. can: decodificação dos frames CAN pela tabela do veículo (can_decoder.h),
+//    da fila em processo até 'set_vehicle_params', em lotes de 1..64 frames
+//    (frames por segundo e custo por frame), conferindo os valores publicados,
+//    e o replay de um log do candump gerado na hora (linhas interpretadas por
+//    segundo).
+// 9. dynamics: período da zona principal sem dinâmica, com o limitador parado
+//    (0 km/h) e com loudness e ganho por velocidade (120 km/h), com o sinal
+//    empurrado acima do teto (o pico com dinâmica é conferido contra o teto);
+//    mais a vazão do limitador isolado e a latência que ele acrescenta.
+// 10. eq: layouts de 3 e 10 bandas: cálculo do cache de coeficientes do layout,
+//    troca de preset projetando os coeficientes na hora (o caminho antigo)
+//    contra 'load_eq_preset' (consulta ao cache + troca atômica), ajuste de
+//    todas as bandas banda a banda contra 'set_eq_bands', e o período renderizado.
+// 11. standby: com a thread de renderização em tempo real (única seção que usa
+//    o relógio), despertares por segundo com o dispositivo ocioso, sem e com
+//    standby, e as latências de entrar em standby e de voltar dele no 'write'.
+// 12. trace: custo dos marcadores por etapa (hal_trace.h) em um período com 2
+//    streams, equalizador e dinâmica: sem marcadores (build sem HAL_TRACE), ou
+//    compilados com a gravação desligada e ligada, mais o custo por marcador e
+//    o da exportação para JSON. Compare a linha da build sem HAL_TRACE com a
+//    da build com -DHAL_TRACE=ON.
+//
+// Código de saída: 0; 1 se uma seção não puder ser medida (interrompe na hora)
+// ou se alguma conferência falhar (relatadas em stderr como "FALHA: ...", com
+// todas as seções medidas); 2 para argumentos inválidos.
+//
+// Uso: audio_hal_bench [--quick] [--kernel auto|scalar|sse|neon]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "audio_hal.h"
+#include "eq_dsp.h"
+#include "audio_mixer.h"
+#include "pcm_format.h"
+#include "resampler.h"
+#include "can_decoder.h"
+#include "dynamics.h"
+#include "hal_trace.h"
+#include "hal_metrics.h"
+#include <unistd.h>
+
+#define BENCH_PERIOD_FRAMES HAL_PERIOD_FRAMES
+#define BENCH_PERIOD_BYTES (BENCH_PERIOD_FRAMES * HAL_FRAME_SIZE)
+#define BENCH_TRACE_PERIODS 256     // Períodos exportados na seção 12
+
+// Percentil (0..100) de amostras já ordenadas.
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = (size_t)(p / 100.0 * (double)(sorted.size() - 1) + 0.5);
+    return sorted[idx];
+}
+
+// Conferências de corretude feitas junto com as medições. Uma falha é
+// registrada e o benchmark segue; no fim, main retorna 1.
+static int bench_failures = 0;
+
+static void bench_check(bool ok, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void bench_check(bool ok, const char* fmt, ...) {
+    if (ok) return;
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "FALHA: ");
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    bench_failures++;
+}
+
+// Sinal de teste: seno de 1 kHz com um pouco de ruído, para que o conteúdo
+// não seja trivial (silêncio exercitaria caminhos de denormal diferentes).
+static void fill_test_signal_s16(int16_t* pcm, size_t frames, int channels) {
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < frames; i++) {
+        const float s = 0.5f * sinf(2.0f * (float)M_PI * 1000.0f * (float)i / (float)HAL_SAMPLE_RATE);
+        for (int c = 0; c < channels; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            const float noise = ((float)(seed >> 9) / (float)(1u << 23) - 0.5f) * 0.05f;
+            pcm[i * channels + c] = (int16_t)((s + noise) * 32767.0f);
+        }
+    }
+}
+
+/**
+ * Seção 1: entrega 'bytes' por chamada pela HAL e mede cada chamada.
+ * Uma "chamada" é o write (repetido enquanto a fila estiver cheia) mais os
+ * renders dos períodos que ficaram completos, ou seja, o custo de ponta a ponta.
+ * O tempo apenas dentro de 'write' (o que a thread JNI/Binder paga) é medido à parte.
+ */
+static int bench_write(audio_hw_device_t* dev, size_t bytes, size_t total_bytes) {
+    size_t calls = total_bytes / bytes;
+    if (calls < 200) calls = 200;
+
+    std::vector<int16_t> input(bytes / sizeof(int16_t));
+    fill_test_signal_s16(input.data(), bytes / HAL_FRAME_SIZE, HAL_CHANNELS);
+    static int16_t period[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+
+    std::vector<uint64_t> total_lat(calls), write_lat(calls);
+    size_t queued = 0; // Bytes na fila ainda não drenados (menos de um período entre chamadas)
+    const uint64_t start = hal_metrics_now_ns();
+    for (size_t i = 0; i < calls; i++) {
+        const uint8_t* p = (const uint8_t*)input.data();
+        size_t remaining = bytes;
+        uint64_t in_write = 0;
+        const uint64_t t0 = hal_metrics_now_ns();
+        while (remaining > 0) {
+            const uint64_t w0 = hal_metrics_now_ns();
+            int n = dev->write(dev, p, remaining);
+            in_write += hal_metrics_now_ns() - w0;
+            if (n < 0) {
+                fprintf(stderr, "write falhou: %d\n", n);
+                return n;
+            }
+            p += n;
+            remaining -= (size_t)n;
+            queued += (size_t)n;
+            while (queued >= BENCH_PERIOD_BYTES) {
+                int r = dev->render(dev, period, BENCH_PERIOD_BYTES);
+                if (r < 0) {
+                    fprintf(stderr, "render falhou: %d\n", r);
+                    return r;
+                }
+                queued -= BENCH_PERIOD_BYTES;
+            }
+        }
+        total_lat[i] = hal_metrics_now_ns() - t0;
+        write_lat[i] = in_write;
+    }
+    const double elapsed_s = (double)(hal_metrics_now_ns() - start) / 1e9;
+
+    std::sort(total_lat.begin(), total_lat.end());
+    std::sort(write_lat.begin(), write_lat.end());
+    const double mb_s = (double)(calls * bytes) / elapsed_s / 1e6;
+    const double audio_s = (double)(calls * bytes) / HAL_FRAME_SIZE / HAL_SAMPLE_RATE;
+    printf("%8zu %8zu %9.1f %8.0fx %9llu %9llu %9llu %9llu %9llu %9llu\n",
+           bytes, calls, mb_s, audio_s / elapsed_s,
+           (unsigned long long)percentile(total_lat, 50), (unsigned long long)percentile(total_lat, 90),
+           (unsigned long long)percentile(total_lat, 99), (unsigned long long)total_lat.back(),
+           (unsigned long long)percentile(write_lat, 50), (unsigned long long)percentile(write_lat, 99));
+    return 0;
+}
+
+/**
+ * Seção 2: custo da cascata do equalizador por formato e número de canais,
+ * processando períodos de 'frames' frames em blocos de EQ_BLOCK_FRAMES.
+ */
+static void bench_dsp(int channels, bool s16_input, size_t frames, size_t total_frames) {
+    eq_state_t eq;
+    eq_init(&eq, (float)HAL_SAMPLE_RATE, channels);
+    eq_set_band_level(&eq, AUDIO_EQ_BAND_BASS, 80);
+    eq_set_band_level(&eq, AUDIO_EQ_BAND_MID, 40);
+    eq_set_band_level(&eq, AUDIO_EQ_BAND_TREBLE, 70);
+
+    std::vector<int16_t> pcm(frames * channels);
+    fill_test_signal_s16(pcm.data(), frames, channels);
+    std::vector<float> fpcm(frames * channels);
+    eq_s16_to_float(pcm.data(), fpcm.data(), frames * channels);
+    alignas(16) static float work[EQ_BLOCK_FRAMES * EQ_MAX_CHANNELS];
+
+    const size_t iterations = total_frames / frames;
+    const uint64_t start = hal_metrics_now_ns();
+    for (size_t it = 0; it < iterations; it++) {
+        for (size_t done = 0; done < frames; ) {
+            size_t chunk = frames - done;
+            if (chunk > EQ_BLOCK_FRAMES) chunk = EQ_BLOCK_FRAMES;
+            const size_t samples = chunk * channels;
+            if (s16_input) {
+                int16_t* block = pcm.data() + done * channels;
+                eq_s16_to_float(block, work, samples);
+                eq_process(&eq, work, chunk);
+                eq_float_to_s16(work, block, samples);
+            } else {
+                eq_process(&eq, fpcm.data() + done * channels, chunk);
+            }
+            done += chunk;
+        }
+    }
+    const double elapsed_ns = (double)(hal_metrics_now_ns() - start);
+    const double processed = (double)(iterations * frames);
+    printf("%-6s %8d %12.1f %10.2f %9.0fx\n", s16_input ? "s16" : "f32", channels,
+           processed / elapsed_ns * 1e3, elapsed_ns / processed, processed / HAL_SAMPLE_RATE / (elapsed_ns / 1e9));
+}
+
+/**
+ * Seção 2: confere que o kernel ativo converte float para 16 bits exatamente
+ * como o escalar (arredondamento e saturação), na saída do equalizador e no
+ * ganho do mixer. A entrada inclui os empates (k + 0,5) / 32768, valores fora
+ * de [-1, 1] e um tamanho que deixa uma cauda para o escalar.
+ * @return Número de amostras diferentes.
+ */
+static size_t check_s16_rounding(eq_kernel_t kernel) {
+    std::vector<float> in;
+    for (int k = -64; k < 64; k++) in.push_back(((float)k + 0.5f) / 32768.0f);
+    static const float edges[] = { -2.0f, -1.0f, -32767.5f / 32768.0f, 32766.5f / 32768.0f,
+                                   32767.5f / 32768.0f, 1.0f, 2.0f, 0.0f, -0.0f };
+    in.insert(in.end(), edges, edges + sizeof(edges) / sizeof(edges[0]));
+    uint32_t seed = 777;
+    while (in.size() < 4096 + 7) {
+        seed = seed * 1664525u + 1013904223u;
+        in.push_back(((float)(seed >> 8) / (float)(1u << 24) - 0.5f) * 2.4f);
+    }
+    const size_t samples = in.size();
+    std::vector<int16_t> ref(samples * 3), out(samples * 3);
+    // Ganho constante (passo 0): só assim o mixer usa o kernel SIMD.
+    int16_t* dst[2] = { ref.data(), out.data() };
+    const eq_kernel_t kernels[2] = { EQ_KERNEL_SCALAR, kernel };
+    for (int k = 0; k < 2; k++) {
+        eq_select_kernel(kernels[k]);
+        eq_float_to_s16(in.data(), dst[k], samples);
+        mixer_apply_gain_to_s16(in.data(), dst[k] + samples, samples, 1, 1.0f, 0.0f);
+        mixer_apply_gain_to_s16(in.data(), dst[k] + 2 * samples, samples, 1, 0.7f, 0.0f);
+    }
+    eq_select_kernel(kernel);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < ref.size(); i++) mismatches += ref[i] != out[i];
+    return mismatches;
+}
+
+/**
+ * Seção 3: abre 'streams' streams (o primário e mais streams - 1), escreve um
+ * período em cada e mede o 'render' que os mistura.
+ */
+static int bench_mix(int streams, size_t periods) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->stop_render_thread(dev);
+    dev->set_master_volume(dev, 0.8f);
+
+    audio_stream_out_t* extra[AUDIO_MAX_OUTPUT_STREAMS] = {};
+    for (int i = 1; i < streams; i++) {
+        audio_stream_config_t config = {};
+        config.usage = AUDIO_USAGE_MEDIA;
+        config.gain = 0.5f;
+        ret = dev->open_output_stream(dev, &config, &extra[i]);
+        if (ret != 0) break;
+    }
+    static int16_t input[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t period[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(input, BENCH_PERIOD_FRAMES, HAL_CHANNELS);
+
+    std::vector<uint64_t> lat(periods);
+    for (size_t p = 0; ret == 0 && p < periods; p++) {
+        dev->write(dev, input, sizeof(input));
+        for (int i = 1; i < streams; i++) {
+            extra[i]->write(extra[i], input, sizeof(input));
+        }
+        const uint64_t t0 = hal_metrics_now_ns();
+        dev->render(dev, period, sizeof(period));
+        lat[p] = hal_metrics_now_ns() - t0;
+    }
+    for (int i = 1; i < streams; i++) {
+        if (extra[i]) dev->close_output_stream(dev, extra[i]);
+    }
+    dev->common.close(&dev->common);
+    if (ret != 0) return ret;
+
+    std::sort(lat.begin(), lat.end());
+    const uint64_t p50 = percentile(lat, 50);
+    printf("%8d %10llu %10llu %12.1f\n", streams, (unsigned long long)p50,
+           (unsigned long long)percentile(lat, 99), (double)p50 / BENCH_PERIOD_FRAMES);
+    return 0;
+}
+
+/**
+ * Seção 4: um stream extra alimentado por 'write' (cópia do buffer do produtor
+ * para a fila) ou por memória compartilhada (PCM gerado direto na fila + 'commit').
+ * O produtor é simulado por uma cópia do sinal de teste, como o decodificador faria.
+ */
+static int bench_feed(bool shared, size_t periods) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->stop_render_thread(dev);
+
+    const size_t region_bytes = AUDIO_SHARED_PCM_HEADER_BYTES + 16384;
+    uint8_t* region = NULL;
+    if (posix_memalign((void**)&region, AUDIO_SHARED_PCM_ALIGNMENT, region_bytes) != 0) {
+        dev->common.close(&dev->common);
+        return -ENOMEM;
+    }
+    audio_stream_config_t config = {};
+    config.usage = AUDIO_USAGE_MEDIA;
+    config.gain = 1.0f;
+    if (shared) {
+        config.shared_memory = region;
+        config.shared_bytes = region_bytes;
+    }
+    audio_stream_out_t* stream = NULL;
+    ret = dev->open_output_stream(dev, &config, &stream);
+
+    static int16_t source[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t staging[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t period[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(source, BENCH_PERIOD_FRAMES, HAL_CHANNELS);
+    uint8_t* data = region + AUDIO_SHARED_PCM_HEADER_BYTES;
+    uint32_t write_pos = 0;
+
+    std::vector<uint64_t> produce(periods), total(periods);
+    for (size_t p = 0; ret == 0 && p < periods; p++) {
+        const uint64_t t0 = hal_metrics_now_ns();
+        if (shared) {
+            // O período (960 B) não divide a fila: o wrap-around cai no meio de um período.
+            const uint32_t offset = write_pos & (16384 - 1);
+            const size_t first = std::min<size_t>(BENCH_PERIOD_BYTES, 16384 - offset);
+            memcpy(data + offset, source, first);
+            memcpy(data, (const uint8_t*)source + first, BENCH_PERIOD_BYTES - first);
+            ret = stream->commit(stream, BENCH_PERIOD_BYTES) < 0 ? -EIO : 0;
+            write_pos += BENCH_PERIOD_BYTES;
+        } else {
+            memcpy(staging, source, sizeof(staging));
+            ret = stream->write(stream, staging, sizeof(staging)) < 0 ? -EIO : 0;
+        }
+        const uint64_t t1 = hal_metrics_now_ns();
+        dev->render(dev, period, sizeof(period));
+        produce[p] = t1 - t0;
+        total[p] = hal_metrics_now_ns() - t0;
+    }
+    if (stream) dev->close_output_stream(dev, stream);
+    uint64_t overruns = 0, underruns = 0;
+    dev->get_xrun_counts(dev, &overruns, &underruns);
+    dev->common.close(&dev->common);
+    free(region);
+    if (ret != 0) return ret;
+
+    std::sort(produce.begin(), produce.end());
+    std::sort(total.begin(), total.end());
+    printf("%-10s %12llu %12llu %12llu %10llu\n", shared ? "shared" : "write",
+           (unsigned long long)percentile(produce, 50), (unsigned long long)percentile(total, 50),
+           (unsigned long long)percentile(total, 99), (unsigned long long)(overruns + underruns));
+    return 0;
+}
+
+/**
+ * Referência da seção 5: conversão genérica, com o formato e os canais decididos
+ * em tempo de execução a cada amostra (o custo que os kernels especializados evitam).
+ */
+static void accumulate_generic(float* acc, const uint8_t* in, size_t frames, audio_format_t format,
+                               int channels, float gain) {
+    const size_t sample_bytes = audio_format_bytes(format);
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < 2; c++) {
+            const uint8_t* p = in + (i * channels + (c < channels ? c : 0)) * sample_bytes;
+            float v;
+            switch (format) {
+                case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+                    v = (float)((int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) |
+                                          ((uint32_t)p[2] << 24)) >> 8) / 8388608.0f;
+                    break;
+                case AUDIO_FORMAT_PCM_32_BIT: { int32_t x; memcpy(&x, p, 4); v = (float)x / 2147483648.0f; break; }
+                case AUDIO_FORMAT_PCM_FLOAT: memcpy(&v, p, 4); break;
+                default: { int16_t x; memcpy(&x, p, 2); v = (float)x / 32768.0f; break; }
+            }
+            acc[i * 2 + c] += v * gain;
+        }
+    }
+}
+
+/**
+ * Seção 5: vazão dos kernels de um (formato, canais), em blocos de
+ * EQ_BLOCK_FRAMES frames como no caminho de renderização.
+ */
+static void bench_convert(audio_format_t format, int channels, size_t total_frames) {
+    const pcm_kernels_t* kernels = pcm_kernels_select(format, channels);
+    const size_t frames = EQ_BLOCK_FRAMES;
+    std::vector<uint8_t> in(frames * kernels->frame_bytes);
+    std::vector<int16_t> pcm(frames * channels);
+    fill_test_signal_s16(pcm.data(), frames, channels);
+    // O mesmo sinal em cada formato: a amostra de 16 bits vai para o topo da palavra.
+    for (size_t k = 0; k < pcm.size(); k++) {
+        uint8_t* p = in.data() + k * audio_format_bytes(format);
+        const int32_t v32 = (int32_t)pcm[k] * 65536;
+        const float vf = (float)pcm[k] / 32768.0f;
+        switch (format) {
+            case AUDIO_FORMAT_PCM_24_BIT_PACKED: p[0] = 0; p[1] = (uint8_t)pcm[k]; p[2] = (uint8_t)(pcm[k] >> 8); break;
+            case AUDIO_FORMAT_PCM_32_BIT: memcpy(p, &v32, 4); break;
+            case AUDIO_FORMAT_PCM_FLOAT: memcpy(p, &vf, 4); break;
+            default: memcpy(p, &pcm[k], 2); break;
+        }
+    }
+    alignas(16) static float acc[EQ_BLOCK_FRAMES * 2];
+    alignas(16) static float plane_storage[AUDIO_MAX_STREAM_CHANNELS][EQ_BLOCK_FRAMES];
+    float* planes[AUDIO_MAX_STREAM_CHANNELS];
+    for (int c = 0; c < AUDIO_MAX_STREAM_CHANNELS; c++) planes[c] = plane_storage[c];
+    memset(acc, 0, sizeof(acc));
+
+    const size_t iterations = total_frames / frames;
+    double rate[3];
+    for (int mode = 0; mode < 3; mode++) {
+        const uint64_t start = hal_metrics_now_ns();
+        for (size_t it = 0; it < iterations; it++) {
+            if (mode == 0) kernels->accumulate(acc, in.data(), frames, 0.5f, 0.0f);
+            else if (mode == 1) kernels->deinterleave(planes, in.data(), frames);
+            else accumulate_generic(acc, in.data(), frames, format, channels, 0.5f);
+        }
+        rate[mode] = (double)(iterations * frames) / (double)(hal_metrics_now_ns() - start) * 1e3;
+    }
+    // Impede que o compilador descarte os laços.
+    volatile float sink = acc[0] + plane_storage[0][0];
+    (void)sink;
+    printf("%-6s %8d %12.1f %12.1f %12.1f %8.1fx\n", audio_format_name(format), channels,
+           rate[0], rate[1], rate[2], rate[0] / rate[2]);
+}
+
+// Janela do conversor para entradas de até 4x a taxa de saída (ex: 192 kHz).
+#define BENCH_RESAMPLE_WINDOW_FRAMES RESAMPLER_WINDOW_FRAMES(EQ_BLOCK_FRAMES, 4)
+alignas(16) static float resample_window[BENCH_RESAMPLE_WINDOW_FRAMES * RESAMPLER_CHANNELS];
+
+/**
+ * Converte um segundo de senoide (periódico: frequência inteira em Hz) de
+ * 'in_rate' para HAL_SAMPLE_RATE e mede a SNR da saída contra a senoide ideal,
+ * depois do transitório inicial. A saída j está no instante j / HAL_SAMPLE_RATE.
+ */
+static double resample_snr_db(uint32_t in_rate, audio_resampler_quality_t quality, double freq) {
+    resampler_t rs = {};
+    if (resampler_init(&rs, in_rate, HAL_SAMPLE_RATE, quality, EQ_BLOCK_FRAMES, resample_window,
+                       BENCH_RESAMPLE_WINDOW_FRAMES) != 0) return 0.0;
+    const double amplitude = 0.5;
+    static float out[EQ_BLOCK_FRAMES * RESAMPLER_CHANNELS];
+    uint64_t in_pos = 0, out_pos = 0;
+    double signal = 0.0, noise = 0.0;
+    const uint64_t skip = (uint64_t)rs.taps * 4;
+    while (out_pos < HAL_SAMPLE_RATE) {
+        const size_t needed = resampler_input_needed(&rs, EQ_BLOCK_FRAMES);
+        float* in = resampler_input_buffer(&rs, needed);
+        for (size_t i = 0; i < needed; i++, in_pos++) {
+            in[2 * i] = in[2 * i + 1] = (float)(amplitude * sin(2.0 * M_PI * freq * in_pos / in_rate));
+        }
+        resampler_commit_input(&rs, needed);
+        const size_t got = resampler_process(&rs, out, EQ_BLOCK_FRAMES);
+        for (size_t j = 0; j < got; j++, out_pos++) {
+            if (out_pos < skip) continue;
+            const double ideal = amplitude * sin(2.0 * M_PI * freq * out_pos / HAL_SAMPLE_RATE);
+            signal += ideal * ideal;
+            noise += (out[2 * j] - ideal) * (out[2 * j] - ideal);
+        }
+    }
+    return noise > 0.0 ? 10.0 * log10(signal / noise) : 200.0;
+}
+
+// SNR mínima (1 kHz, 10 kHz) por preset, de LOW_LATENCY a HIGH: alguns dB
+// abaixo do medido em 44,1 e 96 kHz, para acusar regressões do filtro.
+static const double resample_min_snr_db[][2] = { {50.0, 30.0}, {60.0, 60.0}, {75.0, 75.0}, {105.0, 105.0} };
+
+/**
+ * Seção 6: vazão do conversor em blocos de EQ_BLOCK_FRAMES frames de saída,
+ * alimentado por um segundo de senoide de 1 kHz em laço, e a SNR conferida
+ * contra resample_min_snr_db.
+ */
+static void bench_resample(uint32_t in_rate, audio_resampler_quality_t quality, size_t total_frames) {
+    resampler_t rs = {};
+    if (resampler_init(&rs, in_rate, HAL_SAMPLE_RATE, quality, EQ_BLOCK_FRAMES, resample_window,
+                       BENCH_RESAMPLE_WINDOW_FRAMES) != 0) {
+        printf("%8u %-12s não suportado\n", in_rate, resampler_quality_name(quality));
+        return;
+    }
+    std::vector<float> source(in_rate * RESAMPLER_CHANNELS);
+    for (size_t i = 0; i < in_rate; i++) {
+        source[2 * i] = source[2 * i + 1] = (float)(0.5 * sin(2.0 * M_PI * 1000.0 * i / in_rate));
+    }
+    alignas(16) static float out[EQ_BLOCK_FRAMES * RESAMPLER_CHANNELS];
+    size_t in_pos = 0, produced = 0;
+    const uint64_t start = hal_metrics_now_ns();
+    while (produced < total_frames) {
+        const size_t needed = resampler_input_needed(&rs, EQ_BLOCK_FRAMES);
+        float* in = resampler_input_buffer(&rs, needed);
+        for (size_t copied = 0; copied < needed; ) {
+            const size_t n = std::min(needed - copied, (size_t)in_rate - in_pos);
+            memcpy(in + copied * RESAMPLER_CHANNELS, source.data() + in_pos * RESAMPLER_CHANNELS,
+                   n * RESAMPLER_CHANNELS * sizeof(float));
+            copied += n;
+            in_pos = (in_pos + n) % in_rate;
+        }
+        resampler_commit_input(&rs, needed);
+        produced += resampler_process(&rs, out, EQ_BLOCK_FRAMES);
+    }
+    const double elapsed_ns = (double)(hal_metrics_now_ns() - start);
+    const double snr[2] = { resample_snr_db(in_rate, quality, 1000.0), resample_snr_db(in_rate, quality, 10000.0) };
+    printf("%8u %-12s %6d %9zu %12.1f %9.0fx %9.1f %9.1f\n", in_rate, resampler_quality_name(quality), rs.taps,
+           resampler_latency_frames(&rs), produced / elapsed_ns * 1e3,
+           produced / (double)HAL_SAMPLE_RATE / (elapsed_ns / 1e9), snr[0], snr[1]);
+    const double* min_snr = resample_min_snr_db[quality - AUDIO_RESAMPLER_QUALITY_LOW_LATENCY];
+    bench_check(snr[0] >= min_snr[0] && snr[1] >= min_snr[1],
+                "resample %u Hz %s: SNR %.1f / %.1f dB abaixo do mínimo %.0f / %.0f dB", in_rate,
+                resampler_quality_name(quality), snr[0], snr[1], min_snr[0], min_snr[1]);
+}
+
+/**
+ * Seção 7: um período com 'zones' zonas, cada uma com seu equalizador (níveis
+ * diferentes) e seu volume, sobre a mistura de dois streams.
+ * @param base_p50 p50 de uma zona no mesmo período (0 na primeira medição).
+ * @return p50 em ns, ou 0 em caso de erro.
+ */
+static uint64_t bench_zones(int zones, size_t period_frames, size_t periods, uint64_t base_p50) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return 0;
+    dev->stop_render_thread(dev);
+    ret = dev->set_zone_count(dev, zones);
+    for (int z = 0; ret == 0 && z < zones; z++) {
+        dev->set_zone_volume(dev, z, 1.0f - 0.05f * (float)z);
+        dev->set_zone_eq_band_level(dev, z, AUDIO_EQ_BAND_BASS, 60 + 4 * z);
+        dev->set_zone_eq_band_level(dev, z, AUDIO_EQ_BAND_TREBLE, 40 + 3 * z);
+    }
+    audio_stream_out_t* extra = NULL;
+    audio_stream_config_t config = {};
+    config.usage = AUDIO_USAGE_NAVIGATION;
+    config.priority = 1;
+    config.gain = 0.5f;
+    if (ret == 0) ret = dev->open_output_stream(dev, &config, &extra);
+
+    static int16_t input[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t period[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(input, period_frames, HAL_CHANNELS);
+    const size_t bytes = period_frames * HAL_FRAME_SIZE;
+
+    std::vector<uint64_t> lat(periods);
+    uint64_t total_ns = 0;
+    for (size_t p = 0; ret == 0 && p < periods; p++) {
+        dev->write(dev, input, bytes);
+        extra->write(extra, input, bytes);
+        const uint64_t t0 = hal_metrics_now_ns();
+        dev->render(dev, period, bytes);
+        lat[p] = hal_metrics_now_ns() - t0;
+        total_ns += lat[p];
+    }
+    if (extra) dev->close_output_stream(dev, extra);
+    dev->common.close(&dev->common);
+    if (ret != 0) return 0;
+
+    std::sort(lat.begin(), lat.end());
+    const uint64_t p50 = percentile(lat, 50);
+    const double zone_frames = (double)zones * (double)period_frames * (double)periods;
+    const double speedup = base_p50 ? (double)zones * (double)base_p50 / (double)p50 : 1.0;
+    printf("%8zu %6d %10llu %10llu %12.1f %9.2f\n", period_frames, zones, (unsigned long long)p50,
+           (unsigned long long)percentile(lat, 99), zone_frames / ((double)total_ns / 1e3), speedup);
+    return p50;
+}
+
+/**
+ * Frame 'i' da mistura do benchmark: volume (0x123), velocidade (0x3E9,
+ * big-endian) e um ID fora da tabela, em proporções parecidas.
+ */
+static void make_can_frame(size_t i, can_frame_t* frame) {
+    memset(frame, 0, sizeof(*frame));
+    switch (i % 3) {
+        case 0:
+            frame->can_id = 0x123;
+            frame->len = 1;
+            frame->data[0] = (uint8_t)(i % 101);
+            break;
+        case 1: {
+            const uint16_t speed = (uint16_t)(i % 30000); // 0,01 km/h
+            frame->can_id = 0x3E9;
+            frame->len = 2;
+            frame->data[0] = (uint8_t)(speed >> 8);
+            frame->data[1] = (uint8_t)speed;
+            break;
+        }
+        default:
+            frame->can_id = 0x200;
+            frame->len = 8;
+            break;
+    }
+}
+
+/**
+ * Seção 8: frames enfileirados no stub, lidos em lotes de 'batch', decodificados
+ * e publicados na HAL com uma chamada por lote. Confere que a HAL termina com
+ * o volume e a velocidade dos últimos frames de cada ID e que só os frames de
+ * ID desconhecido ficam sem sinal.
+ */
+static int bench_can_decode(audio_hw_device_t* dev, size_t batch, size_t total_frames) {
+    static can_decoder_t decoder;
+    static can_stub_source_t stub;
+    int ret = can_decoder_compile(&decoder, can_vehicle_signals, can_vehicle_signal_count);
+    if (ret != 0) return ret;
+    can_stub_init(&stub);
+    static can_frame_t frames[CAN_STUB_CAPACITY_FRAMES];
+    for (size_t i = 0; i < CAN_STUB_CAPACITY_FRAMES; i++) make_can_frame(i, &frames[i]);
+    can_frame_t in[CAN_INGEST_BATCH_FRAMES];
+    // Esperado: sinais do último frame de cada ID da fila (0,01 km/h por bit na velocidade).
+    float expected_volume = -1.0f, expected_speed = -1.0f;
+    size_t unknown_per_fill = 0;
+    for (size_t i = 0; i < CAN_STUB_CAPACITY_FRAMES; i++) {
+        if (frames[i].can_id == 0x123) {
+            expected_volume = (float)frames[i].data[0];
+        } else if (frames[i].can_id == 0x3E9) {
+            expected_speed = (float)((frames[i].data[0] << 8) | frames[i].data[1]) * 0.01f;
+        } else {
+            unknown_per_fill++;
+        }
+    }
+    const uint64_t frames_before = decoder.frames.load(std::memory_order_relaxed);
+    const uint64_t unknown_before = decoder.unknown_frames.load(std::memory_order_relaxed);
+
+    uint64_t elapsed = 0;
+    size_t done = 0, calls = 0;
+    while (done < total_frames) {
+        can_stub_push(&stub, frames, CAN_STUB_CAPACITY_FRAMES); // Fora da medição
+        const uint64_t t0 = hal_metrics_now_ns();
+        int n;
+        while ((n = stub.source.read(&stub.source, in, batch)) > 0) {
+            can_decoded_t decoded;
+            decoded.updated = 0;
+            can_decoder_decode(&decoder, in, (size_t)n, &decoded);
+            if ((ret = can_decoder_apply(&decoder, &decoded, dev)) != 0) return ret;
+            done += (size_t)n;
+            calls++;
+        }
+        elapsed += hal_metrics_now_ns() - t0;
+    }
+    printf("%-8s %6zu %12.2f %10.1f %12.0f\n", "decode", batch, done / (double)elapsed * 1e3,
+           (double)elapsed / done, calls / ((double)elapsed / 1e9));
+
+    float volume = -1.0f, speed = -1.0f;
+    dev->get_vehicle_param(dev, AUDIO_VEHICLE_PARAM_MASTER_VOLUME, &volume);
+    dev->get_vehicle_param(dev, AUDIO_VEHICLE_PARAM_SPEED_KMH, &speed);
+    bench_check(fabsf(volume - expected_volume) < 1e-3f && fabsf(speed - expected_speed) < 1e-3f,
+                "can lote %zu: volume %.2f e velocidade %.2f km/h, esperado %.2f e %.2f", batch, volume, speed,
+                expected_volume, expected_speed);
+    const uint64_t frames_decoded = decoder.frames.load(std::memory_order_relaxed) - frames_before;
+    const uint64_t unknown = decoder.unknown_frames.load(std::memory_order_relaxed) - unknown_before;
+    const uint64_t fills = done / CAN_STUB_CAPACITY_FRAMES;
+    bench_check(frames_decoded == done && unknown == fills * unknown_per_fill,
+                "can lote %zu: %llu frames (%llu sem sinal), esperado %zu (%llu)", batch,
+                (unsigned long long)frames_decoded, (unsigned long long)unknown, done,
+                (unsigned long long)(fills * unknown_per_fill));
+    return 0;
+}
+
+/**
+ * Seção 8: replay, o mais rápido possível, de um log do candump com 'lines'
+ * linhas gravado em um arquivo temporário.
+ */
+static int bench_can_replay(size_t lines) {
+    char path[] = "/tmp/audio_hal_bench_can_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) return -errno;
+    FILE* f = fdopen(fd, "w");
+    if (!f) {
+        close(fd);
+        unlink(path);
+        return -EIO;
+    }
+    for (size_t i = 0; i < lines; i++) {
+        can_frame_t frame;
+        make_can_frame(i, &frame);
+        fprintf(f, "(%llu.%06llu) can0 %03X#", 1700000000ull + i / 1000, (unsigned long long)(i % 1000) * 1000,
+                frame.can_id);
+        for (int b = 0; b < frame.len; b++) fprintf(f, "%02X", frame.data[b]);
+        fputc('\n', f);
+    }
+    const long bytes = ftell(f);
+    fclose(f);
+
+    can_replay_source_t replay;
+    int ret = can_replay_open(&replay, path, false, false);
+    unlink(path);
+    if (ret != 0) return ret;
+    can_frame_t in[CAN_INGEST_BATCH_FRAMES];
+    const uint64_t t0 = hal_metrics_now_ns();
+    while (replay.source.read(&replay.source, in, CAN_INGEST_BATCH_FRAMES) > 0) {
+    }
+    const double elapsed = (double)(hal_metrics_now_ns() - t0);
+    printf("%-8s %6d %12.2f %10.1f %12s (%.0f MB/s, %llu linhas ignoradas)\n", "replay", CAN_INGEST_BATCH_FRAMES,
+           replay.frames / elapsed * 1e3, elapsed / (double)replay.frames, "-", bytes / elapsed * 1e3,
+           (unsigned long long)replay.bad_lines);
+    ret = replay.frames == lines ? 0 : -EIO;
+    can_replay_close(&replay);
+    return ret;
+}
+
+/**
+ * Seção 9: um período da zona principal (equalizador com graves e agudos no
+ * máximo) com a dinâmica configurada por 'enabled' e 'speed_kmh'. Com a
+ * dinâmica ligada, confere que o pico da saída não passa do teto do limitador.
+ */
+static int bench_dynamics(const char* label, bool enabled, float speed_kmh, size_t periods) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->stop_render_thread(dev);
+    dev->set_eq_band_level(dev, AUDIO_EQ_BAND_BASS, EQ_LEVEL_MAX);
+    dev->set_eq_band_level(dev, AUDIO_EQ_BAND_TREBLE, EQ_LEVEL_MAX);
+    const audio_dynamics_config_t config = { enabled, 120.0f, 4.0f, 6.0f, 3.0f, -1.0f, 200.0f };
+    const audio_vehicle_param_update_t speed = { AUDIO_VEHICLE_PARAM_SPEED_KMH, speed_kmh };
+    ret = dev->set_dynamics_config(dev, &config);
+    if (ret == 0) ret = dev->set_vehicle_params(dev, &speed, 1);
+
+    static int16_t input[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t period[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(input, BENCH_PERIOD_FRAMES, HAL_CHANNELS);
+    std::vector<uint64_t> lat(periods);
+    int peak = 0;
+    for (size_t p = 0; ret == 0 && p < periods; p++) {
+        dev->write(dev, input, sizeof(input));
+        const uint64_t t0 = hal_metrics_now_ns();
+        dev->render(dev, period, sizeof(period));
+        lat[p] = hal_metrics_now_ns() - t0;
+        for (size_t i = 0; i < BENCH_PERIOD_FRAMES * HAL_CHANNELS; i++) {
+            peak = std::max(peak, abs((int)period[i]));
+        }
+    }
+    audio_render_stats_t stats = {};
+    dev->get_render_stats(dev, &stats);
+    dev->common.close(&dev->common);
+    if (ret != 0) return ret;
+
+    std::sort(lat.begin(), lat.end());
+    const uint64_t p50 = percentile(lat, 50);
+    const double peak_db = 20.0 * log10(peak / 32768.0);
+    printf("%-16s %10llu %10llu %10.2f %9u %8.1f\n", label, (unsigned long long)p50,
+           (unsigned long long)percentile(lat, 99), (double)p50 / BENCH_PERIOD_FRAMES, stats.latency_frames,
+           peak_db);
+    // Folga de 0,01 dB para o arredondamento a 16 bits.
+    bench_check(!enabled || peak_db <= config.limiter_threshold_db + 0.01,
+                "dynamics %s: pico de %.2f dBFS acima do teto de %.1f dBFS", label, peak_db,
+                config.limiter_threshold_db);
+    return 0;
+}
+
+/**
+ * Seção 9: o limitador sozinho, em blocos de EQ_BLOCK_FRAMES, sobre uma senoide
+ * que alterna trechos abaixo e acima do teto.
+ */
+static void bench_limiter(size_t total_frames) {
+    const audio_dynamics_config_t config = { true, 120.0f, 4.0f, 6.0f, 3.0f, -1.0f, 200.0f };
+    static dyn_limiter_t limiter;
+    dyn_limiter_reset(&limiter, &config, (float)HAL_SAMPLE_RATE);
+    alignas(16) static float block[EQ_BLOCK_FRAMES * HAL_CHANNELS];
+    for (size_t i = 0; i < EQ_BLOCK_FRAMES; i++) {
+        block[2 * i] = block[2 * i + 1] = (float)(1.5 * sin(2.0 * M_PI * 440.0 * i / HAL_SAMPLE_RATE));
+    }
+    size_t done = 0;
+    const uint64_t start = hal_metrics_now_ns();
+    for (; done < total_frames; done += EQ_BLOCK_FRAMES) {
+        const float gain = (done / EQ_BLOCK_FRAMES) % 2 ? 1.0f : 0.25f;
+        dyn_limiter_process(&limiter, block, block, EQ_BLOCK_FRAMES, gain, 0.0f);
+    }
+    const double elapsed_ns = (double)(hal_metrics_now_ns() - start);
+    printf("limitador isolado: %.1f Mframes/s, %.2f ns/frame, %.0fx RT\n", done / elapsed_ns * 1e3,
+           elapsed_ns / done, done / (double)HAL_SAMPLE_RATE / (elapsed_ns / 1e9));
+}
+
+/**
+ * Layout de oitavas da seção 10: shelves nas pontas, peaking no meio.
+ */
+static void octave_layout(audio_eq_band_t* layout, int bands) {
+    for (int b = 0; b < bands; b++) {
+        layout[b].shape = b == 0 ? AUDIO_EQ_SHAPE_LOW_SHELF
+                        : (b == bands - 1 ? AUDIO_EQ_SHAPE_HIGH_SHELF : AUDIO_EQ_SHAPE_PEAKING);
+        layout[b].freq_hz = 31.25f * (float)(1 << b) * (10.0f / (float)bands);
+        layout[b].q = 1.41f;
+    }
+}
+
+/**
+ * Seção 10: custo de trocar parâmetros e de renderizar com um layout de 'bands' bandas.
+ */
+static int bench_eq(int bands, size_t switches, size_t periods) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->stop_render_thread(dev);
+    audio_eq_band_t layout[AUDIO_EQ_MAX_BANDS];
+    octave_layout(layout, bands);
+    uint64_t t0 = hal_metrics_now_ns();
+    ret = dev->set_eq_layout(dev, layout, bands);
+    const uint64_t layout_ns = hal_metrics_now_ns() - t0;
+
+    // Troca de preset com os coeficientes projetados na hora.
+    int levels[AUDIO_EQ_PRESET_COUNT][AUDIO_EQ_MAX_BANDS];
+    for (int p = 0; p < AUDIO_EQ_PRESET_COUNT; p++) eq_preset_levels(p, layout, bands, levels[p]);
+    static biquad_coeffs_t designed[AUDIO_EQ_MAX_BANDS];
+    t0 = hal_metrics_now_ns();
+    for (size_t i = 0; i < switches; i++) {
+        const int* l = levels[i % AUDIO_EQ_PRESET_COUNT];
+        for (int b = 0; b < bands; b++) eq_design(&layout[b], l[b], (float)HAL_SAMPLE_RATE, &designed[b]);
+    }
+    const double design_ns = (double)(hal_metrics_now_ns() - t0) / switches;
+
+    t0 = hal_metrics_now_ns();
+    for (size_t i = 0; ret == 0 && i < switches; i++) {
+        ret = dev->load_eq_preset(dev, (int)(i % AUDIO_EQ_PRESET_COUNT));
+    }
+    const double preset_ns = (double)(hal_metrics_now_ns() - t0) / switches;
+
+    t0 = hal_metrics_now_ns();
+    for (size_t i = 0; ret == 0 && i < switches; i++) {
+        const int* l = levels[i % AUDIO_EQ_PRESET_COUNT];
+        for (int b = 0; ret == 0 && b < bands; b++) ret = dev->set_eq_band_level(dev, b, l[b]);
+    }
+    const double per_band_ns = (double)(hal_metrics_now_ns() - t0) / switches;
+
+    t0 = hal_metrics_now_ns();
+    for (size_t i = 0; ret == 0 && i < switches; i++) {
+        ret = dev->set_eq_bands(dev, levels[i % AUDIO_EQ_PRESET_COUNT], bands);
+    }
+    const double batch_ns = (double)(hal_metrics_now_ns() - t0) / switches;
+
+    static int16_t input[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t period[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(input, BENCH_PERIOD_FRAMES, HAL_CHANNELS);
+    std::vector<uint64_t> lat(periods);
+    for (size_t p = 0; ret == 0 && p < periods; p++) {
+        dev->write(dev, input, sizeof(input));
+        t0 = hal_metrics_now_ns();
+        dev->render(dev, period, sizeof(period));
+        lat[p] = hal_metrics_now_ns() - t0;
+    }
+    dev->common.close(&dev->common);
+    if (ret != 0) return ret;
+
+    std::sort(lat.begin(), lat.end());
+    printf("%6d %10.1f %12.0f %12.0f %12.0f %12.0f %10.2f\n", bands, layout_ns / 1e3, design_ns, preset_ns,
+           per_band_ns, batch_ns, (double)percentile(lat, 50) / BENCH_PERIOD_FRAMES);
+    return 0;
+}
+
+// Espera a thread de renderização entrar em standby (até 'timeout_ms').
+static bool wait_standby(audio_hw_device_t* dev, int timeout_ms) {
+    audio_render_stats_t stats = {};
+    for (int waited = 0; waited < timeout_ms; waited++) {
+        dev->get_render_stats(dev, &stats);
+        if (stats.standby) return true;
+        usleep(1000);
+    }
+    return false;
+}
+
+/**
+ * Seção 11: despertares por segundo com o dispositivo ocioso (thread de
+ * renderização ativa, nenhum 'write') e, com standby, 'cycles' voltas:
+ * um 'write' de dois períodos acorda a thread, que volta ao standby depois de
+ * 'delay_ms' sem dados.
+ */
+static int bench_standby(const char* label, uint32_t delay_ms, int cycles) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->set_standby_delay(dev, delay_ms);
+
+    // Despertares ociosos: janela de 200 ms depois do atraso do standby.
+    audio_render_stats_t stats = {};
+    usleep((delay_ms + 50) * 1000);
+    dev->get_render_stats(dev, &stats);
+    usleep(200000);
+    dev->get_render_stats(dev, &stats);
+    const float idle_rate = stats.wakeups_per_sec;
+
+    static int16_t input[2 * BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(input, 2 * BENCH_PERIOD_FRAMES, HAL_CHANNELS);
+    std::vector<uint64_t> resume, enter;
+    for (int c = 0; delay_ms > 0 && c < cycles; c++) {
+        if (!wait_standby(dev, 1000)) {
+            ret = -ETIMEDOUT;
+            break;
+        }
+        dev->write(dev, input, sizeof(input));
+        usleep(2000);
+        dev->get_render_stats(dev, &stats);
+        resume.push_back(stats.resume_latency_last_ns);
+        enter.push_back(stats.standby_latency_last_ns);
+    }
+    dev->get_render_stats(dev, &stats);
+    dev->common.close(&dev->common);
+    if (ret != 0) return ret;
+
+    std::sort(resume.begin(), resume.end());
+    std::sort(enter.begin(), enter.end());
+    printf("%-12s %12.1f %10llu %12llu %12llu %12llu %12llu\n", label, idle_rate,
+           (unsigned long long)stats.standby_entries, (unsigned long long)percentile(enter, 50),
+           (unsigned long long)stats.standby_latency_max_ns, (unsigned long long)percentile(resume, 50),
+           (unsigned long long)stats.resume_latency_max_ns);
+    return 0;
+}
+
+/**
+ * Seção 12: período da zona principal com 2 streams, equalizador e dinâmica
+ * (todas as etapas marcadas), com a gravação do trace desligada ou ligada.
+ * Com a gravação ligada, exporta os eventos dos períodos para um JSON
+ * temporário, para contar os marcadores por período e medir a exportação.
+ */
+static int bench_trace(const char* label, bool record, size_t periods) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->stop_render_thread(dev);
+    dev->set_eq_band_level(dev, AUDIO_EQ_BAND_BASS, 80);
+    const audio_dynamics_config_t config = { true, 120.0f, 4.0f, 6.0f, 3.0f, -1.0f, 200.0f };
+    const audio_vehicle_param_update_t speed = { AUDIO_VEHICLE_PARAM_SPEED_KMH, 80.0f };
+    ret = dev->set_dynamics_config(dev, &config);
+    if (ret == 0) ret = dev->set_vehicle_params(dev, &speed, 1);
+    audio_stream_out_t* extra = NULL;
+    audio_stream_config_t stream_config = {};
+    stream_config.usage = AUDIO_USAGE_MEDIA;
+    stream_config.gain = 0.5f;
+    if (ret == 0) ret = dev->open_output_stream(dev, &stream_config, &extra);
+
+    static int16_t input[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    static int16_t period[BENCH_PERIOD_FRAMES * HAL_CHANNELS];
+    fill_test_signal_s16(input, BENCH_PERIOD_FRAMES, HAL_CHANNELS);
+    hal_trace_set_enabled(record);
+    hal_trace_clear();
+    std::vector<uint64_t> lat(periods);
+    for (size_t p = 0; ret == 0 && p < periods; p++) {
+        // Só os últimos períodos ficam no trace: todos cabem no buffer da thread.
+        if (p + BENCH_TRACE_PERIODS == periods) hal_trace_clear();
+        dev->write(dev, input, sizeof(input));
+        extra->write(extra, input, sizeof(input));
+        const uint64_t t0 = hal_metrics_now_ns();
+        dev->render(dev, period, sizeof(period));
+        lat[p] = hal_metrics_now_ns() - t0;
+    }
+    if (extra) dev->close_output_stream(dev, extra);
+    dev->common.close(&dev->common);
+    if (ret != 0) return ret;
+
+    int events = 0;
+    uint64_t export_ns = 0;
+    if (record) {
+        char path[] = "/tmp/audio_hal_bench_trace_XXXXXX";
+        const int fd = mkstemp(path);
+        if (fd < 0) return -errno;
+        close(fd);
+        const uint64_t t0 = hal_metrics_now_ns();
+        events = hal_trace_write_json(path);
+        export_ns = hal_metrics_now_ns() - t0;
+        unlink(path);
+        if (events < 0) return events;
+    }
+    hal_trace_set_enabled(true);
+    hal_trace_clear();
+
+    std::sort(lat.begin(), lat.end());
+    // 2 'write' por período entram na conta de eventos, mas não no tempo medido.
+    const double per_period = events > 0 ? (double)events / BENCH_TRACE_PERIODS - 2.0 : 0.0;
+    printf("%-20s %10llu %10llu %10.2f %12.1f", label, (unsigned long long)percentile(lat, 50),
+           (unsigned long long)percentile(lat, 99), (double)percentile(lat, 50) / BENCH_PERIOD_FRAMES, per_period);
+    if (events > 0) {
+        printf("   exportação: %d eventos em %.1f ms (%.0f ns/evento)", events, (double)export_ns * 1e-6,
+               (double)export_ns / events);
+    }
+    printf("\n");
+    return 0;
+}
+
+#if defined(HAL_TRACE) && HAL_TRACE
+/**
+ * Seção 12: custo de um marcador isolado (escopo vazio), gravando ou não.
+ */
+static void bench_trace_marker(size_t markers) {
+    hal_trace_clear();
+    for (int record = 0; record < 2; record++) {
+        hal_trace_set_enabled(record != 0);
+        const uint64_t t0 = hal_metrics_now_ns();
+        for (size_t i = 0; i < markers; i++) {
+            HAL_TRACE_SCOPE("bench");
+        }
+        const uint64_t elapsed = hal_metrics_now_ns() - t0;
+        printf("marcador vazio, gravação %-9s %8.1f ns\n", record ? "ligada:" : "desligada:",
+               (double)elapsed / (double)markers);
+    }
+    hal_trace_set_enabled(true);
+    hal_trace_clear();
+}
+#endif
+
+// Parâmetros comuns às seções, derivados da linha de comando.
+typedef struct {
+    bool quick;
+    eq_kernel_t kernel;
+    size_t dsp_total;       // Frames por medição de DSP, conversão, taxa e CAN
+    size_t mix_periods;     // Períodos por medição de render
+} bench_options_t;
+
+/**
+ * Imprime o título de uma seção: "[nome] " seguido do texto formatado.
+ */
+static void section_header(const char* name, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void section_header(const char* name, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    printf("\n[%s] ", name);
+    vprintf(fmt, args);
+    putchar('\n');
+    va_end(args);
+}
+
+// --- Seção 1: write ---
+static int section_write(const bench_options_t* opt) {
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    // O benchmark é o consumidor: sem a thread, o ritmo é o da CPU e não o do relógio.
+    dev->stop_render_thread(dev);
+    dev->set_eq_band_level(dev, AUDIO_EQ_BAND_BASS, 80);
+    dev->set_eq_band_level(dev, AUDIO_EQ_BAND_MID, 40);
+    dev->set_eq_band_level(dev, AUDIO_EQ_BAND_TREBLE, 70);
+
+    const size_t write_total = opt->quick ? (1u << 20) : (16u << 20);
+    section_header("write", "PCM s16 estéreo %d Hz, período de %d frames; latências em ns por chamada",
+                   HAL_SAMPLE_RATE, BENCH_PERIOD_FRAMES);
+    printf("%8s %8s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+           "bytes", "chamadas", "MB/s", "x RT", "p50", "p90", "p99", "max", "wr p50", "wr p99");
+    for (size_t bytes = 64; bytes <= 65536; bytes *= 4) {
+        ret = bench_write(dev, bytes, write_total);
+        if (ret != 0) break;
+    }
+    uint64_t overruns = 0, underruns = 0;
+    dev->get_xrun_counts(dev, &overruns, &underruns);
+    printf("overruns: %llu (esperado com buffers maiores que a fila), underruns: %llu\n",
+           (unsigned long long)overruns, (unsigned long long)underruns);
+    audio_metrics_t metrics;
+    if (dev->get_metrics(dev, &metrics) == 0 && metrics.process_latency.count > 0) {
+        printf("métricas da HAL: %llu períodos, processamento médio %llu ns, máximo %llu ns\n",
+               (unsigned long long)metrics.periods_rendered,
+               (unsigned long long)(metrics.process_latency.sum_ns / metrics.process_latency.count),
+               (unsigned long long)metrics.process_latency.max_ns);
+    }
+    dev->common.close(&dev->common);
+    return ret;
+}
+
+// --- Seção 2: dsp ---
+static int section_dsp(const bench_options_t* opt) {
+    section_header("dsp", "cascata de 3 biquads (layout padrão), períodos de %d frames", HAL_MAX_PERIOD_FRAMES);
+    printf("%-6s %8s %12s %10s %10s\n", "fmt", "canais", "Mframes/s", "ns/frame", "x RT");
+    static const int channel_counts[] = {1, 2, 4, 6, 8};
+    for (int f = 0; f < 2; f++) {
+        for (size_t c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); c++) {
+            bench_dsp(channel_counts[c], f == 0, HAL_MAX_PERIOD_FRAMES, opt->dsp_total);
+        }
+    }
+    const size_t rounding_mismatches = check_s16_rounding(opt->kernel);
+    printf("float -> s16 (%s x scalar): %zu amostras diferentes\n", eq_kernel_name(), rounding_mismatches);
+    bench_check(rounding_mismatches == 0, "o kernel %s arredonda diferente do escalar", eq_kernel_name());
+    return 0;
+}
+
+// --- Seção 3: mix ---
+static int section_mix(const bench_options_t* opt) {
+    section_header("mix", "período de %d frames: streams + equalizador + volume mestre", BENCH_PERIOD_FRAMES);
+    printf("%8s %10s %10s %12s\n", "streams", "p50 ns", "p99 ns", "ns/frame");
+    for (int streams = 1; streams <= AUDIO_MAX_OUTPUT_STREAMS; streams++) {
+        const int ret = bench_mix(streams, opt->mix_periods);
+        if (ret != 0) return ret;
+    }
+    return 0;
+}
+
+// --- Seção 4: feed ---
+static int section_feed(const bench_options_t* opt) {
+    section_header("feed", "um stream extra, período de %d frames; ns por período", BENCH_PERIOD_FRAMES);
+    printf("%-10s %12s %12s %12s %10s\n", "modo", "produtor p50", "total p50", "total p99", "xruns");
+    for (int shared = 0; shared < 2; shared++) {
+        const int ret = bench_feed(shared != 0, opt->mix_periods);
+        if (ret != 0) return ret;
+    }
+    return 0;
+}
+
+// --- Seção 5: convert ---
+static int section_convert(const bench_options_t* opt) {
+    section_header("convert", "kernels dos streams, blocos de %d frames; Mframes/s", EQ_BLOCK_FRAMES);
+    printf("%-6s %8s %12s %12s %12s %9s\n", "fmt", "canais", "soma", "planos", "genérico", "ganho");
+    static const audio_format_t formats[] = {
+        AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_24_BIT_PACKED, AUDIO_FORMAT_PCM_32_BIT, AUDIO_FORMAT_PCM_FLOAT,
+    };
+    static const int convert_channels[] = {1, 2, 6, 8};
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for (size_t c = 0; c < sizeof(convert_channels) / sizeof(convert_channels[0]); c++) {
+            bench_convert(formats[f], convert_channels[c], opt->dsp_total);
+        }
+    }
+    return 0;
+}
+
+// --- Seção 6: resample ---
+static int section_resample(const bench_options_t* opt) {
+    section_header("resample", "para %d Hz, estéreo, blocos de %d frames; latência em frames de saída",
+                   HAL_SAMPLE_RATE, EQ_BLOCK_FRAMES);
+    printf("%8s %-12s %6s %9s %12s %10s %9s %9s\n",
+           "entrada", "qualidade", "taps", "latência", "Mframes/s", "x RT", "SNR 1k", "SNR 10k");
+    static const uint32_t resample_rates[] = {44100, 96000};
+    for (size_t r = 0; r < sizeof(resample_rates) / sizeof(resample_rates[0]); r++) {
+        for (int q = AUDIO_RESAMPLER_QUALITY_LOW_LATENCY; q <= AUDIO_RESAMPLER_QUALITY_HIGH; q++) {
+            bench_resample(resample_rates[r], (audio_resampler_quality_t)q, opt->dsp_total);
+        }
+    }
+    return 0;
+}
+
+// --- Seção 7: zones ---
+static int section_zones(const bench_options_t* opt) {
+    section_header("zones", "mistura de 2 streams + equalizador e volume por zona; ns por período");
+    printf("%8s %6s %10s %10s %12s %9s\n", "período", "zonas", "p50 ns", "p99 ns", "Mframes/s", "ganho");
+    static const size_t zone_periods[] = {BENCH_PERIOD_FRAMES, HAL_MAX_PERIOD_FRAMES};
+    for (size_t f = 0; f < sizeof(zone_periods) / sizeof(zone_periods[0]); f++) {
+        uint64_t base_p50 = 0;
+        for (int zones = 1; zones <= AUDIO_MAX_ZONES; zones++) {
+            const uint64_t p50 = bench_zones(zones, zone_periods[f], opt->mix_periods, base_p50);
+            if (p50 == 0) return -EIO;
+            if (zones == 1) base_p50 = p50;
+        }
+    }
+    return 0;
+}
+
+// --- Seção 8: can ---
+static int section_can(const bench_options_t* opt) {
+    section_header("can", "tabela do veículo (volume 0x123, velocidade 0x3E9, 1/3 de IDs desconhecidos)");
+    printf("%-8s %6s %12s %10s %12s\n", "fonte", "lote", "Mframes/s", "ns/frame", "lotes/s");
+    audio_hw_device_t* dev = NULL;
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&dev);
+    if (ret != 0) return ret;
+    dev->stop_render_thread(dev);
+    static const size_t can_batches[] = {1, 8, CAN_INGEST_BATCH_FRAMES};
+    for (size_t b = 0; ret == 0 && b < sizeof(can_batches) / sizeof(can_batches[0]); b++) {
+        ret = bench_can_decode(dev, can_batches[b], opt->dsp_total);
+    }
+    dev->common.close(&dev->common);
+    if (ret != 0) return ret;
+    return bench_can_replay(opt->quick ? 100000 : 1000000);
+}
+
+// --- Seção 9: dynamics ---
+static int section_dynamics(const bench_options_t* opt) {
+    section_header("dynamics", "zona principal, EQ de graves/agudos no máximo, período de %d frames",
+                   BENCH_PERIOD_FRAMES);
+    printf("%-16s %10s %10s %10s %9s %8s\n", "modo", "p50 ns", "p99 ns", "ns/frame", "latência", "pico dB");
+    int ret = bench_dynamics("sem dinâmica", false, 0.0f, opt->mix_periods);
+    if (ret == 0) ret = bench_dynamics("limitador", true, 0.0f, opt->mix_periods);
+    if (ret == 0) ret = bench_dynamics("120 km/h", true, 120.0f, opt->mix_periods);
+    if (ret != 0) return ret;
+    bench_limiter(opt->dsp_total);
+    return 0;
+}
+
+// --- Seção 10: eq ---
+static int section_eq(const bench_options_t* opt) {
+    section_header("eq", "layouts de oitavas; trocas em ns por troca (todas as bandas), período de %d frames",
+                   BENCH_PERIOD_FRAMES);
+    printf("%6s %10s %12s %12s %12s %12s %10s\n", "bandas", "cache us", "projeto ns", "preset ns",
+           "por banda ns", "lote ns", "ns/frame");
+    const size_t switches = opt->quick ? 2000 : 20000;
+    const int ret = bench_eq(AUDIO_EQ_NUM_BANDS, switches, opt->mix_periods);
+    return ret != 0 ? ret : bench_eq(AUDIO_EQ_MAX_BANDS, switches, opt->mix_periods);
+}
+
+// --- Seção 11: standby ---
+static int section_standby(const bench_options_t* opt) {
+    section_header("standby", "thread de renderização em tempo real, período de %d frames; latências em ns",
+                   HAL_PERIOD_FRAMES);
+    printf("%-12s %12s %10s %12s %12s %12s %12s\n", "standby", "ociosa/s", "entradas", "entrada p50",
+           "entrada max", "volta p50", "volta max");
+    const int ret = bench_standby("desligado", 0, 0);
+    return ret != 0 ? ret : bench_standby("20 ms", 20, opt->quick ? 10 : 50);
+}
+
+// --- Seção 12: trace ---
+static int section_trace(const bench_options_t* opt) {
+#if defined(HAL_TRACE) && HAL_TRACE
+    section_header("trace", "marcadores compilados (HAL_TRACE=ON); 2 streams + EQ + dinâmica, período de %d frames",
+                   BENCH_PERIOD_FRAMES);
+#else
+    section_header("trace", "marcadores removidos na compilação (HAL_TRACE=OFF); 2 streams + EQ + dinâmica, "
+                   "período de %d frames", BENCH_PERIOD_FRAMES);
+#endif
+    printf("%-20s %10s %10s %10s %12s\n", "gravação", "p50 ns", "p99 ns", "ns/frame", "marc/período");
+#if defined(HAL_TRACE) && HAL_TRACE
+    int ret = bench_trace("desligada", false, opt->mix_periods);
+    if (ret == 0) ret = bench_trace("ligada", true, opt->mix_periods);
+    if (ret == 0) bench_trace_marker(opt->quick ? 1000000 : 10000000);
+    return ret;
+#else
+    return bench_trace("sem marcadores", false, opt->mix_periods);
+#endif
+}
+
+typedef struct {
+    const char* name;
+    int (*run)(const bench_options_t* opt);
+} bench_section_t;
+
+// Seções na ordem do comentário do topo do arquivo.
+static const bench_section_t bench_sections[] = {
+    { "write", section_write },
+    { "dsp", section_dsp },
+    { "mix", section_mix },
+    { "feed", section_feed },
+    { "convert", section_convert },
+    { "resample", section_resample },
+    { "zones", section_zones },
+    { "can", section_can },
+    { "dynamics", section_dynamics },
+    { "eq", section_eq },
+    { "standby", section_standby },
+    { "trace", section_trace },
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Uso: %s [--quick] [--kernel auto|scalar|sse|neon]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    bench_options_t opt = {};
+    opt.kernel = EQ_KERNEL_AUTO;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            opt.quick = true;
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            const char* k = argv[++i];
+            if (strcmp(k, "auto") == 0) opt.kernel = EQ_KERNEL_AUTO;
+            else if (strcmp(k, "scalar") == 0) opt.kernel = EQ_KERNEL_SCALAR;
+            else if (strcmp(k, "sse") == 0) opt.kernel = EQ_KERNEL_SSE;
+            else if (strcmp(k, "neon") == 0) opt.kernel = EQ_KERNEL_NEON;
+            else { usage(argv[0]); return 2; }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (eq_select_kernel(opt.kernel) != 0) {
+        fprintf(stderr, "Kernel não suportado nesta CPU.\n");
+        return 1;
+    }
+    opt.dsp_total = opt.quick ? 480000 : 4800000;
+    opt.mix_periods = opt.quick ? 2000 : 20000;
+
+    printf("kernel EQ: %s%s\n", eq_kernel_name(), opt.quick ? " (modo rápido)" : "");
+    for (size_t s = 0; s < sizeof(bench_sections) / sizeof(bench_sections[0]); s++) {
+        const int ret = bench_sections[s].run(&opt);
+        if (ret != 0) {
+            fprintf(stderr, "Falha ao medir a seção %s: %d\n", bench_sections[s].name, ret);
+            return 1;
+        }
+    }
+    if (bench_failures > 0) {
+        fprintf(stderr, "\n%d conferência(s) falharam.\n", bench_failures);
+        return 1;
+    }
+    return 0;
+}
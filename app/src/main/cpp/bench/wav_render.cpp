@@ -0,0 +1,144 @@
+// --- Renderização Offline de Arquivos WAV (build de host) ---
+// Passa um ou mais WAVs pela cadeia da HAL e grava a saída (ver offline_render.h),
+// dividindo os arquivos entre threads. Imprime o fator de tempo real alcançado.
+//
+// --verify renderiza também com uma única thread (em <saída>.ref) e compara os
+// arquivos byte a byte: a saída paralela precisa ser idêntica.
+//
+// Uso: wav_render [--threads N] [--period FRAMES] [--segment-s S] [--overlap-ms MS]
+//                 [--preset ID] [--speed KMH] [--verify] <entrada.wav> <saída.wav> [...]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#include "audio_hal.h"
+#include "offline_render.h"
+
+typedef struct {
+    int preset;         // -1: equalizador desligado
+    float speed_kmh;    // < 0: dinâmica desligada
+} render_setup_t;
+
+// Mesma configuração em todos os dispositivos (ver offline_configure_fn).
+static int configure(audio_hw_device_t* dev, void* cookie) {
+    const render_setup_t* setup = (const render_setup_t*)cookie;
+    int ret = 0;
+    if (setup->preset >= 0) {
+        ret = dev->load_eq_preset(dev, setup->preset);
+        if (ret == 0) ret = dev->set_eq_enabled(dev, true);
+    }
+    if (ret == 0 && setup->speed_kmh >= 0.0f) {
+        const audio_dynamics_config_t config = { true, 120.0f, 4.0f, 6.0f, 3.0f, -1.0f, 200.0f };
+        const audio_vehicle_param_update_t speed = { AUDIO_VEHICLE_PARAM_SPEED_KMH, setup->speed_kmh };
+        ret = dev->set_dynamics_config(dev, &config);
+        if (ret == 0) ret = dev->set_vehicle_params(dev, &speed, 1);
+    }
+    return ret;
+}
+
+// 0 se os arquivos forem idênticos; senão o primeiro byte diferente + 1 (ou -1 em erro).
+static long long compare_files(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    long long result = -1;
+    if (fa && fb) {
+        long long offset = 0;
+        char ba[65536], bb[65536];
+        result = 0;
+        for (;;) {
+            const size_t na = fread(ba, 1, sizeof(ba), fa);
+            const size_t nb = fread(bb, 1, sizeof(bb), fb);
+            const size_t n = na < nb ? na : nb;
+            size_t i = 0;
+            while (i < n && ba[i] == bb[i]) i++;
+            if (i < n || na != nb) {
+                result = offset + (long long)i + 1;
+                break;
+            }
+            if (na == 0) break;
+            offset += (long long)na;
+        }
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return result;
+}
+
+static void print_stats(const char* label, const offline_render_stats_t* stats) {
+    printf("%-10s %8.1f s de áudio em %7.3f s: %7.1fx tempo real  segmentos %4llu  corrigidos %3llu (%.1f s)"
+           "  aquecimento %.1f s\n", label, (double)stats->frames / HAL_SAMPLE_RATE, (double)stats->elapsed_ns * 1e-9,
+           stats->realtime_factor, (unsigned long long)stats->segments, (unsigned long long)stats->resegmented,
+           (double)stats->repaired_frames / HAL_SAMPLE_RATE, (double)stats->warmup_frames / HAL_SAMPLE_RATE);
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Uso: %s [--threads N] [--period FRAMES] [--segment-s S] [--overlap-ms MS]\n"
+            "          [--preset ID] [--speed KMH] [--verify] <entrada.wav> <saída.wav> [...]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    offline_render_options_t options = {};
+    render_setup_t setup = { -1, -1.0f };
+    bool verify = false;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) options.period_frames = (size_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--segment-s") == 0 && i + 1 < argc)
+            options.segment_frames = (uint64_t)(atof(argv[++i]) * HAL_SAMPLE_RATE);
+        else if (strcmp(argv[i], "--overlap-ms") == 0 && i + 1 < argc)
+            options.overlap_frames = (uint64_t)(atof(argv[++i]) * HAL_SAMPLE_RATE / 1000.0);
+        else if (strcmp(argv[i], "--preset") == 0 && i + 1 < argc) setup.preset = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) setup.speed_kmh = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--verify") == 0) verify = true;
+        else if (argv[i][0] != '-') paths.push_back(argv[i]);
+        else { usage(argv[0]); return 2; }
+    }
+    if (paths.empty() || paths.size() % 2 != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    options.configure = configure;
+    options.cookie = &setup;
+
+    std::vector<offline_render_job_t> jobs;
+    for (size_t i = 0; i < paths.size(); i += 2) {
+        jobs.push_back({ paths[i], paths[i + 1] });
+    }
+    offline_render_stats_t stats;
+    int ret = offline_render_files(jobs.data(), jobs.size(), &options, &stats);
+    if (ret != 0) {
+        fprintf(stderr, "Falha na renderização: %d\n", ret);
+        return 1;
+    }
+    print_stats("paralelo", &stats);
+    if (!verify) return 0;
+
+    // Referência com uma única thread, gravada ao lado de cada saída.
+    std::vector<std::string> refs;
+    std::vector<offline_render_job_t> ref_jobs;
+    for (const offline_render_job_t& job : jobs) refs.push_back(std::string(job.output) + ".ref");
+    for (size_t i = 0; i < jobs.size(); i++) ref_jobs.push_back({ jobs[i].input, refs[i].c_str() });
+    offline_render_options_t serial = options;
+    serial.threads = 1;
+    ret = offline_render_files(ref_jobs.data(), ref_jobs.size(), &serial, &stats);
+    if (ret != 0) {
+        fprintf(stderr, "Falha na renderização de referência: %d\n", ret);
+        return 1;
+    }
+    print_stats("1 thread", &stats);
+    int mismatches = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const long long diff = compare_files(jobs[i].output, refs[i].c_str());
+        if (diff != 0) {
+            mismatches++;
+            if (diff < 0) printf("%s: falha ao comparar\n", jobs[i].output);
+            else printf("%s: difere da referência no byte %lld\n", jobs[i].output, diff - 1);
+        }
+    }
+    printf("verificação: %s\n", mismatches == 0 ? "saídas idênticas" : "DIVERGÊNCIA");
+    return mismatches == 0 ? 0 : 1;
+}
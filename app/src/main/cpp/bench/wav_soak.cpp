@@ -0,0 +1,165 @@
+// --- Soak Test da HAL com um Arquivo WAV (build de host) ---
+// Toca um WAV pela HAL usando a fonte mapeada em memória (wav_source.h), para
+// rodar gravações longas em máquinas Linux e acompanhar xruns e memória.
+//
+// Modos:
+// - tempo real (padrão): a thread de renderização da HAL consome no ritmo do
+//   relógio e o WAV é entregue no mesmo ritmo; um relatório é impresso a cada
+//   intervalo, com xruns, jitter e RSS (que deve ficar constante).
+// - --asap: sem relógio; a thread de renderização é parada e cada período é
+//   drenado logo após a escrita, medindo a vazão de ponta a ponta.
+// --trace grava ao fim os marcadores por etapa dos últimos segundos como JSON
+// do Chrome/Perfetto (requer a build com -DHAL_TRACE=ON, ver hal_trace.h).
+//
+// Uso: wav_soak <arquivo.wav> [--asap] [--loop] [--seconds N] [--period FRAMES] [--trace SAIDA.json]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <atomic>
+
+#include "audio_hal.h"
+#include "wav_source.h"
+#include "hal_trace.h"
+
+#define SOAK_REPORT_INTERVAL_S 10
+
+static std::atomic<bool> g_stop(false);
+
+static void handle_signal(int /*sig*/) {
+    g_stop.store(true, std::memory_order_relaxed);
+}
+
+typedef struct {
+    audio_hw_device_t* dev;
+    wav_source_t* src;
+    wav_stream_options_t options;
+    wav_stream_stats_t stats;
+    int result;
+    std::atomic<bool> done;
+} soak_job_t;
+
+static void* soak_thread(void* arg) {
+    soak_job_t* job = (soak_job_t*)arg;
+    HAL_TRACE_THREAD_NAME("wav soak");
+    job->result = wav_stream_to_hal(job->dev, job->src, &job->options, &job->stats);
+    job->done.store(true, std::memory_order_release);
+    return NULL;
+}
+
+// RSS atual em KiB (de /proc/self/statm), ou 0 se indisponível.
+static long rss_kib(void) {
+    long pages_total = 0, pages_resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%ld %ld", &pages_total, &pages_resident) != 2) pages_resident = 0;
+    fclose(f);
+    return pages_resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void report(audio_hw_device_t* dev, double seconds) {
+    audio_metrics_t metrics;
+    audio_render_stats_t render;
+    dev->get_metrics(dev, &metrics);
+    dev->get_render_stats(dev, &render);
+    printf("%8.1f s  frames %12llu  overruns %6llu  underruns %6llu  jitter max %7llu ns  RSS %6ld KiB\n",
+           seconds, (unsigned long long)metrics.frames_rendered, (unsigned long long)metrics.overruns,
+           (unsigned long long)metrics.underruns, (unsigned long long)render.jitter_max_ns, rss_kib());
+    fflush(stdout);
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Uso: %s <arquivo.wav> [--asap] [--loop] [--seconds N] [--period FRAMES] [--trace SAIDA.json]\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    const char* trace_path = NULL;
+    bool asap = false, loop = false;
+    long seconds = 0;
+    long period = HAL_PERIOD_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--asap") == 0) asap = true;
+        else if (strcmp(argv[i], "--loop") == 0) loop = true;
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atol(argv[++i]);
+        else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) period = atol(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) trace_path = argv[++i];
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else { usage(argv[0]); return 2; }
+    }
+    if (!path || period < HAL_MIN_PERIOD_FRAMES || period > HAL_MAX_PERIOD_FRAMES) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    wav_source_t src;
+    int ret = wav_source_open(&src, path);
+    if (ret != 0) {
+        fprintf(stderr, "Falha ao abrir %s: %d\n", path, ret);
+        return 1;
+    }
+    printf("%s: %s, %d canais, %u Hz, %.1f s\n", path, wav_sample_format_name(src.format), src.channels,
+           src.sample_rate, (double)src.frames / src.sample_rate);
+
+    audio_hw_device_t* dev = NULL;
+    ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                   (hw_device_t**)&dev);
+    if (ret != 0) {
+        fprintf(stderr, "Falha ao abrir a HAL: %d\n", ret);
+        wav_source_close(&src);
+        return 1;
+    }
+    // No modo --asap quem drena os períodos é o streaming, não a thread.
+    if (asap) dev->stop_render_thread(dev);
+    dev->set_period_size(dev, (size_t)period);
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    soak_job_t job;
+    job.dev = dev;
+    job.src = &src;
+    job.options.pace = asap ? WAV_PACE_ASAP : WAV_PACE_REALTIME;
+    job.options.period_frames = (size_t)period;
+    job.options.loop = loop;
+    job.options.stop = &g_stop;
+    job.stats = wav_stream_stats_t();
+    job.result = 0;
+    job.done.store(false, std::memory_order_relaxed);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, soak_thread, &job) != 0) {
+        fprintf(stderr, "Falha ao criar a thread de streaming.\n");
+        dev->common.close(&dev->common);
+        wav_source_close(&src);
+        return 1;
+    }
+
+    // A thread principal só acompanha: relatório periódico e limite de duração.
+    for (long tick = 1; !job.done.load(std::memory_order_acquire); tick++) {
+        usleep(100000);
+        if (seconds > 0 && tick >= seconds * 10) g_stop.store(true, std::memory_order_relaxed);
+        if (tick % (SOAK_REPORT_INTERVAL_S * 10) == 0) report(dev, tick / 10.0);
+    }
+    pthread_join(thread, NULL);
+
+    const double elapsed_s = job.stats.elapsed_ns / 1e9;
+    const double audio_s = (double)job.stats.frames / HAL_SAMPLE_RATE;
+    report(dev, elapsed_s);
+    printf("resultado %d: %.1f s de áudio em %.2f s (%.1fx tempo real), %llu voltas, %llu escritas parciais\n",
+           job.result, audio_s, elapsed_s, elapsed_s > 0 ? audio_s / elapsed_s : 0.0,
+           (unsigned long long)job.stats.loops, (unsigned long long)job.stats.short_writes);
+    if (trace_path) {
+        const int events = hal_trace_write_json(trace_path);
+        if (events >= 0) printf("trace: %d eventos em %s\n", events, trace_path);
+        else fprintf(stderr, "Falha ao gravar o trace: %d%s\n", events,
+                     events == -ENOSYS ? " (compile com -DHAL_TRACE=ON)" : "");
+    }
+
+    dev->common.close(&dev->common);
+    wav_source_close(&src);
+    return job.result == 0 ? 0 : 1;
+}
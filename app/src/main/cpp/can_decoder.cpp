@@ -0,0 +1,264 @@
+// --- Includes Padrão ---
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal_log.h"
+#include "can_decoder.h"
+#include "hal_trace.h"
+
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "CanDecoder", __VA_ARGS__)
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "CanDecoder", __VA_ARGS__)
+
+// Lotes drenados antes de publicar na HAL, para que uma fonte que nunca esvazia
+// (replay sem ritmo) ainda publique com frequência.
+#define CAN_INGEST_MAX_BATCHES_PER_ROUND 16
+
+// A carga é lida com memcpy como little-endian e invertida para a palavra big-endian.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "decodificação assume CPU little-endian");
+static_assert(AUDIO_VEHICLE_PARAM_COUNT <= 32, "'updated' é uma máscara de 32 bits");
+
+
+// --- Tabela do Veículo Simulado ---
+// 0x123: volume mestre no byte 0 (0..100), enviado pelo simulador CAN do app.
+// 0x3E9: velocidade em 0,01 km/h, 16 bits big-endian nos bytes 0-1.
+const can_signal_def_t can_vehicle_signals[] = {
+    { "MasterVolume", 0x123, 0, 8, CAN_BYTE_ORDER_INTEL, false, 1.0f, 0.0f, 0.0f, 100.0f,
+      AUDIO_VEHICLE_PARAM_MASTER_VOLUME },
+    { "VehicleSpeed", 0x3E9, 7, 16, CAN_BYTE_ORDER_MOTOROLA, false, 0.01f, 0.0f, 0.0f, 300.0f,
+      AUDIO_VEHICLE_PARAM_SPEED_KMH },
+};
+const size_t can_vehicle_signal_count = sizeof(can_vehicle_signals) / sizeof(can_vehicle_signals[0]);
+
+
+// --- Compilação da Tabela ---
+
+/**
+ * Converte uma definição em deslocamento/máscara sobre a palavra da sua ordem de bytes.
+ * @return 0, ou -EINVAL se os bits não couberem em um frame de 8 bytes.
+ */
+static int compile_signal(const can_signal_def_t* def, can_signal_t* sig) {
+    if (def->length == 0 || def->length > 64 || def->start_bit > 63 || def->scale == 0.0f ||
+        def->target < 0 || def->target >= AUDIO_VEHICLE_PARAM_COUNT || !(def->min <= def->max)) {
+        return -EINVAL;
+    }
+    int lsb;
+    if (def->byte_order == CAN_BYTE_ORDER_INTEL) {
+        // Na palavra little-endian o bit k do DBC é o bit k.
+        if (def->start_bit + def->length > 64) return -EINVAL;
+        lsb = def->start_bit;
+        sig->word = 0;
+        sig->min_len = (uint8_t)((lsb + def->length + 7) / 8);
+    } else if (def->byte_order == CAN_BYTE_ORDER_MOTOROLA) {
+        // Na palavra big-endian o byte b ocupa os bits (7 - b) * 8 .. + 7.
+        const int msb = (7 - def->start_bit / 8) * 8 + def->start_bit % 8;
+        lsb = msb - (def->length - 1);
+        if (lsb < 0) return -EINVAL;
+        sig->word = 1;
+        sig->min_len = (uint8_t)(8 - lsb / 8);
+    } else {
+        return -EINVAL;
+    }
+    sig->shift = (uint8_t)lsb;
+    sig->mask = def->length == 64 ? ~0ull : (1ull << def->length) - 1;
+    sig->sign_bit = def->is_signed ? 1ull << (def->length - 1) : 0;
+    sig->target = (uint8_t)def->target;
+    sig->scale = def->scale;
+    sig->offset = def->offset;
+    sig->min = def->min;
+    sig->max = def->max;
+    return 0;
+}
+
+int can_decoder_compile(can_decoder_t* decoder, const can_signal_def_t* defs, size_t count) {
+    if (!decoder || (!defs && count > 0)) {
+        return -EINVAL;
+    }
+    if (count > CAN_MAX_SIGNALS) {
+        return -ENOSPC;
+    }
+    // Ordem de compilação: padrão antes de estendido, por ID (ordenação por
+    // inserção de índices; a tabela tem no máximo CAN_MAX_SIGNALS linhas).
+    uint8_t order[CAN_MAX_SIGNALS];
+    for (size_t i = 0; i < count; i++) {
+        size_t j = i;
+        while (j > 0 && defs[order[j - 1]].can_id > defs[i].can_id) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (uint8_t)i;
+    }
+
+    memset(decoder->index, 0, sizeof(decoder->index));
+    decoder->extended_count = 0;
+    decoder->signal_count = 0;
+    uint16_t per_id[CAN_STANDARD_IDS] = {};
+    for (size_t k = 0; k < count; k++) {
+        const can_signal_def_t* def = &defs[order[k]];
+        const bool extended = (def->can_id & CAN_FRAME_EFF_FLAG) != 0;
+        const uint32_t id = def->can_id & ~CAN_FRAME_EFF_FLAG;
+        if ((extended && id > CAN_FRAME_EFF_MASK) || (!extended && id > CAN_FRAME_SFF_MASK) ||
+            compile_signal(def, &decoder->signals[k]) != 0) {
+            ALOGE("CanDecoder: Sinal %s (ID 0x%X) inválido.", def->name ? def->name : "?", def->can_id);
+            return -EINVAL;
+        }
+        if (!extended) {
+            per_id[id]++;
+            continue;
+        }
+        can_extended_message_t* last = decoder->extended_count > 0
+                ? &decoder->extended[decoder->extended_count - 1] : NULL;
+        if (last && last->can_id == id) {
+            last->count++;
+        } else {
+            if (decoder->extended_count == CAN_MAX_EXTENDED_MESSAGES) return -ENOSPC;
+            can_extended_message_t* msg = &decoder->extended[decoder->extended_count++];
+            msg->can_id = id;
+            msg->first = (uint16_t)k;
+            msg->count = 1;
+        }
+    }
+    // Offsets CSR: os sinais padrão vêm primeiro em 'signals', na ordem dos IDs.
+    uint16_t offset = 0;
+    for (uint32_t id = 0; id < CAN_STANDARD_IDS; id++) {
+        decoder->index[id] = offset;
+        offset = (uint16_t)(offset + per_id[id]);
+    }
+    decoder->index[CAN_STANDARD_IDS] = offset;
+    decoder->signal_count = (int)count;
+    ALOGI("CanDecoder: %zu sinais compilados (%u em IDs padrão, %d mensagens estendidas).",
+          count, (unsigned)offset, decoder->extended_count);
+    return 0;
+}
+
+
+// --- Decodificação ---
+
+/**
+ * Sinais de um frame: [*first, *first + count). Busca direta para IDs padrão,
+ * binária para estendidos.
+ */
+static inline uint32_t lookup(const can_decoder_t* decoder, uint32_t can_id, uint32_t* first) {
+    if (!(can_id & CAN_FRAME_EFF_FLAG)) {
+        const uint32_t id = can_id & CAN_FRAME_SFF_MASK;
+        *first = decoder->index[id];
+        return (uint32_t)(decoder->index[id + 1] - decoder->index[id]);
+    }
+    const uint32_t id = can_id & CAN_FRAME_EFF_MASK;
+    int lo = 0, hi = decoder->extended_count;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (decoder->extended[mid].can_id < id) lo = mid + 1; else hi = mid;
+    }
+    if (lo < decoder->extended_count && decoder->extended[lo].can_id == id) {
+        *first = decoder->extended[lo].first;
+        return decoder->extended[lo].count;
+    }
+    return 0;
+}
+
+void can_decoder_decode(can_decoder_t* decoder, const can_frame_t* frames, size_t count, can_decoded_t* out) {
+    HAL_TRACE_SCOPE_ARG("can_decode", (int32_t)count);
+    uint64_t decoded = 0, unknown = 0, short_frames = 0, out_of_range = 0;
+    for (size_t f = 0; f < count; f++) {
+        const can_frame_t* frame = &frames[f];
+        uint32_t first = 0;
+        const uint32_t n = (frame->can_id & CAN_FRAME_RTR_FLAG) ? 0 : lookup(decoder, frame->can_id, &first);
+        if (n == 0) {
+            unknown++;
+            continue;
+        }
+        // As duas leituras possíveis da carga; cada sinal escolhe a sua pelo índice.
+        uint64_t words[2];
+        memcpy(&words[0], frame->data, sizeof(uint64_t));
+        words[1] = __builtin_bswap64(words[0]);
+        for (uint32_t s = first; s < first + n; s++) {
+            const can_signal_t* sig = &decoder->signals[s];
+            if (frame->len < sig->min_len) {
+                short_frames++;
+                continue;
+            }
+            const uint64_t raw = (words[sig->word] >> sig->shift) & sig->mask;
+            const int64_t value = (int64_t)((raw ^ sig->sign_bit) - sig->sign_bit); // Extensão de sinal
+            const float physical = (float)value * sig->scale + sig->offset;
+            if (!(physical >= sig->min && physical <= sig->max)) {
+                out_of_range++;
+                continue;
+            }
+            out->values[sig->target] = physical;
+            out->updated |= 1u << sig->target;
+            decoded++;
+        }
+    }
+    // Um único escritor: load + store, uma vez por lote.
+    decoder->frames.store(decoder->frames.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    decoder->signals_decoded.store(decoder->signals_decoded.load(std::memory_order_relaxed) + decoded,
+                                   std::memory_order_relaxed);
+    decoder->unknown_frames.store(decoder->unknown_frames.load(std::memory_order_relaxed) + unknown,
+                                  std::memory_order_relaxed);
+    decoder->short_frames.store(decoder->short_frames.load(std::memory_order_relaxed) + short_frames,
+                                std::memory_order_relaxed);
+    decoder->out_of_range.store(decoder->out_of_range.load(std::memory_order_relaxed) + out_of_range,
+                                std::memory_order_relaxed);
+}
+
+int can_decoder_apply(can_decoder_t* decoder, const can_decoded_t* decoded, audio_hw_device_t* dev) {
+    audio_vehicle_param_update_t updates[AUDIO_VEHICLE_PARAM_COUNT];
+    size_t count = 0;
+    for (int p = 0; p < AUDIO_VEHICLE_PARAM_COUNT; p++) {
+        if (decoded->updated & (1u << p)) {
+            updates[count].param = (audio_vehicle_param_t)p;
+            updates[count].value = decoded->values[p];
+            count++;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    HAL_TRACE_SCOPE("can_apply");
+    decoder->batches.store(decoder->batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return dev->set_vehicle_params(dev, updates, count);
+}
+
+
+// --- Ingestão Contínua ---
+
+int can_ingest_to_hal(can_decoder_t* decoder, can_source_t* source, audio_hw_device_t* dev,
+                      const can_ingest_options_t* options) {
+    if (!decoder || !source || !source->read || !dev || !options) {
+        return -EINVAL;
+    }
+    can_frame_t batch[CAN_INGEST_BATCH_FRAMES];
+    const struct timespec poll = { (time_t)(options->poll_us / 1000000), (long)(options->poll_us % 1000000) * 1000 };
+    while (!(options->stop && options->stop->load(std::memory_order_relaxed))) {
+        can_decoded_t decoded;
+        decoded.updated = 0;
+        int status = 0;
+        size_t total = 0;
+        for (int round = 0; round < CAN_INGEST_MAX_BATCHES_PER_ROUND; round++) {
+            status = source->read(source, batch, CAN_INGEST_BATCH_FRAMES);
+            if (status <= 0) break;
+            can_decoder_decode(decoder, batch, (size_t)status, &decoded);
+            total += (size_t)status;
+            if (status < CAN_INGEST_BATCH_FRAMES) break; // Fonte esvaziada
+        }
+        const int ret = can_decoder_apply(decoder, &decoded, dev);
+        if (ret != 0) {
+            ALOGE("CanDecoder: A HAL recusou o lote: %d", ret);
+        }
+        if (status == -ENODATA) {
+            return 0;
+        }
+        if (status < 0) {
+            return status;
+        }
+        if (total == 0) {
+            if (source->wait) {
+                source->wait(source, options->stop);
+            } else {
+                nanosleep(&poll, NULL);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// --- Decodificador de Sinais CAN por Tabela ---
+// Decodifica sinais de frames CAN a partir de uma tabela no estilo DBC
+// (ID -> bit inicial, tamanho, ordem dos bytes, sinal, escala, offset, faixa) e
+// publica os valores físicos direto nos parâmetros do veículo da HAL
+// ('set_vehicle_params').
+//
+// - A tabela é compilada uma vez em uma busca plana: os IDs padrão (11 bits)
+//   indexam diretamente um vetor de offsets (CSR) para a lista de sinais da
+//   mensagem; os estendidos (29 bits), raros, usam busca binária em um vetor
+//   ordenado. Cada sinal vira um deslocamento e uma máscara sobre a carga lida
+//   como um inteiro de 64 bits (little-endian para Intel, big-endian para
+//   Motorola), então a extração não tem laço por bit nem desvio por ordem.
+// - Os frames chegam em lotes de uma can_source_t; o lote inteiro é decodificado
+//   antes de publicar, e cada parâmetro recebe só o seu último valor do lote:
+//   uma chamada à HAL por lote, não por frame.
+// - Nada é alocado nem formatado em texto: o decodificador é uma estrutura de
+//   tamanho fixo e erros viram contadores.
+#ifndef MYAUDIOHALPROJECT_CAN_DECODER_H
+#define MYAUDIOHALPROJECT_CAN_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "audio_hal.h"
+#include "can_source.h"
+
+#define CAN_MAX_SIGNALS 64
+#define CAN_MAX_EXTENDED_MESSAGES 32
+#define CAN_STANDARD_IDS (CAN_FRAME_SFF_MASK + 1)
+// Frames lidos da fonte por vez na ingestão.
+#define CAN_INGEST_BATCH_FRAMES 64
+
+// Ordem dos bytes de um sinal (como no DBC: @1 Intel, @0 Motorola).
+typedef enum {
+    CAN_BYTE_ORDER_INTEL = 0,   // Little-endian: 'start_bit' é o bit menos significativo
+    CAN_BYTE_ORDER_MOTOROLA,    // Big-endian: 'start_bit' é o bit mais significativo
+} can_byte_order_t;
+
+// Definição de um sinal (uma linha "SG_" do DBC) e o parâmetro da HAL que ele alimenta.
+// Numeração de bits do DBC: bit k = bit (k % 8) do byte (k / 8).
+typedef struct {
+    const char* name;           // Só para logs na compilação da tabela
+    uint32_t can_id;            // Identificador, com CAN_FRAME_EFF_FLAG se estendido
+    uint8_t start_bit;          // 0..63
+    uint8_t length;             // 1..64 bits
+    can_byte_order_t byte_order;
+    bool is_signed;             // Complemento de dois
+    float scale;                // valor = bruto * scale + offset
+    float offset;
+    float min;                  // Faixa física; valores fora dela são descartados
+    float max;
+    audio_vehicle_param_t target;
+} can_signal_def_t;
+
+// Sinal compilado: extração por deslocamento e máscara.
+typedef struct {
+    uint64_t mask;              // (1 << length) - 1
+    uint64_t sign_bit;          // Bit de sinal (0 para sinais sem sinal)
+    uint8_t shift;              // Deslocamento do bit menos significativo na palavra
+    uint8_t word;               // 0: palavra little-endian, 1: big-endian
+    uint8_t min_len;            // Bytes de dados necessários no frame
+    uint8_t target;             // audio_vehicle_param_t
+    float scale;
+    float offset;
+    float min;
+    float max;
+} can_signal_t;
+
+typedef struct {
+    uint32_t can_id;            // Sem a flag
+    uint16_t first;             // Primeiro sinal em 'signals'
+    uint16_t count;
+} can_extended_message_t;
+
+// Valores decodificados de um lote: o último de cada parâmetro.
+typedef struct {
+    float values[AUDIO_VEHICLE_PARAM_COUNT];
+    uint32_t updated;           // Bit p = parâmetro p recebeu valor no lote
+} can_decoded_t;
+
+typedef struct {
+    // Mensagens padrão: os sinais do ID i são signals[index[i] .. index[i + 1]).
+    uint16_t index[CAN_STANDARD_IDS + 1];
+    can_extended_message_t extended[CAN_MAX_EXTENDED_MESSAGES];  // Ordenado por ID
+    int extended_count;
+    can_signal_t signals[CAN_MAX_SIGNALS];
+    int signal_count;
+
+    // Contadores (escritos só pela thread de ingestão, lidos por qualquer uma).
+    std::atomic<uint64_t> frames;           // Frames recebidos
+    std::atomic<uint64_t> signals_decoded;  // Sinais extraídos dentro da faixa
+    std::atomic<uint64_t> unknown_frames;   // Frames sem sinais na tabela
+    std::atomic<uint64_t> short_frames;     // Sinais descartados: frame curto demais
+    std::atomic<uint64_t> out_of_range;     // Sinais descartados: fora de min..max
+    std::atomic<uint64_t> batches;          // Lotes publicados na HAL
+} can_decoder_t;
+
+/**
+ * Compila a tabela de sinais. Não deve ser chamada durante a decodificação.
+ * @return 0 em caso de sucesso; -EINVAL para uma definição inválida (bits fora do
+ *         frame, tamanho zero, escala nula, parâmetro inexistente) ou -ENOSPC
+ *         para mais de CAN_MAX_SIGNALS sinais ou CAN_MAX_EXTENDED_MESSAGES mensagens estendidas.
+ */
+int can_decoder_compile(can_decoder_t* decoder, const can_signal_def_t* defs, size_t count);
+
+/**
+ * Decodifica um lote de frames e acumula em 'out' o último valor de cada
+ * parâmetro (limpe 'out->updated' antes do primeiro lote). Não aloca nem bloqueia.
+ */
+void can_decoder_decode(can_decoder_t* decoder, const can_frame_t* frames, size_t count, can_decoded_t* out);
+
+/**
+ * Publica os parâmetros atualizados em 'decoded' na HAL, em uma única chamada.
+ * @return 0 (também sem atualizações) ou o erro de 'set_vehicle_params'.
+ */
+int can_decoder_apply(can_decoder_t* decoder, const can_decoded_t* decoded, audio_hw_device_t* dev);
+
+// Tabela de sinais do veículo simulado: volume (0x123, byte 0) e velocidade (0x3E9).
+extern const can_signal_def_t can_vehicle_signals[];
+extern const size_t can_vehicle_signal_count;
+
+
+// --- Ingestão Contínua ---
+
+typedef struct {
+    uint32_t poll_us;                   // Espera entre leituras com a fonte vazia (fontes sem 'wait')
+    // true encerra a ingestão na próxima leitura; quem pede a parada chama
+    // também 'wake' da fonte, se houver, para interromper um 'wait'.
+    const std::atomic<bool>* stop;
+} can_ingest_options_t;
+
+/**
+ * Drena a fonte em lotes de até CAN_INGEST_BATCH_FRAMES frames, decodificando e
+ * publicando cada rodada (tudo o que estava disponível) com uma chamada à HAL.
+ * Com a fonte vazia, dorme em 'wait' da fonte até chegarem frames, ou por
+ * 'poll_us' se a fonte não tiver 'wait'. Usa apenas um lote na pilha.
+ * @return 0 quando a fonte termina ou 'stop' é pedido; -EINVAL para argumentos
+ *         inválidos, ou o erro da fonte.
+ */
+int can_ingest_to_hal(can_decoder_t* decoder, can_source_t* source, audio_hw_device_t* dev,
+                      const can_ingest_options_t* options);
+
+#endif // MYAUDIOHALPROJECT_CAN_DECODER_H
@@ -0,0 +1,235 @@
+// --- Includes Padrão ---
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h> // Para SYS_futex
+#include <linux/futex.h> // Para FUTEX_WAIT_PRIVATE / FUTEX_WAKE_PRIVATE
+
+#include "hal_log.h"
+#include "hal_metrics.h" // Para hal_metrics_now_ns
+#include "can_source.h"
+
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "CanSource", __VA_ARGS__)
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "CanSource", __VA_ARGS__)
+
+static_assert(sizeof(can_frame_t) == 16, "layout de struct can_frame");
+static_assert((CAN_STUB_CAPACITY_FRAMES & (CAN_STUB_CAPACITY_FRAMES - 1)) == 0, "capacidade potência de dois");
+
+
+// --- Interpretação de Linhas do candump ---
+// Tudo é lido no lugar, no mapeamento; 'end' é sempre o fim do arquivo.
+
+// Valor de um dígito hexadecimal, ou -1.
+static inline int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/**
+ * Lê o timestamp "(segundos.micros)" do início da linha.
+ * @return Posição depois do ')', ou NULL se malformado.
+ */
+static const char* parse_timestamp(const char* p, const char* end, uint64_t* ts_us) {
+    if (p >= end || *p != '(') return NULL;
+    p++;
+    uint64_t sec = 0;
+    while (p < end && *p >= '0' && *p <= '9') sec = sec * 10 + (uint64_t)(*p++ - '0');
+    if (p >= end || *p != '.') return NULL;
+    p++;
+    uint64_t frac = 0;
+    int digits = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (digits < 6) frac = frac * 10 + (uint64_t)(*p - '0');
+        digits++;
+        p++;
+    }
+    if (p >= end || *p != ')' || digits == 0) return NULL;
+    for (; digits < 6; digits++) frac *= 10;
+    *ts_us = sec * 1000000ull + frac;
+    return p + 1;
+}
+
+/**
+ * Interpreta "ID#DADOS" (após o nome da interface) em 'frame'.
+ * @return true para um frame de dados clássico válido.
+ */
+static bool parse_frame(const char* p, const char* end, can_frame_t* frame) {
+    uint32_t id = 0;
+    int id_digits = 0;
+    int v;
+    while (p < end && (v = hex_value(*p)) >= 0) {
+        id = (id << 4) | (uint32_t)v;
+        id_digits++;
+        p++;
+    }
+    if (p >= end || *p != '#' || (id_digits != 3 && id_digits != 8)) return false;
+    p++;
+    if (p < end && (*p == 'R' || *p == '#')) return false; // Remoto ou CAN FD
+    if (id_digits == 8) {
+        if (id > CAN_FRAME_EFF_MASK) return false;
+        id |= CAN_FRAME_EFF_FLAG;
+    } else if (id > CAN_FRAME_SFF_MASK) {
+        return false;
+    }
+    uint8_t len = 0;
+    while (p + 1 < end && hex_value(p[0]) >= 0 && hex_value(p[1]) >= 0) {
+        if (len == CAN_FRAME_MAX_DATA) return false;
+        frame->data[len++] = (uint8_t)((hex_value(p[0]) << 4) | hex_value(p[1]));
+        p += 2;
+    }
+    if (p < end && *p != '\n' && *p != '\r' && *p != ' ') return false; // Dígito ímpar ou lixo
+    frame->can_id = id;
+    frame->len = len;
+    return true;
+}
+
+/**
+ * Interpreta a linha em 'p' (até '\n' ou o fim).
+ * @return 1 para um frame, 0 para uma linha ignorada.
+ */
+static int parse_line(const char* p, const char* end, uint64_t* ts_us, can_frame_t* frame) {
+    p = parse_timestamp(p, end, ts_us);
+    if (!p || p >= end || *p != ' ') return 0;
+    p++;
+    while (p < end && *p != ' ' && *p != '\n') p++; // Nome da interface
+    if (p >= end || *p != ' ') return 0;
+    return parse_frame(p + 1, end, frame) ? 1 : 0;
+}
+
+
+// --- Replay ---
+
+static int replay_read(can_source_t* source, can_frame_t* frames, size_t max) {
+    can_replay_source_t* replay = (can_replay_source_t*)source;
+    const char* const end = replay->map + replay->map_bytes;
+    const uint64_t elapsed_us = replay->realtime ? (hal_metrics_now_ns() - replay->start_ns) / 1000 : 0;
+    size_t count = 0;
+    while (count < max) {
+        if (replay->pos >= replay->map_bytes) {
+            if (!replay->loop || replay->frames + count == 0) {
+                replay->frames += count;
+                return count > 0 ? (int)count : -ENODATA;
+            }
+            // Nova volta: o relógio recomeça no primeiro frame.
+            replay->pos = 0;
+            replay->loops++;
+            replay->first_ts_us = UINT64_MAX;
+            replay->start_ns = hal_metrics_now_ns();
+            if (replay->realtime) break;
+            continue;
+        }
+        const char* line = replay->map + replay->pos;
+        const char* nl = (const char*)memchr(line, '\n', (size_t)(end - line));
+        const char* line_end = nl ? nl : end;
+        uint64_t ts_us = 0;
+        can_frame_t* frame = &frames[count];
+        if (!parse_line(line, line_end, &ts_us, frame)) {
+            if (line_end > line) replay->bad_lines++;
+            replay->pos = (size_t)(line_end - replay->map) + 1;
+            continue;
+        }
+        if (replay->first_ts_us == UINT64_MAX) replay->first_ts_us = ts_us;
+        if (replay->realtime && ts_us > replay->first_ts_us &&
+            ts_us - replay->first_ts_us > elapsed_us) {
+            break; // Ainda não é a hora deste frame: fica para a próxima leitura
+        }
+        replay->pos = (size_t)(line_end - replay->map) + 1;
+        count++;
+    }
+    replay->frames += count;
+    return (int)count;
+}
+
+int can_replay_open(can_replay_source_t* replay, const char* path, bool loop, bool realtime) {
+    memset(replay, 0, sizeof(*replay));
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        const int err = errno;
+        ALOGE("CanSource: Falha ao abrir %s: %s", path, strerror(err));
+        return -err;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return -EINVAL;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        const int err = errno;
+        ALOGE("CanSource: Falha no mmap: %s", strerror(err));
+        return -err;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    replay->source.read = replay_read;
+    replay->map = (const char*)map;
+    replay->map_bytes = (size_t)st.st_size;
+    replay->loop = loop;
+    replay->realtime = realtime;
+    replay->first_ts_us = UINT64_MAX;
+    replay->start_ns = hal_metrics_now_ns();
+    ALOGI("CanSource: Replay de %s (%zu bytes%s%s).", path, replay->map_bytes,
+          loop ? ", em loop" : "", realtime ? ", tempo real" : "");
+    return 0;
+}
+
+void can_replay_close(can_replay_source_t* replay) {
+    if (replay->map) {
+        munmap((void*)replay->map, replay->map_bytes);
+    }
+    memset(replay, 0, sizeof(*replay));
+}
+
+
+// --- Stub ---
+
+static int stub_read(can_source_t* source, can_frame_t* frames, size_t max) {
+    can_stub_source_t* stub = (can_stub_source_t*)source;
+    return (int)(spsc_ring_pop(&stub->ring, frames, max * sizeof(can_frame_t)) / sizeof(can_frame_t));
+}
+
+static void stub_wait(can_source_t* source, const std::atomic<bool>* stop) {
+    can_stub_source_t* stub = (can_stub_source_t*)source;
+    const uint32_t seen = stub->signal.load(std::memory_order_acquire);
+    stub->sleeping.store(1, std::memory_order_relaxed);
+    // Par da barreira em can_stub_push/stub_wake: ou o produtor vê 'sleeping' e
+    // muda 'signal' (o futex não dorme), ou esta releitura vê os frames / a parada.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (spsc_ring_readable(&stub->ring) == 0 && !(stop && stop->load(std::memory_order_relaxed))) {
+        // Retorna sem dormir se 'signal' já mudou (EAGAIN) ou em sinais (EINTR).
+        syscall(SYS_futex, (uint32_t*)&stub->signal, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+    }
+    stub->sleeping.store(0, std::memory_order_relaxed);
+}
+
+static void stub_wake(can_source_t* source) {
+    can_stub_source_t* stub = (can_stub_source_t*)source;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (stub->sleeping.load(std::memory_order_relaxed)) {
+        stub->signal.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, (uint32_t*)&stub->signal, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+void can_stub_init(can_stub_source_t* stub) {
+    stub->source.read = stub_read;
+    stub->source.wait = stub_wait;
+    stub->source.wake = stub_wake;
+    stub->dropped = 0;
+    stub->signal.store(0, std::memory_order_relaxed);
+    stub->sleeping.store(0, std::memory_order_relaxed);
+    spsc_ring_init(&stub->ring, NULL, stub->storage, sizeof(stub->storage));
+}
+
+size_t can_stub_push(can_stub_source_t* stub, const can_frame_t* frames, size_t count) {
+    // Todas as operações movem frames inteiros, então o espaço livre é sempre múltiplo do frame.
+    const size_t pushed = spsc_ring_push(&stub->ring, frames, count * sizeof(can_frame_t)) / sizeof(can_frame_t);
+    stub->dropped += count - pushed;
+    if (pushed > 0) stub_wake(&stub->source);
+    return pushed;
+}
@@ -0,0 +1,113 @@
+// --- Fontes de Frames CAN ---
+// Interface comum para quem entrega frames CAN ao decodificador (can_decoder.h)
+// em lotes, e as duas fontes da simulação:
+// - replay: um log no formato do 'candump -l' (SocketCAN), mapeado com mmap e
+//   interpretado no lugar, sem sscanf nem strings; opcionalmente no ritmo dos
+//   timestamps gravados e em loop;
+// - stub: uma fila lock-free em processo, alimentada por outra thread (a camada
+//   JNI do simulador CAN, testes, o benchmark).
+// Nenhuma fonte aloca memória ou formata texto por frame. Um barramento real
+// (socket CAN_RAW, lido com recvmmsg) entraria como mais uma implementação:
+// can_frame_t tem o layout de 'struct can_frame'.
+#ifndef MYAUDIOHALPROJECT_CAN_SOURCE_H
+#define MYAUDIOHALPROJECT_CAN_SOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "spsc_ring_buffer.h"
+
+// Bits de 'can_id', como em <linux/can.h>.
+#define CAN_FRAME_EFF_FLAG 0x80000000u  // Identificador estendido (29 bits)
+#define CAN_FRAME_RTR_FLAG 0x40000000u  // Remote transmission request (sem dados)
+#define CAN_FRAME_SFF_MASK 0x000007FFu
+#define CAN_FRAME_EFF_MASK 0x1FFFFFFFu
+#define CAN_FRAME_MAX_DATA 8
+
+// Frame CAN clássico, com o layout de 'struct can_frame' do SocketCAN (16 bytes).
+typedef struct {
+    uint32_t can_id;    // Identificador | CAN_FRAME_*_FLAG
+    uint8_t len;        // Bytes de dados (0..8)
+    uint8_t pad[3];
+    alignas(8) uint8_t data[CAN_FRAME_MAX_DATA];
+} can_frame_t;
+
+// Fonte de frames. 'read' nunca bloqueia.
+typedef struct can_source {
+    /**
+     * Copia até 'max' frames disponíveis agora para 'frames'.
+     * @return Frames copiados (0 = nada disponível no momento), ou -ENODATA
+     *         quando a fonte terminou (fim do log sem loop).
+     */
+    int (*read)(struct can_source* source, can_frame_t* frames, size_t max);
+    /**
+     * Opcional: dorme até a fonte ter frames, '*stop' virar true ou 'wake' ser
+     * chamada (pode retornar antes; quem chama relê a fonte). Sem ela, quem lê
+     * faz polling (ex: o replay, cujo próximo frame depende do relógio).
+     */
+    void (*wait)(struct can_source* source, const std::atomic<bool>* stop);
+    // Acorda um 'wait' em andamento (ex: depois de pedir a parada). NULL sem 'wait'.
+    void (*wake)(struct can_source* source);
+} can_source_t;
+
+
+// --- Replay de Log (candump -l) ---
+// Uma linha por frame: "(1436509052.249713) can0 123#DEADBEEF". Identificadores
+// com 8 dígitos são estendidos; frames remotos ("#R") e CAN FD ("##") são
+// ignorados, assim como linhas malformadas (contadas em 'bad_lines').
+
+typedef struct {
+    can_source_t source;        // Primeiro membro: permite o cast
+    const char* map;
+    size_t map_bytes;
+    size_t pos;                 // Próxima linha
+    bool loop;                  // Recomeça do início no fim do log
+    bool realtime;              // Entrega cada frame só quando o seu timestamp chega
+    uint64_t first_ts_us;       // Timestamp da primeira linha da volta atual
+    uint64_t start_ns;          // Relógio monotônico no início da volta atual
+    uint64_t frames;            // Frames entregues
+    uint64_t bad_lines;         // Linhas ignoradas
+    uint64_t loops;
+} can_replay_source_t;
+
+/**
+ * Mapeia um log do candump.
+ * @param loop Recomeça do início ao chegar no fim.
+ * @param realtime Respeita os intervalos entre timestamps (senão, o mais rápido possível).
+ * @return 0 em caso de sucesso; -errno se o arquivo não puder ser aberto/mapeado,
+ *         ou -EINVAL para um arquivo vazio.
+ */
+int can_replay_open(can_replay_source_t* replay, const char* path, bool loop, bool realtime);
+
+// Desfaz o mapeamento.
+void can_replay_close(can_replay_source_t* replay);
+
+
+// --- Stub em Processo ---
+// Fila SPSC de frames: um produtor (can_stub_push) e o leitor da fonte. Com a
+// fila vazia, o leitor dorme em um futex que o produtor só sinaliza quando há
+// alguém dormindo (sem syscall por frame enquanto a ingestão acompanha).
+
+#define CAN_STUB_CAPACITY_FRAMES 1024   // Potência de dois
+
+typedef struct {
+    can_source_t source;        // Primeiro membro: permite o cast
+    spsc_ring_t ring;
+    uint64_t dropped;           // Frames descartados com a fila cheia (só o produtor escreve)
+    // Palavra de futex do leitor: incrementada a cada sinal; 'sleeping' indica
+    // que o leitor pode estar dormindo nela.
+    alignas(HAL_CACHE_LINE_SIZE) std::atomic<uint32_t> signal;
+    std::atomic<uint32_t> sleeping;
+    alignas(HAL_CACHE_LINE_SIZE) uint8_t storage[CAN_STUB_CAPACITY_FRAMES * sizeof(can_frame_t)];
+} can_stub_source_t;
+
+void can_stub_init(can_stub_source_t* stub);
+
+/**
+ * Enfileira frames (lado produtor) e acorda o leitor se ele estiver dormindo.
+ * Nunca bloqueia: com a fila cheia, o excesso é descartado e contado em 'dropped'.
+ * @return Frames aceitos.
+ */
+size_t can_stub_push(can_stub_source_t* stub, const can_frame_t* frames, size_t count);
+
+#endif // MYAUDIOHALPROJECT_CAN_SOURCE_H
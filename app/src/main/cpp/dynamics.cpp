@@ -0,0 +1,229 @@
+// --- Includes Padrão ---
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // Intrínsecos SSE/SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>   // Intrínsecos NEON
+#endif
+
+#include "dynamics.h"
+
+static_assert(HAL_CHANNELS == 2, "o limitador processa estéreo intercalado");
+static_assert((DYN_LIMITER_RING_FRAMES & (DYN_LIMITER_RING_FRAMES - 1)) == 0, "fila potência de dois");
+static_assert(DYN_LIMITER_RING_FRAMES % DYN_LIMITER_BLOCK_FRAMES == 0, "blocos não cruzam o fim da fila");
+
+#define DYN_SLOT_MASK (DYN_LIMITER_RING_FRAMES / DYN_LIMITER_BLOCK_FRAMES - 1)
+
+
+// --- Kernel Escalar (fallback) ---
+
+static void scale_ramp_scalar(const float* in, float* out, size_t frames, float gain, float gain_step) {
+    for (size_t i = 0; i < frames; i++) {
+        const float g = gain + (float)i * gain_step;
+        out[2 * i] = in[2 * i] * g;
+        out[2 * i + 1] = in[2 * i + 1] * g;
+    }
+}
+
+static float peak_scalar(const float* in, size_t samples) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < samples; i++) {
+        peak = fmaxf(peak, fabsf(in[i]));
+    }
+    return peak;
+}
+
+
+// --- Kernel SSE ---
+// Dois frames estéreo por registrador; o ganho de cada frame é recalculado a
+// partir do índice (sem acumular erro de arredondamento ao longo do bloco).
+#if defined(__SSE2__)
+
+static void scale_ramp_sse(const float* in, float* out, size_t frames, float gain, float gain_step) {
+    const __m128 lane_frame = _mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f);
+    const __m128 g0 = _mm_set1_ps(gain);
+    const __m128 step = _mm_set1_ps(gain_step);
+    size_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        const __m128 index = _mm_add_ps(_mm_set1_ps((float)i), lane_frame);
+        const __m128 g = _mm_add_ps(g0, _mm_mul_ps(index, step));
+        _mm_storeu_ps(out + 2 * i, _mm_mul_ps(_mm_loadu_ps(in + 2 * i), g));
+    }
+    scale_ramp_scalar(in + 2 * i, out + 2 * i, frames - i, gain + (float)i * gain_step, gain_step);
+}
+
+static float peak_sse(const float* in, size_t samples) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 peak = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        peak = _mm_max_ps(peak, _mm_and_ps(_mm_loadu_ps(in + i), abs_mask));
+    }
+    peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+    return fmaxf(_mm_cvtss_f32(peak), peak_scalar(in + i, samples - i));
+}
+
+#endif // __SSE2__
+
+
+// --- Kernel NEON ---
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+static void scale_ramp_neon(const float* in, float* out, size_t frames, float gain, float gain_step) {
+    static const float kLaneFrame[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    const float32x4_t lane_frame = vld1q_f32(kLaneFrame);
+    const float32x4_t g0 = vdupq_n_f32(gain);
+    size_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        const float32x4_t index = vaddq_f32(vdupq_n_f32((float)i), lane_frame);
+        const float32x4_t g = vmlaq_n_f32(g0, index, gain_step);
+        vst1q_f32(out + 2 * i, vmulq_f32(vld1q_f32(in + 2 * i), g));
+    }
+    scale_ramp_scalar(in + 2 * i, out + 2 * i, frames - i, gain + (float)i * gain_step, gain_step);
+}
+
+static float peak_neon(const float* in, size_t samples) {
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        peak = vmaxq_f32(peak, vabsq_f32(vld1q_f32(in + i)));
+    }
+#if defined(__aarch64__)
+    const float lanes = vmaxvq_f32(peak);
+#else
+    float32x2_t half = vpmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+    half = vpmax_f32(half, half);
+    const float lanes = vget_lane_f32(half, 0);
+#endif
+    return fmaxf(lanes, peak_scalar(in + i, samples - i));
+}
+
+#endif // __ARM_NEON
+
+
+// --- Despacho ---
+
+static inline void scale_ramp(const float* in, float* out, size_t frames, float gain, float gain_step) {
+    switch (eq_active_kernel()) {
+#if defined(__SSE2__)
+        case EQ_KERNEL_SSE: scale_ramp_sse(in, out, frames, gain, gain_step); return;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case EQ_KERNEL_NEON: scale_ramp_neon(in, out, frames, gain, gain_step); return;
+#endif
+        default: scale_ramp_scalar(in, out, frames, gain, gain_step); return;
+    }
+}
+
+static inline float peak(const float* in, size_t samples) {
+    switch (eq_active_kernel()) {
+#if defined(__SSE2__)
+        case EQ_KERNEL_SSE: return peak_sse(in, samples);
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case EQ_KERNEL_NEON: return peak_neon(in, samples);
+#endif
+        default: return peak_scalar(in, samples);
+    }
+}
+
+
+// --- Configuração e Loudness ---
+
+int dyn_validate_config(const audio_dynamics_config_t* config) {
+    if (!config) return -EINVAL;
+    // As comparações negadas também recusam NaN.
+    if (!(config->speed_ref_kmh > 0.0f) ||
+        !(config->speed_gain_db >= 0.0f && config->speed_gain_db <= EQ_MAX_GAIN_DB) ||
+        !(config->loudness_bass_db >= 0.0f && config->loudness_bass_db <= EQ_MAX_GAIN_DB) ||
+        !(config->loudness_treble_db >= 0.0f && config->loudness_treble_db <= EQ_MAX_GAIN_DB) ||
+        !(config->limiter_threshold_db >= -24.0f && config->limiter_threshold_db <= 0.0f) ||
+        !(config->limiter_release_ms >= 1.0f && config->limiter_release_ms <= 5000.0f)) {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+// Nível de banda do equalizador (0..100, 50 = plano) mais próximo de um reforço em dB.
+static int db_to_level(float db) {
+    return EQ_LEVEL_FLAT + (int)lroundf(db / EQ_MAX_GAIN_DB * (float)(EQ_LEVEL_MAX - EQ_LEVEL_FLAT));
+}
+
+void dyn_loudness_design(dyn_loudness_table_t* table, const audio_dynamics_config_t* config, float sample_rate) {
+    for (int step = 0; step <= DYN_LOUDNESS_STEPS; step++) {
+        const float fraction = (float)step / DYN_LOUDNESS_STEPS;
+        biquad_coeffs_t* coeffs = table->coeffs[step];
+        eq_design_band(AUDIO_EQ_BAND_BASS, db_to_level(fraction * config->loudness_bass_db), sample_rate,
+                       &coeffs[AUDIO_EQ_BAND_BASS]);
+        eq_design_band(AUDIO_EQ_BAND_MID, EQ_LEVEL_FLAT, sample_rate, &coeffs[AUDIO_EQ_BAND_MID]);
+        eq_design_band(AUDIO_EQ_BAND_TREBLE, db_to_level(fraction * config->loudness_treble_db), sample_rate,
+                       &coeffs[AUDIO_EQ_BAND_TREBLE]);
+    }
+}
+
+
+// --- Limitador ---
+
+void dyn_limiter_reset(dyn_limiter_t* lim, const audio_dynamics_config_t* config, float sample_rate) {
+    memset(lim, 0, sizeof(*lim));
+    lim->threshold = powf(10.0f, config->limiter_threshold_db / 20.0f);
+    // Recuperação exponencial: a redução cai a 1/e em 'limiter_release_ms'.
+    const float blocks_per_release = config->limiter_release_ms * 1e-3f * sample_rate / DYN_LIMITER_BLOCK_FRAMES;
+    lim->release_coeff = expf(-1.0f / blocks_per_release);
+    lim->next_target = 1.0f;
+    lim->last_gain = 1.0f;
+    for (size_t i = 0; i < sizeof(lim->block_gain) / sizeof(lim->block_gain[0]); i++) {
+        lim->block_gain[i] = 1.0f;
+    }
+}
+
+void dyn_limiter_process(dyn_limiter_t* lim, const float* in, float* out, size_t frames,
+                         float gain, float gain_step) {
+    // Saída a partir de 'written - latência' (aritmética sem sinal: no início,
+    // índices "negativos" caem no fim da fila, em silêncio e com ganho 1).
+    uint64_t read = lim->written - DYN_LIMITER_LATENCY_FRAMES;
+
+    // 1. Entrada: ganho de entrada para a fila e pico de cada bloco. Ao completar
+    //    um bloco, o anterior (cujo sucessor agora é conhecido) é finalizado.
+    for (size_t done = 0; done < frames; ) {
+        const size_t fill = (size_t)(lim->written % DYN_LIMITER_BLOCK_FRAMES);
+        size_t n = DYN_LIMITER_BLOCK_FRAMES - fill;
+        if (n > frames - done) n = frames - done;
+        float* dst = lim->ring + (size_t)(lim->written % DYN_LIMITER_RING_FRAMES) * HAL_CHANNELS;
+        scale_ramp(in + done * HAL_CHANNELS, dst, n, gain + (float)done * gain_step, gain_step);
+        lim->block_peak = fmaxf(lim->block_peak, peak(dst, n * HAL_CHANNELS));
+        lim->written += n;
+        done += n;
+        if (fill + n == DYN_LIMITER_BLOCK_FRAMES) {
+            const uint64_t block = lim->written / DYN_LIMITER_BLOCK_FRAMES - 1;
+            const float target = lim->threshold / fmaxf(lim->block_peak, lim->threshold);
+            const float released = 1.0f - (1.0f - lim->last_gain) * lim->release_coeff;
+            const float gain_end = fminf(fminf(lim->next_target, target), released);
+            lim->block_gain[(block - 1) & DYN_SLOT_MASK] = gain_end;
+            lim->last_gain = gain_end;
+            lim->next_target = target;
+            lim->block_peak = 0.0f;
+        }
+    }
+
+    // 2. Saída atrasada: em cada bloco, rampa linear do ganho ao fim do bloco
+    //    anterior até o ganho ao fim deste.
+    for (size_t done = 0; done < frames; ) {
+        const size_t offset = (size_t)(read % DYN_LIMITER_BLOCK_FRAMES);
+        size_t n = DYN_LIMITER_BLOCK_FRAMES - offset;
+        if (n > frames - done) n = frames - done;
+        const uint64_t slot = read / DYN_LIMITER_BLOCK_FRAMES;
+        const float g_start = lim->block_gain[(slot - 1) & DYN_SLOT_MASK];
+        const float g_end = lim->block_gain[slot & DYN_SLOT_MASK];
+        const float step = (g_end - g_start) * (1.0f / DYN_LIMITER_BLOCK_FRAMES);
+        scale_ramp(lim->ring + (size_t)(read % DYN_LIMITER_RING_FRAMES) * HAL_CHANNELS, out + done * HAL_CHANNELS,
+                   n, g_start + step * (float)(offset + 1), step);
+        read += n;
+        done += n;
+    }
+}
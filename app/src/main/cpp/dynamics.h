@@ -0,0 +1,93 @@
+// --- Estágio de Dinâmica: Compensação por Velocidade e Limitador ---
+// Última etapa da cadeia de cada zona, depois do equalizador do usuário:
+// 1. Loudness por velocidade: um low shelf de graves e um high shelf de agudos
+//    cujo reforço cresce com a velocidade, cobrindo o ruído de rodagem. Os
+//    coeficientes de cada degrau de velocidade são calculados na configuração
+//    (dyn_loudness_table_t); a thread de áudio só escolhe o degrau e faz uma
+//    rampa de coeficientes, sem trigonometria.
+// 2. Ganho por velocidade, somado em dB ao volume da zona e ao volume mestre.
+// 3. Limitador de pico com look-ahead, para que reforços do equalizador e da
+//    compensação nunca saturem na conversão para 16 bits (o amplificador).
+//
+// O limitador trabalha em blocos de DYN_LIMITER_BLOCK_FRAMES frames: o pico de
+// cada bloco (máximo de |x| nos dois canais, vetorizado) define o ganho que o
+// bloco admite, e o ganho ao fim de cada bloco é o mínimo entre o do próprio
+// bloco, o do bloco seguinte e a recuperação (release) do anterior. Aplicado
+// em rampa linear dentro do bloco, o ganho já chegou ao valor necessário
+// quando o pico sai: nenhuma amostra passa do teto. Para conhecer o bloco
+// seguinte, a saída atrasa DYN_LIMITER_LATENCY_FRAMES frames, reportados em
+// 'audio_render_stats_t::latency_frames'. Detecção e aplicação do ganho não
+// têm desvio por amostra (SSE2/NEON, seguindo eq_active_kernel).
+#ifndef MYAUDIOHALPROJECT_DYNAMICS_H
+#define MYAUDIOHALPROJECT_DYNAMICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "audio_hal.h"
+#include "eq_dsp.h"
+
+#define DYN_LIMITER_BLOCK_FRAMES 32     // 0,67 ms a 48 kHz: duração do ataque
+#define DYN_LIMITER_LATENCY_FRAMES (2 * DYN_LIMITER_BLOCK_FRAMES)
+#define DYN_LIMITER_RING_FRAMES 512     // Potência de dois
+#define DYN_LIMITER_MAX_FRAMES EQ_BLOCK_FRAMES // Frames por chamada a dyn_limiter_process
+#define DYN_LOUDNESS_STEPS 16           // Degraus de velocidade da tabela de loudness
+
+static_assert(DYN_LIMITER_MAX_FRAMES + DYN_LIMITER_LATENCY_FRAMES <= DYN_LIMITER_RING_FRAMES,
+              "a fila do limitador precisa conter o atraso e uma chamada inteira");
+
+// Estado do limitador de uma zona (estéreo intercalado).
+typedef struct {
+    float threshold;            // Teto linear
+    float release_coeff;        // Fração da redução de ganho que sobra a cada bloco
+    uint64_t written;           // Frames recebidos desde o reset
+    float block_peak;           // Pico parcial do bloco de entrada corrente
+    float next_target;          // Ganho admitido pelo último bloco completo
+    float last_gain;            // Ganho ao fim do último bloco finalizado
+    // Ganho ao fim de cada bloco, indexado como os blocos da fila.
+    float block_gain[DYN_LIMITER_RING_FRAMES / DYN_LIMITER_BLOCK_FRAMES];
+    alignas(16) float ring[DYN_LIMITER_RING_FRAMES * HAL_CHANNELS];
+} dyn_limiter_t;
+
+// Coeficientes do equalizador de loudness para cada degrau de velocidade
+// (degrau 0 = plano).
+typedef struct {
+    biquad_coeffs_t coeffs[DYN_LOUDNESS_STEPS + 1][AUDIO_EQ_NUM_BANDS];
+} dyn_loudness_table_t;
+
+/**
+ * Valida uma configuração de dinâmica (faixas documentadas em audio_hal.h).
+ * @return 0, ou -EINVAL.
+ */
+int dyn_validate_config(const audio_dynamics_config_t* config);
+
+/**
+ * Calcula a tabela de loudness de uma configuração (trigonometria: só em
+ * operações de controle).
+ */
+void dyn_loudness_design(dyn_loudness_table_t* table, const audio_dynamics_config_t* config, float sample_rate);
+
+/**
+ * Fração da compensação (0..1) para uma velocidade em km/h.
+ */
+static inline float dyn_speed_fraction(const audio_dynamics_config_t* config, float speed_kmh) {
+    const float f = speed_kmh / config->speed_ref_kmh;
+    return f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+}
+
+/**
+ * Zera o limitador: fila em silêncio e ganho unitário.
+ */
+void dyn_limiter_reset(dyn_limiter_t* lim, const audio_dynamics_config_t* config, float sample_rate);
+
+/**
+ * Aplica o ganho de entrada (rampa g = gain + i * gain_step no frame i) e limita
+ * 'frames' frames estéreo intercalados. A saída corresponde à entrada de
+ * DYN_LIMITER_LATENCY_FRAMES frames antes. 'in' e 'out' podem ser o mesmo buffer.
+ * Não aloca nem bloqueia.
+ * @param frames No máximo DYN_LIMITER_MAX_FRAMES.
+ */
+void dyn_limiter_process(dyn_limiter_t* lim, const float* in, float* out, size_t frames,
+                         float gain, float gain_step);
+
+#endif // MYAUDIOHALPROJECT_DYNAMICS_H
@@ -0,0 +1,595 @@
+// --- Includes Padrão ---
+#include <errno.h>      // Para códigos de erro padrão (-EINVAL, -ENOTSUP)
+#include <math.h>       // Para pow, sin, cos, sqrt no cálculo dos coeficientes
+#include <string.h>     // Para memset
+#include <pthread.h>    // Para pthread_once (detecção única da CPU)
+#include <atomic>       // Para publicar o kernel escolhido entre threads
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // Intrínsecos SSE/SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>   // Intrínsecos NEON
+#endif
+#if defined(__arm__) && !defined(__aarch64__)
+#include <sys/auxv.h>   // Para getauxval(AT_HWCAP) na detecção de NEON em ARMv7
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+#include "eq_dsp.h"
+
+
+// --- Parâmetros das Bandas ---
+// Frequência central/de corte e fator de qualidade de cada estágio do layout padrão.
+const audio_eq_band_t eq_default_layout[AUDIO_EQ_NUM_BANDS] = {
+        { AUDIO_EQ_SHAPE_LOW_SHELF,  100.0f,  0.7071f }, // Graves
+        { AUDIO_EQ_SHAPE_PEAKING,    1000.0f, 0.7f    }, // Médios
+        { AUDIO_EQ_SHAPE_HIGH_SHELF, 8000.0f, 0.7071f }, // Agudos
+};
+
+// Curvas dos presets em dB, nas oitavas de kPresetAnchorHz (x2 a cada coluna).
+#define EQ_PRESET_ANCHORS 10
+static const double kPresetAnchorHz = 31.25;
+static const float kPresetCurves[AUDIO_EQ_PRESET_COUNT][EQ_PRESET_ANCHORS] = {
+        //  31     63    125    250    500    1k     2k     4k     8k    16k
+        {  0.0f,  0.0f,  0.0f,  0.0f,  0.0f,  0.0f,  0.0f,  0.0f,  0.0f,  0.0f }, // FLAT
+        {  5.0f,  4.0f,  3.0f,  1.0f, -1.0f, -1.0f,  1.0f,  3.0f,  4.0f,  5.0f }, // ROCK
+        { -1.0f,  1.0f,  3.0f,  4.0f,  3.0f,  0.0f, -1.0f, -1.0f,  1.0f,  2.0f }, // POP
+        {  3.0f,  2.0f,  1.0f,  2.0f, -1.0f, -1.0f,  0.0f,  1.0f,  2.0f,  3.0f }, // JAZZ
+        {  4.0f,  3.0f,  2.0f,  1.0f, -1.0f, -1.0f,  0.0f,  2.0f,  3.0f,  4.0f }, // CLASSICAL
+        { -2.0f, -2.0f, -1.0f,  1.0f,  3.0f,  4.0f,  4.0f,  2.0f,  0.0f, -1.0f }, // VOCAL
+        {  8.0f,  7.0f,  5.0f,  3.0f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,  0.0f }, // BASS_BOOST
+};
+
+// Valores de estado abaixo deste limiar são zerados ao fim de cada bloco.
+// Evita que a cauda do filtro caia em números denormais, que são dezenas de
+// vezes mais lentos em várias CPUs quando o stream fica em silêncio.
+static const float kDenormalThreshold = 1e-20f;
+
+
+// --- Projeto dos Coeficientes (RBJ Audio EQ Cookbook) ---
+
+/**
+ * Calcula os coeficientes normalizados de um estágio para o ganho pedido.
+ * O cálculo é feito em double e arredondado para float no final.
+ */
+static biquad_coeffs_t design_band(const audio_eq_band_t* band, double gain_db, double sample_rate) {
+    // Mantém a frequência abaixo de Nyquist para taxas baixas (ex: 16 kHz).
+    double f0 = (double)band->freq_hz;
+    if (f0 > 0.45 * sample_rate) f0 = 0.45 * sample_rate;
+
+    const double A = pow(10.0, gain_db / 40.0);
+    const double w0 = 2.0 * M_PI * f0 / sample_rate;
+    const double cw = cos(w0);
+    const double alpha = sin(w0) / (2.0 * (double)band->q);
+    const double sqA2alpha = 2.0 * sqrt(A) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (band->shape) {
+        case AUDIO_EQ_SHAPE_LOW_SHELF:
+            b0 = A * ((A + 1) - (A - 1) * cw + sqA2alpha);
+            b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+            b2 = A * ((A + 1) - (A - 1) * cw - sqA2alpha);
+            a0 = (A + 1) + (A - 1) * cw + sqA2alpha;
+            a1 = -2 * ((A - 1) + (A + 1) * cw);
+            a2 = (A + 1) + (A - 1) * cw - sqA2alpha;
+            break;
+        case AUDIO_EQ_SHAPE_HIGH_SHELF:
+            b0 = A * ((A + 1) + (A - 1) * cw + sqA2alpha);
+            b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+            b2 = A * ((A + 1) + (A - 1) * cw - sqA2alpha);
+            a0 = (A + 1) - (A - 1) * cw + sqA2alpha;
+            a1 = 2 * ((A - 1) - (A + 1) * cw);
+            a2 = (A + 1) - (A - 1) * cw - sqA2alpha;
+            break;
+        case AUDIO_EQ_SHAPE_PEAKING:
+        default:
+            b0 = 1 + alpha * A;
+            b1 = -2 * cw;
+            b2 = 1 - alpha * A;
+            a0 = 1 + alpha / A;
+            a1 = -2 * cw;
+            a2 = 1 - alpha / A;
+            break;
+    }
+
+    biquad_coeffs_t c;
+    c.b0 = (float)(b0 / a0);
+    c.b1 = (float)(b1 / a0);
+    c.b2 = (float)(b2 / a0);
+    c.a1 = (float)(a1 / a0);
+    c.a2 = (float)(a2 / a0);
+    return c;
+}
+
+/**
+ * Converte o nível da SeekBar (0..100) em ganho em dB (-12..+12).
+ */
+static double level_to_db(int level) {
+    return (double)(level - EQ_LEVEL_FLAT) * EQ_MAX_GAIN_DB / (double)(EQ_LEVEL_FLAT - EQ_LEVEL_MIN);
+}
+
+
+// --- Kernel Escalar (fallback portátil) ---
+// Processa um estágio por vez sobre o bloco inteiro ("stage-major"), o que
+// mantém os coeficientes e o estado do canal em registradores.
+// Com RAMP = true, os coeficientes avançam 'd' a cada frame (transição sem cliques);
+// a variante sem rampa é a usada em regime permanente e não paga por isso.
+
+template <bool RAMP>
+static void biquad_scalar(const biquad_coeffs_t* c, const biquad_coeffs_t* d, float* z1p, float* z2p,
+                          float* pcm, size_t frames, int stride) {
+    float b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+    float z1 = *z1p, z2 = *z2p;
+    for (size_t i = 0; i < frames; i++) {
+        const float x = pcm[i * stride];
+        const float y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        pcm[i * stride] = y;
+        if (RAMP) {
+            b0 += d->b0; b1 += d->b1; b2 += d->b2; a1 += d->a1; a2 += d->a2;
+        }
+    }
+    *z1p = z1;
+    *z2p = z2;
+}
+
+template <bool RAMP>
+static void eq_process_scalar(eq_state_t* eq, float* pcm, size_t frames) {
+    const int ch = eq->channels;
+    for (int s = 0; s < eq->bands; s++) {
+        for (int c = 0; c < ch; c++) {
+            biquad_scalar<RAMP>(&eq->coeffs[s], &eq->delta[s], &eq->z1[s][c], &eq->z2[s][c], pcm + c, frames, ch);
+        }
+    }
+}
+
+static void s16_to_float_scalar(const int16_t* in, float* out, size_t samples) {
+    const float scale = 1.0f / 32768.0f;
+    for (size_t i = 0; i < samples; i++) out[i] = (float)in[i] * scale;
+}
+
+static void float_to_s16_scalar(const float* in, int16_t* out, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        float v = in[i] * 32768.0f;
+        v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+        // Mais próximo com empate para o par, como cvtps (SSE) e neon_round_s32:
+        // os kernels SIMD deixam só a cauda para cá e o resultado não muda com o
+        // tamanho do bloco. Já limitado, 'v' não gera erro de domínio.
+        out[i] = (int16_t)lrintf(v);
+    }
+}
+
+
+// --- Kernel SSE (x86 / x86_64) ---
+#if defined(__SSE2__)
+
+// Carrega/armazena W lanes (4, 2 ou 1) de um frame intercalado.
+template <int W> static inline __m128 sse_load(const float* p) {
+    if (W == 4) return _mm_loadu_ps(p);
+    if (W == 2) return _mm_castpd_ps(_mm_load_sd((const double*)p));
+    return _mm_load_ss(p);
+}
+template <int W> static inline void sse_store(float* p, __m128 v) {
+    if (W == 4) _mm_storeu_ps(p, v);
+    else if (W == 2) _mm_store_sd((double*)p, _mm_castps_pd(v));
+    else _mm_store_ss(p, v);
+}
+
+// Um estágio biquad sobre um grupo de W canais consecutivos.
+template <int W, bool RAMP>
+static void biquad_sse(const biquad_coeffs_t* c, const biquad_coeffs_t* d, float* z1p, float* z2p,
+                       float* pcm, size_t frames, int stride) {
+    __m128 b0 = _mm_set1_ps(c->b0), b1 = _mm_set1_ps(c->b1), b2 = _mm_set1_ps(c->b2);
+    __m128 a1 = _mm_set1_ps(c->a1), a2 = _mm_set1_ps(c->a2);
+    __m128 db0, db1, db2, da1, da2;
+    if (RAMP) {
+        db0 = _mm_set1_ps(d->b0); db1 = _mm_set1_ps(d->b1); db2 = _mm_set1_ps(d->b2);
+        da1 = _mm_set1_ps(d->a1); da2 = _mm_set1_ps(d->a2);
+    }
+    __m128 z1 = sse_load<W>(z1p), z2 = sse_load<W>(z2p);
+    for (size_t i = 0; i < frames; i++) {
+        float* p = pcm + i * stride;
+        const __m128 x = sse_load<W>(p);
+        const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        sse_store<W>(p, y);
+        if (RAMP) {
+            b0 = _mm_add_ps(b0, db0); b1 = _mm_add_ps(b1, db1); b2 = _mm_add_ps(b2, db2);
+            a1 = _mm_add_ps(a1, da1); a2 = _mm_add_ps(a2, da2);
+        }
+    }
+    sse_store<W>(z1p, z1);
+    sse_store<W>(z2p, z2);
+}
+
+template <bool RAMP>
+static void eq_process_sse(eq_state_t* eq, float* pcm, size_t frames) {
+    const int ch = eq->channels;
+    for (int s = 0; s < eq->bands; s++) {
+        const biquad_coeffs_t* c = &eq->coeffs[s];
+        const biquad_coeffs_t* d = &eq->delta[s];
+        int g = 0;
+        for (; g + 4 <= ch; g += 4) biquad_sse<4, RAMP>(c, d, &eq->z1[s][g], &eq->z2[s][g], pcm + g, frames, ch);
+        for (; g + 2 <= ch; g += 2) biquad_sse<2, RAMP>(c, d, &eq->z1[s][g], &eq->z2[s][g], pcm + g, frames, ch);
+        for (; g < ch; g++)         biquad_sse<1, RAMP>(c, d, &eq->z1[s][g], &eq->z2[s][g], pcm + g, frames, ch);
+    }
+}
+
+static void s16_to_float_sse(const int16_t* in, float* out, size_t samples) {
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+        // Extensão de sinal de 16 para 32 bits: desloca para a metade alta e volta com shift aritmético.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    s16_to_float_scalar(in + i, out + i, samples - i);
+}
+
+static void float_to_s16_sse(const float* in, int16_t* out, size_t samples) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        // cvtps arredonda como lrintf (empate para o par); packs satura em [-32768, 32767].
+        const __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        const __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+    }
+    float_to_s16_scalar(in + i, out + i, samples - i);
+}
+
+#endif // __SSE2__
+
+
+// --- Kernel NEON (ARMv7 com NEON / AArch64) ---
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+// Um estágio biquad sobre 4 canais consecutivos (registradores Q).
+template <bool RAMP>
+static void biquad_neon4(const biquad_coeffs_t* c, const biquad_coeffs_t* d, float* z1p, float* z2p,
+                         float* pcm, size_t frames, int stride) {
+    float32x4_t b0 = vdupq_n_f32(c->b0), b1 = vdupq_n_f32(c->b1), b2 = vdupq_n_f32(c->b2);
+    float32x4_t na1 = vdupq_n_f32(-c->a1), na2 = vdupq_n_f32(-c->a2);
+    float32x4_t db0, db1, db2, dna1, dna2;
+    if (RAMP) {
+        db0 = vdupq_n_f32(d->b0); db1 = vdupq_n_f32(d->b1); db2 = vdupq_n_f32(d->b2);
+        dna1 = vdupq_n_f32(-d->a1); dna2 = vdupq_n_f32(-d->a2);
+    }
+    float32x4_t z1 = vld1q_f32(z1p), z2 = vld1q_f32(z2p);
+    for (size_t i = 0; i < frames; i++) {
+        float* p = pcm + i * stride;
+        const float32x4_t x = vld1q_f32(p);
+        const float32x4_t y = vmlaq_f32(z1, b0, x);
+        z1 = vmlaq_f32(vmlaq_f32(z2, b1, x), na1, y);
+        z2 = vmlaq_f32(vmulq_f32(b2, x), na2, y);
+        vst1q_f32(p, y);
+        if (RAMP) {
+            b0 = vaddq_f32(b0, db0); b1 = vaddq_f32(b1, db1); b2 = vaddq_f32(b2, db2);
+            na1 = vaddq_f32(na1, dna1); na2 = vaddq_f32(na2, dna2);
+        }
+    }
+    vst1q_f32(z1p, z1);
+    vst1q_f32(z2p, z2);
+}
+
+// Um estágio biquad sobre 2 canais consecutivos (registradores D) - o caso estéreo.
+template <bool RAMP>
+static void biquad_neon2(const biquad_coeffs_t* c, const biquad_coeffs_t* d, float* z1p, float* z2p,
+                         float* pcm, size_t frames, int stride) {
+    float32x2_t b0 = vdup_n_f32(c->b0), b1 = vdup_n_f32(c->b1), b2 = vdup_n_f32(c->b2);
+    float32x2_t na1 = vdup_n_f32(-c->a1), na2 = vdup_n_f32(-c->a2);
+    float32x2_t db0, db1, db2, dna1, dna2;
+    if (RAMP) {
+        db0 = vdup_n_f32(d->b0); db1 = vdup_n_f32(d->b1); db2 = vdup_n_f32(d->b2);
+        dna1 = vdup_n_f32(-d->a1); dna2 = vdup_n_f32(-d->a2);
+    }
+    float32x2_t z1 = vld1_f32(z1p), z2 = vld1_f32(z2p);
+    for (size_t i = 0; i < frames; i++) {
+        float* p = pcm + i * stride;
+        const float32x2_t x = vld1_f32(p);
+        const float32x2_t y = vmla_f32(z1, b0, x);
+        z1 = vmla_f32(vmla_f32(z2, b1, x), na1, y);
+        z2 = vmla_f32(vmul_f32(b2, x), na2, y);
+        vst1_f32(p, y);
+        if (RAMP) {
+            b0 = vadd_f32(b0, db0); b1 = vadd_f32(b1, db1); b2 = vadd_f32(b2, db2);
+            na1 = vadd_f32(na1, dna1); na2 = vadd_f32(na2, dna2);
+        }
+    }
+    vst1_f32(z1p, z1);
+    vst1_f32(z2p, z2);
+}
+
+template <bool RAMP>
+static void eq_process_neon(eq_state_t* eq, float* pcm, size_t frames) {
+    const int ch = eq->channels;
+    for (int s = 0; s < eq->bands; s++) {
+        const biquad_coeffs_t* c = &eq->coeffs[s];
+        const biquad_coeffs_t* d = &eq->delta[s];
+        int g = 0;
+        for (; g + 4 <= ch; g += 4) biquad_neon4<RAMP>(c, d, &eq->z1[s][g], &eq->z2[s][g], pcm + g, frames, ch);
+        for (; g + 2 <= ch; g += 2) biquad_neon2<RAMP>(c, d, &eq->z1[s][g], &eq->z2[s][g], pcm + g, frames, ch);
+        for (; g < ch; g++)         biquad_scalar<RAMP>(c, d, &eq->z1[s][g], &eq->z2[s][g], pcm + g, frames, ch);
+    }
+}
+
+static void s16_to_float_neon(const int16_t* in, float* out, size_t samples) {
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const int16x8_t v = vld1q_s16(in + i);
+        // Conversão em ponto fixo Q15 -> float (divide por 2^15 na própria instrução).
+        vst1q_f32(out + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v)), 15));
+        vst1q_f32(out + i + 4, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v)), 15));
+    }
+    s16_to_float_scalar(in + i, out + i, samples - i);
+}
+
+static void float_to_s16_neon(const float* in, int16_t* out, size_t samples) {
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        // vcvt satura em 32 bits e vqmovn satura para 16 bits.
+        const int32x4_t lo = neon_round_s32(vmulq_f32(vld1q_f32(in + i), scale));
+        const int32x4_t hi = neon_round_s32(vmulq_f32(vld1q_f32(in + i + 4), scale));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    float_to_s16_scalar(in + i, out + i, samples - i);
+}
+
+#endif // __ARM_NEON
+
+
+// --- Seleção do Kernel em Tempo de Execução ---
+
+typedef struct {
+    eq_kernel_t id;
+    const char* name;
+    void (*process)(eq_state_t* eq, float* pcm, size_t frames);       // Coeficientes fixos
+    void (*process_ramp)(eq_state_t* eq, float* pcm, size_t frames);  // Coeficientes em rampa
+    void (*s16_to_float)(const int16_t* in, float* out, size_t samples);
+    void (*float_to_s16)(const float* in, int16_t* out, size_t samples);
+} eq_kernel_ops_t;
+
+static const eq_kernel_ops_t kScalarOps = {
+        EQ_KERNEL_SCALAR, "scalar", eq_process_scalar<false>, eq_process_scalar<true>, s16_to_float_scalar, float_to_s16_scalar };
+#if defined(__SSE2__)
+static const eq_kernel_ops_t kSseOps = {
+        EQ_KERNEL_SSE, "sse", eq_process_sse<false>, eq_process_sse<true>, s16_to_float_sse, float_to_s16_sse };
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+static const eq_kernel_ops_t kNeonOps = {
+        EQ_KERNEL_NEON, "neon", eq_process_neon<false>, eq_process_neon<true>, s16_to_float_neon, float_to_s16_neon };
+#endif
+
+static std::atomic<const eq_kernel_ops_t*> g_kernel(&kScalarOps);
+static pthread_once_t g_kernel_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Retorna a tabela de operações de um kernel, ou NULL se ele não for
+ * suportado pela CPU atual (compilado e presente em tempo de execução).
+ */
+static const eq_kernel_ops_t* kernel_ops_for(eq_kernel_t kernel) {
+    switch (kernel) {
+        case EQ_KERNEL_SCALAR:
+            return &kScalarOps;
+        case EQ_KERNEL_SSE:
+#if defined(__SSE2__)
+            if (__builtin_cpu_supports("sse2")) return &kSseOps;
+#endif
+            return NULL;
+        case EQ_KERNEL_NEON:
+#if defined(__aarch64__)
+            return &kNeonOps; // NEON (ASIMD) é obrigatório em AArch64
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+            if (getauxval(AT_HWCAP) & HWCAP_NEON) return &kNeonOps;
+#endif
+            return NULL;
+        case EQ_KERNEL_AUTO:
+        default: {
+            const eq_kernel_ops_t* ops = kernel_ops_for(EQ_KERNEL_NEON);
+            if (!ops) ops = kernel_ops_for(EQ_KERNEL_SSE);
+            return ops ? ops : &kScalarOps;
+        }
+    }
+}
+
+static void detect_kernel_once(void) {
+    g_kernel.store(kernel_ops_for(EQ_KERNEL_AUTO), std::memory_order_release);
+}
+
+static inline const eq_kernel_ops_t* active_kernel(void) {
+    pthread_once(&g_kernel_once, detect_kernel_once);
+    return g_kernel.load(std::memory_order_acquire);
+}
+
+int eq_select_kernel(eq_kernel_t kernel) {
+    pthread_once(&g_kernel_once, detect_kernel_once);
+    const eq_kernel_ops_t* ops = kernel_ops_for(kernel);
+    if (!ops) return -ENOTSUP;
+    g_kernel.store(ops, std::memory_order_release);
+    return 0;
+}
+
+const char* eq_kernel_name(void) {
+    return active_kernel()->name;
+}
+
+eq_kernel_t eq_active_kernel(void) {
+    return active_kernel()->id;
+}
+
+
+// --- API Pública ---
+
+int eq_init(eq_state_t* eq, float sample_rate, int channels) {
+    if (!eq || sample_rate <= 0.0f || channels < 1 || channels > EQ_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+    memset(eq, 0, sizeof(*eq));
+    eq->sample_rate = sample_rate;
+    eq->channels = channels;
+    eq->bands = AUDIO_EQ_NUM_BANDS;
+    for (int b = 0; b < AUDIO_EQ_NUM_BANDS; b++) {
+        eq_set_band_level(eq, b, EQ_LEVEL_FLAT);
+    }
+    return 0;
+}
+
+int eq_design_band(int band, int level, float sample_rate, biquad_coeffs_t* out) {
+    if (band < 0 || band >= AUDIO_EQ_NUM_BANDS) return -EINVAL;
+    return eq_design(&eq_default_layout[band], level, sample_rate, out);
+}
+
+int eq_design(const audio_eq_band_t* band, int level, float sample_rate, biquad_coeffs_t* out) {
+    if (eq_validate_layout(band, 1, sample_rate) != 0) return -EINVAL;
+    if (level < EQ_LEVEL_MIN) level = EQ_LEVEL_MIN;
+    if (level > EQ_LEVEL_MAX) level = EQ_LEVEL_MAX;
+    *out = design_band(band, level_to_db(level), sample_rate);
+    return 0;
+}
+
+int eq_validate_layout(const audio_eq_band_t* layout, int bands, float sample_rate) {
+    if (!layout || bands < 1 || bands > AUDIO_EQ_MAX_BANDS || !(sample_rate > 0.0f)) return -EINVAL;
+    for (int b = 0; b < bands; b++) {
+        const audio_eq_band_t* band = &layout[b];
+        // As comparações negadas também recusam NaN.
+        if ((band->shape != AUDIO_EQ_SHAPE_LOW_SHELF && band->shape != AUDIO_EQ_SHAPE_PEAKING &&
+             band->shape != AUDIO_EQ_SHAPE_HIGH_SHELF) ||
+            !(band->freq_hz >= 10.0f && band->freq_hz <= 20000.0f) ||
+            !(band->q >= 0.1f && band->q <= 20.0f)) {
+            return -EINVAL;
+        }
+    }
+    return 0;
+}
+
+int eq_table_build(eq_coeff_table_t* table, const audio_eq_band_t* layout, int bands, float sample_rate) {
+    if (!table || eq_validate_layout(layout, bands, sample_rate) != 0) return -EINVAL;
+    table->sample_rate = sample_rate;
+    table->bands = bands;
+    for (int b = 0; b < bands; b++) {
+        table->layout[b] = layout[b];
+        for (int level = EQ_LEVEL_MIN; level <= EQ_LEVEL_MAX; level++) {
+            table->coeffs[b][level - EQ_LEVEL_MIN] = design_band(&layout[b], level_to_db(level), sample_rate);
+        }
+    }
+    return 0;
+}
+
+int eq_preset_levels(int preset, const audio_eq_band_t* layout, int bands, int* levels) {
+    if (preset < 0 || preset >= AUDIO_EQ_PRESET_COUNT || !layout || !levels) return -EINVAL;
+    const float* curve = kPresetCurves[preset];
+    for (int b = 0; b < bands; b++) {
+        // Posição da banda em oitavas a partir da primeira âncora, limitada às pontas.
+        double x = log2((double)layout[b].freq_hz / kPresetAnchorHz);
+        if (x < 0.0) x = 0.0;
+        if (x > EQ_PRESET_ANCHORS - 1) x = EQ_PRESET_ANCHORS - 1;
+        const int k = x >= EQ_PRESET_ANCHORS - 1 ? EQ_PRESET_ANCHORS - 2 : (int)x;
+        const double db = curve[k] + (curve[k + 1] - curve[k]) * (x - k);
+        const int level = EQ_LEVEL_FLAT + (int)lround(db / EQ_MAX_GAIN_DB * (EQ_LEVEL_MAX - EQ_LEVEL_FLAT));
+        levels[b] = level < EQ_LEVEL_MIN ? EQ_LEVEL_MIN : (level > EQ_LEVEL_MAX ? EQ_LEVEL_MAX : level);
+    }
+    return 0;
+}
+
+void eq_ramp_to(eq_state_t* eq, const biquad_coeffs_t* target, size_t ramp_frames) {
+    if (ramp_frames == 0) {
+        memcpy(eq->coeffs, target, (size_t)eq->bands * sizeof(biquad_coeffs_t));
+        eq->ramp_remaining = 0;
+        return;
+    }
+    const float inv = 1.0f / (float)ramp_frames;
+    for (int b = 0; b < eq->bands; b++) {
+        const biquad_coeffs_t* c = &eq->coeffs[b];
+        const biquad_coeffs_t* t = &target[b];
+        eq->target[b] = *t;
+        eq->delta[b].b0 = (t->b0 - c->b0) * inv;
+        eq->delta[b].b1 = (t->b1 - c->b1) * inv;
+        eq->delta[b].b2 = (t->b2 - c->b2) * inv;
+        eq->delta[b].a1 = (t->a1 - c->a1) * inv;
+        eq->delta[b].a2 = (t->a2 - c->a2) * inv;
+    }
+    eq->ramp_remaining = ramp_frames;
+}
+
+int eq_set_bands(eq_state_t* eq, const biquad_coeffs_t* coeffs, int bands) {
+    if (bands < 1 || bands > AUDIO_EQ_MAX_BANDS) return -EINVAL;
+    eq->bands = bands;
+    eq_reset(eq);
+    eq_ramp_to(eq, coeffs, 0);
+    return 0;
+}
+
+int eq_set_band_level(eq_state_t* eq, int band, int level) {
+    int ret = eq_design_band(band, level, eq->sample_rate, &eq->coeffs[band]);
+    if (ret != 0) return ret;
+    eq->levels[band] = level < EQ_LEVEL_MIN ? EQ_LEVEL_MIN : (level > EQ_LEVEL_MAX ? EQ_LEVEL_MAX : level);
+    return 0;
+}
+
+void eq_reset(eq_state_t* eq) {
+    memset(eq->z1, 0, sizeof(eq->z1));
+    memset(eq->z2, 0, sizeof(eq->z2));
+}
+
+void eq_process(eq_state_t* eq, float* pcm, size_t frames) {
+    const eq_kernel_ops_t* ops = active_kernel();
+    size_t done = 0;
+
+    if (eq->ramp_remaining > 0) {
+        done = frames < eq->ramp_remaining ? frames : eq->ramp_remaining;
+        ops->process_ramp(eq, pcm, done);
+        eq->ramp_remaining -= done;
+        if (eq->ramp_remaining == 0) {
+            // Fim da rampa: fixa o alvo exato (sem o erro acumulado das somas).
+            memcpy(eq->coeffs, eq->target, (size_t)eq->bands * sizeof(biquad_coeffs_t));
+        } else {
+            // Avança os coeficientes até o ponto em que o kernel parou.
+            const float n = (float)done;
+            for (int b = 0; b < eq->bands; b++) {
+                eq->coeffs[b].b0 += eq->delta[b].b0 * n;
+                eq->coeffs[b].b1 += eq->delta[b].b1 * n;
+                eq->coeffs[b].b2 += eq->delta[b].b2 * n;
+                eq->coeffs[b].a1 += eq->delta[b].a1 * n;
+                eq->coeffs[b].a2 += eq->delta[b].a2 * n;
+            }
+        }
+    }
+    if (done < frames) {
+        ops->process(eq, pcm + done * eq->channels, frames - done);
+    }
+
+    // Descarta a cauda denormal do estado (ver kDenormalThreshold).
+    for (int s = 0; s < eq->bands; s++) {
+        for (int c = 0; c < eq->channels; c++) {
+            if (fabsf(eq->z1[s][c]) < kDenormalThreshold) eq->z1[s][c] = 0.0f;
+            if (fabsf(eq->z2[s][c]) < kDenormalThreshold) eq->z2[s][c] = 0.0f;
+        }
+    }
+}
+
+void eq_crossfade(float* wet, const float* dry, size_t frames, int channels, float gain, float gain_step) {
+    for (size_t i = 0; i < frames; i++) {
+        const float g = gain + (float)i * gain_step;
+        for (int c = 0; c < channels; c++) {
+            const size_t k = i * channels + c;
+            wet[k] = dry[k] + g * (wet[k] - dry[k]);
+        }
+    }
+}
+
+void eq_s16_to_float(const int16_t* in, float* out, size_t samples) {
+    active_kernel()->s16_to_float(in, out, samples);
+}
+
+void eq_float_to_s16(const float* in, int16_t* out, size_t samples) {
+    active_kernel()->float_to_s16(in, out, samples);
+}
@@ -0,0 +1,105 @@
+// --- Snapshot de Parâmetros do Equalizador (estilo RCU) ---
+// Os parâmetros completos do equalizador (liga/desliga, níveis e coeficientes já
+// calculados) são publicados como um snapshot imutável. As threads de controle
+// (UI, Binder, CAN) montam o snapshot novo fora da thread de áudio e o publicam
+// com uma única troca atômica; a thread de áudio pega o mais recente na
+// fronteira de período, também com uma única troca atômica. Nenhum lado espera
+// pelo outro e a thread de áudio nunca toma um mutex.
+//
+// Como o leitor pode continuar usando um snapshot enquanto o escritor prepara o
+// próximo, dois buffers não bastam sem uma espera de "grace period"; por isso
+// são usados três slots (buffer triplo): um do escritor, um do leitor e um
+// "pronto" trocado entre eles. Rajadas de atualizações (ex: mensagens CAN)
+// simplesmente sobrescrevem o slot pronto: a thread de áudio só vê a última.
+#ifndef MYAUDIOHALPROJECT_EQ_PARAMS_H
+#define MYAUDIOHALPROJECT_EQ_PARAMS_H
+
+#include <stdint.h>
+#include <string.h>     // Para memcpy
+#include <pthread.h>    // Para o mutex que serializa os escritores (nunca usado pela thread de áudio)
+#include <atomic>
+
+#include "eq_dsp.h"
+
+// Snapshot imutável dos parâmetros do equalizador.
+typedef struct {
+    bool enabled;                                  // Processamento ligado
+    int bands;                                     // Bandas do layout (estágios da cascata)
+    int levels[AUDIO_EQ_MAX_BANDS];                // Níveis 0..100 (para consulta)
+    biquad_coeffs_t coeffs[AUDIO_EQ_MAX_BANDS];    // Coeficientes prontos para o kernel
+} eq_params_t;
+
+#define EQ_PARAMS_SLOT_MASK 0x3u  // Índice do slot (0..2)
+#define EQ_PARAMS_FRESH 0x4u      // Marca: o slot pronto ainda não foi consumido
+
+typedef struct {
+    eq_params_t slots[3];
+    std::atomic<uint32_t> ready;   // Slot pronto | EQ_PARAMS_FRESH
+    uint32_t back;                 // Slot do escritor (protegido por writer_lock)
+    uint32_t front;                // Slot do leitor (só a thread de áudio acessa)
+
+    // Lado dos escritores: vários podem existir (UI e Binder), então são
+    // serializados entre si. A thread de áudio nunca toma este mutex.
+    pthread_mutex_t writer_lock;
+    eq_params_t pending;           // Estado desejado mais recente (base para edições parciais)
+} eq_param_store_t;
+
+/**
+ * Inicializa o armazenamento com um snapshot inicial, já visível para o leitor.
+ */
+static inline void eq_params_init(eq_param_store_t* store, const eq_params_t* initial) {
+    for (int i = 0; i < 3; i++) store->slots[i] = *initial;
+    store->pending = *initial;
+    store->front = 0;
+    store->ready.store(1, std::memory_order_relaxed);
+    store->back = 2;
+    pthread_mutex_init(&store->writer_lock, NULL);
+}
+
+static inline void eq_params_destroy(eq_param_store_t* store) {
+    pthread_mutex_destroy(&store->writer_lock);
+}
+
+/**
+ * Começa uma edição: trava os escritores e devolve a cópia editável do estado desejado.
+ * Deve ser seguida de eq_params_end_write.
+ */
+static inline eq_params_t* eq_params_begin_write(eq_param_store_t* store) {
+    pthread_mutex_lock(&store->writer_lock);
+    return &store->pending;
+}
+
+/**
+ * Publica o estado editado como um novo snapshot e libera os escritores.
+ */
+static inline void eq_params_end_write(eq_param_store_t* store) {
+    memcpy(&store->slots[store->back], &store->pending, sizeof(eq_params_t));
+    // Troca o slot recém-escrito pelo slot pronto; o antigo pronto vira o próximo 'back'.
+    const uint32_t prev = store->ready.exchange(store->back | EQ_PARAMS_FRESH, std::memory_order_acq_rel);
+    store->back = prev & EQ_PARAMS_SLOT_MASK;
+    pthread_mutex_unlock(&store->writer_lock);
+}
+
+/**
+ * Abandona uma edição sem publicar (ex: argumento inválido descoberto com o
+ * lock tomado). O estado desejado não pode ter sido alterado.
+ */
+static inline void eq_params_cancel_write(eq_param_store_t* store) {
+    pthread_mutex_unlock(&store->writer_lock);
+}
+
+/**
+ * Lado do leitor (thread de áudio): retorna o snapshot publicado desde a última
+ * chamada, ou NULL se nada mudou. O ponteiro vale até a próxima chamada.
+ * Wait-free: um load e, havendo novidade, uma troca atômica.
+ */
+static inline const eq_params_t* eq_params_consume(eq_param_store_t* store) {
+    if (!(store->ready.load(std::memory_order_relaxed) & EQ_PARAMS_FRESH)) {
+        return NULL;
+    }
+    const uint32_t prev = store->ready.exchange(store->front, std::memory_order_acq_rel);
+    store->front = prev & EQ_PARAMS_SLOT_MASK;
+    return &store->slots[store->front];
+}
+
+#endif // MYAUDIOHALPROJECT_EQ_PARAMS_H
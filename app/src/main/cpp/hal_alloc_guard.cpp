@@ -0,0 +1,114 @@
+// --- Includes Padrão ---
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>     // Para write (a mensagem de erro não pode alocar)
+#include <new>
+
+#include "hal_alloc_guard.h"
+
+#if defined(HAL_ALLOC_GUARD) && HAL_ALLOC_GUARD
+
+thread_local int hal_no_alloc_depth __attribute__((tls_model("initial-exec"))) = 0;
+
+/**
+ * Aborta se a thread atual estiver em um trecho sem alocação.
+ * @param what Nome da função de alocação chamada.
+ */
+static void hal_alloc_check(const char* what) {
+    if (hal_no_alloc_depth > 0) {
+        hal_no_alloc_depth = 0; // O abort pode passar pelo alocador
+        static const char prefix[] = "AudioHAL: alocação no caminho de áudio: ";
+        ssize_t ignored = write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+        ignored = write(STDERR_FILENO, what, strlen(what));
+        ignored = write(STDERR_FILENO, "\n", 1);
+        (void)ignored;
+        abort();
+    }
+}
+
+
+// --- Interceptação do malloc (glibc) ---
+// A glibc exporta as implementações reais como __libc_*; em outras libcs
+// (bionic) só os operadores do C++ são verificados.
+#if defined(__GLIBC__)
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    hal_alloc_check("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    hal_alloc_check("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    hal_alloc_check("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    if (ptr) hal_alloc_check("free");
+    __libc_free(ptr);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    hal_alloc_check("posix_memalign");
+    void* p = __libc_memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    hal_alloc_check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+} // extern "C"
+
+#endif // __GLIBC__
+
+
+// --- Operadores Globais do C++ ---
+
+void* operator new(size_t size) {
+    hal_alloc_check("operator new");
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    hal_alloc_check("operator new[]");
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) hal_alloc_check("operator delete");
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    if (ptr) hal_alloc_check("operator delete[]");
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete[](ptr);
+}
+
+#endif // HAL_ALLOC_GUARD
@@ -0,0 +1,31 @@
+// --- Guarda do Alocador no Caminho de Áudio (depuração) ---
+// Com HAL_ALLOC_GUARD=1 (padrão nas builds Debug, ver CMakeLists.txt), os
+// trechos marcados com HAL_NO_ALLOC_SCOPE() — 'write'/'commit' dos streams e
+// cada período renderizado — abortam o processo se a thread chamar o alocador
+// do sistema: malloc/calloc/realloc/free/posix_memalign (interceptados na glibc)
+// e os operadores new/delete globais (em todas as plataformas). A mensagem diz
+// qual função foi chamada; o core dump mostra de onde.
+// Sem a flag, a macro não gera código.
+#ifndef MYAUDIOHALPROJECT_HAL_ALLOC_GUARD_H
+#define MYAUDIOHALPROJECT_HAL_ALLOC_GUARD_H
+
+#if defined(HAL_ALLOC_GUARD) && HAL_ALLOC_GUARD
+
+// Profundidade de trechos sem alocação da thread atual. TLS estática
+// (initial-exec): acessá-la de dentro do malloc não pode alocar.
+extern thread_local int hal_no_alloc_depth __attribute__((tls_model("initial-exec")));
+
+struct hal_no_alloc_scope {
+    hal_no_alloc_scope() { hal_no_alloc_depth++; }
+    ~hal_no_alloc_scope() { hal_no_alloc_depth--; }
+};
+
+#define HAL_NO_ALLOC_SCOPE() hal_no_alloc_scope hal_no_alloc_scope_
+
+#else
+
+#define HAL_NO_ALLOC_SCOPE() ((void)0)
+
+#endif // HAL_ALLOC_GUARD
+
+#endif // MYAUDIOHALPROJECT_HAL_ALLOC_GUARD_H
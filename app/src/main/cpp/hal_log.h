@@ -0,0 +1,64 @@
+// --- Nível de Log em Tempo de Compilação e Log com Limite de Taxa ---
+// As macros ALOG* de cada arquivo passam por HAL_LOG, que descarta em tempo de
+// compilação as mensagens abaixo de HAL_LOG_LEVEL: em builds de release (NDEBUG)
+// o padrão é INFO, então ALOGD não gera nem a chamada nem a formatação.
+// Para eventos que podem se repetir a cada período (underruns, overruns, erros
+// no caminho de áudio), HAL_LOG_RATELIMITED imprime no máximo uma mensagem por
+// intervalo por ponto de chamada; as contagens exatas ficam nas métricas da HAL.
+#ifndef MYAUDIOHALPROJECT_HAL_LOG_H
+#define MYAUDIOHALPROJECT_HAL_LOG_H
+
+#include <stdint.h>
+#include <time.h>       // Para clock_gettime
+#include <android/log.h>
+#include <atomic>
+
+// Prioridade mínima compilada (valores de android_LogPriority: 3 = DEBUG, 4 = INFO,
+// 6 = ERROR). Pode ser definida pela build, ex: -DHAL_LOG_LEVEL=3.
+#ifndef HAL_LOG_LEVEL
+#ifdef NDEBUG
+#define HAL_LOG_LEVEL 4 // Release: INFO e acima
+#else
+#define HAL_LOG_LEVEL 3 // Debug: DEBUG e acima
+#endif
+#endif
+
+// Constante em tempo de compilação: o compilador remove o ramo inteiro quando falsa.
+#define HAL_LOG_ENABLED(prio) ((prio) >= HAL_LOG_LEVEL)
+
+#define HAL_LOG(prio, tag, ...) \
+    do { \
+        if (HAL_LOG_ENABLED(prio)) { \
+            __android_log_print(prio, tag, __VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * Decide se um ponto de log com limite de taxa pode imprimir agora.
+ * Lock-free: no máximo uma thread vence o compare-exchange por intervalo.
+ * @param last_ms Instante (CLOCK_MONOTONIC, ms) da última impressão deste ponto.
+ * @param interval_ms Intervalo mínimo entre impressões.
+ */
+static inline bool hal_log_ratelimit_allow(std::atomic<int64_t>* last_ms, int64_t interval_ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const int64_t now = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    int64_t last = last_ms->load(std::memory_order_relaxed);
+    if (now - last < interval_ms) {
+        return false;
+    }
+    return last_ms->compare_exchange_strong(last, now, std::memory_order_relaxed);
+}
+
+// Cada expansão tem seu próprio estado estático, ou seja, o limite é por ponto de chamada.
+#define HAL_LOG_RATELIMITED(prio, tag, interval_ms, ...) \
+    do { \
+        if (HAL_LOG_ENABLED(prio)) { \
+            static std::atomic<int64_t> hal_log_last_ms_(INT64_MIN / 2); \
+            if (hal_log_ratelimit_allow(&hal_log_last_ms_, (interval_ms))) { \
+                __android_log_print(prio, tag, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#endif // MYAUDIOHALPROJECT_HAL_LOG_H
@@ -0,0 +1,107 @@
+// --- Métricas do Caminho de Áudio (lock-free) ---
+// Contadores e histogramas de latência atualizados no caminho quente (write e
+// renderização) sem locks e sem formatar texto. Os campos do lado consumidor têm
+// um único escritor (a thread de renderização), então a atualização é um
+// load + store relaxados, sem instrução atômica de leitura-modificação-escrita.
+// Os do lado produtor são compartilhados pelos produtores de todos os streams
+// e usam fetch_add relaxado (variantes *_shared).
+// Qualquer thread pode tirar um snapshot (audio_metrics_t) a qualquer momento;
+// os campos são lidos individualmente, o que basta para diagnóstico.
+#ifndef MYAUDIOHALPROJECT_HAL_METRICS_H
+#define MYAUDIOHALPROJECT_HAL_METRICS_H
+
+#include <stdint.h>
+#include <time.h>       // Para clock_gettime
+#include <atomic>
+
+#include "audio_hal.h"  // Para audio_metrics_t e AUDIO_METRICS_LATENCY_BUCKETS
+
+// Histograma de latência com baldes fixos em potências de dois (ver audio_metrics_t).
+typedef struct {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint64_t> buckets[AUDIO_METRICS_LATENCY_BUCKETS];
+} hal_latency_histogram_t;
+
+typedef struct {
+    // Lado produtor ('write' de qualquer stream; vários escritores).
+    std::atomic<uint64_t> bytes_written;
+    std::atomic<uint64_t> frames_written;
+    std::atomic<uint64_t> overruns;
+    hal_latency_histogram_t write_latency;
+    // Lado consumidor (renderização; escritor único).
+    std::atomic<uint64_t> frames_rendered;
+    std::atomic<uint64_t> periods_rendered;
+    std::atomic<uint64_t> underruns;
+    hal_latency_histogram_t process_latency;
+} hal_metrics_t;
+
+static inline uint64_t hal_metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Incremento por um único escritor: evita o custo de um fetch_add (lock add).
+static inline void hal_counter_add(std::atomic<uint64_t>* counter, uint64_t value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Incremento com vários escritores (produtores de streams diferentes).
+static inline void hal_counter_add_shared(std::atomic<uint64_t>* counter, uint64_t value) {
+    counter->fetch_add(value, std::memory_order_relaxed);
+}
+
+/**
+ * Índice do balde de uma latência: 0 para menos de 1024 ns, depois um balde por
+ * potência de dois, e o último acumula tudo acima do penúltimo limite.
+ */
+static inline int hal_latency_bucket(uint64_t ns) {
+    if (ns < (1ull << AUDIO_METRICS_LATENCY_BUCKET0_SHIFT)) {
+        return 0;
+    }
+    const int log2 = 63 - __builtin_clzll(ns);
+    const int bucket = log2 - AUDIO_METRICS_LATENCY_BUCKET0_SHIFT + 1;
+    return bucket < AUDIO_METRICS_LATENCY_BUCKETS ? bucket : AUDIO_METRICS_LATENCY_BUCKETS - 1;
+}
+
+static inline void hal_latency_record(hal_latency_histogram_t* h, uint64_t ns) {
+    hal_counter_add(&h->count, 1);
+    hal_counter_add(&h->sum_ns, ns);
+    hal_counter_add(&h->buckets[hal_latency_bucket(ns)], 1);
+    if (ns > h->max_ns.load(std::memory_order_relaxed)) {
+        h->max_ns.store(ns, std::memory_order_relaxed);
+    }
+}
+
+static inline void hal_latency_record_shared(hal_latency_histogram_t* h, uint64_t ns) {
+    hal_counter_add_shared(&h->count, 1);
+    hal_counter_add_shared(&h->sum_ns, ns);
+    hal_counter_add_shared(&h->buckets[hal_latency_bucket(ns)], 1);
+    uint64_t max = h->max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !h->max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+static inline void hal_latency_snapshot(const hal_latency_histogram_t* h, audio_latency_histogram_t* out) {
+    out->count = h->count.load(std::memory_order_relaxed);
+    out->sum_ns = h->sum_ns.load(std::memory_order_relaxed);
+    out->max_ns = h->max_ns.load(std::memory_order_relaxed);
+    for (int i = 0; i < AUDIO_METRICS_LATENCY_BUCKETS; i++) {
+        out->buckets[i] = h->buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+static inline void hal_metrics_snapshot(const hal_metrics_t* m, audio_metrics_t* out) {
+    out->bytes_written = m->bytes_written.load(std::memory_order_relaxed);
+    out->frames_written = m->frames_written.load(std::memory_order_relaxed);
+    out->overruns = m->overruns.load(std::memory_order_relaxed);
+    out->frames_rendered = m->frames_rendered.load(std::memory_order_relaxed);
+    out->periods_rendered = m->periods_rendered.load(std::memory_order_relaxed);
+    out->underruns = m->underruns.load(std::memory_order_relaxed);
+    hal_latency_snapshot(&m->write_latency, &out->write_latency);
+    hal_latency_snapshot(&m->process_latency, &out->process_latency);
+}
+
+#endif // MYAUDIOHALPROJECT_HAL_METRICS_H
@@ -0,0 +1,64 @@
+// --- Includes Padrão ---
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+
+#include "hal_pool.h"
+
+
+// --- Pool de Blocos Fixos ---
+
+void* hal_pool_alloc(hal_pool_t* pool) {
+    const uint32_t all = pool->blocks == 32 ? 0xFFFFFFFFu : (1u << pool->blocks) - 1;
+    uint32_t used = pool->used.load(std::memory_order_relaxed);
+    for (;;) {
+        const uint32_t free_mask = ~used & all;
+        if (free_mask == 0) {
+            return NULL;
+        }
+        const uint32_t bit = free_mask & (0u - free_mask); // Menor bloco livre
+        if (pool->used.compare_exchange_weak(used, used | bit, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+            return pool->storage + (size_t)__builtin_ctz(bit) * pool->block_bytes;
+        }
+    }
+}
+
+int hal_pool_free(hal_pool_t* pool, void* block) {
+    const uint8_t* p = (const uint8_t*)block;
+    if (p < pool->storage || p >= pool->storage + (size_t)pool->blocks * pool->block_bytes ||
+        (size_t)(p - pool->storage) % pool->block_bytes != 0) {
+        return -EINVAL;
+    }
+    const uint32_t bit = 1u << ((size_t)(p - pool->storage) / pool->block_bytes);
+    // release: as escritas feitas no bloco ficam visíveis para quem o reservar depois.
+    const uint32_t before = pool->used.fetch_and(~bit, std::memory_order_release);
+    return (before & bit) ? 0 : -EINVAL;
+}
+
+uint32_t hal_pool_in_use(const hal_pool_t* pool) {
+    return (uint32_t)__builtin_popcount(pool->used.load(std::memory_order_relaxed));
+}
+
+
+// --- Arena Sequencial ---
+
+void* hal_arena_alloc(hal_arena_t* arena, size_t bytes, size_t align) {
+    pthread_mutex_lock(&arena->lock);
+    const uintptr_t base = (uintptr_t)arena->storage;
+    const uintptr_t start = (base + arena->used + align - 1) & ~(uintptr_t)(align - 1);
+    void* p = NULL;
+    if (start - base <= arena->capacity && bytes <= arena->capacity - (start - base)) {
+        p = (void*)start;
+        arena->used = start - base + bytes;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    return p;
+}
+
+size_t hal_arena_used(hal_arena_t* arena) {
+    pthread_mutex_lock(&arena->lock);
+    const size_t used = arena->used;
+    pthread_mutex_unlock(&arena->lock);
+    return used;
+}
@@ -0,0 +1,78 @@
+// --- Pool e Arena Pré-Alocados do Módulo ---
+// Toda a memória da HAL vem de armazenamento estático do próprio módulo,
+// reservado quando a biblioteca é carregada; nada passa pelo alocador do sistema.
+// - hal_pool_t: blocos de tamanho fixo (ex: os dispositivos, com seus slots de
+//   stream, filas e buffers de período embutidos), alinhados à linha de cache.
+//   Alocar e liberar é um compare-exchange em um bitmap: sem lock e sem syscalls.
+// - hal_arena_t: alocação sequencial de tamanho variável para dados imutáveis
+//   compartilhados pelo módulo inteiro (ex: tabelas de filtro), nunca liberados
+//   individualmente. Protegida por mutex: só para caminhos de controle.
+// As páginas do armazenamento estático (BSS) só são tocadas na primeira
+// abertura, que zera o bloco inteiro fora do caminho de áudio.
+#ifndef MYAUDIOHALPROJECT_HAL_POOL_H
+#define MYAUDIOHALPROJECT_HAL_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <atomic>
+
+#include "spsc_ring_buffer.h" // Para HAL_CACHE_LINE_SIZE
+
+#define HAL_POOL_MAX_BLOCKS 32 // Um bit por bloco em 'used'
+
+typedef struct {
+    uint8_t* storage;
+    size_t block_bytes;           // Múltiplo de HAL_CACHE_LINE_SIZE
+    uint32_t blocks;
+    std::atomic<uint32_t> used;   // Bit i = bloco i em uso
+} hal_pool_t;
+
+typedef struct {
+    uint8_t* storage;
+    size_t capacity;
+    size_t used;                  // Protegido por 'lock'
+    pthread_mutex_t lock;
+} hal_arena_t;
+
+// Define um pool estático de 'blocks' objetos do tipo 'type' (no escopo do arquivo).
+#define HAL_POOL_DEFINE(name, type, count) \
+    static_assert(sizeof(type) % HAL_CACHE_LINE_SIZE == 0, "blocos alinhados à linha de cache"); \
+    static_assert((count) <= HAL_POOL_MAX_BLOCKS, "blocos demais para o bitmap"); \
+    alignas(HAL_CACHE_LINE_SIZE) static uint8_t name##_storage_[(count) * sizeof(type)]; \
+    static hal_pool_t name = { name##_storage_, sizeof(type), (count), {0u} }
+
+// Define uma arena estática de 'bytes' bytes (no escopo do arquivo).
+#define HAL_ARENA_DEFINE(name, bytes) \
+    alignas(HAL_CACHE_LINE_SIZE) static uint8_t name##_storage_[(bytes)]; \
+    static hal_arena_t name = { name##_storage_, (bytes), 0, PTHREAD_MUTEX_INITIALIZER }
+
+/**
+ * Reserva um bloco livre do pool. O conteúdo não é zerado.
+ * @return O bloco (alinhado à linha de cache), ou NULL se todos estiverem em uso.
+ */
+void* hal_pool_alloc(hal_pool_t* pool);
+
+/**
+ * Devolve um bloco obtido com hal_pool_alloc.
+ * @return 0 em caso de sucesso, ou -EINVAL se 'block' não for um bloco em uso do pool.
+ */
+int hal_pool_free(hal_pool_t* pool, void* block);
+
+/**
+ * Número de blocos em uso (diagnóstico).
+ */
+uint32_t hal_pool_in_use(const hal_pool_t* pool);
+
+/**
+ * Reserva 'bytes' bytes alinhados a 'align' (potência de dois) na arena.
+ * @return A memória (não zerada), ou NULL se a arena estiver esgotada.
+ */
+void* hal_arena_alloc(hal_arena_t* arena, size_t bytes, size_t align);
+
+/**
+ * Bytes já reservados na arena (diagnóstico).
+ */
+size_t hal_arena_used(hal_arena_t* arena);
+
+#endif // MYAUDIOHALPROJECT_HAL_POOL_H
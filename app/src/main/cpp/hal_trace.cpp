@@ -0,0 +1,291 @@
+// --- Includes Padrão ---
+#include <errno.h>       // Para -ENOSYS e os erros de fopen
+#include <stddef.h>      // Para ptrdiff_t
+#include <stdio.h>       // Para a escrita do JSON
+#include <string.h>      // Para strncpy
+#include <unistd.h>      // Para getpid e syscall
+#include <sys/syscall.h> // Para SYS_gettid
+#include <pthread.h>     // Para liberar o buffer quando a thread termina
+#include <vector>
+#include <android/log.h> // Para a função __android_log_print, usada para logs no Logcat Android
+
+#include "hal_trace.h"
+#include "hal_log.h"     // Nível de log em tempo de compilação
+#include "hal_metrics.h" // Para hal_metrics_now_ns (o mesmo relógio das métricas)
+
+
+// --- Macros ALOG (mesma solução de contorno de audio_hal.cpp) ---
+#ifndef ANDROID_LOG_INFO
+#define ANDROID_LOG_INFO 4  // Prioridade de informação (Info)
+#endif
+#ifndef ALOGI
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "AudioHAL", __VA_ARGS__)
+#endif
+
+
+#if defined(HAL_TRACE) && HAL_TRACE
+
+#if defined(__ANDROID__)
+#include <android/trace.h> // ATrace_beginSection / ATrace_endSection (API 23+)
+#endif
+
+#define HAL_TRACE_BUFFER_MASK (HAL_TRACE_BUFFER_EVENTS - 1)
+#define HAL_TRACE_MAX_DURATION_NS 0xFFFFFFFFu
+
+static_assert((HAL_TRACE_BUFFER_EVENTS & HAL_TRACE_BUFFER_MASK) == 0, "buffer do trace em potência de dois");
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+    uint32_t duration_ns;
+    int32_t arg;
+} hal_trace_event_t;
+
+// Estados de um buffer do pool.
+#define TRACE_BUFFER_FREE 0u
+#define TRACE_BUFFER_OWNED 1u             // Uma thread viva grava nele
+#define TRACE_BUFFER_RETIRED 2u           // A thread terminou: eventos mantidos até o reúso
+
+// Buffer de uma thread: só ela escreve; a exportação lê de qualquer thread.
+typedef struct {
+    hal_trace_event_t events[HAL_TRACE_BUFFER_EVENTS];
+    std::atomic<uint64_t> head;       // Eventos já publicados (índice do próximo)
+    std::atomic<uint64_t> cleared;    // Eventos anteriores a este índice foram descartados
+    std::atomic<uint64_t> name_seq;   // Ímpar enquanto o nome está sendo trocado
+    char name[16];
+    std::atomic<int> tid;
+    std::atomic<uint32_t> state;      // TRACE_BUFFER_*
+} hal_trace_buffer_t;
+
+std::atomic<uint32_t> hal_trace_mode(HAL_TRACE_MODE_RECORD);
+
+static hal_trace_buffer_t g_trace_buffers[HAL_TRACE_MAX_THREADS];
+static pthread_once_t g_trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_trace_key;
+static std::atomic<uint64_t> g_trace_lost(0); // Eventos de threads sem buffer
+
+// TLS estática (initial-exec), como a guarda do alocador: o primeiro acesso no
+// caminho de áudio não pode alocar. (hal_trace_buffer_t*)1 = pool esgotado.
+static thread_local hal_trace_buffer_t* t_trace_buffer __attribute__((tls_model("initial-exec"))) = NULL;
+
+// Destrutor da chave: a thread terminou. Os eventos ficam para a exportação
+// até que outra thread precise do buffer.
+static void retire_thread_buffer(void* arg) {
+    hal_trace_buffer_t* buffer = (hal_trace_buffer_t*)arg;
+    buffer->state.store(TRACE_BUFFER_RETIRED, std::memory_order_release);
+}
+
+static void create_trace_key(void) {
+    pthread_key_create(&g_trace_key, retire_thread_buffer);
+}
+
+/**
+ * Tenta tomar o buffer 'buffer' que está no estado 'from'.
+ */
+static bool claim_buffer(hal_trace_buffer_t* buffer, uint32_t from) {
+    uint32_t expected = from;
+    if (!buffer->state.compare_exchange_strong(expected, TRACE_BUFFER_OWNED, std::memory_order_acq_rel)) {
+        return false;
+    }
+    // Eventos e nome da dona anterior são descartados.
+    buffer->cleared.store(buffer->head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    const uint64_t seq = buffer->name_seq.load(std::memory_order_relaxed);
+    buffer->name_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    buffer->name[0] = '\0';
+    buffer->name_seq.store(seq + 2, std::memory_order_release);
+    buffer->tid.store((int)syscall(SYS_gettid), std::memory_order_release);
+    return true;
+}
+
+/**
+ * Buffer da thread atual, reservado no primeiro uso: um livre ou, se não houver,
+ * o de uma thread que já terminou (ex: as threads da renderização offline).
+ * Nada aqui aloca: a chave usa as vagas estáticas da libc.
+ * @return NULL se todos os HAL_TRACE_MAX_THREADS buffers forem de threads vivas.
+ */
+static hal_trace_buffer_t* thread_buffer(void) {
+    hal_trace_buffer_t* buffer = t_trace_buffer;
+    if (buffer == (hal_trace_buffer_t*)1) return NULL;
+    if (buffer) return buffer;
+    pthread_once(&g_trace_key_once, create_trace_key);
+    static const uint32_t claim_order[] = { TRACE_BUFFER_FREE, TRACE_BUFFER_RETIRED };
+    for (int pass = 0; !buffer && pass < 2; pass++) {
+        for (int i = 0; i < HAL_TRACE_MAX_THREADS; i++) {
+            if (claim_buffer(&g_trace_buffers[i], claim_order[pass])) {
+                buffer = &g_trace_buffers[i];
+                break;
+            }
+        }
+    }
+    if (!buffer) {
+        t_trace_buffer = (hal_trace_buffer_t*)1;
+        return NULL;
+    }
+    pthread_setspecific(g_trace_key, buffer);
+    t_trace_buffer = buffer;
+    return buffer;
+}
+
+uint64_t hal_trace_begin(const char* name, uint32_t mode) {
+#if defined(__ANDROID__)
+    if (mode & HAL_TRACE_MODE_ATRACE) ATrace_beginSection(name);
+#else
+    (void)name;
+    (void)mode;
+#endif
+    return hal_metrics_now_ns();
+}
+
+void hal_trace_end(const char* name, int32_t arg, uint64_t start_ns, uint32_t mode) {
+    const uint64_t end_ns = hal_metrics_now_ns();
+#if defined(__ANDROID__)
+    if (mode & HAL_TRACE_MODE_ATRACE) ATrace_endSection();
+#endif
+    if (!(mode & HAL_TRACE_MODE_RECORD)) return;
+    hal_trace_buffer_t* buffer = thread_buffer();
+    if (!buffer) {
+        g_trace_lost.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const uint64_t duration = end_ns - start_ns;
+    const uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    hal_trace_event_t* event = &buffer->events[index & HAL_TRACE_BUFFER_MASK];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->duration_ns = duration > HAL_TRACE_MAX_DURATION_NS ? HAL_TRACE_MAX_DURATION_NS : (uint32_t)duration;
+    event->arg = arg;
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+void hal_trace_set_enabled(bool enabled) {
+    if (enabled) hal_trace_mode.fetch_or(HAL_TRACE_MODE_RECORD, std::memory_order_relaxed);
+    else hal_trace_mode.fetch_and(~HAL_TRACE_MODE_RECORD, std::memory_order_relaxed);
+}
+
+void hal_trace_set_atrace(bool enabled) {
+#if defined(__ANDROID__)
+    if (enabled) hal_trace_mode.fetch_or(HAL_TRACE_MODE_ATRACE, std::memory_order_relaxed);
+    else hal_trace_mode.fetch_and(~HAL_TRACE_MODE_ATRACE, std::memory_order_relaxed);
+#else
+    (void)enabled;
+#endif
+}
+
+void hal_trace_clear(void) {
+    for (int i = 0; i < HAL_TRACE_MAX_THREADS; i++) {
+        hal_trace_buffer_t* buffer = &g_trace_buffers[i];
+        buffer->cleared.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+    g_trace_lost.store(0, std::memory_order_relaxed);
+}
+
+void hal_trace_set_thread_name(const char* name) {
+    hal_trace_buffer_t* buffer = thread_buffer();
+    if (!buffer || !name) return;
+    // Seqlock: a exportação relê o nome se ele mudou durante a cópia.
+    const uint64_t seq = buffer->name_seq.load(std::memory_order_relaxed);
+    buffer->name_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    strncpy(buffer->name, name, sizeof(buffer->name) - 1);
+    buffer->name[sizeof(buffer->name) - 1] = '\0';
+    buffer->name_seq.store(seq + 2, std::memory_order_release);
+}
+
+/**
+ * Copia o nome da thread dona de 'buffer' sem travar quem escreve.
+ */
+static void copy_thread_name(const hal_trace_buffer_t* buffer, char* out, size_t size) {
+    for (;;) {
+        const uint64_t seq = buffer->name_seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        memcpy(out, buffer->name, size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer->name_seq.load(std::memory_order_relaxed) == seq) break;
+    }
+    out[size - 1] = '\0';
+}
+
+/**
+ * Copia os eventos ainda válidos de 'buffer' para 'out'. A thread dona pode
+ * continuar gravando: o que ela sobrescreveu durante a cópia é descartado
+ * (a cópia é validada pelo índice lido depois dela, como em um seqlock).
+ */
+static void copy_events(const hal_trace_buffer_t* buffer, std::vector<hal_trace_event_t>* out) {
+    const uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t first = buffer->cleared.load(std::memory_order_relaxed);
+    if (head > HAL_TRACE_BUFFER_EVENTS && first < head - HAL_TRACE_BUFFER_EVENTS) {
+        first = head - HAL_TRACE_BUFFER_EVENTS;
+    }
+    const size_t base = out->size();
+    for (uint64_t i = first; i < head; i++) {
+        out->push_back(buffer->events[i & HAL_TRACE_BUFFER_MASK]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // O escritor pode estar no meio do evento 'after': ele ocupa a vaga de 'after - N'.
+    const uint64_t after = buffer->head.load(std::memory_order_relaxed);
+    const uint64_t valid_from = after >= HAL_TRACE_BUFFER_EVENTS ? after - HAL_TRACE_BUFFER_EVENTS + 1 : 0;
+    if (valid_from > first) {
+        const uint64_t stale = (valid_from < head ? valid_from : head) - first;
+        out->erase(out->begin() + (ptrdiff_t)base, out->begin() + (ptrdiff_t)(base + stale));
+    }
+}
+
+int hal_trace_write_json(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return -errno;
+
+    const int pid = (int)getpid();
+    std::vector<hal_trace_event_t> events;
+    events.reserve(HAL_TRACE_BUFFER_EVENTS);
+    int written = 0;
+    bool first_line = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (int b = 0; b < HAL_TRACE_MAX_THREADS; b++) {
+        const hal_trace_buffer_t* buffer = &g_trace_buffers[b];
+        if (buffer->state.load(std::memory_order_acquire) == TRACE_BUFFER_FREE) continue;
+        const int tid = buffer->tid.load(std::memory_order_acquire);
+        events.clear();
+        copy_events(buffer, &events);
+        if (events.empty()) continue; // Ex: a thread de uma renderização já parada
+        char name[sizeof(buffer->name)];
+        copy_thread_name(buffer, name, sizeof(name));
+        if (name[0]) {
+            // Nomes vêm do código (literais ASCII sem aspas): não precisam de escape.
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first_line ? "" : ",", pid, tid, name);
+            first_line = false;
+        }
+        for (const hal_trace_event_t& event : events) {
+            // Microssegundos com três casas: a resolução de ns do relógio.
+            fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"hal\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                    "\"ts\":%llu.%03llu,\"dur\":%u.%03u",
+                    first_line ? "" : ",", event.name, pid, tid,
+                    (unsigned long long)(event.start_ns / 1000), (unsigned long long)(event.start_ns % 1000),
+                    event.duration_ns / 1000, event.duration_ns % 1000);
+            if (event.arg != HAL_TRACE_NO_ARG) fprintf(file, ",\"args\":{\"i\":%d}", event.arg);
+            fputc('}', file);
+            first_line = false;
+            written++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    const bool failed = ferror(file) != 0;
+    if (fclose(file) != 0 || failed) return -EIO;
+    ALOGI("AudioHAL: Trace gravado em %s: %d eventos; %llu perdidos por threads sem buffer.", path, written,
+          (unsigned long long)g_trace_lost.load(std::memory_order_relaxed));
+    return written;
+}
+
+#else // !HAL_TRACE
+
+void hal_trace_set_enabled(bool /*enabled*/) {}
+void hal_trace_set_atrace(bool /*enabled*/) {}
+void hal_trace_clear(void) {}
+void hal_trace_set_thread_name(const char* /*name*/) {}
+
+int hal_trace_write_json(const char* /*path*/) {
+    return -ENOSYS;
+}
+
+#endif // HAL_TRACE
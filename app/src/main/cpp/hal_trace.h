@@ -0,0 +1,102 @@
+// --- Marcadores de Trace por Etapa (Chrome / Perfetto) ---
+// Com HAL_TRACE=1 (opção do CMake, desligada por padrão), HAL_TRACE_SCOPE("nome")
+// registra a duração do escopo em que aparece: cada etapa do período (mistura,
+// conversão, taxa, zonas, equalizador, limitador, sinks), o 'write' dos streams
+// e as entradas JNI. Quando um período atrasa, o trace mostra para onde foi o
+// tempo, thread a thread.
+// - Cada thread grava em seu próprio buffer circular (pool estático, sem lock
+//   nem alocação): um evento com início e duração em ns por escopo. Com o
+//   buffer cheio, os eventos mais antigos são sobrescritos. O buffer de uma
+//   thread que terminou é mantido até outra thread precisar dele.
+// - hal_trace_write_json exporta, quando pedido, os eventos de todas as threads
+//   no formato JSON de trace events do Chrome (abre em chrome://tracing e no
+//   ui.perfetto.dev).
+// - No Android, hal_trace_set_atrace encaminha os mesmos escopos ao ATrace
+//   (systrace / Perfetto do sistema) enquanto o rastreamento do app estiver ativo.
+// Sem a flag, as macros não geram código; as funções de controle continuam
+// existindo e hal_trace_write_json retorna -ENOSYS.
+#ifndef MYAUDIOHALPROJECT_HAL_TRACE_H
+#define MYAUDIOHALPROJECT_HAL_TRACE_H
+
+#include <stdint.h>
+
+#define HAL_TRACE_MAX_THREADS 32          // Threads vivas com buffer; as demais perdem os eventos
+#define HAL_TRACE_BUFFER_EVENTS 16384     // Eventos por thread (potência de dois; ~10 s da thread de áudio)
+#define HAL_TRACE_NO_ARG INT32_MIN
+
+// Destinos ligados (máscara de hal_trace_mode).
+#define HAL_TRACE_MODE_RECORD 1u          // Buffers por thread (padrão)
+#define HAL_TRACE_MODE_ATRACE 2u          // ATrace (só no Android)
+
+/**
+ * Liga ou desliga a gravação nos buffers. Os escopos já abertos terminam no
+ * modo em que começaram. Não deve ser chamada no caminho de áudio.
+ */
+void hal_trace_set_enabled(bool enabled);
+
+/**
+ * Liga ou desliga o encaminhamento ao ATrace. Sem efeito fora do Android.
+ */
+void hal_trace_set_atrace(bool enabled);
+
+/**
+ * Descarta os eventos gravados até agora (as threads mantêm seus buffers).
+ */
+void hal_trace_clear(void);
+
+/**
+ * Grava os eventos de todas as threads em 'path', como JSON de trace events.
+ * Pode ser chamada com o áudio rodando: eventos sobrescritos durante a cópia
+ * são descartados, não corrompidos.
+ * @return O número de eventos gravados, -ENOSYS sem HAL_TRACE, ou -errno.
+ */
+int hal_trace_write_json(const char* path);
+
+/**
+ * Dá nome à thread atual no trace (ex: "render"). Até 15 caracteres.
+ */
+void hal_trace_set_thread_name(const char* name);
+
+#if defined(HAL_TRACE) && HAL_TRACE
+
+#include <atomic>
+
+// Máscara HAL_TRACE_MODE_*; lida por todo escopo, antes de qualquer outro custo.
+extern std::atomic<uint32_t> hal_trace_mode;
+
+uint64_t hal_trace_begin(const char* name, uint32_t mode);
+void hal_trace_end(const char* name, int32_t arg, uint64_t start_ns, uint32_t mode);
+
+struct hal_trace_scope {
+    const char* name;
+    int32_t arg;
+    uint32_t mode;
+    uint64_t start_ns;
+
+    hal_trace_scope(const char* n, int32_t a)
+        : name(n), arg(a), mode(hal_trace_mode.load(std::memory_order_relaxed)), start_ns(0) {
+        if (mode) start_ns = hal_trace_begin(name, mode);
+    }
+    ~hal_trace_scope() {
+        if (mode) hal_trace_end(name, arg, start_ns, mode);
+    }
+};
+
+#define HAL_TRACE_CONCAT_(a, b) a##b
+#define HAL_TRACE_CONCAT(a, b) HAL_TRACE_CONCAT_(a, b)
+// 'name' precisa ser um literal (ou viver até a exportação): só o ponteiro é gravado.
+#define HAL_TRACE_SCOPE(name) hal_trace_scope HAL_TRACE_CONCAT(hal_trace_scope_, __LINE__)((name), HAL_TRACE_NO_ARG)
+// Com um inteiro que aparece nos argumentos do evento (ex: índice do stream ou da zona).
+#define HAL_TRACE_SCOPE_ARG(name, arg) \
+    hal_trace_scope HAL_TRACE_CONCAT(hal_trace_scope_, __LINE__)((name), (int32_t)(arg))
+#define HAL_TRACE_THREAD_NAME(name) hal_trace_set_thread_name(name)
+
+#else
+
+#define HAL_TRACE_SCOPE(name) ((void)0)
+#define HAL_TRACE_SCOPE_ARG(name, arg) ((void)0)
+#define HAL_TRACE_THREAD_NAME(name) ((void)0)
+
+#endif // HAL_TRACE
+
+#endif // MYAUDIOHALPROJECT_HAL_TRACE_H
@@ -0,0 +1,45 @@
+// --- Shim de <android/log.h> para a Build de Host (Linux) ---
+// Substitui o cabeçalho do NDK quando a HAL é compilada fora do Android (CI,
+// benchmarks). Tem a mesma interface usada pelo projeto: as prioridades
+// ANDROID_LOG_* e __android_log_print, que aqui escreve em stderr.
+// Mensagens abaixo de HOST_LOG_MIN_PRIORITY são descartadas antes da formatação,
+// para que os logs de depuração não dominem as medições do benchmark.
+#ifndef MYAUDIOHALPROJECT_HOST_ANDROID_LOG_H
+#define MYAUDIOHALPROJECT_HOST_ANDROID_LOG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+// Prioridade mínima impressa (pode ser redefinida com -DHOST_LOG_MIN_PRIORITY=3).
+#ifndef HOST_LOG_MIN_PRIORITY
+#define HOST_LOG_MIN_PRIORITY ANDROID_LOG_INFO
+#endif
+
+__attribute__((format(printf, 3, 4)))
+static inline int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    if (prio < HOST_LOG_MIN_PRIORITY) {
+        return 0;
+    }
+    static const char letters[] = "??VDIWEFS";
+    va_list args;
+    va_start(args, fmt);
+    int n = fprintf(stderr, "%c/%s: ", letters[prio >= 0 && prio <= ANDROID_LOG_SILENT ? prio : 0], tag);
+    n += vfprintf(stderr, fmt, args);
+    n += fprintf(stderr, "\n");
+    va_end(args);
+    return n;
+}
+
+#endif // MYAUDIOHALPROJECT_HOST_ANDROID_LOG_H
@@ -3,7 +3,15 @@
 #include <string>        // Para manipulação de strings C++
 #include <android/log.h> // Para a função __android_log_print, usada para logs no Logcat Android
 #include <string.h>      // Para funções de manipulação de memória (ex: memset)
-#include <stdio.h>       // Para printf, usado como log de fallback/verificação em C padrão
+#include <stdint.h>      // Para uintptr_t (alinhamento da região compartilhada)
+#include <errno.h>       // Para -EINVAL
+
+#include "hal_log.h"     // Nível de log em tempo de compilação (ALOGD some em release)
+#include "wav_source.h"  // Fonte WAV mapeada em memória (som de teste)
+#include "can_decoder.h" // Decodificação dos frames CAN do simulador -> parâmetros do veículo
+#include "hal_trace.h"   // Marcadores de trace das entradas JNI (com HAL_TRACE)
+#include <pthread.h>     // Thread de streaming do som de teste
+#include <atomic>
 
 
 // --- Definições Manuais de Constantes de Prioridade de Log ---
@@ -29,99 +37,88 @@
 // dado que o cabeçalho <log/log.h> (que as define nativamente) não foi encontrado
 // de forma consistente no ambiente de build.
 #ifndef ALOGD
-#define ALOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "NativeJNI", __VA_ARGS__)
+#define ALOGD(...) HAL_LOG(ANDROID_LOG_DEBUG, "NativeJNI", __VA_ARGS__)
 #endif
 
 #ifndef ALOGE
-#define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR, "NativeJNI", __VA_ARGS__)
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "NativeJNI", __VA_ARGS__)
+#endif
+
+#ifndef ALOGI
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "NativeJNI", __VA_ARGS__)
 #endif
 
 
-// --- Definições Mínimas Injetadas para Simulação da HAL ---
-// Este bloco de código contém as definições mínimas de estruturas e macros
-// que normalmente seriam fornecidas pelos cabeçalhos padrão do NDK,
-// especificamente <hardware/hardware.h> e <hardware/audio.h>.
-// Elas foram injetadas diretamente neste arquivo (e em audio_hal.cpp)
-// como uma solução de contorno para problemas de ambiente que impediram
-// o compilador de encontrar esses cabeçalhos.
-// A ordem de declaração das estruturas é crucial em C/C++ para evitar erros de tipo.
-
-// Forward declarations para estruturas que se referenciam mutuamente.
-// Isso informa ao compilador sobre a existência dessas estruturas antes de suas definições completas.
-struct hw_module_t;
-struct hw_device_t;
-struct audio_hw_device; // Forward declaration para a estrutura base de audio_hw_device_t
-
-// Estrutura comum para todos os módulos de hardware (base para HALs).
-// Define a interface básica que um módulo HAL deve ter.
-struct hw_module_t {
-    uint32_t tag;               // Identificador único da estrutura (ex: HARDWARE_MODULE_TAG)
-    uint32_t version_major;     // Versão principal da interface do módulo
-    uint32_t version_minor;     // Versão secundária da interface do módulo
-    const char *id;             // Identificador textual do módulo (ex: "audio")
-    const char *name;           // Nome amigável do módulo
-    const char *author;         // Autor ou organização responsável pelo módulo
-    struct hw_module_methods_t *methods; // Ponteiro para os métodos de acesso do módulo
-    void* dso;                  // Ponteiro interno para o objeto de biblioteca compartilhada (não usado na simulação)
-    uint32_t reserved[32-7];    // Campos reservados para uso futuro, garantindo tamanho fixo
-};
-
-// Métodos comuns para todos os módulos de hardware.
-// Contém o método 'open', que é o ponto de entrada principal para obter uma instância de um dispositivo HAL.
-struct hw_module_methods_t {
-    // Função para abrir um dispositivo de hardware específico dentro do módulo.
-    // Parâmetros: ponteiro para o módulo, ID do dispositivo (ex: "primary"), e ponteiro para preencher com o dispositivo aberto.
-    int (*open)(const struct hw_module_t* module, const char* id, struct hw_device_t** device);
-};
-
-// Estrutura comum para todos os dispositivos de hardware.
-// Define a interface básica que um dispositivo HAL deve ter.
-struct hw_device_t {
-    uint32_t tag;               // Identificador único da estrutura (ex: HARDWARE_DEVICE_TAG)
-    uint32_t version;           // Versão da interface do dispositivo
-    struct hw_module_t* module; // Ponteiro de volta para o módulo ao qual este dispositivo pertence
-    int (*close)(struct hw_device_t* device); // Função para fechar e liberar o dispositivo
-    void* reserved[32-4];       // Campos reservados para uso futuro
-};
-
-// Estrutura específica do dispositivo de áudio.
-// Estende a estrutura genérica 'hw_device_t' com operações específicas de áudio.
-// 'audio_hw_device_t' é um alias (typedef) para 'struct audio_hw_device'.
-typedef struct audio_hw_device {
-    struct hw_device_t common; // Membro comum, herdando as propriedades e métodos de 'hw_device_t'
-
-    // Operações específicas de áudio.
-    // Para esta simulação, apenas a função 'write' (simulando a saída de áudio) é implementada.
-    int (*write)(struct audio_hw_device* dev, const void* buffer, size_t bytes);
-
-    void* reserved[32 - 1]; // Campos reservados para outras funções de áudio não simuladas
-} audio_hw_device_t;
-
-// Estrutura para o módulo de áudio.
-// Usada para definir o símbolo HAL_MODULE_INFO_SYM que o Android procura em bibliotecas compartilhadas.
-// 'audio_module_t' é um alias (typedef) para 'struct audio_module'.
-typedef struct audio_module {
-    struct hw_module_t common; // Membro comum, herdando as propriedades de 'hw_module_t'
-} audio_module_t;
-
-// Macros e Constantes cruciais para a identificação e versão das HALs.
-#define HARDWARE_MODULE_TAG        0x4D4F4455 // "MODU" - Tag para módulos de hardware (ASCII para MODU)
-#define HARDWARE_DEVICE_TAG        0x44455649 // "DEVI" - Tag para dispositivos de hardware (ASCII para DEVI)
-
-#define AUDIO_DEVICE_API_VERSION_2_0 0x02000000 // Versão da API do dispositivo de áudio (Major 2, Minor 0)
-
-#define AUDIO_HARDWARE_MODULE_ID   "audio"    // ID padrão para o módulo HAL de áudio (usado por hw_get_module)
-#define AUDIO_HARDWARE_INTERFACE   "primary"  // Nome da interface primária de áudio (comum para áudio)
-
-// --- Fim das Definições Injetadas ---
+// --- Definições da Interface da HAL ---
+// As estruturas e macros de <hardware/hardware.h> e <hardware/audio.h> injetadas
+// para a simulação ficam em audio_hal.h, compartilhado com audio_hal.cpp.
+#include "audio_hal.h"
 
 
 // --- Variáveis Globais para a HAL ---
 // Ponteiros estáticos para o módulo e dispositivo de áudio da HAL.
 // 'static' garante que estas variáveis são visíveis apenas dentro deste arquivo.
-// Elas são inicializadas como NULL e preenchidas na primeira chamada JNI.
+// Elas são inicializadas como NULL e preenchidas na primeira chamada JNI, que
+// pode vir da thread de UI, de threads Binder (EqualizerService) ou das que
+// iniciam PCM/CAN/WAV: a abertura é serializada por gAudioDeviceLock e
+// gAudioDevice só é publicado (gAudioDeviceReady) depois de configurado.
 static audio_module_t* gAudioModule = NULL;
 static audio_hw_device_t* gAudioDevice = NULL;
+static pthread_mutex_t gAudioDeviceLock = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<bool> gAudioDeviceReady(false);
+
+
+// --- Acesso ao Dispositivo HAL ---
+/**
+ * Abre e configura o dispositivo. Chamada com gAudioDeviceLock.
+ * @return 0 em caso de sucesso, ou o código de erro retornado por 'open'.
+ */
+static int open_audio_device_locked() {
+    // 1. Obter o Módulo HAL de Áudio
+    // Esta lógica simula o processo de carregamento de um módulo HAL.
+    // Em um sistema Android real, a função 'hw_get_module()' seria usada para carregar
+    // dinamicamente o módulo da biblioteca compartilhada (.so).
+    // Aqui, como estamos em um ambiente de simulação e contorno de problemas de NDK,
+    // referenciamos diretamente a instância global da HAL definida em 'audio_hal.cpp'
+    // (declarada como 'extern' em audio_hal.h).
+    if (gAudioModule == NULL) {
+        gAudioModule = &HAL_MODULE_INFO_SYM; // Atribui o endereço da instância global da HAL
+        ALOGD("JNI: Módulo de áudio HAL obtido via referência direta.");
+    }
+
+    // 2. Abrir o Dispositivo HAL de Áudio
+    // Esta lógica simula a abertura de um dispositivo específico dentro do módulo HAL.
+    // A função 'open' do módulo HAL é chamada para obter a instância do dispositivo de áudio.
+    // 'AUDIO_HARDWARE_INTERFACE' identifica a interface de áudio a ser aberta (ex: "primary").
+    audio_hw_device_t* device = NULL;
+    int ret = gAudioModule->common.methods->open((const hw_module_t*)gAudioModule,
+                                                 AUDIO_HARDWARE_INTERFACE,
+                                                 (hw_device_t**)&device);
+    if (ret != 0) {
+        // Em caso de falha na abertura do dispositivo, registra um erro e reseta o ponteiro do módulo.
+        ALOGE("JNI: Falha ao abrir o dispositivo de áudio HAL: %d", ret);
+        gAudioModule = NULL; // Reseta para tentar novamente em futuras chamadas JNI
+        return ret;          // Retorna o código de erro para o chamador
+    }
+    ALOGD("JNI: Dispositivo de áudio HAL aberto com sucesso.");
+    gAudioDevice = device;
+    gAudioDeviceReady.store(true, std::memory_order_release);
+    return 0;
+}
+
+/**
+ * Garante que o módulo e o dispositivo de áudio da HAL estejam abertos.
+ * Compartilhado por todas as funções JNI que precisam falar com a HAL; depois
+ * que retorna 0, gAudioDevice pode ser lido sem lock (nunca muda).
+ * @return 0 em caso de sucesso, ou o código de erro retornado por 'open'.
+ */
+static int ensure_audio_device() {
+    if (gAudioDeviceReady.load(std::memory_order_acquire)) return 0;
+    pthread_mutex_lock(&gAudioDeviceLock);
+    const int ret = gAudioDeviceReady.load(std::memory_order_relaxed) ? 0 : open_audio_device_locked();
+    pthread_mutex_unlock(&gAudioDeviceLock);
+    return ret;
+}
 
 
 // --- Função JNI Principal ---
@@ -139,59 +136,31 @@ extern "C" JNIEXPORT jint JNICALL
 Java_com_example_myaudiohalproject_MainActivity_triggerHalAudioWrite(
         JNIEnv* env,
         jobject /*obj*/) {
+    HAL_TRACE_SCOPE("jni_write");
 
-    // Log de verificação usando printf. Útil para depuração em ambientes onde ALOG não funciona.
-    printf("NATIVE_LIB: triggerHalAudioWrite - INICIANDO\n");
-    // Log detalhado para o Logcat Android, usando a macro ALOGD definida acima.
-    ALOGD("JNI: Tentando chamar triggerHalAudioWrite...");
-
-    // Declaração externa do símbolo HAL_MODULE_INFO_SYM.
-    // Este símbolo representa a instância global da sua HAL de áudio, definida em audio_hal.cpp.
-    // 'extern' informa ao compilador que essa variável existe, mas está definida em outro arquivo.
-    extern struct audio_module HAL_MODULE_INFO_SYM;
+    // Sem logs por chamada aqui: esta função fica no caminho de áudio e os bytes
+    // escritos, overruns e latências já são contabilizados nas métricas da HAL
+    // (ver getHalMetricsNative). Só erros são registrados.
 
-    // 1. Obter o Módulo HAL de Áudio
-    // Esta lógica simula o processo de carregamento de um módulo HAL.
-    // Em um sistema Android real, a função 'hw_get_module()' seria usada para carregar
-    // dinamicamente o módulo da biblioteca compartilhada (.so).
-    // Aqui, como estamos em um ambiente de simulação e contorno de problemas de NDK,
-    // referenciamos diretamente a instância global da HAL definida em 'audio_hal.cpp'.
-    if (gAudioModule == NULL) {
-        gAudioModule = &HAL_MODULE_INFO_SYM; // Atribui o endereço da instância global da HAL
-        ALOGD("JNI: Módulo de áudio HAL obtido via referência direta.");
-    }
-
-    // 2. Abrir o Dispositivo HAL de Áudio
-    // Esta lógica simula a abertura de um dispositivo específico dentro do módulo HAL.
-    // A função 'open' do módulo HAL é chamada para obter a instância do dispositivo de áudio.
-    if (gAudioDevice == NULL) {
-        // Chama o método 'open' através da estrutura 'methods' do módulo HAL.
-        // 'AUDIO_HARDWARE_INTERFACE' identifica a interface de áudio a ser aberta (ex: "primary").
-        int ret = gAudioModule->common.methods->open((const hw_module_t*)gAudioModule,
-                                                     AUDIO_HARDWARE_INTERFACE,
-                                                     (hw_device_t**)&gAudioDevice);
-        if (ret != 0) {
-            // Em caso de falha na abertura do dispositivo, registra um erro e reseta o ponteiro do módulo.
-            ALOGE("JNI: Falha ao abrir o dispositivo de áudio HAL: %d", ret);
-            gAudioModule = NULL; // Reseta para tentar novamente em futuras chamadas JNI
-            return ret;          // Retorna o código de erro para o Kotlin/Java
-        }
-        ALOGD("JNI: Dispositivo de áudio HAL aberto com sucesso.");
+    // 1 e 2. Obter o módulo e abrir o dispositivo HAL de áudio (se ainda não estiverem abertos).
+    int ret = ensure_audio_device();
+    if (ret != 0) {
+        return ret; // Retorna o código de erro para o Kotlin/Java
     }
 
     // 3. Chamar a Função audio_write da HAL (Simulada)
     // Prepara um buffer de dados fictício (dummy_buffer) para simular o envio de dados de áudio para a HAL.
-    unsigned char dummy_buffer[1024];
-    memset(dummy_buffer, 0, sizeof(dummy_buffer)); // Preenche o buffer com zeros para dados limpos
+    // Estático e já zerado: nada de memset a cada chamada.
+    static const unsigned char dummy_buffer[1024] = {0};
 
     // Chama a função 'write' do dispositivo de áudio da HAL.
-    // Esta função simula o processamento dos dados de áudio pela HAL.
+    // Ela apenas enfileira os dados no ring buffer lock-free da HAL e retorna sem
+    // bloquear esta thread; o processamento acontece no lado consumidor ('render').
     ssize_t bytes_written = gAudioDevice->write(gAudioDevice, dummy_buffer, sizeof(dummy_buffer));
 
     // Verifica o resultado da operação de escrita na HAL.
     if (bytes_written >= 0) {
         // Se 'bytes_written' for não-negativo, a operação é considerada bem-sucedida.
-        ALOGD("JNI: Função audio_write da HAL chamada. Bytes processados: %zd", bytes_written);
         return 0; // Retorna 0 para indicar sucesso ao Kotlin/Java
     } else {
         // Se 'bytes_written' for negativo, indica um erro retornado pela HAL.
@@ -199,3 +168,567 @@ Java_com_example_myaudiohalproject_MainActivity_triggerHalAudioWrite(
         return (jint)bytes_written; // Retorna o código de erro para o Kotlin/Java
     }
 }
+
+
+
+// --- Funções JNI do Equalizador ---
+// Implementações nativas dos métodos 'external' declarados em MainActivity.kt
+// e EqualizerService.kt.
+// Elas apenas publicam os novos parâmetros na HAL, que os aplica na thread de áudio.
+
+/**
+ * Retorna um texto de status da HAL nativa para exibição na UI.
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_myaudiohalproject_MainActivity_stringFromJNI(
+        JNIEnv* env,
+        jobject /*obj*/) {
+    if (ensure_audio_device() != 0) {
+        return env->NewStringUTF("HAL de áudio: indisponível");
+    }
+    std::string status = "HAL de áudio: ";
+    status += HAL_MODULE_INFO_SYM.common.name;
+    return env->NewStringUTF(status.c_str());
+}
+
+/**
+ * Liga ou desliga o equalizador da HAL.
+ * @param enabled true para ativar o processamento, false para bypass.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setEqualizerEnabledNative(
+        JNIEnv* /*env*/,
+        jobject /*obj*/,
+        jboolean enabled) {
+    HAL_TRACE_SCOPE("jni_set_eq_enabled");
+    if (ensure_audio_device() != 0) return;
+    gAudioDevice->set_eq_enabled(gAudioDevice, enabled == JNI_TRUE);
+}
+
+/**
+ * Ajusta uma banda do equalizador da HAL e registra eventuais erros.
+ */
+static void set_eq_band_level(int band, jint level) {
+    HAL_TRACE_SCOPE_ARG("jni_set_eq_band", band);
+    if (ensure_audio_device() != 0) return;
+    int ret = gAudioDevice->set_eq_band_level(gAudioDevice, band, (int)level);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao ajustar banda %d do equalizador: %d", band, ret);
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setBassLevelNative(
+        JNIEnv* /*env*/, jobject /*obj*/, jint level) {
+    set_eq_band_level(AUDIO_EQ_BAND_BASS, level);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setMidLevelNative(
+        JNIEnv* /*env*/, jobject /*obj*/, jint level) {
+    set_eq_band_level(AUDIO_EQ_BAND_MID, level);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setTrebleLevelNative(
+        JNIEnv* /*env*/, jobject /*obj*/, jint level) {
+    set_eq_band_level(AUDIO_EQ_BAND_TREBLE, level);
+}
+
+// Chamadas pelo EqualizerService (Binder 'oneway'): todas as bandas ou um
+// preset em uma única publicação, com os coeficientes do cache da HAL.
+
+/**
+ * Ajusta todas as bandas do equalizador de uma vez.
+ * @param levels Um nível (0..100) por banda do layout da HAL.
+ * @return 0 em caso de sucesso, ou um código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_EqualizerService_setEqualizerBandsNative(
+        JNIEnv* env, jobject /*obj*/, jintArray levels) {
+    HAL_TRACE_SCOPE("jni_set_eq_bands");
+    int ret = ensure_audio_device();
+    if (ret != 0) return ret;
+    const jsize count = levels ? env->GetArrayLength(levels) : 0;
+    if (count < 1 || count > AUDIO_EQ_MAX_BANDS) {
+        ALOGE("JNI: %d níveis de equalizador inválidos.", (int)count);
+        return -EINVAL;
+    }
+    jint values[AUDIO_EQ_MAX_BANDS]; // Cópia para a pilha: sem fixar o array da JVM
+    env->GetIntArrayRegion(levels, 0, count, values);
+    int bands[AUDIO_EQ_MAX_BANDS];
+    for (jsize i = 0; i < count; i++) bands[i] = (int)values[i];
+    ret = gAudioDevice->set_eq_bands(gAudioDevice, bands, (int)count);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao ajustar as bandas do equalizador: %d", ret);
+    }
+    return ret;
+}
+
+/**
+ * Carrega um preset do equalizador (AUDIO_EQ_PRESET_*).
+ * @return 0 em caso de sucesso, ou um código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_EqualizerService_loadEqPresetNative(
+        JNIEnv* /*env*/, jobject /*obj*/, jint preset) {
+    HAL_TRACE_SCOPE_ARG("jni_load_eq_preset", preset);
+    int ret = ensure_audio_device();
+    if (ret != 0) return ret;
+    ret = gAudioDevice->load_eq_preset(gAudioDevice, (int)preset);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao carregar o preset %d do equalizador: %d", (int)preset, ret);
+    }
+    return ret;
+}
+
+
+// --- Volume Mestre ---
+/**
+ * Aplica um volume mestre de 0 a 100 (a mesma escala do sinal CAN 0x123), pelo
+ * parâmetro de volume do veículo; a curva em dB fica na HAL.
+ * @param volume Volume de 0 a 100 (valores fora da faixa são limitados).
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setMasterVolumeNative(
+        JNIEnv* /*env*/,
+        jobject /*obj*/,
+        jint volume) {
+    HAL_TRACE_SCOPE("jni_set_volume");
+    if (ensure_audio_device() != 0) return;
+    const audio_vehicle_param_update_t update = { AUDIO_VEHICLE_PARAM_MASTER_VOLUME, (float)volume };
+    int ret = gAudioDevice->set_vehicle_params(gAudioDevice, &update, 1);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao ajustar o volume mestre: %d", ret);
+    }
+}
+
+
+// --- Dinâmica ---
+/**
+ * Liga ou desliga a compensação do ruído de rodagem pela velocidade (sinal CAN
+ * 0x3E9) e o limitador na saída, para que os reforços do equalizador não
+ * saturem. Desligada por padrão: ligada, acrescenta a latência do limitador
+ * (DYN_LIMITER_LATENCY_FRAMES) a todos os streams.
+ * @param enabled true para ligar com a configuração do carro, false para desligar.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setDynamicsEnabledNative(
+        JNIEnv* /*env*/,
+        jobject /*obj*/,
+        jboolean enabled) {
+    HAL_TRACE_SCOPE("jni_set_dynamics");
+    if (ensure_audio_device() != 0) return;
+    audio_dynamics_config_t config = {};
+    config.enabled = enabled == JNI_TRUE;
+    config.speed_ref_kmh = 120.0f;
+    config.speed_gain_db = 4.0f;
+    config.loudness_bass_db = 6.0f;
+    config.loudness_treble_db = 3.0f;
+    config.limiter_threshold_db = -1.0f;
+    config.limiter_release_ms = 200.0f;
+    int ret = gAudioDevice->set_dynamics_config(gAudioDevice, &config);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao configurar a dinâmica: %d", ret);
+    }
+}
+
+
+// --- Métricas da HAL ---
+// Layout do array retornado por getHalMetricsNative (mantenha em sincronia com HalMetrics.kt):
+//   [0..5]   bytes escritos, frames escritos, overruns, frames renderizados, períodos, underruns
+//   [6..8]   latência de write: contagem, soma (ns), máximo (ns)
+//   [9..24]  latência de write: baldes do histograma (AUDIO_METRICS_LATENCY_BUCKETS)
+//   [25..27] latência de processamento: contagem, soma (ns), máximo (ns)
+//   [28..43] latência de processamento: baldes do histograma
+#define METRICS_COUNTERS 6
+#define METRICS_HISTOGRAM_LONGS (3 + AUDIO_METRICS_LATENCY_BUCKETS)
+#define METRICS_ARRAY_LENGTH (METRICS_COUNTERS + 2 * METRICS_HISTOGRAM_LONGS)
+
+static jlong* put_histogram(jlong* out, const audio_latency_histogram_t* h) {
+    *out++ = (jlong)h->count;
+    *out++ = (jlong)h->sum_ns;
+    *out++ = (jlong)h->max_ns;
+    for (int i = 0; i < AUDIO_METRICS_LATENCY_BUCKETS; i++) {
+        *out++ = (jlong)h->buckets[i];
+    }
+    return out;
+}
+
+/**
+ * Retorna um snapshot das métricas do caminho de áudio da HAL (layout acima),
+ * ou null se o dispositivo não puder ser aberto. A leitura é lock-free e não
+ * interfere na thread de renderização.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myaudiohalproject_MainActivity_getHalMetricsNative(
+        JNIEnv* env,
+        jobject /*obj*/) {
+    HAL_TRACE_SCOPE("jni_get_metrics");
+    if (ensure_audio_device() != 0) return NULL;
+    audio_metrics_t metrics;
+    if (gAudioDevice->get_metrics(gAudioDevice, &metrics) != 0) return NULL;
+
+    jlong values[METRICS_ARRAY_LENGTH];
+    jlong* out = values;
+    *out++ = (jlong)metrics.bytes_written;
+    *out++ = (jlong)metrics.frames_written;
+    *out++ = (jlong)metrics.overruns;
+    *out++ = (jlong)metrics.frames_rendered;
+    *out++ = (jlong)metrics.periods_rendered;
+    *out++ = (jlong)metrics.underruns;
+    out = put_histogram(out, &metrics.write_latency);
+    put_histogram(out, &metrics.process_latency);
+
+    jlongArray array = env->NewLongArray(METRICS_ARRAY_LENGTH);
+    if (array == NULL) return NULL; // OutOfMemoryError já pendente na JVM
+    env->SetLongArrayRegion(array, 0, METRICS_ARRAY_LENGTH, values);
+    return array;
+}
+
+
+// --- Stream PCM em Memória Compartilhada (HalPcmStream.kt) ---
+// O Kotlin aloca um ByteBuffer direto (ou mapeia um SharedMemory/memfd) uma única
+// vez e o registra aqui; a HAL usa essa região como a fila do stream (layout em
+// audio_hal.h). O Kotlin escreve o PCM diretamente nos dados da fila e só chama
+// 'commitNative' para publicar a nova posição de escrita: não há
+// GetByteArrayElements, cópia de array nem pinning por chamada, e a thread de
+// renderização mistura o PCM no lugar.
+
+// Estado nativo de um HalPcmStream (o 'handle' visto pelo Kotlin).
+typedef struct {
+    audio_stream_out_t* stream;
+    jobject buffer_ref;     // Referência global: impede o GC de liberar a região
+} shared_pcm_stream_t;
+
+/**
+ * Distância, em bytes, do início do ByteBuffer até o primeiro endereço alinhado
+ * a AUDIO_SHARED_PCM_ALIGNMENT, onde o cabeçalho da fila deve começar.
+ * @return O offset, ou -EINVAL se o buffer não for direto.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_HalPcmStream_alignmentOffsetNative(
+        JNIEnv* env, jclass /*clazz*/, jobject buffer) {
+    const uintptr_t address = (uintptr_t)env->GetDirectBufferAddress(buffer);
+    if (address == 0) return -EINVAL;
+    return (jint)((AUDIO_SHARED_PCM_ALIGNMENT - address % AUDIO_SHARED_PCM_ALIGNMENT) % AUDIO_SHARED_PCM_ALIGNMENT);
+}
+
+/**
+ * Abre um stream da HAL cuja fila é a região do ByteBuffer a partir de 'offset'.
+ * O endereço é obtido uma única vez aqui; depois disso nenhuma chamada toca o buffer.
+ * @return O handle do stream (diferente de 0), ou 0 em caso de erro.
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_myaudiohalproject_HalPcmStream_openNative(
+        JNIEnv* env, jclass /*clazz*/, jobject buffer, jint offset, jint usage, jint priority) {
+    if (ensure_audio_device() != 0) return 0;
+    uint8_t* address = (uint8_t*)env->GetDirectBufferAddress(buffer);
+    const jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == NULL || offset < 0 || offset >= capacity) {
+        ALOGE("JNI: Região PCM compartilhada inválida (buffer não direto ou offset %d).", (int)offset);
+        return 0;
+    }
+
+    shared_pcm_stream_t* shared = new shared_pcm_stream_t;
+    audio_stream_config_t config = {};
+    config.usage = (audio_usage_t)usage;
+    config.priority = (int)priority;
+    config.gain = 1.0f;
+    config.shared_memory = address + offset;
+    config.shared_bytes = (size_t)(capacity - offset);
+    int ret = gAudioDevice->open_output_stream(gAudioDevice, &config, &shared->stream);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao abrir o stream PCM compartilhado: %d", ret);
+        delete shared;
+        return 0;
+    }
+    shared->buffer_ref = env->NewGlobalRef(buffer);
+    return (jlong)(uintptr_t)shared;
+}
+
+/**
+ * Publica 'bytes' já escritos pelo Kotlin nos dados da fila (pode ser 0, só para
+ * consultar o espaço livre). Chamada no caminho de áudio: sem logs.
+ * @return Espaço livre restante em bytes, ou um código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_HalPcmStream_commitNative(
+        JNIEnv* /*env*/, jclass /*clazz*/, jlong handle, jint bytes) {
+    HAL_TRACE_SCOPE("jni_commit");
+    shared_pcm_stream_t* shared = (shared_pcm_stream_t*)(uintptr_t)handle;
+    if (shared == NULL || bytes < 0) return -EINVAL;
+    return shared->stream->commit(shared->stream, (size_t)bytes);
+}
+
+/**
+ * Fecha o stream e libera a referência ao ByteBuffer. Se a thread de renderização
+ * não liberar o stream a tempo (-ETIMEDOUT), o handle e a referência são mantidos
+ * (a região ainda pode ser lida) e uma nova chamada conclui o fechamento.
+ * @return 0 em caso de sucesso, ou o código de erro de 'close_output_stream'.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_HalPcmStream_closeNative(
+        JNIEnv* env, jclass /*clazz*/, jlong handle) {
+    shared_pcm_stream_t* shared = (shared_pcm_stream_t*)(uintptr_t)handle;
+    if (shared == NULL) return -EINVAL;
+    int ret = gAudioDevice->close_output_stream(gAudioDevice, shared->stream);
+    if (ret != 0) {
+        ALOGE("JNI: Falha ao fechar o stream PCM compartilhado: %d", ret);
+        return ret;
+    }
+    env->DeleteGlobalRef(shared->buffer_ref);
+    delete shared;
+    return 0;
+}
+
+
+// --- Som de Teste (res/raw/test_sound.wav) ---
+// O WAV é mapeado direto do APK (via AssetFileDescriptor) e entregue à HAL por
+// 'write', um período por período de relógio, em uma thread própria: a thread de
+// UI só inicia e para. Uma reprodução por vez.
+static wav_source_t gWavSource;
+static pthread_t gWavThread;
+static bool gWavThreadStarted = false;
+static std::atomic<bool> gWavStop(false);
+static wav_stream_options_t gWavOptions;
+
+static void* wav_playback_thread(void* /*arg*/) {
+    HAL_TRACE_THREAD_NAME("wav playback");
+    wav_stream_stats_t stats;
+    int ret = wav_stream_to_hal(gAudioDevice, &gWavSource, &gWavOptions, &stats);
+    if (ret != 0) {
+        ALOGE("JNI: Reprodução do WAV interrompida: %d", ret);
+    }
+    return NULL;
+}
+
+static void stop_wav_playback() {
+    if (!gWavThreadStarted) return;
+    gWavStop.store(true, std::memory_order_relaxed);
+    pthread_join(gWavThread, NULL);
+    gWavThreadStarted = false;
+    wav_source_close(&gWavSource);
+}
+
+/**
+ * Começa a tocar um WAV contido em um arquivo (ex: recurso não comprimido do APK).
+ * O descritor só é usado durante a chamada; o mapeamento independe dele.
+ * @return 0 em caso de sucesso, ou um código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_MainActivity_startWavPlaybackNative(
+        JNIEnv* /*env*/, jobject /*obj*/, jint fd, jlong offset, jlong length, jboolean loop) {
+    int ret = ensure_audio_device();
+    if (ret != 0) return ret;
+    stop_wav_playback();
+    ret = wav_source_open_fd(&gWavSource, (int)fd, (off_t)offset, (size_t)length);
+    if (ret != 0) {
+        ALOGE("JNI: WAV inválido: %d", ret);
+        return ret;
+    }
+    gWavOptions.pace = WAV_PACE_REALTIME;
+    gWavOptions.period_frames = HAL_PERIOD_FRAMES;
+    gWavOptions.loop = loop == JNI_TRUE;
+    gWavOptions.stop = &gWavStop;
+    gWavStop.store(false, std::memory_order_relaxed);
+    ret = -pthread_create(&gWavThread, NULL, wav_playback_thread, NULL);
+    if (ret != 0) {
+        wav_source_close(&gWavSource);
+        return ret;
+    }
+    gWavThreadStarted = true;
+    return 0;
+}
+
+/**
+ * Para a reprodução do WAV (no máximo um período de espera).
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_stopWavPlaybackNative(
+        JNIEnv* /*env*/, jobject /*obj*/) {
+    stop_wav_playback();
+}
+
+
+// --- Barramento CAN (VehicleCanBusSimulator) ---
+// Os frames do simulador entram em uma fila lock-free (can_push_frame, sem
+// alocação nem log por frame) ou vêm de um log do candump; uma thread de
+// ingestão os decodifica pela tabela can_vehicle_signals e publica os sinais na
+// HAL em lotes. Uma ingestão por vez. A thread dorme enquanto a fila estiver
+// vazia; só o replay, que segue o relógio, é lido por polling.
+// Início, parada e push passam por gCanLock: gCanSource e a fila só mudam com
+// ele, então um push nunca cai em uma fila sendo reiniciada. A thread de
+// ingestão não usa o lock (só lê a fonte fixada antes de ser criada).
+#define CAN_INGEST_POLL_US 2000
+
+static can_decoder_t gCanDecoder;
+static can_stub_source_t gCanStub;
+static can_replay_source_t gCanReplay;
+static can_source_t* gCanSource = NULL;
+static pthread_mutex_t gCanLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t gCanThread;
+static bool gCanThreadStarted = false;
+static std::atomic<bool> gCanStop(false);
+static can_ingest_options_t gCanOptions;
+
+static void* can_ingest_thread(void* /*arg*/) {
+    HAL_TRACE_THREAD_NAME("can ingest");
+    int ret = can_ingest_to_hal(&gCanDecoder, gCanSource, gAudioDevice, &gCanOptions);
+    if (ret != 0) {
+        ALOGE("JNI: Ingestão CAN interrompida: %d", ret);
+    }
+    return NULL;
+}
+
+/**
+ * Para a thread de ingestão e fecha a fonte. Chamada com gCanLock.
+ */
+static void stop_can_ingest() {
+    if (!gCanThreadStarted) return;
+    gCanStop.store(true, std::memory_order_relaxed);
+    if (gCanSource->wake) gCanSource->wake(gCanSource);
+    pthread_join(gCanThread, NULL);
+    gCanThreadStarted = false;
+    ALOGI("JNI: Ingestão CAN parada: %llu frames, %llu sinais, %llu desconhecidos, %llu descartados na fila.",
+          (unsigned long long)gCanDecoder.frames.load(std::memory_order_relaxed),
+          (unsigned long long)gCanDecoder.signals_decoded.load(std::memory_order_relaxed),
+          (unsigned long long)gCanDecoder.unknown_frames.load(std::memory_order_relaxed),
+          (unsigned long long)gCanStub.dropped);
+    if (gCanSource == &gCanReplay.source) {
+        can_replay_close(&gCanReplay);
+    }
+    gCanSource = NULL;
+}
+
+/**
+ * Compila a tabela de sinais e inicia a thread de ingestão sobre 'source'.
+ * Chamada com gCanLock.
+ * @return 0 em caso de sucesso, ou um código de erro negativo.
+ */
+static int start_can_ingest(can_source_t* source) {
+    int ret = can_decoder_compile(&gCanDecoder, can_vehicle_signals, can_vehicle_signal_count);
+    if (ret != 0) return ret;
+    gCanSource = source;
+    gCanOptions.poll_us = CAN_INGEST_POLL_US;
+    gCanOptions.stop = &gCanStop;
+    gCanStop.store(false, std::memory_order_relaxed);
+    ret = -pthread_create(&gCanThread, NULL, can_ingest_thread, NULL);
+    if (ret != 0) {
+        gCanSource = NULL;
+        return ret;
+    }
+    gCanThreadStarted = true;
+    return 0;
+}
+
+/**
+ * Inicia a ingestão dos frames enviados por pushFrameNative.
+ * @return 0 em caso de sucesso, ou um código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_com_example_myaudiohalproject_VehicleCanBusSimulator_startIngestNative(
+        JNIEnv* /*env*/, jobject /*obj*/) {
+    int ret = ensure_audio_device();
+    if (ret != 0) return ret;
+    pthread_mutex_lock(&gCanLock);
+    stop_can_ingest();
+    can_stub_init(&gCanStub);
+    ret = start_can_ingest(&gCanStub.source);
+    pthread_mutex_unlock(&gCanLock);
+    return ret;
+}
+
+/**
+ * Inicia a ingestão de um log do candump (ex: gravado de um veículo) no lugar da fila.
+ * @return 0 em caso de sucesso, ou um código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_com_example_myaudiohalproject_VehicleCanBusSimulator_startReplayNative(
+        JNIEnv* env, jobject /*obj*/, jstring path, jboolean loop, jboolean realtime) {
+    int ret = ensure_audio_device();
+    if (ret != 0) return ret;
+    const char* c_path = env->GetStringUTFChars(path, NULL);
+    if (!c_path) return -ENOMEM;
+    pthread_mutex_lock(&gCanLock);
+    stop_can_ingest();
+    ret = can_replay_open(&gCanReplay, c_path, loop == JNI_TRUE, realtime == JNI_TRUE);
+    if (ret == 0) {
+        ret = start_can_ingest(&gCanReplay.source);
+        if (ret != 0) can_replay_close(&gCanReplay);
+    }
+    pthread_mutex_unlock(&gCanLock);
+    env->ReleaseStringUTFChars(path, c_path);
+    return ret;
+}
+
+/**
+ * Enfileira um frame para a ingestão (serializado com início e parada por gCanLock). IDs acima de
+ * 0x7FF são enviados como estendidos.
+ * @return false se o frame for inválido, a ingestão da fila não estiver ativa
+ *         ou a fila estiver cheia.
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_myaudiohalproject_com_example_myaudiohalproject_VehicleCanBusSimulator_pushFrameNative(
+        JNIEnv* env, jobject /*obj*/, jint id, jbyteArray data) {
+    HAL_TRACE_SCOPE("jni_can_push");
+    if (id < 0 || (uint32_t)id > CAN_FRAME_EFF_MASK) return JNI_FALSE;
+    const jsize len = data ? env->GetArrayLength(data) : 0;
+    if (len > CAN_FRAME_MAX_DATA) return JNI_FALSE;
+    can_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = (uint32_t)id > CAN_FRAME_SFF_MASK ? ((uint32_t)id | CAN_FRAME_EFF_FLAG) : (uint32_t)id;
+    frame.len = (uint8_t)len;
+    if (len > 0) {
+        env->GetByteArrayRegion(data, 0, len, (jbyte*)frame.data);
+    }
+    // Sem disputa no uso normal (um produtor); só espera durante um início ou parada.
+    pthread_mutex_lock(&gCanLock);
+    const bool pushed = gCanSource == &gCanStub.source && can_stub_push(&gCanStub, &frame, 1) == 1;
+    pthread_mutex_unlock(&gCanLock);
+    return pushed ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Para a ingestão CAN (no replay, no máximo CAN_INGEST_POLL_US de espera).
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_com_example_myaudiohalproject_VehicleCanBusSimulator_stopIngestNative(
+        JNIEnv* /*env*/, jobject /*obj*/) {
+    pthread_mutex_lock(&gCanLock);
+    stop_can_ingest();
+    pthread_mutex_unlock(&gCanLock);
+}
+
+
+// --- Trace da HAL ---
+/**
+ * Liga ou desliga o encaminhamento dos marcadores ao ATrace (systrace/Perfetto
+ * do sistema). Desligado por padrão; só tem efeito em builds com HAL_TRACE.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myaudiohalproject_MainActivity_setHalAtraceEnabledNative(
+        JNIEnv* /*env*/, jobject /*obj*/, jboolean enabled) {
+    hal_trace_set_atrace(enabled == JNI_TRUE);
+    ALOGI("JNI: ATrace da HAL %s.", enabled == JNI_TRUE ? "ligado" : "desligado");
+}
+
+/**
+ * Grava os marcadores de trace de todas as threads (HAL, workers, JNI) em
+ * 'path', como JSON de trace events do Chrome (abre no ui.perfetto.dev).
+ * @return O número de eventos gravados, -ENOSYS se a biblioteca foi compilada
+ *         sem HAL_TRACE, ou outro código de erro negativo.
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_myaudiohalproject_MainActivity_dumpHalTraceNative(
+        JNIEnv* env, jobject /*obj*/, jstring path) {
+    if (path == NULL) return -EINVAL;
+    const char* chars = env->GetStringUTFChars(path, NULL);
+    if (chars == NULL) return -ENOMEM; // OutOfMemoryError já pendente na JVM
+    const int ret = hal_trace_write_json(chars);
+    env->ReleaseStringUTFChars(path, chars);
+    if (ret < 0 && ret != -ENOSYS) {
+        ALOGE("JNI: Falha ao gravar o trace da HAL: %d", ret);
+    }
+    return ret;
+}
@@ -0,0 +1,407 @@
+// --- Includes Padrão ---
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dynamics.h"
+#include "hal_log.h"
+#include "hal_metrics.h" // Para hal_metrics_now_ns
+#include "hal_trace.h"
+#include "offline_render.h"
+#include "wav_source.h"
+
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "OfflineRender", __VA_ARGS__)
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "OfflineRender", __VA_ARGS__)
+
+#define WAV_HEADER_BYTES 44
+// Saída acumulada antes de cada pwrite (64 KiB).
+#define OFFLINE_FLUSH_FRAMES 16384
+
+// Um dispositivo com sua fonte: a posição da fonte é a do estado do dispositivo.
+typedef struct {
+    audio_hw_device_t* dev;
+    wav_source_t src;
+} offline_renderer_t;
+
+// Um trecho [start, end) de um arquivo.
+typedef struct {
+    size_t file;
+    uint64_t start;
+    uint64_t end;
+    offline_renderer_t renderer;
+    uint64_t* checkpoints;      // Resumo do estado em start, start + align, ...
+    uint64_t warmup_frames;
+    int result;
+} offline_segment_t;
+
+typedef struct {
+    const offline_render_job_t* jobs;
+    const offline_render_options_t* options;
+    const int* out_fds;
+    uint64_t align;             // Intervalo dos limites e dos pontos de verificação
+} offline_context_t;
+
+typedef struct {
+    const offline_context_t* ctx;
+    offline_segment_t* segment;
+} offline_task_t;
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        const uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static inline uint64_t round_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+
+// --- Arquivo de Saída ---
+
+static inline void put_le16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * Cria a saída já no tamanho final (cabeçalho PCM 16 bits estéreo e 'data' de
+ * 'frames' frames), para que os segmentos gravem cada um no seu lugar com pwrite.
+ * @return O descritor, ou -errno.
+ */
+static int create_output(const char* path, uint64_t frames) {
+    const uint64_t data_bytes = frames * HAL_FRAME_SIZE;
+    if (data_bytes > UINT32_MAX - (WAV_HEADER_BYTES - 8)) {
+        return -EFBIG;
+    }
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        const int err = errno;
+        ALOGE("OfflineRender: Falha ao criar %s: %s", path, strerror(err));
+        return -err;
+    }
+    uint8_t header[WAV_HEADER_BYTES];
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, (uint32_t)(data_bytes + WAV_HEADER_BYTES - 8));
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    put_le16(header + 20, 1); // PCM
+    put_le16(header + 22, HAL_CHANNELS);
+    put_le32(header + 24, HAL_SAMPLE_RATE);
+    put_le32(header + 28, HAL_SAMPLE_RATE * HAL_FRAME_SIZE);
+    put_le16(header + 32, HAL_FRAME_SIZE);
+    put_le16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, (uint32_t)data_bytes);
+    if (pwrite(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        ftruncate(fd, (off_t)(WAV_HEADER_BYTES + data_bytes)) != 0) {
+        const int err = errno ? errno : EIO;
+        close(fd);
+        return -err;
+    }
+    return fd;
+}
+
+static int write_frames(int fd, const int16_t* pcm, size_t frames, uint64_t first_frame) {
+    const size_t bytes = frames * HAL_FRAME_SIZE;
+    const off_t offset = (off_t)(WAV_HEADER_BYTES + first_frame * HAL_FRAME_SIZE);
+    for (size_t done = 0; done < bytes; ) {
+        const ssize_t n = pwrite(fd, (const uint8_t*)pcm + done, bytes - done, offset + (off_t)done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+
+// --- Renderização de um Trecho ---
+
+/**
+ * Abre um dispositivo configurado (thread de renderização parada) e a fonte.
+ */
+static int renderer_open(offline_renderer_t* r, const char* input, const offline_render_options_t* options) {
+    memset(r, 0, sizeof(*r));
+    int ret = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common, AUDIO_HARDWARE_INTERFACE,
+                                                       (hw_device_t**)&r->dev);
+    if (ret != 0) {
+        r->dev = NULL;
+        return ret;
+    }
+    r->dev->stop_render_thread(r->dev);
+    ret = r->dev->set_period_size(r->dev, options->period_frames);
+    if (ret == 0) {
+        ret = r->dev->stop_render_thread(r->dev); // set_period_size a reinicia se estiver ativa
+    }
+    if (ret == 0 && options->configure) {
+        ret = options->configure(r->dev, options->cookie);
+    }
+    if (ret == 0) {
+        ret = wav_source_open(&r->src, input);
+    }
+    if (ret != 0) {
+        r->dev->common.close(&r->dev->common);
+        r->dev = NULL;
+    }
+    return ret;
+}
+
+static void renderer_close(offline_renderer_t* r) {
+    if (r->dev) {
+        r->dev->common.close(&r->dev->common);
+        wav_source_close(&r->src);
+        r->dev = NULL;
+    }
+}
+
+/**
+ * Renderiza a entrada de 'from' a 'to', período a período, gravando a saída a
+ * partir de 'keep' (antes disso é aquecimento). Com 'checkpoints', guarda o
+ * resumo do estado em keep, keep + align, ... (antes de 'to').
+ */
+static int renderer_run(offline_renderer_t* r, size_t period_frames, uint64_t from, uint64_t to, uint64_t keep,
+                        int out_fd, uint64_t align, uint64_t* checkpoints) {
+    int16_t pcm[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+    int16_t pending[OFFLINE_FLUSH_FRAMES * HAL_CHANNELS];
+    size_t pending_frames = 0;
+    uint64_t pending_start = keep;
+
+    wav_source_seek(&r->src, from);
+    for (uint64_t pos = from; pos < to; ) {
+        if (checkpoints && pos >= keep && (pos - keep) % align == 0) {
+            const int ret = r->dev->get_render_state_digest(r->dev, &checkpoints[(pos - keep) / align]);
+            if (ret != 0) return ret;
+        }
+        size_t n = period_frames;
+        if (n > to - pos) n = (size_t)(to - pos);
+        n = wav_source_read_s16(&r->src, pcm, n);
+        if (n == 0) return -EIO; // Arquivo menor do que na abertura
+        // Um período sempre cabe na fila vazia: 'write' aceita tudo.
+        int ret = r->dev->write(r->dev, pcm, n * HAL_FRAME_SIZE);
+        if (ret >= 0) ret = r->dev->render(r->dev, pcm, n * HAL_FRAME_SIZE);
+        if (ret < 0) return ret;
+        if (pos >= keep) {
+            if (pending_frames + n > OFFLINE_FLUSH_FRAMES) {
+                ret = write_frames(out_fd, pending, pending_frames, pending_start);
+                if (ret != 0) return ret;
+                pending_start += pending_frames;
+                pending_frames = 0;
+            }
+            memcpy(pending + pending_frames * HAL_CHANNELS, pcm, n * HAL_FRAME_SIZE);
+            pending_frames += n;
+        }
+        pos += n;
+    }
+    return write_frames(out_fd, pending, pending_frames, pending_start);
+}
+
+static void* segment_task(void* arg) {
+    offline_task_t* task = (offline_task_t*)arg;
+    const offline_context_t* ctx = task->ctx;
+    offline_segment_t* seg = task->segment;
+    HAL_TRACE_SCOPE_ARG("segment", (int32_t)seg->file);
+    const uint64_t overlap = ctx->options->overlap_frames;
+    const uint64_t from = seg->start > overlap ? seg->start - overlap : 0;
+    seg->warmup_frames = seg->start - from;
+    seg->checkpoints = (uint64_t*)malloc((size_t)((seg->end - seg->start - 1) / ctx->align + 1) * sizeof(uint64_t));
+    seg->result = seg->checkpoints ? renderer_open(&seg->renderer, ctx->jobs[seg->file].input, ctx->options) : -ENOMEM;
+    if (seg->result == 0) {
+        seg->result = renderer_run(&seg->renderer, ctx->options->period_frames, from, seg->end, seg->start,
+                                   ctx->out_fds[seg->file], ctx->align, seg->checkpoints);
+    }
+    return NULL;
+}
+
+/**
+ * Corrige um segmento cujo estado inicial não bateu com o verdadeiro: o
+ * 'carrier' (estado verdadeiro em seg->start) renderiza o segmento de novo,
+ * um intervalo por vez, até que seu resumo coincida com um ponto de
+ * verificação do segmento. Daí em diante as duas renderizações são idênticas,
+ * então a saída do segmento já está certa e o dispositivo dele assume.
+ * @return 0 em caso de sucesso; 'carrier' passa a ser o dispositivo com o
+ *         estado verdadeiro em seg->end.
+ */
+static int repair_segment(const offline_context_t* ctx, offline_segment_t* seg, offline_renderer_t** carrier,
+                          uint64_t* repaired_frames) {
+    HAL_TRACE_SCOPE_ARG("repair", (int32_t)seg->file);
+    offline_renderer_t* truth = *carrier;
+    for (uint64_t pos = seg->start; pos < seg->end; pos += ctx->align) {
+        uint64_t digest = 0;
+        int ret = truth->dev->get_render_state_digest(truth->dev, &digest);
+        if (ret != 0) return ret;
+        if (digest == seg->checkpoints[(pos - seg->start) / ctx->align]) {
+            renderer_close(truth);
+            *carrier = &seg->renderer;
+            return 0;
+        }
+        const uint64_t to = seg->end - pos > ctx->align ? pos + ctx->align : seg->end;
+        ret = renderer_run(truth, ctx->options->period_frames, pos, to, pos, ctx->out_fds[seg->file], 0, NULL);
+        if (ret != 0) return ret;
+        *repaired_frames += to - pos;
+    }
+    // Não convergiu dentro do segmento: o carrier segue com o estado verdadeiro.
+    renderer_close(&seg->renderer);
+    return 0;
+}
+
+
+// --- Orquestração ---
+
+int offline_render_files(const offline_render_job_t* jobs, size_t count, const offline_render_options_t* options,
+                         offline_render_stats_t* stats) {
+    offline_render_options_t opts = {};
+    if (options) opts = *options;
+    if (opts.threads == 0) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        opts.threads = cpus < 1 ? 1 : (cpus > OFFLINE_RENDER_MAX_THREADS ? OFFLINE_RENDER_MAX_THREADS : (int)cpus);
+    }
+    if (opts.period_frames == 0) opts.period_frames = HAL_PERIOD_FRAMES;
+    if (opts.segment_frames == 0) opts.segment_frames = OFFLINE_RENDER_DEFAULT_SEGMENT_FRAMES;
+    if (opts.overlap_frames == 0) opts.overlap_frames = OFFLINE_RENDER_DEFAULT_OVERLAP_FRAMES;
+    if ((count > 0 && !jobs) || opts.threads < 1 || opts.threads > OFFLINE_RENDER_MAX_THREADS ||
+        opts.period_frames < HAL_MIN_PERIOD_FRAMES || opts.period_frames > HAL_MAX_PERIOD_FRAMES) {
+        return -EINVAL;
+    }
+    // Limites múltiplos do período e da fila do limitador: nos dois caminhos até
+    // um limite, os períodos e os blocos do limitador caem nos mesmos frames.
+    const uint64_t align = (uint64_t)opts.period_frames / gcd_u64(opts.period_frames, DYN_LIMITER_RING_FRAMES) *
+                           DYN_LIMITER_RING_FRAMES;
+    opts.segment_frames = round_up(opts.segment_frames, align);
+    opts.overlap_frames = round_up(opts.overlap_frames, align);
+
+    const uint64_t start_ns = hal_metrics_now_ns();
+    offline_render_stats_t local = {};
+    int ret = 0;
+    int* out_fds = (int*)malloc((count ? count : 1) * sizeof(int));
+    uint64_t* file_frames = (uint64_t*)malloc((count ? count : 1) * sizeof(uint64_t));
+    offline_segment_t* segments = NULL;
+    size_t segment_count = 0;
+    if (!out_fds || !file_frames) {
+        free(out_fds);
+        free(file_frames);
+        return -ENOMEM;
+    }
+    for (size_t i = 0; i < count; i++) out_fds[i] = -1;
+
+    // 1. Duração de cada entrada e saídas no tamanho final.
+    for (size_t i = 0; i < count && ret == 0; i++) {
+        wav_source_t probe;
+        ret = wav_source_open(&probe, jobs[i].input);
+        if (ret != 0) break;
+        file_frames[i] = probe.frames;
+        wav_source_close(&probe);
+        const int fd = create_output(jobs[i].output, file_frames[i]);
+        if (fd < 0) ret = fd;
+        else out_fds[i] = fd;
+        local.frames += file_frames[i];
+    }
+
+    // 2. Segmentos (com uma thread, um por arquivo).
+    if (ret == 0) {
+        const uint64_t length = opts.threads == 1 ? UINT64_MAX : opts.segment_frames;
+        for (size_t i = 0; i < count; i++) {
+            segment_count += file_frames[i] == 0 ? 0 : (size_t)((file_frames[i] - 1) / length + 1);
+        }
+        segments = (offline_segment_t*)calloc(segment_count ? segment_count : 1, sizeof(offline_segment_t));
+        if (!segments) ret = -ENOMEM;
+        size_t k = 0;
+        for (size_t i = 0; i < count && ret == 0; i++) {
+            for (uint64_t start = 0; start < file_frames[i]; start += length) {
+                segments[k].file = i;
+                segments[k].start = start;
+                segments[k].end = file_frames[i] - start > length ? start + length : file_frames[i];
+                k++;
+                if (file_frames[i] - start <= length) break;
+            }
+        }
+    }
+
+    // 3. Ondas de 'threads' segmentos em paralelo, seguidas da verificação em
+    //    ordem. 'carrier' é o dispositivo com o estado verdadeiro ao fim do
+    //    último segmento aceito do arquivo corrente.
+    const offline_context_t ctx = {jobs, &opts, out_fds, align};
+    offline_renderer_t* carrier = NULL;
+    for (size_t wave = 0; wave < segment_count && ret == 0; wave += (size_t)opts.threads) {
+        const size_t n = segment_count - wave < (size_t)opts.threads ? segment_count - wave : (size_t)opts.threads;
+        offline_task_t tasks[OFFLINE_RENDER_MAX_THREADS];
+        pthread_t threads[OFFLINE_RENDER_MAX_THREADS];
+        bool started[OFFLINE_RENDER_MAX_THREADS] = {};
+        for (size_t t = 0; t < n; t++) {
+            tasks[t].ctx = &ctx;
+            tasks[t].segment = &segments[wave + t];
+        }
+        // Threads comuns (não SCHED_FIFO): o trabalho é longo e não tem prazo.
+        for (size_t t = 1; t < n; t++) {
+            started[t] = pthread_create(&threads[t], NULL, segment_task, &tasks[t]) == 0;
+            if (!started[t]) segment_task(&tasks[t]);
+        }
+        segment_task(&tasks[0]);
+        for (size_t t = 1; t < n; t++) {
+            if (started[t]) pthread_join(threads[t], NULL);
+        }
+
+        for (size_t t = 0; t < n; t++) {
+            offline_segment_t* seg = &segments[wave + t];
+            local.segments++;
+            local.warmup_frames += seg->warmup_frames;
+            if (ret == 0 && seg->result != 0) {
+                ALOGE("OfflineRender: Falha no segmento %llu..%llu de %s: %d", (unsigned long long)seg->start,
+                      (unsigned long long)seg->end, jobs[seg->file].input, seg->result);
+                ret = seg->result;
+            }
+            if (ret != 0) {
+                renderer_close(&seg->renderer);
+                continue;
+            }
+            if (seg->start == 0) {
+                // Início do arquivo: o estado inicial é o mesmo em qualquer caminho.
+                if (carrier) renderer_close(carrier);
+                carrier = &seg->renderer;
+                continue;
+            }
+            const uint64_t before = local.repaired_frames;
+            ret = repair_segment(&ctx, seg, &carrier, &local.repaired_frames);
+            if (local.repaired_frames != before) local.resegmented++;
+        }
+    }
+    if (carrier) renderer_close(carrier);
+    for (size_t k = 0; k < segment_count; k++) {
+        renderer_close(&segments[k].renderer);
+        free(segments[k].checkpoints);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (out_fds[i] >= 0 && close(out_fds[i]) != 0 && ret == 0) ret = -errno;
+    }
+    free(segments);
+    free(file_frames);
+    free(out_fds);
+
+    local.elapsed_ns = hal_metrics_now_ns() - start_ns;
+    if (local.elapsed_ns > 0) {
+        local.realtime_factor = (double)local.frames / HAL_SAMPLE_RATE / ((double)local.elapsed_ns * 1e-9);
+    }
+    if (ret == 0) {
+        ALOGI("OfflineRender: %zu arquivo(s), %llu frames em %.3f s (%.1fx tempo real), %llu segmentos, "
+              "%llu corrigidos (%llu frames).", count, (unsigned long long)local.frames,
+              (double)local.elapsed_ns * 1e-9, local.realtime_factor, (unsigned long long)local.segments,
+              (unsigned long long)local.resegmented, (unsigned long long)local.repaired_frames);
+    }
+    if (stats) *stats = local;
+    return ret;
+}
@@ -0,0 +1,91 @@
+// --- Renderizador Offline (WAV -> WAV) ---
+// Passa arquivos WAV pela cadeia de processamento da HAL (mistura, equalizador,
+// volume, dinâmica) sem ritmo de tempo real e grava a saída da zona 0 em outro
+// WAV (PCM 16 bits estéreo a HAL_SAMPLE_RATE). Serve para gerar referências,
+// comparar configurações e medir a vazão da cadeia no host.
+//
+// Paralelismo sem mudar um bit da saída:
+// - Arquivos longos são divididos em segmentos, e os segmentos (de um ou de
+//   vários arquivos) são renderizados em ondas de até 'threads' segmentos, cada
+//   um em seu próprio dispositivo.
+// - O estado da cadeia (filtros, rampas, limitador) depende de todo o áudio
+//   anterior. Cada segmento começa 'overlap_frames' antes do seu início e
+//   descarta essa saída (aquecimento), deixando o estado convergir para o que
+//   uma renderização contínua teria ali.
+// - A convergência é verificada, não suposta: o resumo do estado
+//   (get_render_state_digest) no início do segmento é comparado com o do
+//   dispositivo que terminou o segmento anterior. Se forem iguais, a saída é
+//   idêntica à de uma única thread. Se não (filtros IIR em float só coincidem
+//   bit a bit depois de um tempo que varia com o sinal), o dispositivo com o
+//   estado verdadeiro renderiza o segmento de novo, em série, até alcançar um
+//   dos pontos de verificação que o segmento registrou com o mesmo resumo; a
+//   partir dali a saída paralela já está certa. Mais aquecimento diminui esse
+//   trabalho em série.
+// - Os limites dos segmentos e o aquecimento são múltiplos do período e dos
+//   blocos do limitador, para que as fases internas coincidam.
+//
+// Com 'threads' = 1, cada arquivo é renderizado de uma vez, em série: é a
+// referência contra a qual as execuções paralelas podem ser comparadas.
+#ifndef MYAUDIOHALPROJECT_OFFLINE_RENDER_H
+#define MYAUDIOHALPROJECT_OFFLINE_RENDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "audio_hal.h"
+
+// Segmentos renderizados ao mesmo tempo (cada um com um dispositivo, mais o
+// dispositivo que carrega o estado verdadeiro: cabe no pool da HAL).
+#define OFFLINE_RENDER_MAX_THREADS 7
+#define OFFLINE_RENDER_DEFAULT_SEGMENT_FRAMES (10 * HAL_SAMPLE_RATE)  // 10 s
+// Aquecimento padrão: com o equalizador e a dinâmica ligados, a recuperação do
+// limitador e os shelves de graves levam alguns segundos para coincidir bit a bit.
+#define OFFLINE_RENDER_DEFAULT_OVERLAP_FRAMES (4 * HAL_SAMPLE_RATE)   // 4 s
+
+/**
+ * Configura um dispositivo recém-aberto (equalizador, volumes, dinâmica,
+ * parâmetros do veículo) antes de qualquer áudio. É chamada uma vez para cada
+ * dispositivo, possivelmente em threads diferentes ao mesmo tempo, e precisa
+ * deixar todos no mesmo estado.
+ * @return 0, ou um código de erro negativo (interrompe a renderização).
+ */
+typedef int (*offline_configure_fn)(audio_hw_device_t* dev, void* cookie);
+
+typedef struct {
+    int threads;                    // 1..OFFLINE_RENDER_MAX_THREADS; 0 = núcleos disponíveis
+    size_t period_frames;           // Período da HAL; 0 = HAL_PERIOD_FRAMES
+    uint64_t segment_frames;        // 0 = OFFLINE_RENDER_DEFAULT_SEGMENT_FRAMES
+    uint64_t overlap_frames;        // Aquecimento; 0 = OFFLINE_RENDER_DEFAULT_OVERLAP_FRAMES
+    offline_configure_fn configure; // Opcional
+    void* cookie;
+} offline_render_options_t;
+
+typedef struct {
+    const char* input;              // WAV na taxa da HAL (formatos de wav_source.h)
+    const char* output;             // Criado ou sobrescrito
+} offline_render_job_t;
+
+typedef struct {
+    uint64_t frames;                // Frames de saída gravados (todos os arquivos)
+    uint64_t segments;
+    uint64_t resegmented;           // Segmentos corrigidos (estado não convergiu no aquecimento)
+    uint64_t repaired_frames;       // Frames re-renderizados em série nessas correções
+    uint64_t warmup_frames;         // Frames renderizados só para aquecimento
+    uint64_t elapsed_ns;
+    double realtime_factor;         // Segundos de áudio por segundo de relógio
+} offline_render_stats_t;
+
+/**
+ * Renderiza cada 'jobs[i].input' em 'jobs[i].output'. A saída tem a mesma
+ * duração da entrada; com a dinâmica ligada, ela inclui o atraso do limitador.
+ * Não deve ser chamada no caminho de áudio (abre dispositivos e threads).
+ * @param options Opcional (NULL = padrões).
+ * @param stats Opcional; preenchido ao fim.
+ * @return 0 em caso de sucesso; -EINVAL para opções inválidas, -EFBIG para uma
+ *         saída que não cabe em um WAV, ou o erro da HAL, de wav_source_open
+ *         ou do sistema de arquivos.
+ */
+int offline_render_files(const offline_render_job_t* jobs, size_t count, const offline_render_options_t* options,
+                         offline_render_stats_t* stats);
+
+#endif // MYAUDIOHALPROJECT_OFFLINE_RENDER_H
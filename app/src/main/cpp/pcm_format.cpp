@@ -0,0 +1,297 @@
+// --- Includes Padrão ---
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>     // Para memcpy (leituras sem alinhamento garantido)
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // Intrínsecos SSE/SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>   // Intrínsecos NEON
+#endif
+
+#include "pcm_format.h"
+#include "eq_dsp.h"     // Para eq_active_kernel (mesma escolha de SIMD do equalizador)
+
+
+// --- Formatos de Amostra ---
+// Cada formato define o tamanho da amostra e a leitura escalar para float em
+// [-1, 1). Os dados vêm das filas dos streams, sem alinhamento garantido.
+
+template <audio_format_t F> struct sample_traits;
+
+template <> struct sample_traits<AUDIO_FORMAT_PCM_16_BIT> {
+    static constexpr size_t bytes = 2;
+    static inline float load(const uint8_t* p) {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 32768.0f);
+    }
+};
+
+template <> struct sample_traits<AUDIO_FORMAT_PCM_24_BIT_PACKED> {
+    static constexpr size_t bytes = 3;
+    static inline float load(const uint8_t* p) {
+        // Monta os 24 bits no topo de um int32: o deslocamento aritmético estende o sinal.
+        const int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+        return (float)(v >> 8) * (1.0f / 8388608.0f);
+    }
+};
+
+template <> struct sample_traits<AUDIO_FORMAT_PCM_32_BIT> {
+    static constexpr size_t bytes = 4;
+    static inline float load(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 2147483648.0f);
+    }
+};
+
+template <> struct sample_traits<AUDIO_FORMAT_PCM_FLOAT> {
+    static constexpr size_t bytes = 4;
+    static inline float load(const uint8_t* p) {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+};
+
+
+// --- Conjuntos SIMD ---
+// Cada conjunto expõe um vetor de 'width' floats e a leitura de 'width' amostras
+// consecutivas de um formato já convertidas. O conjunto escalar tem largura 1 e
+// só é usado pelos laços de resto e pelas rampas de ganho.
+
+struct isa_scalar {
+    static constexpr size_t width = 1;
+};
+
+// Sem instrução de carga de 3 bytes: 4 amostras de 24 bits (12 bytes) viram 4
+// int32 com a amostra no topo, a partir de 4 leituras de 32 bits que nunca passam
+// do 12º byte (a última lê um byte antes e o descarta pela máscara). Assume
+// little-endian, como todos os alvos da HAL.
+static inline void load_s24_words(const uint8_t* p, int32_t v[4]) {
+    uint32_t w[4];
+    memcpy(&w[0], p, 4);
+    memcpy(&w[1], p + 3, 4);
+    memcpy(&w[2], p + 6, 4);
+    memcpy(&w[3], p + 8, 4);
+    v[0] = (int32_t)(w[0] << 8);
+    v[1] = (int32_t)(w[1] << 8);
+    v[2] = (int32_t)(w[2] << 8);
+    v[3] = (int32_t)(w[3] & 0xFFFFFF00u);
+}
+
+#if defined(__SSE2__)
+struct isa_sse {
+    static constexpr size_t width = 4;
+    typedef __m128 vec;
+    static inline vec set1(float x) { return _mm_set1_ps(x); }
+    static inline vec load(const float* p) { return _mm_loadu_ps(p); }
+    static inline void store(float* p, vec v) { _mm_storeu_ps(p, v); }
+    static inline vec madd(vec acc, vec x, vec g) { return _mm_add_ps(acc, _mm_mul_ps(x, g)); }
+    // (a, b, c, d) -> (a, a, b, b) e (c, c, d, d): mono para estéreo.
+    static inline vec dup_lo(vec v) { return _mm_unpacklo_ps(v, v); }
+    static inline vec dup_hi(vec v) { return _mm_unpackhi_ps(v, v); }
+
+    template <audio_format_t F> static inline vec load_samples(const uint8_t* p);
+};
+
+template <> inline __m128 isa_sse::load_samples<AUDIO_FORMAT_PCM_16_BIT>(const uint8_t* p) {
+    const __m128i v = _mm_loadl_epi64((const __m128i*)p);
+    const __m128i wide = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    return _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(1.0f / 32768.0f));
+}
+template <> inline __m128 isa_sse::load_samples<AUDIO_FORMAT_PCM_24_BIT_PACKED>(const uint8_t* p) {
+    int32_t v[4];
+    load_s24_words(p, v);
+    const __m128i wide = _mm_loadu_si128((const __m128i*)v);
+    return _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(1.0f / 2147483648.0f));
+}
+template <> inline __m128 isa_sse::load_samples<AUDIO_FORMAT_PCM_32_BIT>(const uint8_t* p) {
+    const __m128i v = _mm_loadu_si128((const __m128i*)p);
+    return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / 2147483648.0f));
+}
+template <> inline __m128 isa_sse::load_samples<AUDIO_FORMAT_PCM_FLOAT>(const uint8_t* p) {
+    return _mm_loadu_ps((const float*)p);
+}
+#endif // __SSE2__
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct isa_neon {
+    static constexpr size_t width = 4;
+    typedef float32x4_t vec;
+    static inline vec set1(float x) { return vdupq_n_f32(x); }
+    static inline vec load(const float* p) { return vld1q_f32(p); }
+    static inline void store(float* p, vec v) { vst1q_f32(p, v); }
+    static inline vec madd(vec acc, vec x, vec g) { return vmlaq_f32(acc, x, g); }
+    static inline vec dup_lo(vec v) { return vzipq_f32(v, v).val[0]; }
+    static inline vec dup_hi(vec v) { return vzipq_f32(v, v).val[1]; }
+
+    template <audio_format_t F> static inline vec load_samples(const uint8_t* p);
+};
+
+template <> inline float32x4_t isa_neon::load_samples<AUDIO_FORMAT_PCM_16_BIT>(const uint8_t* p) {
+    // Q15 -> float na própria conversão.
+    return vcvtq_n_f32_s32(vmovl_s16(vld1_s16((const int16_t*)p)), 15);
+}
+template <> inline float32x4_t isa_neon::load_samples<AUDIO_FORMAT_PCM_24_BIT_PACKED>(const uint8_t* p) {
+    int32_t v[4];
+    load_s24_words(p, v);
+    return vcvtq_n_f32_s32(vld1q_s32(v), 31);
+}
+template <> inline float32x4_t isa_neon::load_samples<AUDIO_FORMAT_PCM_32_BIT>(const uint8_t* p) {
+    return vcvtq_n_f32_s32(vld1q_s32((const int32_t*)p), 31);
+}
+template <> inline float32x4_t isa_neon::load_samples<AUDIO_FORMAT_PCM_FLOAT>(const uint8_t* p) {
+    return vld1q_f32((const float*)p);
+}
+#endif // __ARM_NEON
+
+
+// --- Kernels ---
+// Instanciados por (conjunto SIMD, formato, canais). Com 'C' constante o laço
+// por frame é desenrolado e os índices viram deslocamentos fixos.
+
+template <class Isa, audio_format_t F, int C>
+struct pcm_kernel {
+    typedef sample_traits<F> traits;
+    static constexpr size_t frame_bytes = traits::bytes * C;
+    // Deslocamento do canal direito: mono usa o mesmo canal nos dois lados.
+    static constexpr size_t right = C > 1 ? traits::bytes : 0;
+
+    static void accumulate_scalar(float* acc, const uint8_t* in, size_t frames, float gain, float gain_step) {
+        for (size_t i = 0; i < frames; i++) {
+            const float g = gain + (float)i * gain_step;
+            const uint8_t* frame = in + i * frame_bytes;
+            acc[2 * i] += traits::load(frame) * g;
+            acc[2 * i + 1] += traits::load(frame + right) * g;
+        }
+    }
+
+    static void accumulate(float* acc, const void* in_, size_t frames, float gain, float gain_step) {
+        const uint8_t* in = (const uint8_t*)in_;
+        size_t i = 0;
+        if constexpr (Isa::width > 1 && (C == 1 || C == 2)) {
+            if (gain_step == 0.0f) {
+                const typename Isa::vec g = Isa::set1(gain);
+                // Estéreo: amostras e acumulador têm o mesmo layout; 4 amostras = 2 frames.
+                // Mono: 4 amostras viram 4 frames estéreo (8 floats).
+                constexpr size_t step = C == 2 ? Isa::width / 2 : Isa::width;
+                for (; i + step <= frames; i += step) {
+                    const typename Isa::vec x = Isa::template load_samples<F>(in + i * frame_bytes);
+                    float* a = acc + 2 * i;
+                    if constexpr (C == 2) {
+                        Isa::store(a, Isa::madd(Isa::load(a), x, g));
+                    } else {
+                        Isa::store(a, Isa::madd(Isa::load(a), Isa::dup_lo(x), g));
+                        Isa::store(a + Isa::width, Isa::madd(Isa::load(a + Isa::width), Isa::dup_hi(x), g));
+                    }
+                }
+            }
+        }
+        accumulate_scalar(acc + 2 * i, in + i * frame_bytes, frames - i, gain + (float)i * gain_step, gain_step);
+    }
+
+    static void to_float(float* out, const void* in_, size_t frames) {
+        const uint8_t* in = (const uint8_t*)in_;
+        // Intercalado -> intercalado: o número de canais não importa, é um vetor contínuo.
+        const size_t samples = frames * C;
+        size_t k = 0;
+        if constexpr (Isa::width > 1) {
+            for (; k + Isa::width <= samples; k += Isa::width) {
+                Isa::store(out + k, Isa::template load_samples<F>(in + k * traits::bytes));
+            }
+        }
+        for (; k < samples; k++) {
+            out[k] = traits::load(in + k * traits::bytes);
+        }
+    }
+
+    static void deinterleave(float* const* planes, const void* in_, size_t frames) {
+        const uint8_t* in = (const uint8_t*)in_;
+        for (size_t i = 0; i < frames; i++) {
+            const uint8_t* frame = in + i * frame_bytes;
+            for (int c = 0; c < C; c++) { // Desenrolado: C é constante
+                planes[c][i] = traits::load(frame + c * traits::bytes);
+            }
+        }
+    }
+
+    static constexpr pcm_kernels_t table() {
+        return { F, C, frame_bytes, accumulate, to_float, deinterleave };
+    }
+};
+
+
+// --- Tabelas de Despacho ---
+// Uma linha por formato (na ordem de audio_format_t, a partir de PCM_16_BIT) e
+// uma coluna por número de canais (1..AUDIO_MAX_STREAM_CHANNELS).
+
+#define PCM_NUM_FORMATS 4
+
+template <class Isa, audio_format_t F, int... C>
+struct pcm_row {
+    static constexpr pcm_kernels_t kernels[sizeof...(C)] = { pcm_kernel<Isa, F, C>::table()... };
+};
+
+template <class Isa>
+struct pcm_table {
+#define PCM_ROW(F) pcm_row<Isa, F, 1, 2, 3, 4, 5, 6, 7, 8>::kernels
+    static const pcm_kernels_t* row(int f) {
+        static const pcm_kernels_t* const rows[PCM_NUM_FORMATS] = {
+            PCM_ROW(AUDIO_FORMAT_PCM_16_BIT),
+            PCM_ROW(AUDIO_FORMAT_PCM_24_BIT_PACKED),
+            PCM_ROW(AUDIO_FORMAT_PCM_32_BIT),
+            PCM_ROW(AUDIO_FORMAT_PCM_FLOAT),
+        };
+        return rows[f];
+    }
+#undef PCM_ROW
+};
+static_assert(AUDIO_MAX_STREAM_CHANNELS == 8, "atualize as colunas de pcm_table");
+
+
+// --- API Pública ---
+
+size_t audio_format_bytes(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_DEFAULT:
+        case AUDIO_FORMAT_PCM_16_BIT: return 2;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: return 3;
+        case AUDIO_FORMAT_PCM_32_BIT:
+        case AUDIO_FORMAT_PCM_FLOAT: return 4;
+    }
+    return 0;
+}
+
+const char* audio_format_name(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_DEFAULT:
+        case AUDIO_FORMAT_PCM_16_BIT: return "s16";
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: return "s24p";
+        case AUDIO_FORMAT_PCM_32_BIT: return "s32";
+        case AUDIO_FORMAT_PCM_FLOAT: return "f32";
+    }
+    return "?";
+}
+
+const pcm_kernels_t* pcm_kernels_select(audio_format_t format, int channels) {
+    if (format == AUDIO_FORMAT_DEFAULT) {
+        format = AUDIO_FORMAT_PCM_16_BIT;
+    }
+    if (format < AUDIO_FORMAT_PCM_16_BIT || format > AUDIO_FORMAT_PCM_FLOAT ||
+        channels < 1 || channels > AUDIO_MAX_STREAM_CHANNELS) {
+        return NULL;
+    }
+    const int f = format - AUDIO_FORMAT_PCM_16_BIT;
+    switch (eq_active_kernel()) {
+#if defined(__SSE2__)
+        case EQ_KERNEL_SSE: return &pcm_table<isa_sse>::row(f)[channels - 1];
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case EQ_KERNEL_NEON: return &pcm_table<isa_neon>::row(f)[channels - 1];
+#endif
+        default: return &pcm_table<isa_scalar>::row(f)[channels - 1];
+    }
+}
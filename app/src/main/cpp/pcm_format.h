@@ -0,0 +1,54 @@
+// --- Conversão de Formatos de Amostra ---
+// Kernels que convertem o PCM de um stream (16 bits, 24 bits empacotado, 32 bits
+// ou float; de 1 a AUDIO_MAX_STREAM_CHANNELS canais) para o float interno da HAL.
+// Cada combinação (formato, canais) é uma instância de template especializada em
+// tempo de compilação: o tamanho da amostra, a escala e o número de canais são
+// constantes, então os laços são desenrolados e vetorizados (SSE2/NEON) sem
+// nenhum desvio por amostra. A escolha acontece uma única vez, na abertura do
+// stream (pcm_kernels_select); o caminho de áudio só chama os ponteiros.
+#ifndef MYAUDIOHALPROJECT_PCM_FORMAT_H
+#define MYAUDIOHALPROJECT_PCM_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "audio_hal.h"  // Para audio_format_t e AUDIO_MAX_STREAM_CHANNELS
+
+typedef struct {
+    audio_format_t format;
+    int channels;
+    size_t frame_bytes;     // channels * bytes por amostra
+
+    /**
+     * Converte e soma ao acumulador estéreo float da mistura, com o ganho
+     * g = gain + i * gain_step no frame i (gain_step 0 = caminho vetorizado).
+     * Mono vai para os dois lados; com 3 ou mais canais, os dois primeiros
+     * (frente esquerda/direita na ordem WAV/Android) são usados.
+     */
+    void (*accumulate)(float* acc, const void* in, size_t frames, float gain, float gain_step);
+
+    // Converte para float intercalado em [-1, 1), com os mesmos canais.
+    void (*to_float)(float* out, const void* in, size_t frames);
+
+    // Converte e separa os canais: planes[c][i] recebe o canal c do frame i.
+    void (*deinterleave)(float* const* planes, const void* in, size_t frames);
+} pcm_kernels_t;
+
+/**
+ * Bytes por amostra de um formato (0 para um formato inválido).
+ */
+size_t audio_format_bytes(audio_format_t format);
+
+/**
+ * Nome legível do formato (para logs e para o benchmark).
+ */
+const char* audio_format_name(audio_format_t format);
+
+/**
+ * Escolhe os kernels de (formato, canais) para o conjunto SIMD ativo (o mesmo
+ * do equalizador, ver eq_active_kernel). Chamado fora do caminho de áudio.
+ * @return A tabela de kernels (estática), ou NULL para uma combinação não suportada.
+ */
+const pcm_kernels_t* pcm_kernels_select(audio_format_t format, int channels);
+
+#endif // MYAUDIOHALPROJECT_PCM_FORMAT_H
@@ -0,0 +1,226 @@
+// --- Includes Padrão ---
+#include <errno.h>       // Para códigos de erro padrão (-EINVAL, -EALREADY)
+#include <string.h>      // Para strerror
+#include <time.h>        // Para clock_nanosleep
+#include <sched.h>       // Para SCHED_FIFO
+#include <unistd.h>      // Para syscall
+#include <sys/syscall.h> // Para SYS_futex
+#include <linux/futex.h> // Para FUTEX_WAIT_PRIVATE / FUTEX_WAKE_PRIVATE
+#include <android/log.h> // Para a função __android_log_print, usada para logs no Logcat Android
+
+#include "render_thread.h"
+#include "hal_log.h"     // Nível de log em tempo de compilação
+#include "hal_trace.h"   // Nome da thread no trace
+#include "hal_metrics.h" // Para hal_metrics_now_ns (mesmo relógio das métricas)
+
+
+// --- Macros ALOG (mesma solução de contorno de audio_hal.cpp) ---
+#ifndef ANDROID_LOG_INFO
+#define ANDROID_LOG_INFO 4  // Prioridade de informação (Info)
+#endif
+#ifndef ANDROID_LOG_ERROR
+#define ANDROID_LOG_ERROR 6 // Prioridade de erro (Error)
+#endif
+#ifndef ALOGI
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "AudioHAL", __VA_ARGS__)
+#endif
+#ifndef ALOGE
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "AudioHAL", __VA_ARGS__)
+#endif
+
+
+#define NS_PER_SEC 1000000000LL
+#define RENDER_THREAD_MIN_PERIOD_US 500      // Abaixo disso o custo de despertar domina
+#define RENDER_THREAD_MAX_PERIOD_US 100000   // 100 ms
+#define RENDER_THREAD_FIFO_PRIORITY 2        // Prioridade baixa dentro de SCHED_FIFO (como no AudioFlinger)
+
+static inline struct timespec ns_to_timespec(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / NS_PER_SEC);
+    ts.tv_nsec = (long)(ns % NS_PER_SEC);
+    return ts;
+}
+
+static inline void store_max(std::atomic<uint64_t>* max, uint64_t value) {
+    if (value > max->load(std::memory_order_relaxed)) {
+        max->store(value, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Tenta elevar a thread atual para SCHED_FIFO.
+ * Em apps comuns (e em hosts sem CAP_SYS_NICE) isso falha; a thread continua
+ * funcionando com a política padrão, apenas com mais jitter.
+ */
+static void try_set_realtime_priority(void) {
+    struct sched_param param;
+    param.sched_priority = RENDER_THREAD_FIFO_PRIORITY;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) {
+        ALOGI("AudioHAL: SCHED_FIFO indisponível (%s); usando a política padrão.", strerror(ret));
+    }
+}
+
+/**
+ * Dorme em standby até render_thread_wake (ou render_thread_stop). O despertar
+ * conta só em 'resumes': não tem prazo, então fica fora de 'wakeups' e do jitter.
+ * @return O instante do despertar, que vira o novo prazo.
+ */
+static int64_t sleep_in_standby(render_thread_t* rt) {
+    const int64_t asleep_ns = (int64_t)hal_metrics_now_ns();
+    const uint64_t entered = asleep_ns - (int64_t)rt->standby_request_ns.load(std::memory_order_relaxed);
+    rt->standby_entries.fetch_add(1, std::memory_order_relaxed);
+    rt->standby_latency_last_ns.store(entered, std::memory_order_relaxed);
+    store_max(&rt->standby_latency_max_ns, entered);
+
+    uint32_t state;
+    while ((state = rt->standby.load(std::memory_order_acquire)) != RENDER_THREAD_ACTIVE &&
+           rt->running.load(std::memory_order_acquire)) {
+        // Sem prazo: só um produtor (ou o stop) acorda a thread.
+        syscall(SYS_futex, (uint32_t*)&rt->standby, FUTEX_WAIT_PRIVATE, state, NULL, NULL, 0);
+    }
+    const int64_t now_ns = (int64_t)hal_metrics_now_ns();
+    if (rt->running.load(std::memory_order_acquire)) {
+        const int64_t wake_ns = (int64_t)rt->wake_request_ns.load(std::memory_order_relaxed);
+        const uint64_t resume = now_ns > wake_ns ? (uint64_t)(now_ns - wake_ns) : 0;
+        rt->resumes.fetch_add(1, std::memory_order_relaxed);
+        rt->resume_latency_last_ns.store(resume, std::memory_order_relaxed);
+        store_max(&rt->resume_latency_max_ns, resume);
+        rt->standby_ns.fetch_add(wake_ns > asleep_ns ? (uint64_t)(wake_ns - asleep_ns) : 0, std::memory_order_relaxed);
+    }
+    return now_ns;
+}
+
+/**
+ * Laço principal: dorme até o próximo prazo absoluto, mede o atraso e executa o callback.
+ */
+static void* render_thread_loop(void* arg) {
+    render_thread_t* rt = (render_thread_t*)arg;
+    try_set_realtime_priority();
+    HAL_TRACE_THREAD_NAME("render");
+
+    const int64_t period_ns = (int64_t)rt->period_us * 1000;
+    int64_t deadline = (int64_t)hal_metrics_now_ns();
+
+    while (rt->running.load(std::memory_order_acquire)) {
+        if (rt->standby.load(std::memory_order_acquire) != RENDER_THREAD_ACTIVE) {
+            // O período de quem acordou roda já: os dados estão na fila.
+            deadline = sleep_in_standby(rt);
+            if (!rt->running.load(std::memory_order_acquire)) break;
+            rt->callback(rt->cookie);
+            continue;
+        }
+        deadline += period_ns;
+        const struct timespec ts = ns_to_timespec(deadline);
+        // clock_nanosleep retorna o erro diretamente; repete se interrompido por sinal.
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+
+        const int64_t now_ns = (int64_t)hal_metrics_now_ns();
+        const uint64_t jitter = now_ns > deadline ? (uint64_t)(now_ns - deadline) : 0;
+
+        // Somente esta thread escreve as estatísticas, então load+store basta.
+        rt->wakeups.store(rt->wakeups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        rt->jitter_last_ns.store(jitter, std::memory_order_relaxed);
+        rt->jitter_sum_ns.store(rt->jitter_sum_ns.load(std::memory_order_relaxed) + jitter, std::memory_order_relaxed);
+        if (jitter > rt->jitter_max_ns.load(std::memory_order_relaxed)) {
+            rt->jitter_max_ns.store(jitter, std::memory_order_relaxed);
+        }
+        if ((int64_t)jitter > period_ns) {
+            // Perdemos pelo menos um prazo: ressincroniza em vez de disparar
+            // vários períodos seguidos para "alcançar" o relógio.
+            rt->late_wakeups.fetch_add(1, std::memory_order_relaxed);
+            deadline = now_ns;
+        }
+
+        rt->callback(rt->cookie);
+    }
+    return NULL;
+}
+
+int render_thread_start(render_thread_t* rt, uint32_t period_us, render_period_fn callback, void* cookie) {
+    if (!callback || period_us < RENDER_THREAD_MIN_PERIOD_US || period_us > RENDER_THREAD_MAX_PERIOD_US) {
+        return -EINVAL;
+    }
+    if (rt->started) {
+        return -EALREADY;
+    }
+    rt->period_us = period_us;
+    rt->callback = callback;
+    rt->cookie = cookie;
+    rt->wakeups.store(0, std::memory_order_relaxed);
+    rt->late_wakeups.store(0, std::memory_order_relaxed);
+    rt->jitter_last_ns.store(0, std::memory_order_relaxed);
+    rt->jitter_sum_ns.store(0, std::memory_order_relaxed);
+    rt->jitter_max_ns.store(0, std::memory_order_relaxed);
+    rt->standby_entries.store(0, std::memory_order_relaxed);
+    rt->resumes.store(0, std::memory_order_relaxed);
+    rt->standby_latency_last_ns.store(0, std::memory_order_relaxed);
+    rt->standby_latency_max_ns.store(0, std::memory_order_relaxed);
+    rt->resume_latency_last_ns.store(0, std::memory_order_relaxed);
+    rt->resume_latency_max_ns.store(0, std::memory_order_relaxed);
+    rt->standby_ns.store(0, std::memory_order_relaxed);
+    rt->standby.store(RENDER_THREAD_ACTIVE, std::memory_order_relaxed);
+    rt->running.store(true, std::memory_order_release);
+
+    int ret = pthread_create(&rt->thread, NULL, render_thread_loop, rt);
+    if (ret != 0) {
+        rt->running.store(false, std::memory_order_relaxed);
+        ALOGE("AudioHAL: Falha ao criar a thread de renderização: %s", strerror(ret));
+        return -ret;
+    }
+    rt->started = true;
+    return 0;
+}
+
+void render_thread_stop(render_thread_t* rt) {
+    if (!rt->started) {
+        return;
+    }
+    rt->running.store(false, std::memory_order_release);
+    // Em standby a thread não tem prazo: precisa ser acordada para ver o pedido.
+    rt->standby.store(RENDER_THREAD_ACTIVE, std::memory_order_release);
+    syscall(SYS_futex, (uint32_t*)&rt->standby, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    pthread_join(rt->thread, NULL);
+    rt->started = false;
+}
+
+void render_thread_enter_standby(render_thread_t* rt) {
+    rt->standby_request_ns.store(hal_metrics_now_ns(), std::memory_order_relaxed);
+    rt->standby.store(RENDER_THREAD_STANDBY, std::memory_order_seq_cst);
+    // A releitura das filas que o chamador faz em seguida não pode subir antes desta escrita.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool render_thread_cancel_standby(render_thread_t* rt) {
+    uint32_t expected = RENDER_THREAD_STANDBY;
+    return rt->standby.compare_exchange_strong(expected, RENDER_THREAD_ACTIVE, std::memory_order_acq_rel);
+}
+
+void render_thread_resume(render_thread_t* rt) {
+    uint32_t expected = RENDER_THREAD_STANDBY;
+    if (!rt->standby.compare_exchange_strong(expected, RENDER_THREAD_WAKING, std::memory_order_acq_rel)) {
+        return; // Já ativa, ou outro produtor está acordando
+    }
+    rt->wake_request_ns.store(hal_metrics_now_ns(), std::memory_order_relaxed);
+    rt->standby.store(RENDER_THREAD_ACTIVE, std::memory_order_release);
+    syscall(SYS_futex, (uint32_t*)&rt->standby, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void render_thread_get_stats(const render_thread_t* rt, render_thread_stats_t* stats) {
+    const uint64_t wakeups = rt->wakeups.load(std::memory_order_relaxed);
+    stats->period_us = rt->period_us;
+    stats->wakeups = wakeups;
+    stats->late_wakeups = rt->late_wakeups.load(std::memory_order_relaxed);
+    stats->jitter_last_ns = rt->jitter_last_ns.load(std::memory_order_relaxed);
+    stats->jitter_avg_ns = wakeups ? rt->jitter_sum_ns.load(std::memory_order_relaxed) / wakeups : 0;
+    stats->jitter_max_ns = rt->jitter_max_ns.load(std::memory_order_relaxed);
+    stats->standby = rt->started && rt->standby.load(std::memory_order_relaxed) != RENDER_THREAD_ACTIVE;
+    stats->standby_entries = rt->standby_entries.load(std::memory_order_relaxed);
+    stats->resumes = rt->resumes.load(std::memory_order_relaxed);
+    stats->standby_latency_last_ns = rt->standby_latency_last_ns.load(std::memory_order_relaxed);
+    stats->standby_latency_max_ns = rt->standby_latency_max_ns.load(std::memory_order_relaxed);
+    stats->resume_latency_last_ns = rt->resume_latency_last_ns.load(std::memory_order_relaxed);
+    stats->resume_latency_max_ns = rt->resume_latency_max_ns.load(std::memory_order_relaxed);
+    stats->standby_ns = rt->standby_ns.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,139 @@
+// --- Thread de Renderização Periódica ---
+// Thread dedicada que executa um callback uma vez por período, acordada por um
+// prazo ABSOLUTO (clock_nanosleep com TIMER_ABSTIME sobre CLOCK_MONOTONIC).
+// Diferente de um polling com usleep(), o próximo prazo é sempre calculado a
+// partir do anterior, então atrasos de escalonamento não se acumulam (sem deriva)
+// e a thread só acorda uma vez por período.
+// O atraso de cada despertar em relação ao prazo (jitter) é medido e exposto,
+// para calibrar o tamanho do período contra a carga de CPU.
+//
+// Standby: quando o dono decide que não há o que tocar, o callback chama
+// render_thread_enter_standby e, ao retornar, a thread dorme em um futex sem
+// prazo (nenhum timer armado, nenhum despertar periódico) até que um produtor
+// chame render_thread_wake. Ao acordar, o primeiro período roda na hora, sem
+// esperar o próximo prazo, e a linha do tempo recomeça a partir dali.
+#ifndef MYAUDIOHALPROJECT_RENDER_THREAD_H
+#define MYAUDIOHALPROJECT_RENDER_THREAD_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+
+// Estados da palavra de standby (futex).
+#define RENDER_THREAD_ACTIVE 0u
+#define RENDER_THREAD_STANDBY 1u
+#define RENDER_THREAD_WAKING 2u    // Um produtor ganhou o direito de acordar a thread
+
+// Callback executado a cada período, na thread de renderização.
+typedef void (*render_period_fn)(void* cookie);
+
+// Estatísticas de despertar da thread (cópia consistente o suficiente para diagnóstico).
+typedef struct {
+    uint32_t period_us;       // Período configurado em microssegundos
+    uint64_t wakeups;         // Despertares por prazo desde o início (divisor do jitter médio; sem 'resumes')
+    uint64_t late_wakeups;    // Despertares com atraso maior que um período (prazos perdidos)
+    uint64_t jitter_last_ns;  // Atraso do último despertar
+    uint64_t jitter_avg_ns;   // Atraso médio
+    uint64_t jitter_max_ns;   // Maior atraso observado
+    bool standby;             // Dormindo em standby agora
+    uint64_t standby_entries;
+    uint64_t resumes;
+    uint64_t standby_latency_last_ns; // Do pedido de standby até a thread dormir
+    uint64_t standby_latency_max_ns;
+    uint64_t resume_latency_last_ns;  // Do render_thread_wake até o início do primeiro período
+    uint64_t resume_latency_max_ns;
+    uint64_t standby_ns;              // Tempo total dormindo em standby (períodos já encerrados)
+} render_thread_stats_t;
+
+typedef struct {
+    pthread_t thread;
+    std::atomic<bool> running;      // false pede para a thread sair no próximo despertar
+    bool started;                   // true entre start e stop (acessado só pelo dono)
+    uint32_t period_us;
+    render_period_fn callback;
+    void* cookie;
+
+    // Estatísticas escritas pela thread de renderização e lidas por qualquer thread.
+    std::atomic<uint64_t> wakeups;
+    std::atomic<uint64_t> late_wakeups;
+    std::atomic<uint64_t> jitter_last_ns;
+    std::atomic<uint64_t> jitter_sum_ns;
+    std::atomic<uint64_t> jitter_max_ns;
+
+    // Standby: 'standby' é a palavra de futex em que a thread dorme; os instantes
+    // são escritos por quem pede (a própria thread) e por quem acorda (o produtor
+    // que ganhou a troca STANDBY -> WAKING).
+    std::atomic<uint32_t> standby;
+    std::atomic<uint64_t> standby_request_ns;
+    std::atomic<uint64_t> wake_request_ns;
+    std::atomic<uint64_t> standby_entries;
+    std::atomic<uint64_t> resumes;
+    std::atomic<uint64_t> standby_latency_last_ns;
+    std::atomic<uint64_t> standby_latency_max_ns;
+    std::atomic<uint64_t> resume_latency_last_ns;
+    std::atomic<uint64_t> resume_latency_max_ns;
+    std::atomic<uint64_t> standby_ns;
+} render_thread_t;
+
+/**
+ * Cria a thread e começa a chamar 'callback' a cada 'period_us' microssegundos.
+ * Tenta usar SCHED_FIFO; sem permissão, continua com a política padrão.
+ * Zera todas as estatísticas (despertares, jitter e standby).
+ * @return 0 em caso de sucesso, -EINVAL para período inválido, -EALREADY se já
+ *         estiver rodando, ou o erro de pthread_create (negativo).
+ */
+int render_thread_start(render_thread_t* rt, uint32_t period_us, render_period_fn callback, void* cookie);
+
+/**
+ * Pede para a thread sair e aguarda seu término (no máximo um período).
+ * Não faz nada se a thread não estiver rodando.
+ */
+void render_thread_stop(render_thread_t* rt);
+
+/**
+ * Indica se a thread está ativa (chamado pelo dono da thread).
+ */
+static inline bool render_thread_is_running(const render_thread_t* rt) {
+    return rt->started;
+}
+
+/**
+ * Pede standby: ao fim do callback atual a thread dorme até render_thread_wake.
+ * Só pode ser chamada de dentro do callback. Depois dela, o callback precisa
+ * verificar de novo se há trabalho pendente (um produtor que publicou antes de
+ * ver o standby não acorda a thread) e, se houver, desistir com
+ * render_thread_cancel_standby.
+ */
+void render_thread_enter_standby(render_thread_t* rt);
+
+/**
+ * Desiste do standby pedido no callback atual.
+ * @return false se um produtor já estava acordando a thread (que então não dorme).
+ */
+bool render_thread_cancel_standby(render_thread_t* rt);
+
+// Caminho lento de render_thread_wake: a thread está (ou vai ficar) em standby.
+void render_thread_resume(render_thread_t* rt);
+
+/**
+ * Acorda a thread se ela estiver em standby. Chamada pelos produtores depois de
+ * publicar dados; qualquer thread, sem bloquear nem alocar. Com a thread ativa
+ * custa uma barreira e uma leitura; só a primeira chamada depois do standby
+ * faz a syscall.
+ */
+static inline void render_thread_wake(render_thread_t* rt) {
+    // Ordena a publicação dos dados antes da leitura do estado (par da barreira
+    // em render_thread_enter_standby): ou a thread vê os dados, ou quem publicou
+    // vê o standby.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (rt->standby.load(std::memory_order_relaxed) != RENDER_THREAD_ACTIVE) {
+        render_thread_resume(rt);
+    }
+}
+
+/**
+ * Copia as estatísticas de despertar. Pode ser chamada de qualquer thread.
+ */
+void render_thread_get_stats(const render_thread_t* rt, render_thread_stats_t* stats);
+
+#endif // MYAUDIOHALPROJECT_RENDER_THREAD_H
@@ -0,0 +1,325 @@
+// --- Includes Padrão ---
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>     // Para memset e memmove
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>    // Para o lock do cache de tabelas
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // Intrínsecos SSE/SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>   // Intrínsecos NEON
+#endif
+
+#include "resampler.h"
+#include "eq_dsp.h"     // Para eq_active_kernel (mesma escolha de SIMD do equalizador)
+#include "hal_pool.h"   // Arena estática das tabelas
+
+
+// --- Presets de Qualidade ---
+// Taps por fase (na taxa menor) e atenuação de projeto da janela de Kaiser.
+// A banda de transição sai da fórmula de Kaiser, df = (A - 7,95) / (14,36 * N),
+// e termina na frequência de Nyquist da taxa menor: o que passa dela (imagens
+// na subida de taxa, aliasing na descida) fica pelo menos A dB abaixo.
+
+typedef struct {
+    int taps;
+    double atten_db;
+    const char* name;
+} resampler_preset_t;
+
+static const resampler_preset_t kPresets[] = {
+    {  8,  40.0, "low-latency" },  // AUDIO_RESAMPLER_QUALITY_LOW_LATENCY
+    { 16,  60.0, "low" },          // AUDIO_RESAMPLER_QUALITY_LOW
+    { 32,  80.0, "medium" },       // AUDIO_RESAMPLER_QUALITY_MEDIUM
+    { 64, 100.0, "high" },         // AUDIO_RESAMPLER_QUALITY_HIGH
+};
+
+static const resampler_preset_t* preset_for(audio_resampler_quality_t quality) {
+    if (quality == AUDIO_RESAMPLER_QUALITY_DEFAULT) quality = AUDIO_RESAMPLER_QUALITY_MEDIUM;
+    if (quality < AUDIO_RESAMPLER_QUALITY_LOW_LATENCY || quality > AUDIO_RESAMPLER_QUALITY_HIGH) return NULL;
+    return &kPresets[quality - AUDIO_RESAMPLER_QUALITY_LOW_LATENCY];
+}
+
+
+// --- Projeto do Filtro ---
+
+// Função de Bessel modificada de ordem zero (série de potências).
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 64 && term > sum * 1e-12; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static double kaiser_beta(double atten_db) {
+    if (atten_db > 50.0) return 0.1102 * (atten_db - 8.7);
+    if (atten_db > 21.0) return 0.5842 * pow(atten_db - 21.0, 0.4) + 0.07886 * (atten_db - 21.0);
+    return 0.0;
+}
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while (b) {
+        const uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * Preenche coeffs[p][k] para a saída no instante base + (taps/2 - 1) + p/L, em
+ * frames de entrada, lendo os frames base + k. Cada fase é normalizada para
+ * ganho unitário em DC, o que evita uma ondulação que dependa da fase.
+ * @param cutoff Frequência de corte em ciclos por amostra de entrada.
+ */
+static void design_phases(float* coeffs, uint32_t phases, int taps, double cutoff, double beta) {
+    const double half = taps / 2.0;
+    const double i0_beta = bessel_i0(beta);
+    for (uint32_t p = 0; p < phases; p++) {
+        float* row = coeffs + (size_t)p * taps;
+        double sum = 0.0;
+        double h[RESAMPLER_MAX_TAPS];
+        for (int k = 0; k < taps; k++) {
+            const double t = (half - 1.0 - k) + (double)p / phases;
+            const double x = 2.0 * cutoff * t;
+            const double sinc = fabs(x) < 1e-12 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            const double r = t / half;
+            const double window = r * r < 1.0 ? bessel_i0(beta * sqrt(1.0 - r * r)) / i0_beta : 0.0;
+            h[k] = 2.0 * cutoff * sinc * window;
+            sum += h[k];
+        }
+        for (int k = 0; k < taps; k++) {
+            row[k] = (float)(h[k] / sum);
+        }
+    }
+}
+
+
+// --- Cache de Tabelas ---
+// Uma tabela por (taxas, qualidade), gerada na primeira abertura que a usa e
+// nunca liberada: o número de combinações em uso é pequeno e as tabelas são
+// imutáveis, então streams e dispositivos diferentes as compartilham.
+
+typedef struct {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    audio_resampler_quality_t quality;
+    int taps;
+    const float* coeffs;
+} resampler_table_t;
+
+HAL_ARENA_DEFINE(g_table_arena, RESAMPLER_ARENA_BYTES);
+static resampler_table_t g_tables[RESAMPLER_MAX_TABLES];
+static int g_table_count = 0;
+static pthread_mutex_t g_table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Procura a tabela em cache ou a gera na arena.
+ * @return A tabela, ou NULL se o cache ou a arena estiverem cheios.
+ */
+static const resampler_table_t* table_get(uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t quality,
+                                          uint32_t phases, int taps, double cutoff, double beta) {
+    pthread_mutex_lock(&g_table_lock);
+    const resampler_table_t* found = NULL;
+    for (int i = 0; i < g_table_count && !found; i++) {
+        const resampler_table_t* t = &g_tables[i];
+        if (t->in_rate == in_rate && t->out_rate == out_rate && t->quality == quality) found = t;
+    }
+    if (!found && g_table_count < RESAMPLER_MAX_TABLES) {
+        float* coeffs = (float*)hal_arena_alloc(&g_table_arena, (size_t)phases * taps * sizeof(float), 16);
+        if (coeffs) {
+            design_phases(coeffs, phases, taps, cutoff, beta);
+            resampler_table_t* t = &g_tables[g_table_count++];
+            t->in_rate = in_rate;
+            t->out_rate = out_rate;
+            t->quality = quality;
+            t->taps = taps;
+            t->coeffs = coeffs;
+            found = t;
+        }
+    }
+    pthread_mutex_unlock(&g_table_lock);
+    return found;
+}
+
+
+// --- Kernels de Produto Interno ---
+// A janela é estéreo intercalada (L0 R0 L1 R1 ...) e cada coeficiente vale para
+// os dois canais: duplicado no registrador, um vetor de 4 floats cobre 2 frames.
+
+static void dot_scalar(const float* coeffs, const float* frames, int taps, float* out) {
+    float left = 0.0f, right = 0.0f;
+    for (int k = 0; k < taps; k++) {
+        left += coeffs[k] * frames[2 * k];
+        right += coeffs[k] * frames[2 * k + 1];
+    }
+    out[0] = left;
+    out[1] = right;
+}
+
+#if defined(__SSE2__)
+static void dot_sse(const float* coeffs, const float* frames, int taps, float* out) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (int k = 0; k < taps; k += 4) {
+        const __m128 c = _mm_load_ps(coeffs + k);
+        // (c0 c0 c1 c1) e (c2 c2 c3 c3): o mesmo coeficiente para L e R.
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_unpacklo_ps(c, c), _mm_loadu_ps(frames + 2 * k)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_unpackhi_ps(c, c), _mm_loadu_ps(frames + 2 * k + 4)));
+    }
+    const __m128 acc = _mm_add_ps(acc0, acc1);        // (L, R, L, R)
+    _mm_storel_pi((__m64*)out, _mm_add_ps(acc, _mm_movehl_ps(acc, acc)));
+}
+#endif // __SSE2__
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+static void dot_neon(const float* coeffs, const float* frames, int taps, float* out) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (int k = 0; k < taps; k += 4) {
+        const float32x4_t c = vld1q_f32(coeffs + k);
+        const float32x4x2_t cc = vzipq_f32(c, c);
+        acc0 = vmlaq_f32(acc0, cc.val[0], vld1q_f32(frames + 2 * k));
+        acc1 = vmlaq_f32(acc1, cc.val[1], vld1q_f32(frames + 2 * k + 4));
+    }
+    const float32x4_t acc = vaddq_f32(acc0, acc1);
+    vst1_f32(out, vadd_f32(vget_low_f32(acc), vget_high_f32(acc)));
+}
+#endif // __ARM_NEON
+
+
+// --- API Pública ---
+
+int resampler_init(resampler_t* rs, uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t quality,
+                   size_t max_out_frames, float* window, size_t window_frames) {
+    const resampler_preset_t* preset = preset_for(quality);
+    if (quality == AUDIO_RESAMPLER_QUALITY_DEFAULT) quality = AUDIO_RESAMPLER_QUALITY_MEDIUM;
+    if (!rs || !preset || max_out_frames == 0 || !window ||
+        in_rate < RESAMPLER_MIN_RATE || in_rate > RESAMPLER_MAX_RATE ||
+        out_rate < RESAMPLER_MIN_RATE || out_rate > RESAMPLER_MAX_RATE) {
+        return -EINVAL;
+    }
+    const uint32_t g = gcd_u32(in_rate, out_rate);
+    const uint32_t phases = out_rate / g;
+    const uint32_t step = in_rate / g;
+    if (phases > RESAMPLER_MAX_PHASES) {
+        return -ENOTSUP;
+    }
+    // Na descida de taxa o filtro cobre o mesmo número de amostras da taxa de
+    // saída, então tem in/out vezes mais taps na entrada.
+    int taps = preset->taps;
+    if (in_rate > out_rate) {
+        taps = (int)(((uint64_t)preset->taps * in_rate + out_rate - 1) / out_rate);
+        taps = (taps + 3) & ~3;
+        if (taps > RESAMPLER_MAX_TAPS) return -ENOTSUP;
+    }
+    const size_t max_in = (size_t)(((uint64_t)max_out_frames * step + phases - 1) / phases) + 1;
+    const size_t capacity = 2 * (size_t)taps + max_in + 2;
+    if (window_frames < capacity) {
+        return -EINVAL;
+    }
+
+    const uint32_t low_rate = in_rate < out_rate ? in_rate : out_rate;
+    const double transition = (preset->atten_db - 7.95) / (14.36 * preset->taps);
+    const double cutoff = (0.5 - transition / 2.0) * low_rate / in_rate;
+    const resampler_table_t* table = table_get(in_rate, out_rate, quality, phases, taps, cutoff,
+                                               kaiser_beta(preset->atten_db));
+    if (!table) {
+        return -ENOMEM;
+    }
+
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->phases = phases;
+    rs->step = step;
+    rs->step_frames = step / phases;
+    rs->step_phases = step % phases;
+    rs->taps = taps;
+    rs->quality = quality;
+    rs->coeffs = table->coeffs;
+    rs->frames = window;
+    rs->capacity = capacity;
+    switch (eq_active_kernel()) {
+#if defined(__SSE2__)
+        case EQ_KERNEL_SSE: rs->dot = dot_sse; break;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case EQ_KERNEL_NEON: rs->dot = dot_neon; break;
+#endif
+        default: rs->dot = dot_scalar; break;
+    }
+    resampler_reset(rs);
+    return 0;
+}
+
+void resampler_reset(resampler_t* rs) {
+    // Meia janela de silêncio: a primeira saída fica centrada no primeiro frame de entrada.
+    rs->count = (size_t)rs->taps / 2 - 1;
+    rs->base = 0;
+    rs->phase = 0;
+    memset(rs->frames, 0, rs->count * RESAMPLER_CHANNELS * sizeof(float));
+}
+
+size_t resampler_input_needed(const resampler_t* rs, size_t out_frames) {
+    if (out_frames == 0) return 0;
+    const uint64_t advance = rs->phase + (uint64_t)(out_frames - 1) * rs->step;
+    const uint64_t end = rs->base + advance / rs->phases + (uint64_t)rs->taps;
+    return end > rs->count ? (size_t)(end - rs->count) : 0;
+}
+
+float* resampler_input_buffer(resampler_t* rs, size_t frames) {
+    float* in = rs->frames + rs->count * RESAMPLER_CHANNELS;
+    const size_t room = rs->capacity - rs->count;
+    memset(in, 0, (frames < room ? frames : room) * RESAMPLER_CHANNELS * sizeof(float));
+    return in;
+}
+
+void resampler_commit_input(resampler_t* rs, size_t frames) {
+    const size_t room = rs->capacity - rs->count;
+    rs->count += frames < room ? frames : room;
+}
+
+size_t resampler_process(resampler_t* rs, float* out, size_t out_frames) {
+    const int taps = rs->taps;
+    const float* coeffs = rs->coeffs;
+    size_t base = rs->base;
+    uint32_t phase = rs->phase;
+    size_t produced = 0;
+    while (produced < out_frames && base + taps <= rs->count) {
+        rs->dot(coeffs + (size_t)phase * taps, rs->frames + base * RESAMPLER_CHANNELS, taps,
+                out + produced * RESAMPLER_CHANNELS);
+        // Avanço de M/L frames sem divisão por frame.
+        base += rs->step_frames;
+        phase += rs->step_phases;
+        if (phase >= rs->phases) {
+            phase -= rs->phases;
+            base++;
+        }
+        produced++;
+    }
+    // Descarta o que nenhuma saída futura lê; sobra menos de uma janela.
+    if (base > 0) {
+        const size_t keep = rs->count > base ? rs->count - base : 0;
+        memmove(rs->frames, rs->frames + base * RESAMPLER_CHANNELS, keep * RESAMPLER_CHANNELS * sizeof(float));
+        rs->count = keep;
+        base = 0;
+    }
+    rs->base = base;
+    rs->phase = phase;
+    return produced;
+}
+
+size_t resampler_latency_frames(const resampler_t* rs) {
+    return (size_t)(((uint64_t)rs->taps / 2 * rs->out_rate + rs->in_rate / 2) / rs->in_rate);
+}
+
+const char* resampler_quality_name(audio_resampler_quality_t quality) {
+    const resampler_preset_t* preset = preset_for(quality);
+    return preset ? preset->name : "?";
+}
@@ -0,0 +1,118 @@
+// --- Conversor de Taxa de Amostragem Polifásico ---
+// Converte um stream estéreo float de 'in_rate' para 'out_rate' (ex: mídia a
+// 44,1 kHz para os 48 kHz do amplificador) com um FIR polifásico. A razão é
+// reduzida para L/M (44100 -> 48000 = 160/147): o filtro protótipo, um sinc
+// com janela de Kaiser, é dividido em L fases de 'taps' coeficientes, e cada
+// frame de saída é um único produto interno da fase corrente pela janela de
+// entrada, sem calcular as amostras intermediárias descartadas.
+//
+// - As tabelas são geradas uma única vez por (taxas, qualidade), na primeira
+//   abertura de stream que as usa, em uma arena estática do módulo (hal_pool.h),
+//   e compartilhadas por todos os streams; o caminho de áudio só as lê.
+// - O produto interno é vetorizado (SSE2/NEON, segundo eq_active_kernel) ao
+//   longo dos taps, com os dois canais na mesma passada; o kernel é escolhido
+//   na inicialização.
+// - Nada é alocado do sistema: a janela de entrada é fornecida pelo chamador.
+//
+// Uso por período: resampler_input_needed diz quantos frames de entrada faltam
+// para N frames de saída; o chamador escreve esses frames em
+// resampler_input_buffer, publica com resampler_commit_input e obtém a saída
+// com resampler_process. Com menos entrada que o pedido, sai menos.
+#ifndef MYAUDIOHALPROJECT_RESAMPLER_H
+#define MYAUDIOHALPROJECT_RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "audio_hal.h"  // Para audio_resampler_quality_t
+
+#define RESAMPLER_MIN_RATE 8000
+#define RESAMPLER_MAX_RATE 192000
+#define RESAMPLER_MAX_PHASES 1024  // L máximo (11025 -> 48000 usa 640)
+#define RESAMPLER_MAX_TAPS 256     // Depois do alongamento para redução de taxa
+#define RESAMPLER_CHANNELS 2       // Entrada e saída estéreo intercaladas
+#define RESAMPLER_MAX_TABLES 16    // Combinações (taxas, qualidade) distintas em cache
+#define RESAMPLER_ARENA_BYTES (2u << 20) // Espaço total das tabelas em cache
+
+// Frames de janela suficientes para qualquer taxa de entrada até
+// 'max_step_frames' vezes a de saída, com até 'max_out' frames por chamada.
+#define RESAMPLER_WINDOW_FRAMES(max_out, max_step_frames) \
+    (2 * RESAMPLER_MAX_TAPS + (max_out) * (max_step_frames) + 3)
+
+typedef struct resampler {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t phases;        // L: fases do filtro (sobreamostragem)
+    uint32_t step;          // M: avanço por frame de saída, em fases
+    uint32_t step_frames;   // M / L
+    uint32_t step_phases;   // M % L
+    int taps;               // Coeficientes por fase (múltiplo de 4)
+    audio_resampler_quality_t quality;
+    const float* coeffs;    // [phases][taps], alinhado a 16 bytes (tabela compartilhada)
+
+    // Janela de entrada (estéreo intercalado, do chamador): histórico + frames novos.
+    float* frames;
+    size_t capacity;        // Em frames
+    size_t count;           // Frames válidos
+    size_t base;            // Primeiro frame da janela da próxima saída
+    uint32_t phase;         // Fase da próxima saída (0..phases-1)
+
+    // Produto interno de uma fase com 'taps' frames estéreo: out[0..1] = L, R.
+    void (*dot)(const float* coeffs, const float* frames, int taps, float* out);
+} resampler_t;
+
+/**
+ * Prepara o conversor: obtém (ou gera, na primeira vez) a tabela de
+ * (in_rate, out_rate, quality) e adota 'window' como janela de entrada.
+ * Não deve ser chamada no caminho de áudio (pode gerar a tabela).
+ * @param max_out_frames Maior número de frames de saída pedido por chamada.
+ * @param window Armazenamento da janela, alinhado a 16 bytes, válido enquanto o
+ *        conversor for usado; RESAMPLER_WINDOW_FRAMES dá um tamanho suficiente.
+ * @param window_frames Tamanho de 'window' em frames estéreo.
+ * @return 0 em caso de sucesso, -EINVAL para taxas fora de
+ *         RESAMPLER_MIN_RATE..RESAMPLER_MAX_RATE, qualidade inválida ou janela
+ *         pequena demais, -ENOTSUP se a razão exigir mais de RESAMPLER_MAX_PHASES
+ *         fases, ou -ENOMEM se o cache de tabelas estiver cheio.
+ */
+int resampler_init(resampler_t* rs, uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t quality,
+                   size_t max_out_frames, float* window, size_t window_frames);
+
+/**
+ * Descarta o histórico: a próxima entrada começa do silêncio.
+ */
+void resampler_reset(resampler_t* rs);
+
+/**
+ * Frames de entrada que ainda faltam para produzir 'out_frames' frames de saída.
+ */
+size_t resampler_input_needed(const resampler_t* rs, size_t out_frames);
+
+/**
+ * Espaço para 'frames' frames novos, já zerado (o chamador pode acumular nele).
+ * 'frames' não pode passar de resampler_input_needed(rs, max_out_frames).
+ */
+float* resampler_input_buffer(resampler_t* rs, size_t frames);
+
+/**
+ * Publica os frames escritos em resampler_input_buffer.
+ */
+void resampler_commit_input(resampler_t* rs, size_t frames);
+
+/**
+ * Produz até 'out_frames' frames estéreo em 'out' com a entrada disponível.
+ * @return Frames produzidos.
+ */
+size_t resampler_process(resampler_t* rs, float* out, size_t out_frames);
+
+/**
+ * Atraso do filtro em frames de saída (metade dos taps, convertida para a
+ * taxa de saída): quanto a entrada precisa estar adiantada.
+ */
+size_t resampler_latency_frames(const resampler_t* rs);
+
+/**
+ * Nome legível da qualidade (para logs e para o benchmark).
+ */
+const char* resampler_quality_name(audio_resampler_quality_t quality);
+
+#endif // MYAUDIOHALPROJECT_RESAMPLER_H
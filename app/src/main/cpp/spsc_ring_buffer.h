@@ -0,0 +1,193 @@
+// --- Ring Buffer SPSC Lock-Free ---
+// Fila circular de bytes para exatamente UM produtor (ex: thread JNI/Binder que
+// chama 'write') e UM consumidor (o lado da HAL que drena períodos).
+// - push/pop são wait-free: nunca bloqueiam, nunca fazem syscalls, e terminam
+//   em um número limitado de passos; se não houver espaço/dados, retornam menos bytes.
+// - A capacidade é potência de dois, então o índice físico é 'pos & mask'.
+// - Os índices são contadores livres de 32 bits (a diferença write - read é
+//   sempre a ocupação, mesmo após o wrap-around do contador).
+// - Cada índice fica em sua própria linha de cache, e a cópia local que cada
+//   lado mantém do índice do outro fica em uma linha só dele, evitando false
+//   sharing e idas desnecessárias à linha do outro núcleo.
+#ifndef MYAUDIOHALPROJECT_SPSC_RING_BUFFER_H
+#define MYAUDIOHALPROJECT_SPSC_RING_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>     // Para memcpy
+#include <errno.h>      // Para -EINVAL
+#include <atomic>
+
+#define HAL_CACHE_LINE_SIZE 64 // Tamanho de linha de cache assumido (ARM Cortex-A e x86)
+
+// Posições da fila. Ficam à parte do restante do estado para poderem morar em
+// memória fornecida pelo cliente (ver AUDIO_SHARED_PCM_* em audio_hal.h): nada
+// aqui é ponteiro ou tamanho, e valores corrompidos só limitam quantos bytes as
+// operações abaixo movem, nunca onde elas leem ou escrevem.
+typedef struct {
+    alignas(HAL_CACHE_LINE_SIZE) std::atomic<uint32_t> write_pos;
+    alignas(HAL_CACHE_LINE_SIZE) std::atomic<uint32_t> read_pos;
+} spsc_ring_positions_t;
+
+typedef struct {
+    // Linha do produtor: última posição de leitura observada.
+    alignas(HAL_CACHE_LINE_SIZE) uint32_t cached_read_pos;
+
+    // Linha do consumidor: última posição de escrita observada.
+    alignas(HAL_CACHE_LINE_SIZE) uint32_t cached_write_pos;
+
+    // Somente leitura após spsc_ring_init; sempre em memória nativa.
+    alignas(HAL_CACHE_LINE_SIZE) spsc_ring_positions_t* pos; // 'own_pos' ou um cabeçalho externo
+    uint8_t* data;
+    uint32_t capacity;  // Em bytes, potência de dois
+    uint32_t mask;      // capacity - 1
+
+    spsc_ring_positions_t own_pos;
+} spsc_ring_t;
+
+/**
+ * Inicializa o ring sobre um armazenamento fornecido pelo chamador (sem alocar).
+ * @param ring O ring a ser inicializado.
+ * @param positions Onde guardar as posições (ex: um cabeçalho compartilhado), ou
+ *        NULL para usar as do próprio ring. As posições são zeradas.
+ * @param storage Memória com pelo menos 'capacity' bytes, válida enquanto o ring existir.
+ * @param capacity Capacidade em bytes; deve ser potência de dois e no máximo 2^31.
+ * @return 0 em caso de sucesso, ou -EINVAL se a capacidade for inválida.
+ */
+static inline int spsc_ring_init(spsc_ring_t* ring, spsc_ring_positions_t* positions, void* storage,
+                                 uint32_t capacity) {
+    if (!storage || capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > (1u << 31)) {
+        return -EINVAL;
+    }
+    ring->pos = positions ? positions : &ring->own_pos;
+    ring->pos->write_pos.store(0, std::memory_order_relaxed);
+    ring->pos->read_pos.store(0, std::memory_order_relaxed);
+    ring->cached_read_pos = 0;
+    ring->cached_write_pos = 0;
+    ring->data = (uint8_t*)storage;
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    return 0;
+}
+
+/**
+ * Limita uma ocupação ou espaço livre à capacidade. Só faz diferença com
+ * posições corrompidas em memória externa; mantém as cópias dentro de 'data'.
+ */
+static inline uint32_t spsc_ring_clamp(const spsc_ring_t* ring, uint32_t bytes) {
+    return bytes < ring->capacity ? bytes : ring->capacity;
+}
+
+/**
+ * Lado do produtor: copia até 'bytes' bytes para o ring.
+ * @return Quantidade de bytes efetivamente enfileirados (menor que 'bytes' se o ring encher).
+ */
+static inline size_t spsc_ring_push(spsc_ring_t* ring, const void* src, size_t bytes) {
+    const uint32_t w = ring->pos->write_pos.load(std::memory_order_relaxed);
+    uint32_t free_bytes = spsc_ring_clamp(ring, ring->capacity - (w - ring->cached_read_pos));
+    if (free_bytes < bytes) {
+        // Só toca a linha do consumidor quando a cópia local indica falta de espaço.
+        ring->cached_read_pos = ring->pos->read_pos.load(std::memory_order_acquire);
+        free_bytes = spsc_ring_clamp(ring, ring->capacity - (w - ring->cached_read_pos));
+    }
+    const uint32_t n = bytes < free_bytes ? (uint32_t)bytes : free_bytes;
+    const uint32_t offset = w & ring->mask;
+    const uint32_t first = n < ring->capacity - offset ? n : ring->capacity - offset;
+    memcpy(ring->data + offset, src, first);
+    memcpy(ring->data, (const uint8_t*)src + first, n - first);
+    ring->pos->write_pos.store(w + n, std::memory_order_release); // Publica os dados copiados
+    return n;
+}
+
+/**
+ * Lado do consumidor: copia até 'bytes' bytes do ring para 'dst'.
+ * @return Quantidade de bytes efetivamente lidos (menor que 'bytes' se o ring esvaziar).
+ */
+static inline size_t spsc_ring_pop(spsc_ring_t* ring, void* dst, size_t bytes) {
+    const uint32_t r = ring->pos->read_pos.load(std::memory_order_relaxed);
+    uint32_t used = spsc_ring_clamp(ring, ring->cached_write_pos - r);
+    if (used < bytes) {
+        ring->cached_write_pos = ring->pos->write_pos.load(std::memory_order_acquire);
+        used = spsc_ring_clamp(ring, ring->cached_write_pos - r);
+    }
+    const uint32_t n = bytes < used ? (uint32_t)bytes : used;
+    const uint32_t offset = r & ring->mask;
+    const uint32_t first = n < ring->capacity - offset ? n : ring->capacity - offset;
+    memcpy(dst, ring->data + offset, first);
+    memcpy((uint8_t*)dst + first, ring->data, n - first);
+    ring->pos->read_pos.store(r + n, std::memory_order_release); // Libera o espaço para o produtor
+    return n;
+}
+
+/**
+ * Lado do produtor, sem cópia: publica 'bytes' bytes que o produtor já escreveu
+ * diretamente em 'data' a partir da posição de escrita (ex: memória compartilhada
+ * preenchida pelo Kotlin). Nunca publica mais do que o espaço livre.
+ * @return Espaço livre restante, em bytes, depois da publicação.
+ */
+static inline size_t spsc_ring_commit(spsc_ring_t* ring, size_t bytes) {
+    const uint32_t w = ring->pos->write_pos.load(std::memory_order_relaxed);
+    ring->cached_read_pos = ring->pos->read_pos.load(std::memory_order_acquire);
+    const uint32_t free_bytes = spsc_ring_clamp(ring, ring->capacity - (w - ring->cached_read_pos));
+    const uint32_t n = bytes < free_bytes ? (uint32_t)bytes : free_bytes;
+    ring->pos->write_pos.store(w + n, std::memory_order_release);
+    return free_bytes - n;
+}
+
+/**
+ * Lado do consumidor, sem cópia: aponta '*ptr' para os próximos bytes legíveis
+ * dentro do próprio ring. Retorna no máximo 'bytes' e no máximo até o fim físico
+ * do armazenamento (o restante, após o wrap-around, vem na próxima chamada).
+ * Os bytes só são liberados para o produtor por spsc_ring_consume.
+ * @return Quantidade de bytes contíguos disponíveis em '*ptr'.
+ */
+static inline size_t spsc_ring_peek(spsc_ring_t* ring, const void** ptr, size_t bytes) {
+    const uint32_t r = ring->pos->read_pos.load(std::memory_order_relaxed);
+    uint32_t used = spsc_ring_clamp(ring, ring->cached_write_pos - r);
+    if (used < bytes) {
+        ring->cached_write_pos = ring->pos->write_pos.load(std::memory_order_acquire);
+        used = spsc_ring_clamp(ring, ring->cached_write_pos - r);
+    }
+    const uint32_t offset = r & ring->mask;
+    uint32_t n = bytes < used ? (uint32_t)bytes : used;
+    if (n > ring->capacity - offset) n = ring->capacity - offset;
+    *ptr = ring->data + offset;
+    return n;
+}
+
+/**
+ * Lado do consumidor: libera 'bytes' bytes já lidos via spsc_ring_peek.
+ */
+static inline void spsc_ring_consume(spsc_ring_t* ring, size_t bytes) {
+    const uint32_t r = ring->pos->read_pos.load(std::memory_order_relaxed);
+    ring->pos->read_pos.store(r + (uint32_t)bytes, std::memory_order_release);
+}
+
+/**
+ * Lado do produtor: espaço livre em bytes (atualiza a cópia local da posição de
+ * leitura). Usado para limitar uma escrita a frames completos antes do push.
+ */
+static inline size_t spsc_ring_writable(spsc_ring_t* ring) {
+    ring->cached_read_pos = ring->pos->read_pos.load(std::memory_order_acquire);
+    const uint32_t w = ring->pos->write_pos.load(std::memory_order_relaxed);
+    return spsc_ring_clamp(ring, ring->capacity - (w - ring->cached_read_pos));
+}
+
+/**
+ * Bytes disponíveis para leitura (visão aproximada, útil para diagnóstico).
+ */
+static inline size_t spsc_ring_readable(const spsc_ring_t* ring) {
+    const uint32_t w = ring->pos->write_pos.load(std::memory_order_acquire);
+    return spsc_ring_clamp(ring, w - ring->pos->read_pos.load(std::memory_order_acquire));
+}
+
+/**
+ * Descarta todo o conteúdo. Só pode ser chamada pelo consumidor.
+ */
+static inline void spsc_ring_flush(spsc_ring_t* ring) {
+    const uint32_t w = ring->pos->write_pos.load(std::memory_order_acquire);
+    ring->cached_write_pos = w;
+    ring->pos->read_pos.store(w, std::memory_order_release);
+}
+
+#endif // MYAUDIOHALPROJECT_SPSC_RING_BUFFER_H
@@ -0,0 +1,315 @@
+// --- Includes Padrão ---
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hal_log.h"
+#include "hal_metrics.h" // Para hal_metrics_now_ns
+#include "wav_source.h"
+#include "hal_trace.h"
+
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "WavSource", __VA_ARGS__)
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "WavSource", __VA_ARGS__)
+
+// Códigos de formato do chunk 'fmt '.
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_IEEE_FLOAT 0x0003
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// As páginas já lidas são devolvidas ao kernel em blocos deste tamanho.
+#define WAV_RELEASE_BYTES (1u << 20)
+// Períodos entregues de uma vez no início do modo em tempo real, para que a
+// fase entre este relógio e o da thread de renderização não cause underruns.
+#define WAV_PREFILL_PERIODS 2
+
+
+// --- Leitura de Campos Little-Endian ---
+// Os campos do RIFF não têm alinhamento garantido; lidos byte a byte.
+
+static inline uint16_t read_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t read_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+// --- Interpretação do RIFF ---
+
+/**
+ * Percorre os chunks do RIFF no mapeamento e preenche o formato e o chunk 'data'.
+ * Chunks desconhecidos (LIST, fact, ...) são pulados.
+ */
+static int parse_riff(wav_source_t* src, const uint8_t* riff, size_t bytes) {
+    if (bytes < 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        return -EINVAL;
+    }
+    bool have_fmt = false;
+    uint16_t tag = 0, bits = 0, block_align = 0;
+    size_t pos = 12;
+    while (pos + 8 <= bytes) {
+        const uint8_t* chunk = riff + pos;
+        const size_t size = read_le32(chunk + 4);
+        const size_t available = bytes - pos - 8;
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (size < 16 || size > available) return -EINVAL;
+            tag = read_le16(chunk + 8);
+            src->channels = read_le16(chunk + 10);
+            src->sample_rate = read_le32(chunk + 12);
+            block_align = read_le16(chunk + 20);
+            bits = read_le16(chunk + 22);
+            if (tag == WAV_FORMAT_EXTENSIBLE) {
+                // O subformato é um GUID cujos dois primeiros bytes são o código real.
+                if (size < 40) return -EINVAL;
+                tag = read_le16(chunk + 8 + 24);
+            }
+            have_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) return -EINVAL;
+            // Gravadores interrompidos deixam o tamanho zerado ou 0xFFFFFFFF: usa o que existe.
+            src->data = chunk + 8;
+            src->data_bytes = size <= available ? size : available;
+            break;
+        }
+        // Um chunk maior que o resto do arquivo não deixa nada depois dele; parar
+        // aqui também impede que 'pos' dê a volta com um 'size' malformado.
+        if (size > available) break;
+        pos += 8 + size + (size & 1); // Chunks são alinhados a 2 bytes
+    }
+    if (!have_fmt || !src->data) {
+        return -EINVAL;
+    }
+
+    if (tag == WAV_FORMAT_PCM && bits == 16) {
+        src->format = WAV_SAMPLE_S16;
+    } else if (tag == WAV_FORMAT_PCM && bits == 24) {
+        src->format = WAV_SAMPLE_S24;
+    } else if (tag == WAV_FORMAT_IEEE_FLOAT && bits == 32) {
+        src->format = WAV_SAMPLE_F32;
+    } else {
+        ALOGE("WavSource: Formato não suportado (código 0x%04x, %u bits).", tag, bits);
+        return -ENOTSUP;
+    }
+    if (src->channels < 1 || block_align != (size_t)src->channels * (bits / 8)) {
+        return -EINVAL;
+    }
+    if (src->sample_rate != HAL_SAMPLE_RATE) {
+        ALOGE("WavSource: Taxa de %u Hz não suportada (a HAL opera a %d Hz).", src->sample_rate, HAL_SAMPLE_RATE);
+        return -ENOTSUP;
+    }
+    src->frame_bytes = block_align;
+    src->frames = src->data_bytes / block_align;
+    return 0;
+}
+
+int wav_source_open_fd(wav_source_t* src, int fd, off_t offset, size_t length) {
+    memset(src, 0, sizeof(*src));
+    if (fd < 0 || offset < 0 || length == 0) {
+        return -EINVAL;
+    }
+    // mmap exige um offset alinhado à página: mapeia a partir da página que contém o início.
+    const off_t page = (off_t)sysconf(_SC_PAGESIZE);
+    const off_t map_offset = offset - offset % page;
+    const size_t lead = (size_t)(offset - map_offset);
+    void* map = mmap(NULL, lead + length, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (map == MAP_FAILED) {
+        const int err = errno;
+        ALOGE("WavSource: Falha no mmap: %s", strerror(err));
+        return -err;
+    }
+    // Leitura sequencial: o kernel lê à frente e pode descartar o que ficou para trás.
+    madvise(map, lead + length, MADV_SEQUENTIAL);
+    src->map = (uint8_t*)map;
+    src->map_bytes = lead + length;
+
+    int ret = parse_riff(src, src->map + lead, length);
+    if (ret != 0) {
+        munmap(map, src->map_bytes);
+        memset(src, 0, sizeof(*src));
+        return ret;
+    }
+    ALOGI("WavSource: %s, %d canais, %u Hz, %llu frames.", wav_sample_format_name(src->format),
+          src->channels, src->sample_rate, (unsigned long long)src->frames);
+    return 0;
+}
+
+int wav_source_open(wav_source_t* src, const char* path) {
+    memset(src, 0, sizeof(*src));
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        const int err = errno;
+        ALOGE("WavSource: Falha ao abrir %s: %s", path, strerror(err));
+        return -err;
+    }
+    struct stat st;
+    int ret = fstat(fd, &st) == 0 ? wav_source_open_fd(src, fd, 0, (size_t)st.st_size) : -errno;
+    close(fd); // O mapeamento continua válido sem o descritor
+    return ret;
+}
+
+void wav_source_close(wav_source_t* src) {
+    if (src->map) {
+        munmap(src->map, src->map_bytes);
+    }
+    memset(src, 0, sizeof(*src));
+}
+
+void wav_source_rewind(wav_source_t* src) {
+    src->position = 0;
+    src->released_bytes = 0;
+}
+
+void wav_source_seek(wav_source_t* src, uint64_t frame) {
+    src->position = frame < src->frames ? frame : src->frames;
+    // O trecho anterior nunca foi lido: a devolução de páginas recomeça daqui.
+    src->released_bytes = (size_t)(src->position * src->frame_bytes);
+}
+
+const char* wav_sample_format_name(wav_sample_format_t format) {
+    switch (format) {
+        case WAV_SAMPLE_S16: return "PCM 16 bits";
+        case WAV_SAMPLE_S24: return "PCM 24 bits";
+        case WAV_SAMPLE_F32: return "float 32 bits";
+    }
+    return "?";
+}
+
+
+// --- Conversão para o Formato da HAL ---
+
+static inline int16_t sample_to_s16(const uint8_t* p, wav_sample_format_t format) {
+    switch (format) {
+        case WAV_SAMPLE_S16:
+            return (int16_t)read_le16(p);
+        case WAV_SAMPLE_S24: {
+            // Arredonda para o mais próximo (em vez de truncar o byte baixo),
+            // saturando o único caso que estoura: os 128 valores do topo.
+            const int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+            const int32_t s = (v + 128) >> 8;
+            return (int16_t)(s > 32767 ? 32767 : s);
+        }
+        case WAV_SAMPLE_F32: {
+            const uint32_t bits = read_le32(p);
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            v *= 32768.0f;
+            if (!(v > -32768.0f)) return -32768; // Inclui NaN
+            if (v > 32767.0f) return 32767;
+            return (int16_t)(v >= 0.0f ? v + 0.5f : v - 0.5f);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Devolve ao kernel as páginas inteiras do mapeamento que já ficaram para trás.
+ * São páginas de arquivo limpas: se a fonte voltar ao início, o kernel as relê.
+ */
+static void release_consumed_pages(wav_source_t* src) {
+    const size_t consumed = (size_t)(src->position * src->frame_bytes);
+    if (consumed - src->released_bytes < WAV_RELEASE_BYTES) {
+        return;
+    }
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t start = ((uintptr_t)(src->data + src->released_bytes) + page - 1) & ~(page - 1);
+    const uintptr_t end = (uintptr_t)(src->data + consumed) & ~(page - 1);
+    if (end > start) {
+        madvise((void*)start, end - start, MADV_DONTNEED);
+    }
+    src->released_bytes = consumed;
+}
+
+size_t wav_source_read_s16(wav_source_t* src, int16_t* out, size_t frames) {
+    const uint64_t remaining = src->frames - src->position;
+    const size_t n = frames < remaining ? frames : (size_t)remaining;
+    const uint8_t* in = src->data + src->position * src->frame_bytes;
+    const size_t sample_bytes = src->frame_bytes / src->channels;
+    // Mono vai para os dois canais; do terceiro canal em diante, é ignorado.
+    const size_t right_offset = src->channels > 1 ? sample_bytes : 0;
+
+    if (src->format == WAV_SAMPLE_S16 && src->channels == HAL_CHANNELS) {
+        memcpy(out, in, n * HAL_FRAME_SIZE); // Já é o formato da HAL (host little-endian)
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            const uint8_t* frame = in + i * src->frame_bytes;
+            out[i * HAL_CHANNELS] = sample_to_s16(frame, src->format);
+            out[i * HAL_CHANNELS + 1] = sample_to_s16(frame + right_offset, src->format);
+        }
+    }
+    src->position += n;
+    release_consumed_pages(src);
+    return n;
+}
+
+
+// --- Streaming para a HAL ---
+
+int wav_stream_to_hal(audio_hw_device_t* dev, wav_source_t* src, const wav_stream_options_t* options,
+                      wav_stream_stats_t* stats) {
+    if (!dev || !src || !src->map || !options ||
+        options->period_frames < HAL_MIN_PERIOD_FRAMES || options->period_frames > HAL_MAX_PERIOD_FRAMES) {
+        return -EINVAL;
+    }
+    const size_t period_frames = options->period_frames;
+    const uint64_t period_ns = (uint64_t)period_frames * 1000000000ull / HAL_SAMPLE_RATE;
+    wav_stream_stats_t local = {};
+    int16_t pcm[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+    int16_t rendered[HAL_MAX_PERIOD_FRAMES * HAL_CHANNELS];
+    size_t pending = 0;     // Bytes de 'pcm' ainda não aceitos pela HAL
+    size_t offset = 0;
+    int ret = 0;
+
+    const uint64_t start_ns = hal_metrics_now_ns();
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    for (uint64_t tick = 0; ; tick++) {
+        if (options->stop && options->stop->load(std::memory_order_relaxed)) break;
+
+        if (pending == 0) {
+            HAL_TRACE_SCOPE("wav_read");
+            size_t n = wav_source_read_s16(src, pcm, period_frames);
+            // Em loop, o período que cruza o fim do arquivo é completado com o
+            // início, para que a emenda não vire um período curto (underrun).
+            while (n < period_frames && options->loop && src->frames > 0) {
+                wav_source_rewind(src);
+                local.loops++;
+                n += wav_source_read_s16(src, pcm + n * HAL_CHANNELS, period_frames - n);
+            }
+            if (n == 0) break; // Fim do arquivo
+            local.periods++;
+            pending = n * HAL_FRAME_SIZE;
+            offset = 0;
+        }
+        // Uma fila cheia não é erro: o resto vai no próximo período, antes de dados novos.
+        ret = dev->write(dev, (const uint8_t*)pcm + offset, pending);
+        if (ret < 0) break;
+        if ((size_t)ret < pending) local.short_writes++;
+        local.frames += (size_t)ret / HAL_FRAME_SIZE;
+        offset += (size_t)ret;
+        pending -= (size_t)ret;
+        ret = 0;
+
+        if (options->pace == WAV_PACE_ASAP) {
+            ret = dev->render(dev, rendered, period_frames * HAL_FRAME_SIZE);
+            if (ret < 0) break;
+            ret = 0;
+        } else if (tick >= WAV_PREFILL_PERIODS) {
+            // Prazo absoluto: atrasos de escalonamento não se acumulam.
+            deadline.tv_nsec += (long)period_ns;
+            while (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_nsec -= 1000000000L;
+                deadline.tv_sec++;
+            }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+            }
+        }
+    }
+    local.elapsed_ns = hal_metrics_now_ns() - start_ns;
+    if (stats) *stats = local;
+    return ret;
+}
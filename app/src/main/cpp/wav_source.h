@@ -0,0 +1,119 @@
+// --- Fonte WAV Mapeada em Memória ---
+// Lê um arquivo WAV (RIFF) mapeado com mmap e o entrega à HAL em períodos.
+// - Os chunks RIFF são interpretados no próprio mapeamento, sem copiar o arquivo:
+//   'fmt ' define o formato e 'data' é lido no lugar, período a período.
+// - Formatos aceitos: PCM 16 bits, PCM 24 bits empacotado e float 32 bits
+//   (incluindo WAVE_FORMAT_EXTENSIBLE), mono ou multicanal, na taxa da HAL.
+//   A saída é sempre o formato da HAL (PCM 16 bits, HAL_CHANNELS canais):
+//   mono é duplicado e canais além dos dois primeiros são ignorados.
+// - Memória constante, qualquer que seja a duração: além do buffer de um período,
+//   as páginas já lidas são devolvidas ao kernel (madvise), então o RSS não cresce
+//   ao tocar gravações longas (soak test no host).
+#ifndef MYAUDIOHALPROJECT_WAV_SOURCE_H
+#define MYAUDIOHALPROJECT_WAV_SOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>  // Para off_t
+#include <atomic>
+
+#include "audio_hal.h"
+
+// Formato das amostras no chunk 'data'.
+typedef enum {
+    WAV_SAMPLE_S16 = 0,   // PCM 16 bits
+    WAV_SAMPLE_S24,       // PCM 24 bits empacotado (3 bytes por amostra)
+    WAV_SAMPLE_F32,       // IEEE float 32 bits
+} wav_sample_format_t;
+
+typedef struct {
+    // Mapeamento do arquivo (alinhado à página) e o chunk 'data' dentro dele.
+    uint8_t* map;
+    size_t map_bytes;
+    const uint8_t* data;
+    size_t data_bytes;
+    // Formato lido do chunk 'fmt '.
+    wav_sample_format_t format;
+    int channels;
+    uint32_t sample_rate;
+    size_t frame_bytes;     // 'block align': bytes por frame no arquivo
+    uint64_t frames;        // Frames completos no chunk 'data'
+    // Posição de leitura e quanto do início de 'data' já foi devolvido ao kernel.
+    uint64_t position;
+    size_t released_bytes;
+} wav_source_t;
+
+/**
+ * Mapeia e interpreta um arquivo WAV.
+ * @return 0 em caso de sucesso; -errno se o arquivo não puder ser aberto/mapeado,
+ *         -EINVAL para um RIFF malformado ou -ENOTSUP para um formato não aceito.
+ */
+int wav_source_open(wav_source_t* src, const char* path);
+
+/**
+ * Igual a wav_source_open, para um WAV dentro de outro arquivo (ex: recurso
+ * 'res/raw' não comprimido do APK, via AssetFileDescriptor). O descritor pode ser
+ * fechado depois que a função retorna.
+ * @param offset Início do WAV no arquivo.
+ * @param length Tamanho do WAV em bytes.
+ */
+int wav_source_open_fd(wav_source_t* src, int fd, off_t offset, size_t length);
+
+/**
+ * Lê até 'frames' frames convertidos para o formato da HAL.
+ * @param out Destino com espaço para frames * HAL_CHANNELS amostras.
+ * @return Frames lidos (0 no fim do arquivo).
+ */
+size_t wav_source_read_s16(wav_source_t* src, int16_t* out, size_t frames);
+
+// Volta ao início do chunk 'data'.
+void wav_source_rewind(wav_source_t* src);
+
+// Posiciona a leitura em 'frame' (limitado ao fim do arquivo).
+void wav_source_seek(wav_source_t* src, uint64_t frame);
+
+// Desfaz o mapeamento.
+void wav_source_close(wav_source_t* src);
+
+// Nome legível do formato (para logs).
+const char* wav_sample_format_name(wav_sample_format_t format);
+
+
+// --- Streaming para a HAL ---
+
+// Ritmo de entrega dos períodos.
+typedef enum {
+    // Um período por período de relógio (CLOCK_MONOTONIC, prazo absoluto), para a
+    // thread de renderização da HAL consumir em tempo real.
+    WAV_PACE_REALTIME = 0,
+    // O mais rápido possível, para medir vazão: a própria função drena cada
+    // período com 'render', então a thread de renderização precisa estar parada.
+    WAV_PACE_ASAP,
+} wav_pace_t;
+
+typedef struct {
+    wav_pace_t pace;
+    size_t period_frames;           // HAL_MIN_PERIOD_FRAMES..HAL_MAX_PERIOD_FRAMES
+    bool loop;                      // Recomeça do início no fim do arquivo
+    const std::atomic<bool>* stop;  // Opcional: true encerra o streaming no próximo período
+} wav_stream_options_t;
+
+typedef struct {
+    uint64_t frames;        // Frames aceitos pela HAL
+    uint64_t periods;       // Períodos lidos do arquivo
+    uint64_t short_writes;  // 'write' aceitou menos que o pedido (fila cheia)
+    uint64_t loops;         // Voltas completas no arquivo
+    uint64_t elapsed_ns;
+} wav_stream_stats_t;
+
+/**
+ * Entrega o WAV à HAL por 'write', em períodos, até o fim do arquivo (ou até
+ * 'stop', com 'loop'). Usa apenas um buffer de período na pilha.
+ * @param stats Opcional; atualizado ao fim.
+ * @return 0 ao terminar; -EINVAL para opções inválidas, ou o erro de 'write'/'render'
+ *         (ex: -EBUSY em WAV_PACE_ASAP com a thread de renderização ativa).
+ */
+int wav_stream_to_hal(audio_hw_device_t* dev, wav_source_t* src, const wav_stream_options_t* options,
+                      wav_stream_stats_t* stats);
+
+#endif // MYAUDIOHALPROJECT_WAV_SOURCE_H
@@ -0,0 +1,201 @@
+// --- Includes Padrão ---
+#include <errno.h>       // Para códigos de erro padrão (-EINVAL, -EALREADY)
+#include <string.h>      // Para strerror
+#include <limits.h>      // Para INT_MAX (acordar todos os workers)
+#include <sched.h>       // Para SCHED_FIFO
+#include <unistd.h>      // Para syscall
+#include <sys/syscall.h> // Para SYS_futex
+#include <linux/futex.h> // Para FUTEX_WAIT_PRIVATE / FUTEX_WAKE_PRIVATE
+#include <android/log.h> // Para a função __android_log_print, usada para logs no Logcat Android
+
+#include "worker_pool.h"
+#include "hal_log.h"     // Nível de log em tempo de compilação
+#include "hal_trace.h"   // Nome da thread no trace
+
+
+// --- Macros ALOG (mesma solução de contorno de audio_hal.cpp) ---
+#ifndef ANDROID_LOG_INFO
+#define ANDROID_LOG_INFO 4  // Prioridade de informação (Info)
+#endif
+#ifndef ANDROID_LOG_ERROR
+#define ANDROID_LOG_ERROR 6 // Prioridade de erro (Error)
+#endif
+#ifndef ALOGI
+#define ALOGI(...) HAL_LOG(ANDROID_LOG_INFO, "AudioHAL", __VA_ARGS__)
+#endif
+#ifndef ALOGE
+#define ALOGE(...) HAL_LOG(ANDROID_LOG_ERROR, "AudioHAL", __VA_ARGS__)
+#endif
+
+
+#define WORKER_POOL_FIFO_PRIORITY 2     // A mesma da thread de renderização
+// Giros antes de dormir no futex (~dezenas de us): cobre períodos seguidos
+// (renderização offline, benchmark) sem queimar CPU entre períodos de tempo real.
+#define WORKER_POOL_SPIN_ITERATIONS 1000
+#define WORKER_POOL_MAX_TASKS 0xFFFF    // A contagem ocupa 16 bits de 'claim'
+
+#define CLAIM_WORD(gen, count, next) (((uint64_t)(gen) << 32) | ((uint64_t)(count) << 16) | (uint64_t)(next))
+#define CLAIM_GEN(word) ((uint32_t)((word) >> 32))
+#define CLAIM_COUNT(word) ((uint32_t)((word) >> 16) & 0xFFFFu)
+#define CLAIM_NEXT(word) ((uint32_t)(word) & 0xFFFFu)
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline void futex_wait(std::atomic<uint32_t>* word, uint32_t expected) {
+    // Retorna sem dormir se o valor já mudou (EAGAIN) ou em sinais (EINTR): quem chama reavalia.
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static inline void futex_wake(std::atomic<uint32_t>* word, int count) {
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/**
+ * Tenta elevar a thread atual para SCHED_FIFO (ver render_thread.cpp).
+ */
+static void try_set_realtime_priority(void) {
+    struct sched_param param;
+    param.sched_priority = WORKER_POOL_FIFO_PRIORITY;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) {
+        ALOGI("AudioHAL: SCHED_FIFO indisponível para o worker (%s); usando a política padrão.", strerror(ret));
+    }
+}
+
+/**
+ * Reserva e executa tarefas da geração 'gen' até acabarem. A geração, a contagem
+ * e o índice estão na mesma palavra: uma palavra de outra geração encerra o laço.
+ */
+static void run_tasks(worker_pool_t* pool, uint32_t gen) {
+    uint64_t word = pool->claim.load(std::memory_order_acquire);
+    for (;;) {
+        if (CLAIM_GEN(word) != gen || CLAIM_NEXT(word) >= CLAIM_COUNT(word)) {
+            return;
+        }
+        if (!pool->claim.compare_exchange_weak(word, word + 1, std::memory_order_acq_rel,
+                                               std::memory_order_acquire)) {
+            continue; // 'word' foi recarregado
+        }
+        pool->fn(pool->cookie, (int)CLAIM_NEXT(word));
+        // seq_cst nos dois lados: ou este worker vê 'waiter', ou quem publicou vê 'pending' zerado.
+        if (pool->pending.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+            pool->waiter.load(std::memory_order_seq_cst)) {
+            futex_wake(&pool->pending, 1);
+        }
+        word = pool->claim.load(std::memory_order_acquire);
+    }
+}
+
+/**
+ * Espera 'generation' sair de 'seen': gira um pouco e depois dorme no futex.
+ * @return A geração nova.
+ */
+static uint32_t wait_generation(worker_pool_t* pool, uint32_t seen) {
+    for (int i = 0; i < pool->spin_iterations; i++) {
+        const uint32_t gen = pool->generation.load(std::memory_order_acquire);
+        if (gen != seen) return gen;
+        cpu_relax();
+    }
+    pool->sleepers.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t gen;
+    while ((gen = pool->generation.load(std::memory_order_seq_cst)) == seen) {
+        futex_wait(&pool->generation, seen);
+    }
+    pool->sleepers.fetch_sub(1, std::memory_order_relaxed);
+    return gen;
+}
+
+/**
+ * Laço de um worker: espera cada geração nova e ajuda a esvaziá-la.
+ */
+static void* worker_loop(void* arg) {
+    worker_pool_t* pool = (worker_pool_t*)arg;
+    try_set_realtime_priority();
+    HAL_TRACE_THREAD_NAME("zone worker");
+    uint32_t seen = pool->generation.load(std::memory_order_acquire);
+    for (;;) {
+        seen = wait_generation(pool, seen);
+        if (!pool->running.load(std::memory_order_acquire)) {
+            break;
+        }
+        run_tasks(pool, seen);
+    }
+    return NULL;
+}
+
+int worker_pool_start(worker_pool_t* pool, int threads) {
+    if (threads < 0 || threads > WORKER_POOL_MAX_THREADS) {
+        return -EINVAL;
+    }
+    if (pool->thread_count > 0) {
+        return -EALREADY;
+    }
+    // Com um único núcleo, girar só atrasa a thread que se espera.
+    pool->spin_iterations = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? WORKER_POOL_SPIN_ITERATIONS : 0;
+    pool->pending.store(0, std::memory_order_relaxed);
+    pool->sleepers.store(0, std::memory_order_relaxed);
+    pool->waiter.store(0, std::memory_order_relaxed);
+    pool->running.store(true, std::memory_order_release);
+    for (int i = 0; i < threads; i++) {
+        int ret = pthread_create(&pool->threads[i], NULL, worker_loop, pool);
+        if (ret != 0) {
+            ALOGE("AudioHAL: Falha ao criar o worker %d: %s", i, strerror(ret));
+            worker_pool_stop(pool); // Encerra os que já foram criados
+            return -ret;
+        }
+        pool->thread_count = i + 1;
+    }
+    return 0;
+}
+
+void worker_pool_stop(worker_pool_t* pool) {
+    if (pool->thread_count == 0) {
+        return;
+    }
+    pool->running.store(false, std::memory_order_release);
+    pool->generation.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(&pool->generation, INT_MAX);
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->thread_count = 0;
+}
+
+void worker_pool_run(worker_pool_t* pool, worker_task_fn fn, void* cookie, int tasks) {
+    if (pool->thread_count == 0 || tasks <= 1 || tasks > WORKER_POOL_MAX_TASKS) {
+        for (int task = 0; task < tasks; task++) {
+            fn(cookie, task);
+        }
+        return;
+    }
+    // Publica: tarefas e contagem primeiro, a palavra de reserva com release, e só
+    // então a geração que acorda os workers.
+    pool->fn = fn;
+    pool->cookie = cookie;
+    pool->pending.store((uint32_t)tasks, std::memory_order_relaxed);
+    const uint32_t gen = pool->generation.load(std::memory_order_relaxed) + 1;
+    pool->claim.store(CLAIM_WORD(gen, tasks, 0), std::memory_order_release);
+    pool->generation.store(gen, std::memory_order_seq_cst);
+    if (pool->sleepers.load(std::memory_order_seq_cst) > 0) {
+        futex_wake(&pool->generation, INT_MAX);
+    }
+
+    // Quem publica também trabalha e depois espera a barreira.
+    run_tasks(pool, gen);
+    for (int i = 0; i < pool->spin_iterations; i++) {
+        if (pool->pending.load(std::memory_order_acquire) == 0) return;
+        cpu_relax();
+    }
+    pool->waiter.store(1, std::memory_order_seq_cst);
+    uint32_t left;
+    while ((left = pool->pending.load(std::memory_order_seq_cst)) != 0) {
+        futex_wait(&pool->pending, left);
+    }
+    pool->waiter.store(0, std::memory_order_relaxed);
+}
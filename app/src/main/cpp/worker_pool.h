@@ -0,0 +1,67 @@
+// --- Pool Fixo de Workers com Barreira por Período ---
+// Executa as tarefas independentes de um período (ex: a cadeia DSP de cada
+// zona) em paralelo, em um punhado de threads criadas uma única vez, fora do
+// caminho de áudio. A cada período quem chama publica N tarefas, também as
+// executa junto com os workers e só retorna quando todas terminaram (barreira):
+// nenhuma thread é criada por período e nada é alocado.
+//
+// - As tarefas são distribuídas dinamicamente: cada thread reserva a próxima com
+//   um CAS em uma palavra que carrega também a geração (o período), então um
+//   worker atrasado de um período anterior nunca executa uma tarefa duas vezes.
+// - A espera é híbrida: um giro curto (os workers costumam estar acordados
+//   quando os períodos vêm seguidos) e depois futex, sem custo enquanto ociosos.
+//   Quem publica só faz a syscall de wake se alguém estiver de fato dormindo.
+// - Sem workers (ou com uma única tarefa) tudo roda inline na thread chamadora.
+#ifndef MYAUDIOHALPROJECT_WORKER_POOL_H
+#define MYAUDIOHALPROJECT_WORKER_POOL_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+
+#define WORKER_POOL_MAX_THREADS 7
+
+// Uma tarefa do período; 'task' vai de 0 a tasks-1.
+typedef void (*worker_task_fn)(void* cookie, int task);
+
+typedef struct {
+    pthread_t threads[WORKER_POOL_MAX_THREADS];
+    int thread_count;
+    int spin_iterations;            // Giros antes do futex (0 em um único núcleo)
+    std::atomic<bool> running;
+
+    // Tarefas do período corrente (escritas por quem publica antes de 'claim').
+    worker_task_fn fn;
+    void* cookie;
+    // Geração (32 bits altos) | contagem (16 bits) | próxima tarefa (16 bits baixos).
+    std::atomic<uint64_t> claim;
+
+    // Palavras de futex: a geração acorda os workers; 'pending' libera quem publicou.
+    std::atomic<uint32_t> generation;
+    std::atomic<uint32_t> pending;    // Tarefas ainda não concluídas
+    std::atomic<uint32_t> sleepers;   // Workers dormindo no futex de 'generation'
+    std::atomic<uint32_t> waiter;     // Quem publicou dorme no futex de 'pending'
+} worker_pool_t;
+
+/**
+ * Cria 'threads' workers (0..WORKER_POOL_MAX_THREADS). Tenta usar SCHED_FIFO,
+ * como a thread de renderização. Não deve ser chamada no caminho de áudio.
+ * @return 0 em caso de sucesso, -EINVAL para um número inválido, -EALREADY se
+ *         o pool já estiver rodando, ou o erro de pthread_create (negativo).
+ */
+int worker_pool_start(worker_pool_t* pool, int threads);
+
+/**
+ * Acorda e encerra os workers, aguardando o término. Sem efeito se parado.
+ * Não pode ser chamada durante um worker_pool_run.
+ */
+void worker_pool_stop(worker_pool_t* pool);
+
+/**
+ * Executa fn(cookie, 0..tasks-1) nos workers e na thread atual e retorna
+ * depois que todas as tarefas terminarem. Uma única thread publica por vez.
+ * Não aloca memória; as escritas das tarefas ficam visíveis no retorno.
+ */
+void worker_pool_run(worker_pool_t* pool, worker_task_fn fn, void* cookie, int tasks);
+
+#endif // MYAUDIOHALPROJECT_WORKER_POOL_H
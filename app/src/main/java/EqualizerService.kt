@@ -28,6 +28,15 @@ class EqualizerService : Service() {
             Log.d(TAG, "[Serviço] Nível de Agudos: $level")
             // Em um cenário real, aqui você chamaria a HAL de áudio ou o código nativo
         }
+        override fun setEqualizerBands(levels: IntArray?) {
+            // Chamada 'oneway': roda em uma thread do Binder, sem log por chamada.
+            val ret = if (levels != null) setEqualizerBandsNative(levels) else -22
+            if (ret != 0) Log.w(TAG, "[Serviço] Bandas recusadas pela HAL: $ret")
+        }
+        override fun loadPreset(presetId: Int) {
+            val ret = loadEqPresetNative(presetId)
+            if (ret != 0) Log.w(TAG, "[Serviço] Preset $presetId recusado pela HAL: $ret")
+        }
     }
     override fun onCreate() {
         super.onCreate()
@@ -45,4 +54,14 @@ class EqualizerService : Service() {
         super.onDestroy()
         Log.d(TAG, "Serviço de Equalizador destruído.")
     }
+
+    // Coeficientes vêm do cache da HAL: a troca é uma consulta e uma troca atômica.
+    private external fun setEqualizerBandsNative(levels: IntArray): Int
+    private external fun loadEqPresetNative(presetId: Int): Int
+
+    companion object {
+        init {
+            System.loadLibrary("native-lib") // O serviço pode ser criado antes da MainActivity
+        }
+    }
 }
\ No newline at end of file
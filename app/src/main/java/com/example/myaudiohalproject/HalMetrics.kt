@@ -0,0 +1,89 @@
+package com.example.myaudiohalproject
+
+/**
+ * Snapshot das métricas do caminho de áudio da HAL nativa.
+ * Construído a partir do array retornado por MainActivity.getHalMetricsNative();
+ * o layout é definido em native-lib.cpp e precisa ficar em sincronia com ele.
+ */
+data class HalMetrics(
+    val bytesWritten: Long,
+    val framesWritten: Long,
+    val overruns: Long,
+    val framesRendered: Long,
+    val periodsRendered: Long,
+    val underruns: Long,
+    val writeLatency: LatencyHistogram,
+    val processLatency: LatencyHistogram
+) {
+    /**
+     * Histograma de latência com baldes em potências de dois: o balde 0 conta
+     * durações abaixo de ~1 us e o balde k conta [2^(k+9), 2^(k+10)) ns.
+     */
+    data class LatencyHistogram(val count: Long, val sumNs: Long, val maxNs: Long, val buckets: LongArray) {
+        val averageNs: Long get() = if (count > 0) sumNs / count else 0
+
+        /** Limite superior (ns) do balde que contém o percentil 'p' (0..100). */
+        fun percentileUpperBoundNs(p: Double): Long {
+            if (count == 0L) return 0
+            val target = (count * p / 100.0).toLong().coerceAtLeast(1)
+            var seen = 0L
+            for (i in buckets.indices) {
+                seen += buckets[i]
+                if (seen >= target) return 1L shl (i + BUCKET0_SHIFT)
+            }
+            return maxNs
+        }
+
+        override fun equals(other: Any?): Boolean {
+            if (this === other) return true
+            if (other !is LatencyHistogram) return false
+            return count == other.count && sumNs == other.sumNs && maxNs == other.maxNs &&
+                buckets.contentEquals(other.buckets)
+        }
+
+        override fun hashCode(): Int {
+            var result = count.hashCode()
+            result = 31 * result + sumNs.hashCode()
+            result = 31 * result + maxNs.hashCode()
+            result = 31 * result + buckets.contentHashCode()
+            return result
+        }
+    }
+
+    override fun toString(): String =
+        "frames escritos=$framesWritten renderizados=$framesRendered " +
+            "overruns=$overruns underruns=$underruns " +
+            "write médio=${writeLatency.averageNs}ns p99<=${writeLatency.percentileUpperBoundNs(99.0)}ns " +
+            "processamento médio=${processLatency.averageNs}ns p99<=${processLatency.percentileUpperBoundNs(99.0)}ns " +
+            "máx=${processLatency.maxNs}ns"
+
+    companion object {
+        private const val BUCKETS = 16       // AUDIO_METRICS_LATENCY_BUCKETS
+        private const val BUCKET0_SHIFT = 10 // AUDIO_METRICS_LATENCY_BUCKET0_SHIFT
+        private const val COUNTERS = 6
+        private const val HISTOGRAM_LONGS = 3 + BUCKETS
+        const val ARRAY_LENGTH = COUNTERS + 2 * HISTOGRAM_LONGS
+
+        private fun histogramAt(values: LongArray, offset: Int) = LatencyHistogram(
+            count = values[offset],
+            sumNs = values[offset + 1],
+            maxNs = values[offset + 2],
+            buckets = values.copyOfRange(offset + 3, offset + HISTOGRAM_LONGS)
+        )
+
+        /** Converte o array nativo; retorna null se ele estiver ausente ou com outro layout. */
+        fun fromArray(values: LongArray?): HalMetrics? {
+            if (values == null || values.size != ARRAY_LENGTH) return null
+            return HalMetrics(
+                bytesWritten = values[0],
+                framesWritten = values[1],
+                overruns = values[2],
+                framesRendered = values[3],
+                periodsRendered = values[4],
+                underruns = values[5],
+                writeLatency = histogramAt(values, COUNTERS),
+                processLatency = histogramAt(values, COUNTERS + HISTOGRAM_LONGS)
+            )
+        }
+    }
+}
@@ -0,0 +1,163 @@
+package com.example.myaudiohalproject
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.ShortBuffer
+
+/**
+ * Stream de saída da HAL alimentado por memória compartilhada, sem cópias via JNI.
+ *
+ * A região (um ByteBuffer direto alocado uma única vez) é registrada na HAL, que a
+ * usa como a própria fila do stream: o PCM é escrito aqui diretamente nos dados da
+ * fila e a thread de renderização nativa o mistura no lugar. A única chamada JNI por
+ * escrita é [commitNative], que publica a nova posição de escrita e devolve o espaço
+ * livre; nenhum array Java é copiado ou fixado (sem GetByteArrayElements).
+ *
+ * Layout da região (ver AUDIO_SHARED_PCM_* em audio_hal.h):
+ * [alinhamento][cabeçalho de 192 bytes, reservado à HAL][dados]. A posição de escrita
+ * é acompanhada aqui e o espaço livre vem do retorno de [commitNative].
+ *
+ * Formato: PCM 16 bits estéreo intercalado a 48 kHz. Deve ser usado por uma única
+ * thread produtora; não é thread-safe.
+ */
+class HalPcmStream private constructor(
+    region: ByteBuffer,
+    headerOffset: Int,
+    /** Capacidade da fila em bytes (potência de dois). */
+    val capacityBytes: Int,
+    private var handle: Long
+) : AutoCloseable {
+
+    private val dataOffset = headerOffset + HEADER_BYTES
+    private val mask = capacityBytes - 1
+    // Visões reutilizadas da região, para que as escritas não aloquem objetos.
+    private val bytes: ByteBuffer = region.duplicate().order(ByteOrder.nativeOrder())
+    private val shorts: ShortBuffer = run {
+        bytes.clear().position(dataOffset)
+        bytes.slice().order(ByteOrder.nativeOrder()).asShortBuffer()
+    }
+    private var writePos = 0        // Contador livre, espelha a posição de escrita da HAL
+    private var freeBytes = capacityBytes // Visão conservadora do espaço livre
+    private var closing = false     // close() já chamado (o fechamento pode estar pendente)
+
+    /** Espaço livre em bytes, consultando a posição de leitura atual da HAL. */
+    fun writableBytes(): Int {
+        refresh()
+        return freeBytes
+    }
+
+    /**
+     * Escreve amostras intercaladas direto na fila e as publica para a HAL.
+     * Nunca bloqueia: aceita só os frames completos que couberem.
+     * @return Número de amostras aceitas, ou um código de erro negativo.
+     */
+    fun write(pcm: ShortArray, offset: Int = 0, length: Int = pcm.size - offset): Int {
+        val wanted = (length / CHANNELS) * FRAME_BYTES
+        if (freeBytes < wanted && !refresh()) return freeBytes
+        val n = minOf(wanted, freeBytes)
+        var done = 0
+        while (done < n) {
+            val physical = (writePos + done) and mask
+            val chunk = minOf(n - done, capacityBytes - physical)
+            shorts.position(physical / 2)
+            shorts.put(pcm, offset + done / 2, chunk / 2)
+            done += chunk
+        }
+        return if (publish(n)) n / 2 else freeBytes
+    }
+
+    /**
+     * Copia os bytes restantes de [src] (PCM em ordem de bytes nativa, ex: saída de
+     * um MediaCodec) direto na fila e os publica. Avança a posição de [src].
+     * @return Número de bytes aceitos, ou um código de erro negativo.
+     */
+    fun write(src: ByteBuffer): Int {
+        val wanted = (src.remaining() / FRAME_BYTES) * FRAME_BYTES
+        if (freeBytes < wanted && !refresh()) return freeBytes
+        val n = minOf(wanted, freeBytes)
+        val savedLimit = src.limit()
+        var done = 0
+        while (done < n) {
+            val physical = (writePos + done) and mask
+            val chunk = minOf(n - done, capacityBytes - physical)
+            src.limit(src.position() + chunk)
+            bytes.limit(dataOffset + physical + chunk).position(dataOffset + physical)
+            bytes.put(src)
+            src.limit(savedLimit)
+            done += chunk
+        }
+        return if (publish(n)) n else freeBytes
+    }
+
+    /**
+     * Fecha o stream na HAL; a região só é liberada pelo GC depois disso. Se a HAL
+     * não liberar o stream a tempo, as escritas já falham e o handle é mantido:
+     * chamar [close] de novo conclui o fechamento.
+     */
+    override fun close() {
+        if (handle == 0L) return
+        closing = true
+        if (closeNative(handle) == 0) {
+            handle = 0L
+        }
+    }
+
+    /** Atualiza [freeBytes] com a posição de leitura da HAL. @return false em caso de erro. */
+    private fun refresh(): Boolean = publish(0)
+
+    private fun publish(n: Int): Boolean {
+        if (handle == 0L || closing) {
+            freeBytes = ERROR_CLOSED
+            return false
+        }
+        val ret = commitNative(handle, n)
+        if (ret < 0) {
+            freeBytes = ret
+            return false
+        }
+        writePos += n
+        freeBytes = ret
+        return true
+    }
+
+    companion object {
+        const val USAGE_MEDIA = 0
+        const val USAGE_NAVIGATION = 1
+        const val USAGE_CHIME = 2
+        const val USAGE_PHONE = 3
+
+        // Espelham as constantes de audio_hal.h.
+        private const val CHANNELS = 2
+        private const val FRAME_BYTES = CHANNELS * 2
+        private const val ALIGNMENT = 64
+        private const val HEADER_BYTES = 192
+        private const val MIN_CAPACITY_BYTES = 960 * FRAME_BYTES
+        private const val ERROR_CLOSED = -19 // -ENODEV
+
+        /**
+         * Aloca a região e abre o stream na HAL.
+         * @param capacityBytes Capacidade desejada da fila; arredondada para potência de dois.
+         * @return O stream, ou null se a HAL recusar a abertura (ex: sem slots livres).
+         */
+        fun open(capacityBytes: Int = 16384, usage: Int = USAGE_MEDIA, priority: Int = 0): HalPcmStream? {
+            val requested = capacityBytes.coerceIn(MIN_CAPACITY_BYTES, 1 shl 29)
+            val capacity = Integer.highestOneBit(requested).let { if (it < requested) it shl 1 else it }
+            // Folga de ALIGNMENT bytes: a HAL exige o cabeçalho alinhado à linha de cache.
+            val region = ByteBuffer.allocateDirect(ALIGNMENT + HEADER_BYTES + capacity)
+            val headerOffset = alignmentOffsetNative(region)
+            if (headerOffset < 0) return null
+            val handle = openNative(region, headerOffset, usage, priority)
+            if (handle == 0L) return null
+            return HalPcmStream(region, headerOffset, capacity, handle)
+        }
+
+        init {
+            System.loadLibrary("native-lib")
+        }
+
+        @JvmStatic private external fun alignmentOffsetNative(buffer: ByteBuffer): Int
+        @JvmStatic private external fun openNative(buffer: ByteBuffer, offset: Int, usage: Int, priority: Int): Long
+        @JvmStatic private external fun commitNative(handle: Long, bytes: Int): Int
+        @JvmStatic private external fun closeNative(handle: Long): Int
+    }
+}
@@ -13,6 +13,7 @@ import android.content.Context
 import android.content.Intent
 import android.content.ServiceConnection
 import android.os.IBinder
+import java.io.File
 import com.example.myaudiohalproject.com.example.myaudiohalproject.VehicleCanBusSimulator
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
@@ -24,6 +25,7 @@ import com.example.myaudiohalproject.com.example.myaudiohalproject.CanMessage
 class MainActivity : AppCompatActivity() {
 
     private lateinit var equalizerSwitch: Switch
+    private lateinit var dynamicsSwitch: Switch
     private lateinit var bassSeekBar: SeekBar
     private lateinit var midSeekBar: SeekBar
     private lateinit var trebleSeekBar: SeekBar
@@ -31,6 +33,9 @@ class MainActivity : AppCompatActivity() {
     private lateinit var readSpeedButton: Button
     private lateinit var canVolumeLabel: TextView // Novo TextView para volume CAN
     private lateinit var sendCanVolumeButton: Button // Novo Botão para volume CAN
+    private lateinit var playTestSoundButton: Button
+    private var testSoundPlaying = false
+    private var halAtraceEnabled = false
     private lateinit var nativeStatusTextView: TextView
     private val TAG = "VehicleEqualizerApp"
     private var equalizerService: IEqualizerService? = null
@@ -46,9 +51,7 @@ class MainActivity : AppCompatActivity() {
             equalizerService = IEqualizerService.Stub.asInterface(service)
             Log.i(TAG, "Conectado ao EqualizerService.")
             equalizerService?.setEqualizerEnabled(equalizerSwitch.isChecked)
-            equalizerService?.setBassLevel(bassSeekBar.progress)
-            equalizerService?.setMidLevel(midSeekBar.progress)
-            equalizerService?.setTrebleLevel(trebleSeekBar.progress)
+            equalizerService?.setEqualizerBands(currentBandLevels())
         }
         override fun onServiceDisconnected(name: ComponentName?) {
             equalizerService = null
@@ -64,6 +67,7 @@ class MainActivity : AppCompatActivity() {
         setContentView(R.layout.activity_main)
 
         equalizerSwitch = findViewById(R.id.equalizerSwitch)
+        dynamicsSwitch = findViewById(R.id.dynamicsSwitch)
         bassSeekBar = findViewById(R.id.bassSeekBar)
         midSeekBar = findViewById(R.id.midSeekBar)
         trebleSeekBar = findViewById(R.id.trebleSeekBar)
@@ -71,35 +75,50 @@ class MainActivity : AppCompatActivity() {
         readSpeedButton = findViewById(R.id.readSpeedButton)
         canVolumeLabel = findViewById(R.id.canVolumeLabel) // Inicializao TextView CAN
         sendCanVolumeButton = findViewById(R.id.sendCanVolumeButton) // Inicializa o Botão CAN
+        playTestSoundButton = findViewById(R.id.playTestSoundButton)
         nativeStatusTextView = findViewById(R.id.nativeStatusTextView)
 
         nativeStatusTextView.text = stringFromJNI()
+        // Depuração: um toque longo no status liga/desliga o envio dos marcadores da
+        // HAL ao systrace/Perfetto (builds nativas com -DHAL_TRACE=ON; desligado por padrão).
+        nativeStatusTextView.setOnLongClickListener {
+            halAtraceEnabled = !halAtraceEnabled
+            setHalAtraceEnabledNative(halAtraceEnabled)
+            Log.i(TAG, "ATrace da HAL: ${if (halAtraceEnabled) "ligado" else "desligado"}")
+            true
+        }
 
         setEqualizerControlsEnabled(equalizerSwitch.isChecked)
+        // Sincroniza o estado inicial dos controles com o equalizador da HAL nativa
+        setEqualizerEnabledNative(equalizerSwitch.isChecked)
+        setBassLevelNative(bassSeekBar.progress)
+        setMidLevelNative(midSeekBar.progress)
+        setTrebleLevelNative(trebleSeekBar.progress)
+        setDynamicsEnabledNative(dynamicsSwitch.isChecked)
 
         equalizerSwitch.setOnCheckedChangeListener { _, isChecked ->
             setEqualizerControlsEnabled(isChecked)
             equalizerService?.setEqualizerEnabled(isChecked)
             setEqualizerEnabledNative(isChecked)
         }
+        // Compensação por velocidade e limitador: só quando pedidos (acrescentam latência).
+        dynamicsSwitch.setOnCheckedChangeListener { _, isChecked ->
+            setDynamicsEnabledNative(isChecked)
+        }
 
         val seekBarChangeListener = object : SeekBar.OnSeekBarChangeListener {
             override fun onProgressChanged(seekBar: SeekBar?, progress: Int, fromUser: Boolean) {}
             override fun onStartTrackingTouch(seekBar: SeekBar?) {}
             override fun onStopTrackingTouch(seekBar: SeekBar?) {
+                // Com o serviço conectado, as três bandas vão juntas em uma chamada 'oneway'.
+                equalizerService?.let {
+                    it.setEqualizerBands(currentBandLevels())
+                    return
+                }
                 when (seekBar?.id) {
-                    R.id.bassSeekBar -> {
-                        equalizerService?.setBassLevel(seekBar.progress)
-                        setBassLevelNative(seekBar.progress)
-                    }
-                    R.id.midSeekBar -> {
-                        equalizerService?.setMidLevel(seekBar.progress)
-                        setMidLevelNative(seekBar.progress)
-                    }
-                    R.id.trebleSeekBar -> {
-                        equalizerService?.setTrebleLevel(seekBar.progress)
-                        setTrebleLevelNative(seekBar.progress)
-                    }
+                    R.id.bassSeekBar -> setBassLevelNative(seekBar.progress)
+                    R.id.midSeekBar -> setMidLevelNative(seekBar.progress)
+                    R.id.trebleSeekBar -> setTrebleLevelNative(seekBar.progress)
                 }
             }
         }
@@ -110,6 +129,12 @@ class MainActivity : AppCompatActivity() {
             val currentSpeed = vehicleSensorSimulator.readSensorData()
             speedLabel.text = "Velocidade Atual: $currentSpeed km/h"
             Log.d(TAG, "Velocidade lida: $currentSpeed km/h")
+            // Publica a velocidade no barramento (0x3E9, 0,01 km/h big-endian): a HAL
+            // ajusta a compensação de ruído de rodagem a partir dela.
+            val raw = currentSpeed * 100
+            vehicleCanBusSimulator.sendMessage(
+                CanMessage(id = 0x3E9, data = byteArrayOf((raw shr 8).toByte(), raw.toByte()))
+            )
         }
 
         // Listener para o botão de envio de volume CAN
@@ -119,14 +144,30 @@ class MainActivity : AppCompatActivity() {
             vehicleCanBusSimulator.sendMessage(message)
         }
 
+        // Liga/desliga a reprodução de res/raw/test_sound.wav pela HAL. O WAV fica sem
+        // compressão no APK, então o lado nativo o mapeia direto do arquivo do APK.
+        playTestSoundButton.setOnClickListener {
+            if (testSoundPlaying) {
+                stopWavPlaybackNative()
+                testSoundPlaying = false
+            } else {
+                resources.openRawResourceFd(R.raw.test_sound).use { afd ->
+                    val ret = startWavPlaybackNative(afd.parcelFileDescriptor.fd, afd.startOffset, afd.length, true)
+                    testSoundPlaying = ret == 0
+                    if (ret != 0) Log.e(TAG, "Falha ao reproduzir o som de teste: $ret")
+                }
+            }
+            playTestSoundButton.text =
+                if (testSoundPlaying) "Parar Som de Teste" else "Reproduzir Som de Teste (via HAL)"
+        }
+
         // Coleta mensagens CAN recebidas e atualiza a UI
         activityScope.launch {
             vehicleCanBusSimulator.canMessageFlow.collect { message ->
                 if (message.id == 0x123 && message.data.isNotEmpty()) {
                     val volume = message.data[0].toInt() and 0xFF
+                    // Só a UI: o volume mestre já foi decodificado e aplicado na HAL pelo lado nativo
                     canVolumeLabel.text = "Volume CAN: $volume"
-                    // Em um cenário real, você poderia usar este volume para ajustar o áudio
-                    // equalizerService?.setMasterVolume(volume) //Exemplo de chamada ao serviço
                 }
             }
         }
@@ -144,6 +185,17 @@ class MainActivity : AppCompatActivity() {
 
     override fun onStop() {
         super.onStop()
+        if (testSoundPlaying) {
+            stopWavPlaybackNative()
+            testSoundPlaying = false
+            playTestSoundButton.text = "Reproduzir Som de Teste (via HAL)"
+        }
+        // Resumo das métricas do caminho de áudio (no lugar dos logs por escrita)
+        HalMetrics.fromArray(getHalMetricsNative())?.let { Log.i(TAG, "Métricas da HAL: $it") }
+        // Marcadores por etapa (só em builds nativas com -DHAL_TRACE=ON; senão retorna -ENOSYS).
+        val tracePath = File(filesDir, "hal_trace.json").path
+        val traceEvents = dumpHalTraceNative(tracePath)
+        if (traceEvents >= 0) Log.i(TAG, "Trace da HAL ($traceEvents eventos): $tracePath")
         if (equalizerService != null) {
             unbindService(serviceConnection)
             equalizerService = null
@@ -156,6 +208,10 @@ class MainActivity : AppCompatActivity() {
 
 
 
+    // Níveis na ordem das bandas do layout padrão da HAL (graves, médios, agudos).
+    private fun currentBandLevels(): IntArray =
+        intArrayOf(bassSeekBar.progress, midSeekBar.progress, trebleSeekBar.progress)
+
     private fun setEqualizerControlsEnabled(enabled: Boolean) {
         bassSeekBar.isEnabled = enabled
         midSeekBar.isEnabled = enabled
@@ -167,10 +223,17 @@ class MainActivity : AppCompatActivity() {
     external fun setBassLevelNative(level: Int)
     external fun setMidLevelNative(level: Int)
     external fun setTrebleLevelNative(level: Int)
+    external fun setDynamicsEnabledNative(enabled: Boolean)
+    external fun getHalMetricsNative(): LongArray?
+    external fun dumpHalTraceNative(path: String): Int
+    external fun setHalAtraceEnabledNative(enabled: Boolean)
+    external fun setMasterVolumeNative(volume: Int)
+    external fun startWavPlaybackNative(fd: Int, offset: Long, length: Long, loop: Boolean): Int
+    external fun stopWavPlaybackNative()
 
     companion object {
         init {
-            System.loadLibrary("vehicleequalizernative")
+            System.loadLibrary("native-lib") // Nome definido em add_library() no CMakeLists.txt
         }
     }
 }
@@ -1,8 +1,7 @@
 package com.example.myaudiohalproject.com.example.myaudiohalproject
 
 import android.util.Log
-import kotlinx.coroutines.*
-import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.BufferOverflow
 import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.asSharedFlow
 
@@ -10,55 +9,52 @@ class VehicleCanBusSimulator {
 
 
     private val TAG = "VehicleCanBusSimulator"
-    private val messageChannel = Channel<CanMessage>()
-    private val scope = CoroutineScope(Dispatchers.Default)
-    // Flow para notificar a UI sobre mensagens CAN recebidas
-    private val _canMessageFlow = MutableSharedFlow<CanMessage>()
+    // Flow para notificar a UI sobre mensagens CAN enviadas. O envio nunca suspende:
+    // se a UI atrasar, as mensagens mais antigas são descartadas (só o último valor importa).
+    private val _canMessageFlow = MutableSharedFlow<CanMessage>(
+        extraBufferCapacity = 64,
+        onBufferOverflow = BufferOverflow.DROP_OLDEST
+    )
 
     val canMessageFlow = _canMessageFlow.asSharedFlow()
 
     init {
-        // Inicia um consumidor de mensagens CAN simulado
-        scope.launch {
-            for (message in messageChannel) {
-                Log.d(TAG, "Mensagem CAN recebida (ID: 0x%X, Dados: %s)".format(message.id, message.data.joinToString { "%02X".format(it) }))
-                // Publica a mensagem para qualquer ouvinte (ex: MainActivity)
-                _canMessageFlow.emit(message)
-
-                // Simula o processamento da mensagem CAN
-                when (message.id) {
-                    0x123 -> { // Exemplo: ID para mensagem de volume mestre
-                        // Converte byte para int (0-255)
-                        if (message.data.isNotEmpty()) {
-                            val volume = message.data[0].toInt() and 0xFF
-                            Log.i(TAG, "Processando mensagem CAN: Novo Volume Mestre: $volume")
-                            // Em um cenário real, isso seria enviado para a HAL de áudio
-                        }
-                    }
-                    // Adicione outros IDs de mensagem CAN para simular diferentes dados do veículo
-                }
-            }
-        }
+        // A decodificação (tabela de sinais, ex: 0x123 = volume mestre) e a publicação
+        // na HAL acontecem no lado nativo, em lotes, em uma thread de ingestão própria.
+        val ret = startIngestNative()
+        if (ret != 0) Log.e(TAG, "Falha ao iniciar a ingestão CAN nativa: $ret")
     }
     /**
     * Simula o envio de uma mensagem CAN para o barramento.
+    * Só enfileira o frame no lado nativo: sem corrotina, canal ou log por mensagem.
     * @param message A mensagem CAN a ser enviada.
     */
-
+    @Synchronized
     fun sendMessage(message: CanMessage) {
-        scope.launch {
-            Log.i(TAG, "Enviando mensagem CAN (ID: 0x%X, Dados: %s)".format(message.id, message.data.joinToString { "%02X".format(it) }))
-            messageChannel.send(message)
+        if (!pushFrameNative(message.id, message.data)) {
+            Log.w(TAG, "Mensagem CAN descartada (ID: 0x${Integer.toHexString(message.id)})")
         }
+        _canMessageFlow.tryEmit(message)
     }
+    /**
+     * Troca a fila do simulador pelo replay de um log do 'candump -l'.
+     * @param realtime Respeita os timestamps do log (senão, o mais rápido possível).
+     * @return 0 em caso de sucesso, ou um código de erro negativo.
+     */
+    @Synchronized
+    fun startReplay(path: String, loop: Boolean, realtime: Boolean): Int =
+        startReplayNative(path, loop, realtime)
     /**
      * Para o simulador CAN e libera os recursos.
      */
+    @Synchronized
     fun stopSimulator() {
-        scope.cancel()
-        messageChannel.close()
+        stopIngestNative()
         Log.d(TAG, "Simulador CAN parado.")
     }
 
-
-}
\ No newline at end of file
+    private external fun startIngestNative(): Int
+    private external fun startReplayNative(path: String, loop: Boolean, realtime: Boolean): Int
+    private external fun pushFrameNative(id: Int, data: ByteArray): Boolean
+    private external fun stopIngestNative()
+}